@@ -103,6 +103,11 @@ Audio pipeline:
 #define CHANNEL_TYPE_SAMPLE 1
 #define CHANNEL_TYPE_WAVETABLE 2
 
+// Channel effect routing (EFFECT_CHANNEL_ROUTING mask)
+#define EFFECT_ROUTE_REVERB 0x01
+#define EFFECT_ROUTE_DELAY 0x02
+#define EFFECT_ROUTE_ALL 0xFF
+
 // Error codes
 typedef enum {
     ERR_NONE = 0,
@@ -128,20 +133,36 @@ enum {
     CMD_TRACKER_LOAD = 0x10,
     CMD_TRACKER_PLAY = 0x11,
     CMD_TRACKER_STOP = 0x12,
+    CMD_TRACKER_LOAD_DATA = 0x20,
     CMD_CHANNEL_NOTE_ON = 0x33,
     CMD_CHANNEL_SET_VOLUME = 0x30,
     CMD_FM_INIT_CHANNEL = 0x50,
     CMD_SAMPLE_LOAD = 0x70,
     CMD_SAMPLE_PLAY = 0x71,
+    CMD_SAMPLE_STREAM_DEFINE = 0x7C,
+    CMD_SAMPLE_STREAM_DATA = 0x7D,
+    CMD_SAMPLE_LOAD_DATA = 0x7E,
+    CMD_SAMPLE_MAP = 0x7F,
     CMD_WAVE_DEFINE_TABLE = 0x90,
     CMD_WAVE_SET_SWEEP = 0x94,
+    CMD_WAVE_MAP_TABLE = 0x9A,
     CMD_EFFECT_SET_REVERB = 0xB0,
     CMD_EFFECT_SET_DELAY = 0xB1,
     CMD_EFFECT_SET_FILTER = 0xB2,
+    CMD_EFFECT_CHANNEL_ROUTING = 0xB4,
     CMD_MEM_STATUS = 0xD3,
     CMD_MEM_CLEAR_SAMPLES = 0xD0,
     CMD_MEM_OPTIMIZE = 0xD4,
-    STATUS_MEMORY = 0xE0
+    CMD_AUDIO_STATUS = 0xDA,
+    STATUS_MEMORY = 0xE0,
+    STATUS_AUDIO = 0xE1,
+    STATUS_STREAM_REQUEST = 0xE2,
+    CMD_PROFILE_START = 0xE6,
+    CMD_PROFILE_STOP = 0xE7,
+    CMD_PROFILE_READ = 0xE8,
+    CMD_SEQUENCED = 0xE9,
+    CMD_BATCH = 0xF6,
+    CMD_CLOCK_SYNC = 0xF8
 };
 
 // RGB color structure
@@ -157,33 +178,10 @@ typedef struct {
     uint8_t type;
     uint8_t volume;
     uint8_t pan;
+    uint8_t effect_routing;  // EFFECT_ROUTE_* sends
     float frequency;
     float base_frequency;
-
-    // Effects
-    bool arpeggio_enabled;
-    uint8_t arpeggio_note1;
-    uint8_t arpeggio_note2;
-    uint8_t arpeggio_counter;
-
-    bool portamento_active;
-    uint8_t portamento_up;
-    uint8_t portamento_down;
-
-    bool vibrato_active;
-    uint8_t vibrato_speed;
-    uint8_t vibrato_depth;
-    float vibrato_phase;
-
-    bool tremolo_active;
-    uint8_t tremolo_speed;
-    uint8_t tremolo_depth;
-    float tremolo_phase;
-    uint8_t base_volume;
-
-    bool volume_slide_active;
-    uint8_t volume_slide;
-    int8_t volume_slide_direction;
+    uint8_t base_volume;     // Volume before tracker curves
 } Channel;
 
 // Global variables
@@ -198,19 +196,31 @@ uint32_t audio_cpu_load = 0;
 uint32_t sample_memory_size = 0;
 uint32_t pattern_memory_size = 0;
 uint32_t instrument_memory_size = 0;
+uint32_t command_buffer_size = 0;
 uint32_t tile_cache_size = 0;
 bool use_24bit_processing = false;
 bool use_cubic_interpolation = false;
 bool enable_wavetable_fm = false;
-bool use_i2s_double_buffer = false;
-uint8_t dma_i2s_channel = 0;
-uint16_t* i2s_buffer = NULL;
+
+// Mixing pipeline. APU_MIX_AUTO picks at boot: the fixed-point bus on
+// the FPU-less RP2040, float on RP2350. Override at build time with
+// -DAPU_MIX_MODE=APU_MIX_FLOAT or APU_MIX_FIXED.
+#define APU_MIX_AUTO 0
+#define APU_MIX_FLOAT 1
+#define APU_MIX_FIXED 2
+#ifndef APU_MIX_MODE
+#define APU_MIX_MODE APU_MIX_AUTO
+#endif
+bool use_fixed_mixing = (APU_MIX_MODE != APU_MIX_FLOAT);
 
 // Function prototypes
 void setup_spi_slave();
 void send_ack_to_cpu(uint8_t command_id);
 void send_error_to_cpu(uint8_t command_id, uint8_t error_code);
+void send_data_to_cpu(uint8_t type, const uint8_t* data, uint8_t length);
 void emergency_memory_cleanup();
+void send_audio_status();
+int16_t advanced_sample_interpolation(const uint8_t* data, uint32_t pos, float frac, bool is_16bit, uint32_t max_pos);
 void reset_sync_state();
 void reset_spi_interface();
 uint32_t get_total_ram();
@@ -225,6 +235,17 @@ void trigger_fm_note(uint8_t channel_id, float freq);
 void trigger_sample_note(uint8_t channel_id, float freq);
 void trigger_wavetable_note(uint8_t channel_id, float freq);
 void update_envelope(FMOperator* op);
+void load_tracker(uint8_t tracker_id, uint16_t data_size, const uint8_t* data, uint16_t length);
+void append_tracker_data(uint8_t tracker_id, const uint8_t* data, uint16_t length);
+void load_sample(uint8_t sample_id, uint8_t format, uint16_t sample_rate, uint16_t loop_start,
+                 uint16_t loop_end, uint16_t size, const uint8_t* data, uint16_t length);
+void append_sample_data(uint8_t sample_id, const uint8_t* data, uint16_t length);
+void define_sample_stream(uint8_t sample_id, uint8_t format, uint16_t sample_rate, uint8_t source,
+                          uint32_t offset, uint32_t length, uint32_t loop_start, uint32_t loop_end);
+void push_sample_stream_data(uint8_t channel_id, uint32_t source_offset, const uint8_t* data, uint32_t size);
+void play_sample(uint8_t channel_id, uint8_t sample_id, uint8_t pitch, uint8_t volume);
+static void release_sample_data(uint8_t sample_id);
+static void release_wavetable_data(uint8_t table_id);
 void process_tracker_row(uint8_t tracker_id);
 void process_tracker_tick_effects(uint8_t tracker_id);
 void setup_i2s_output();
@@ -232,6 +253,11 @@ void calculate_lowpass_coefficients(Filter* filter, float cutoff, float resonanc
 void calculate_highpass_coefficients(Filter* filter, float cutoff, float resonance);
 void calculate_bandpass_coefficients(Filter* filter, float cutoff, float resonance);
 uint8_t find_nearest_color(uint8_t r, uint8_t g, uint8_t b);
+void map_sample(uint8_t sample_id, uint8_t format, uint16_t sample_rate, uint32_t pack_offset,
+                uint32_t size, uint32_t loop_start, uint32_t loop_end);
+void map_wavetable(uint8_t table_id, uint16_t wave_size, uint32_t pack_offset);
+void configure_channel_routing(uint8_t channel_id, uint8_t effect_mask);
+bool service_voice_job(uint32_t timeout_us);
 
 
 // Clock Synchronization Implementation
@@ -268,7 +294,7 @@ void process_clock_sync_command(const uint8_t* data) {
     master_clock_timestamp = cpu_timestamp;
 
     // Send acknowledgment
-    send_ack_to_cpu(0xF1);
+    send_ack_to_cpu(CMD_CLOCK_SYNC);
 
     if (debug_enabled) {
         printf("Clock sync received: frame=%lu offset=%lld\n",
@@ -281,78 +307,149 @@ uint64_t get_master_time() {
     return time_us_64() + local_clock_offset;
 }
 
-// Handshaking Protocols
-typedef struct {
-    uint8_t command_id;
-    uint8_t length;
-    uint8_t data[256];
-    bool requires_ack;
-    uint32_t timestamp;
-    uint8_t retry_count;
-    bool completed;
-} EnhancedCommand;
+// Frame Profiler
+// Same scheme as the GPU: one single-writer ring of begin/end events per core,
+// stamped with master time. APU zone IDs are 0x20-0x2F.
+#define TRACE_RING_SIZE 512     // Events per core, power of two
+#define TRACE_READ_MAX 30       // Events per PROFILE_READ reply
+
+#define TRACE_BEGIN 0
+#define TRACE_END 1
+
+enum {
+    ZONE_APU_COMMAND = 0x20,   // arg = command ID
+    ZONE_APU_MIX = 0x21        // arg = low bits of the output period number
+};
 
 typedef struct {
-    EnhancedCommand* commands;
-    uint16_t capacity;
-    uint16_t head;
-    uint16_t tail;
-    uint16_t count;
-    mutex_t lock;
-    uint16_t pending_acks;
-    uint8_t device_id; // 1=GPU, 2=APU
-} EnhancedCommandQueue;
-
-EnhancedCommandQueue gpu_queue;
-EnhancedCommandQueue apu_queue;
-const uint32_t COMMAND_TIMEOUT_MS = 50; // 50ms timeout for command response
-const uint8_t MAX_RETRIES = 3;
-
-// Improved command queuing with acknowledgment tracking
-bool queue_command_with_ack(EnhancedCommandQueue* queue, uint8_t cmd_id,
-                           uint8_t length, const uint8_t* data, bool needs_ack) {
-    mutex_enter_blocking(&queue->lock);
-
-    // Check if queue is full
-    if (queue->count >= queue->capacity) {
-        mutex_exit(&queue->lock);
-        send_error_to_cpu(ERROR_QUEUE_FULL);
-        return false;
+    uint32_t timestamp;   // Master time in microseconds, low 32 bits
+    uint8_t zone;
+    uint8_t phase;        // TRACE_BEGIN or TRACE_END
+    uint16_t arg;
+} TraceEvent;
+
+TraceEvent trace_rings[2][TRACE_RING_SIZE];
+volatile uint32_t trace_heads[2];   // Events ever recorded on each core
+uint32_t trace_read_cursors[2];     // Next event PROFILE_READ returns
+volatile bool trace_enabled = false;
+
+static inline void trace_record(uint8_t zone, uint8_t phase, uint16_t arg) {
+    if (!trace_enabled) {
+        return;
+    }
+
+    uint core = get_core_num();
+    uint32_t head = trace_heads[core];
+    TraceEvent* event = &trace_rings[core][head & (TRACE_RING_SIZE - 1)];
+    event->timestamp = (uint32_t)get_master_time();
+    event->zone = zone;
+    event->phase = phase;
+    event->arg = arg;
+
+    // Make the event visible before the index that covers it
+    __dmb();
+    trace_heads[core] = head + 1;
+}
+
+static inline void trace_begin(uint8_t zone, uint16_t arg) {
+    trace_record(zone, TRACE_BEGIN, arg);
+}
+
+static inline void trace_end(uint8_t zone, uint16_t arg) {
+    trace_record(zone, TRACE_END, arg);
+}
+
+// Start a capture. The heads keep counting, the reader just skips what came before.
+void start_profiling() {
+    trace_read_cursors[0] = trace_heads[0];
+    trace_read_cursors[1] = trace_heads[1];
+    __dmb();
+    trace_enabled = true;
+}
+
+void stop_profiling() {
+    trace_enabled = false;
+}
+
+// Reply with the next unread events of one core, in the GPU's layout:
+// [core][first sequence:4][count][timestamp:4 zone phase arg:2]*count
+void send_trace_events(uint8_t core) {
+    if (core > 1) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
     }
 
-    // Add command to queue
-    EnhancedCommand* cmd = &queue->commands[queue->tail];
-    cmd->command_id = cmd_id;
-    cmd->length = length;
-    memcpy(cmd->data, data, length - 2);
-    cmd->requires_ack = needs_ack;
-    cmd->timestamp = time_ms_32();
-    cmd->retry_count = 0;
-    cmd->completed = false;
+    uint8_t packet[6 + TRACE_READ_MAX * 8];
+    uint32_t head = trace_heads[core];
+    __dmb();
 
-    // If this command requires ack, increment pending count
-    if (needs_ack) {
-        queue->pending_acks++;
+    // Keep a margin to the writer so events aren't overwritten mid-copy
+    uint32_t cursor = trace_read_cursors[core];
+    if (head - cursor > TRACE_RING_SIZE - TRACE_READ_MAX) {
+        cursor = head - (TRACE_RING_SIZE - TRACE_READ_MAX);
     }
 
-    // Update queue pointers
-    queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count++;
+    uint32_t count = head - cursor;
+    if (count > TRACE_READ_MAX) {
+        count = TRACE_READ_MAX;
+    }
 
-    mutex_exit(&queue->lock);
-    return true;
+    uint8_t pos = 0;
+    packet[pos++] = core;
+    packet[pos++] = cursor >> 24;
+    packet[pos++] = cursor >> 16;
+    packet[pos++] = cursor >> 8;
+    packet[pos++] = cursor;
+    packet[pos++] = count;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const TraceEvent* event = &trace_rings[core][(cursor + i) & (TRACE_RING_SIZE - 1)];
+        packet[pos++] = event->timestamp >> 24;
+        packet[pos++] = event->timestamp >> 16;
+        packet[pos++] = event->timestamp >> 8;
+        packet[pos++] = event->timestamp;
+        packet[pos++] = event->zone;
+        packet[pos++] = event->phase;
+        packet[pos++] = event->arg >> 8;
+        packet[pos++] = event->arg;
+    }
+
+    trace_read_cursors[core] = cursor + count;
+
+    send_data_to_cpu(CMD_PROFILE_READ, packet, pos);
 }
 
 // APU Command Acknowledgment
 
+// Batch execution state - while a batch runs, responses are folded into
+// a single reply sent when it completes
+bool batch_active = false;
+uint8_t batch_error_cmd = 0;
+uint8_t batch_error_code = 0;
+
+// Sequenced delivery state, reported in every ACK and error packet: the next
+// sequence number expected (everything before it has run) and which of the
+// following ones arrived early and are held
+#define SEQ_WINDOW 8
+uint8_t seq_expected = 0;
+uint16_t seq_held_mask = 0;          // Bit i: seq_expected + i is held
+bool seq_ack_pending = false;
+
 void send_ack_to_cpu(uint8_t command_id) {
+    if (batch_active) {
+        return;
+    }
+
     // Prepare acknowledgment packet
-    uint8_t ack_packet[4] = {
+    uint8_t ack_packet[6] = {
         0xFA,        // ACK command ID
-        4,           // Packet length
+        6,           // Packet length
         command_id,  // Original command being acknowledged
-        0            // Status (0 = success)
+        0,           // Status (0 = success)
+        seq_expected,             // Cumulative sequence ACK
+        seq_held_mask >> 1        // Held: bit i = seq_expected + 1 + i
     };
+    seq_ack_pending = false;
 
     // Wait for CPU to be ready to receive response
     while (gpio_get(CPU_CS_PIN) == 0) {
@@ -371,7 +468,7 @@ void send_ack_to_cpu(uint8_t command_id) {
 
     // If CPU responded, send the acknowledgment
     if (timeout > 0) {
-        spi_write_blocking(SPI_PORT, ack_packet, 4);
+        spi_write_blocking(SPI_PORT, ack_packet, 6);
     }
 
     // Clear data ready signal
@@ -379,13 +476,25 @@ void send_ack_to_cpu(uint8_t command_id) {
 }
 
 void send_error_to_cpu(uint8_t command_id, uint8_t error_code) {
+    if (batch_active) {
+        // Report the first failure once the batch completes
+        if (batch_error_code == ERR_NONE) {
+            batch_error_cmd = command_id;
+            batch_error_code = error_code;
+        }
+        return;
+    }
+
     // Prepare error packet
-    uint8_t error_packet[4] = {
+    uint8_t error_packet[6] = {
         0xFE,        // Error command ID
-        4,           // Packet length
+        6,           // Packet length
         command_id,  // Original command with error
-        error_code   // Error code
+        error_code,  // Error code
+        seq_expected,             // Same sequence state as an ACK
+        seq_held_mask >> 1
     };
+    seq_ack_pending = false;
 
     // Similar pattern as acknowledgment sending
     // Wait for CPU to be ready
@@ -402,7 +511,38 @@ void send_error_to_cpu(uint8_t command_id, uint8_t error_code) {
     }
 
     if (timeout > 0) {
-        spi_write_blocking(SPI_PORT, error_packet, 4);
+        spi_write_blocking(SPI_PORT, error_packet, 6);
+    }
+
+    gpio_put(DATA_READY_PIN, 0);
+}
+
+// Send a status or data packet: [type] [length] [data...], length includes the header
+void send_data_to_cpu(uint8_t type, const uint8_t* data, uint8_t length) {
+    if (length > 253) {
+        return;
+    }
+
+    uint8_t header[2] = {
+        type,
+        (uint8_t)(length + 2)
+    };
+
+    while (gpio_get(CPU_CS_PIN) == 0) {
+        sleep_us(10);
+    }
+
+    gpio_put(DATA_READY_PIN, 1);
+
+    uint32_t timeout = 1000;
+    while (gpio_get(CPU_CS_PIN) == 1 && timeout > 0) {
+        sleep_us(1);
+        timeout--;
+    }
+
+    if (timeout > 0) {
+        spi_write_blocking(SPI_PORT, header, 2);
+        spi_write_blocking(SPI_PORT, data, length);
     }
 
     gpio_put(DATA_READY_PIN, 0);
@@ -515,119 +655,11 @@ void reset_spi_interface() {
     }
 }
 
-// Process command queues with acknowledgment and retry handling
-void process_enhanced_queue(EnhancedCommandQueue* queue) {
-    // Max commands to process in one batch
-    const int MAX_BATCH = 10;
-    int processed = 0;
-
-    while (processed < MAX_BATCH) {
-        mutex_enter_blocking(&queue->lock);
-
-        // Check if queue is empty
-        if (queue->count == 0) {
-            mutex_exit(&queue->lock);
-            break;
-        }
-
-        // Get command from queue
-        EnhancedCommand* cmd = &queue->commands[queue->head];
-
-        // Check for retries of timed-out commands
-        if (cmd->requires_ack && !cmd->completed) {
-            uint32_t elapsed = time_ms_32() - cmd->timestamp;
-
-            if (elapsed > COMMAND_TIMEOUT_MS) {
-                // Command has timed out
-                if (cmd->retry_count < MAX_RETRIES) {
-                    // Retry the command
-                    cmd->retry_count++;
-                    cmd->timestamp = time_ms_32();
-
-                    // Prepare buffer for retrying
-                    uint8_t buffer[258];
-                    buffer[0] = cmd->command_id;
-                    buffer[1] = cmd->length;
-                    memcpy(&buffer[2], cmd->data, cmd->length - 2);
-
-                    mutex_exit(&queue->lock);
-
-                    // Log retry attempt
-                    if (debug_enabled) {
-                        printf("Retry %d for command 0x%02X\n", cmd->retry_count, cmd->command_id);
-                    }
-
-                    // Send command to appropriate device
-                    if (queue->device_id == 1) {
-                        gpio_put(GPU_CS_PIN, 0);
-                        spi_write_blocking(GPU_SPI_PORT, buffer, cmd->length);
-                        gpio_put(GPU_CS_PIN, 1);
-                    } else {
-                        gpio_put(APU_CS_PIN, 0);
-                        spi_write_blocking(APU_SPI_PORT, buffer, cmd->length);
-                        gpio_put(APU_CS_PIN, 1);
-                    }
-
-                    processed++;
-                    continue;
-                } else {
-                    // Max retries reached, mark as failed
-                    log_error("Command 0x%02X failed after %d retries",
-                             cmd->command_id, cmd->retry_count);
-
-                    // Move to next command
-                    queue->head = (queue->head + 1) % queue->capacity;
-                    queue->count--;
-
-                    if (cmd->requires_ack) {
-                        queue->pending_acks--;
-                    }
-
-                    mutex_exit(&queue->lock);
-                    continue;
-                }
-            }
-        }
-
-        // Only process completed or non-ack commands
-        if (cmd->completed || !cmd->requires_ack) {
-            // Prepare buffer for SPI transfer
-            uint8_t buffer[258];
-            buffer[0] = cmd->command_id;
-            buffer[1] = cmd->length;
-            memcpy(&buffer[2], cmd->data, cmd->length - 2);
-
-            // Move to next command
-            queue->head = (queue->head + 1) % queue->capacity;
-            queue->count--;
-
-            if (cmd->completed && cmd->requires_ack) {
-                queue->pending_acks--;
-            }
-
-            mutex_exit(&queue->lock);
-
-            // Send command to appropriate device
-            if (queue->device_id == 1) {
-                gpio_put(GPU_CS_PIN, 0);
-                spi_write_blocking(GPU_SPI_PORT, buffer, cmd->length);
-                gpio_put(GPU_CS_PIN, 1);
-            } else {
-                gpio_put(APU_CS_PIN, 0);
-                spi_write_blocking(APU_SPI_PORT, buffer, cmd->length);
-                gpio_put(APU_CS_PIN, 1);
-            }
-
-            processed++;
-        } else {
-            // Command requires acknowledgment but hasn't been completed yet
-            mutex_exit(&queue->lock);
-            break;
-        }
-    }
+// Command Processing System
+static inline uint32_t read_le32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
 }
 
-// Command Processing System
 void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
     switch (cmd_id) {
         // System Commands
@@ -637,6 +669,9 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             
         case CMD_RESET_AUDIO:
             reset_audio_system();
+            // The CPU restarts its numbering with the reset
+            seq_expected = 0;
+            seq_held_mask = 0;
             send_ack_to_cpu(CMD_RESET_AUDIO);
             break;
             
@@ -647,7 +682,19 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
         
         // Tracker Commands
         case CMD_TRACKER_LOAD:
-            load_tracker(data[0], (data[1] | (data[2] << 8)), &data[3]);
+            if (length < 3) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
+            load_tracker(data[0], (data[1] | (data[2] << 8)), &data[3], length - 3);
+            break;
+            
+        case CMD_TRACKER_LOAD_DATA:
+            if (length < 1) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
+            append_tracker_data(data[0], &data[1], length - 1);
             break;
             
         case CMD_TRACKER_PLAY:
@@ -666,9 +713,48 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             
         // Sample Commands
         case CMD_SAMPLE_LOAD:
+            if (length < 10) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
             load_sample(data[0], data[1], data[2] | (data[3] << 8), 
                       data[4] | (data[5] << 8), data[6] | (data[7] << 8),
-                      data[8] | (data[9] << 8), &data[10]);
+                      data[8] | (data[9] << 8), &data[10], length - 10);
+            break;
+            
+        case CMD_SAMPLE_LOAD_DATA:
+            if (length < 1) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
+            append_sample_data(data[0], &data[1], length - 1);
+            break;
+            
+        case CMD_SAMPLE_PLAY:
+            play_sample(data[0], data[1], data[2], data[3]);
+            break;
+            
+        case CMD_SAMPLE_STREAM_DEFINE:
+            define_sample_stream(data[0], data[1], data[2] | (data[3] << 8), data[4],
+                                 read_le32(&data[5]), read_le32(&data[9]),
+                                 read_le32(&data[13]), read_le32(&data[17]));
+            break;
+            
+        case CMD_SAMPLE_STREAM_DATA:
+            if (length < 5) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
+            push_sample_stream_data(data[0], read_le32(&data[1]), &data[5], length - 5);
+            break;
+            
+        case CMD_SAMPLE_MAP:
+            if (length < 20) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
+            map_sample(data[0], data[1], data[2] | (data[3] << 8), read_le32(&data[4]),
+                       read_le32(&data[8]), read_le32(&data[12]), read_le32(&data[16]));
             break;
             
         // Wavetable Commands
@@ -676,16 +762,51 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             define_wavetable(data[0], data[1], &data[2]);
             break;
             
+        case CMD_WAVE_MAP_TABLE:
+            map_wavetable(data[0], data[1] | (data[2] << 8), read_le32(&data[3]));
+            break;
+            
         // Effects Commands
         case CMD_EFFECT_SET_REVERB:
             configure_reverb(data[0], data[1], data[2]);
             break;
             
+        case CMD_EFFECT_CHANNEL_ROUTING:
+            configure_channel_routing(data[0], data[1]);
+            break;
+            
         // Memory Management
         case CMD_MEM_STATUS:
             send_memory_status();
             break;
             
+        case CMD_AUDIO_STATUS:
+            send_audio_status();
+            break;
+            
+        // Profiling and synchronization
+        case CMD_PROFILE_START:
+            start_profiling();
+            send_ack_to_cpu(CMD_PROFILE_START);
+            break;
+            
+        case CMD_PROFILE_STOP:
+            stop_profiling();
+            send_ack_to_cpu(CMD_PROFILE_STOP);
+            break;
+            
+        case CMD_PROFILE_READ:
+            send_trace_events(length > 0 ? data[0] : 0);
+            break;
+            
+        case CMD_CLOCK_SYNC:
+            if (length < 9) {
+                send_error(ERROR_INVALID_PARAMETER);
+                break;
+            }
+            process_clock_sync_command(data);
+            break;
+            
         default:
             // Unknown command
             send_error(ERROR_UNKNOWN_COMMAND);
@@ -693,7 +814,336 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
     }
 }
 
+// Command Reception
+// The CPU streams commands back to back under one CS assertion, so SPI RX is
+// drained by DMA into a ring (command_buffer_size bytes) and parsed from there
+// rather than with a blocking read per command. A 0xFF in the command ID
+// position is idle fill clocked in while the CPU reads a response and is
+// skipped.
+#define CMD_RX_FILL 0xFF
+#define CMD_RX_TIMEOUT_US 2000       // Drop a partial command after this long
+#define BATCH_HEADER_SIZE 4          // [CMD_BATCH][count][size_hi][size_lo]
+#define CMD_RX_DMA_COUNT 0x0FFFFFFF  // Fits the RP2350 count field as well
+
+uint8_t* cmd_rx_ring = NULL;
+uint32_t cmd_rx_size = 0;
+uint32_t cmd_rx_mask = 0;
+int cmd_rx_dma_channel = -1;
+volatile uint32_t cmd_rx_base = 0;   // Bytes received by completed DMA runs
+uint32_t cmd_rx_read_pos = 0;        // Free-running parse position
+uint32_t cmd_rx_stall_start = 0;
+
+typedef struct {
+    uint32_t commands;
+    uint32_t batches;
+    uint32_t overruns;
+    uint32_t timeouts;
+} CommandRxStats;
+
+CommandRxStats cmd_rx_stats;
+
+void cmd_rx_dma_irq_handler() {
+    if (dma_channel_get_irq1_status(cmd_rx_dma_channel)) {
+        dma_channel_acknowledge_irq1(cmd_rx_dma_channel);
+
+        // Re-arm straight away; the write address keeps wrapping in the ring
+        cmd_rx_base += CMD_RX_DMA_COUNT;
+        dma_channel_set_trans_count(cmd_rx_dma_channel, CMD_RX_DMA_COUNT, true);
+    }
+}
+
+// Allocate the receive ring and start SPI RX DMA into it
+bool init_command_rx(uint32_t size) {
+    // DMA address wrapping needs a power of two no larger than 32KB,
+    // aligned to its own size
+    uint32_t ring_bits = 0;
+    while ((2u << ring_bits) <= size && ring_bits < 15) {
+        ring_bits++;
+    }
+    cmd_rx_size = 1u << ring_bits;
+    cmd_rx_mask = cmd_rx_size - 1;
+
+    cmd_rx_ring = aligned_alloc(cmd_rx_size, cmd_rx_size);
+    if (cmd_rx_ring == NULL) {
+        return false;
+    }
+
+    cmd_rx_base = 0;
+    cmd_rx_read_pos = 0;
+    memset(&cmd_rx_stats, 0, sizeof(cmd_rx_stats));
+
+    cmd_rx_dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(cmd_rx_dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, ring_bits);
+    channel_config_set_dreq(&config, spi_get_dreq(SPI_PORT, false));
+
+    dma_channel_set_irq1_enabled(cmd_rx_dma_channel, true);
+    irq_set_exclusive_handler(DMA_IRQ_1, cmd_rx_dma_irq_handler);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_configure(cmd_rx_dma_channel, &config, cmd_rx_ring,
+                          &spi_get_hw(SPI_PORT)->dr, CMD_RX_DMA_COUNT, true);
+    return true;
+}
+
+// Free-running count of bytes DMA has written into the ring
+static inline uint32_t cmd_rx_write_pos() {
+    uint32_t base, remaining;
+    do {
+        base = cmd_rx_base;
+        remaining = dma_hw->ch[cmd_rx_dma_channel].transfer_count;
+    } while (base != cmd_rx_base);
+    return base + (CMD_RX_DMA_COUNT - remaining);
+}
+
+static inline uint8_t cmd_rx_peek(uint32_t offset) {
+    return cmd_rx_ring[(cmd_rx_read_pos + offset) & cmd_rx_mask];
+}
+
+// Pointer to count bytes at offset, copied into scratch only if they wrap
+const uint8_t* cmd_rx_span(uint32_t offset, uint32_t count, uint8_t* scratch) {
+    uint32_t start = (cmd_rx_read_pos + offset) & cmd_rx_mask;
+    if (start + count <= cmd_rx_size) {
+        return &cmd_rx_ring[start];
+    }
+
+    uint32_t first = cmd_rx_size - start;
+    memcpy(scratch, &cmd_rx_ring[start], first);
+    memcpy(scratch + first, cmd_rx_ring, count - first);
+    return scratch;
+}
+
+// Run every sub-command of a batch with ACKs held back, then answer once
+void dispatch_command_batch(uint8_t count, uint16_t size) {
+    uint32_t offset = BATCH_HEADER_SIZE;
+    uint32_t end = BATCH_HEADER_SIZE + size;
+
+    batch_active = true;
+    batch_error_cmd = CMD_BATCH;
+    batch_error_code = ERR_NONE;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (offset + 2 > end) {
+            break;
+        }
+
+        uint8_t cmd_id = cmd_rx_peek(offset);
+        uint8_t length = cmd_rx_peek(offset + 1);
+
+        if (length < 2 || offset + length > end || cmd_id == CMD_BATCH) {
+            // Malformed sub-command - the rest of the batch can't be trusted
+            if (batch_error_code == ERR_NONE) {
+                batch_error_cmd = cmd_id;
+                batch_error_code = ERR_INVALID_DATA;
+            }
+            break;
+        }
+
+        const uint8_t* data = cmd_rx_span(offset + 2, length - 2, cmd_buffer);
+        trace_begin(ZONE_APU_COMMAND, cmd_id);
+        process_command(cmd_id, data, length - 2);
+        trace_end(ZONE_APU_COMMAND, cmd_id);
+        cmd_rx_stats.commands++;
+        offset += length;
+    }
+
+    batch_active = false;
+    cmd_rx_stats.batches++;
+
+    if (batch_error_code == ERR_NONE) {
+        send_ack_to_cpu(CMD_BATCH);
+    } else {
+        send_error_to_cpu(batch_error_cmd, batch_error_code);
+    }
+}
+
+// Sequenced commands: [CMD_SEQUENCED][seq] followed by one whole command.
+// They run in sequence order; one that arrives ahead of a gap is held until
+// the gap is resent, a repeat of one that already ran is dropped, and one
+// far outside the window means the CPU restarted its numbering. Instead of
+// an ACK each, the sequence state goes out once the receive ring has been
+// drained, or with the next ACK or error sent anyway.
+#define SEQ_HEADER_SIZE 2
+
+uint8_t seq_held_data[SEQ_WINDOW][256];  // Held commands from their ID byte on
+
+// Run one sequenced command with its ACK folded into the sequence state
+void run_sequenced_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
+    batch_active = true;
+    batch_error_cmd = cmd_id;
+    batch_error_code = ERR_NONE;
+
+    trace_begin(ZONE_APU_COMMAND, cmd_id);
+    process_command(cmd_id, data, length - 2);
+    trace_end(ZONE_APU_COMMAND, cmd_id);
+    cmd_rx_stats.commands++;
+
+    batch_active = false;
+    seq_expected++;
+    seq_held_mask >>= 1;
+
+    if (batch_error_code == ERR_NONE) {
+        seq_ack_pending = true;
+    } else {
+        send_error_to_cpu(batch_error_cmd, batch_error_code);
+    }
+}
+
+void dispatch_sequenced_command(uint8_t seq, uint8_t cmd_id, uint8_t length) {
+    uint8_t ahead = seq - seq_expected;
+
+    if (ahead >= SEQ_WINDOW) {
+        if (ahead >= (uint8_t)(256 - 2 * SEQ_WINDOW)) {
+            // Ran already; the CPU missed the ACK
+            seq_ack_pending = true;
+            return;
+        }
+
+        // Numbering restarted - follow it
+        seq_expected = seq;
+        seq_held_mask = 0;
+        ahead = 0;
+    }
+
+    if (ahead > 0) {
+        uint8_t* held = seq_held_data[seq % SEQ_WINDOW];
+        held[0] = cmd_id;
+        held[1] = length;
+        for (uint8_t i = 2; i < length; i++) {
+            held[i] = cmd_rx_peek(SEQ_HEADER_SIZE + i);
+        }
+        seq_held_mask |= 1 << ahead;
+        seq_ack_pending = true;
+        return;
+    }
+
+    seq_held_mask |= 1;
+    const uint8_t* data = cmd_rx_span(SEQ_HEADER_SIZE + 2, length - 2, cmd_buffer);
+    run_sequenced_command(cmd_id, data, length);
+
+    // The gap is closed - run what was held behind it
+    while (seq_held_mask & 1) {
+        const uint8_t* held = seq_held_data[seq_expected % SEQ_WINDOW];
+        run_sequenced_command(held[0], held + 2, held[1]);
+    }
+}
+
+// Parse and dispatch every complete command waiting in the receive ring.
+// Returns the number of commands (or batches) dispatched.
+uint32_t process_received_commands() {
+    uint32_t dispatched = 0;
+
+    while (true) {
+        uint32_t available = cmd_rx_write_pos() - cmd_rx_read_pos;
+
+        if (available > cmd_rx_size) {
+            // The CPU outran us and DMA lapped the parser - resynchronise
+            cmd_rx_stats.overruns++;
+            cmd_rx_read_pos = cmd_rx_write_pos();
+            send_error_to_cpu(0, ERR_COMMUNICATION_FAILURE);
+            break;
+        }
+
+        if (available == 0) {
+            break;
+        }
+
+        uint8_t cmd_id = cmd_rx_peek(0);
+        if (cmd_id == CMD_RX_FILL) {
+            cmd_rx_read_pos++;
+            continue;
+        }
+
+        uint32_t needed = 2;
+        if (available >= 2) {
+            if (cmd_id == CMD_SEQUENCED) {
+                needed = SEQ_HEADER_SIZE + 2;
+                if (available >= SEQ_HEADER_SIZE + 2) {
+                    uint8_t inner_id = cmd_rx_peek(SEQ_HEADER_SIZE);
+                    uint8_t inner_length = cmd_rx_peek(SEQ_HEADER_SIZE + 1);
+                    if (inner_length < 2 || inner_id == CMD_BATCH || inner_id == CMD_SEQUENCED) {
+                        // Not a valid wrapped command - drop a byte and look again
+                        send_error_to_cpu(CMD_SEQUENCED, ERR_INVALID_DATA);
+                        cmd_rx_read_pos++;
+                        continue;
+                    }
+                    needed = SEQ_HEADER_SIZE + inner_length;
+                }
+            } else if (cmd_id == CMD_BATCH) {
+                needed = BATCH_HEADER_SIZE;
+                if (available >= BATCH_HEADER_SIZE) {
+                    uint16_t size = (cmd_rx_peek(2) << 8) | cmd_rx_peek(3);
+                    if (BATCH_HEADER_SIZE + size > cmd_rx_size) {
+                        // Can never fit in the ring - skip the header byte
+                        send_error_to_cpu(CMD_BATCH, ERR_INVALID_PARAMETER);
+                        cmd_rx_read_pos++;
+                        continue;
+                    }
+                    needed = BATCH_HEADER_SIZE + size;
+                }
+            } else {
+                needed = cmd_rx_peek(1);
+                if (needed < 2) {
+                    // Not a valid header - drop a byte and look again
+                    cmd_rx_read_pos++;
+                    continue;
+                }
+            }
+        }
+
+        if (available < needed) {
+            // Wait for the rest, but don't hang on a transfer the CPU abandoned
+            if (cmd_rx_stall_start == 0) {
+                cmd_rx_stall_start = time_us_32() | 1;
+            } else if (time_us_32() - cmd_rx_stall_start > CMD_RX_TIMEOUT_US) {
+                cmd_rx_stats.timeouts++;
+                cmd_rx_read_pos += available;
+                cmd_rx_stall_start = 0;
+                send_error_to_cpu(cmd_id, ERR_TIMEOUT);
+            }
+            break;
+        }
+        cmd_rx_stall_start = 0;
+
+        if (cmd_id == CMD_SEQUENCED) {
+            dispatch_sequenced_command(cmd_rx_peek(1), cmd_rx_peek(SEQ_HEADER_SIZE),
+                                       needed - SEQ_HEADER_SIZE);
+        } else if (cmd_id == CMD_BATCH) {
+            trace_begin(ZONE_APU_COMMAND, CMD_BATCH);
+            dispatch_command_batch(cmd_rx_peek(1), needed - BATCH_HEADER_SIZE);
+            trace_end(ZONE_APU_COMMAND, CMD_BATCH);
+        } else {
+            const uint8_t* data = cmd_rx_span(2, needed - 2, cmd_buffer);
+            trace_begin(ZONE_APU_COMMAND, cmd_id);
+            process_command(cmd_id, data, needed - 2);
+            trace_end(ZONE_APU_COMMAND, cmd_id);
+            cmd_rx_stats.commands++;
+        }
+
+        cmd_rx_read_pos += needed;
+        dispatched++;
+
+        // Don't hold core 1's render up for the rest of a long queue
+        service_voice_job(0);
+    }
+
+    // One cumulative ACK for every sequenced command handled in this pass
+    if (seq_ack_pending) {
+        send_ack_to_cpu(CMD_SEQUENCED);
+    }
+
+    return dispatched;
+}
+
+
 // FM Synthesis definitions
+#define FM_CONTROL_RATE 32      // Samples per envelope step
+#define FM_MOD_SHIFT 16         // Full-scale modulator swings the carrier phase by +/-pi
+#define FM_ENV_MAX 32767
+
 typedef struct {
     uint8_t attack_rate;
     uint8_t decay_rate;
@@ -709,6 +1159,10 @@ typedef struct {
     uint8_t envelope_state;  // 0=off, 1=attack, 2=decay, 3=sustain, 4=release
     uint32_t phase;
     float output;
+
+    // Fixed-point engine state
+    uint32_t phase_inc;      // Includes multiple and detune
+    int32_t env_q15;         // Envelope level at the end of the last control step
 } FMOperator;
 
 typedef struct {
@@ -719,10 +1173,32 @@ typedef struct {
     // Feedback history
     float op1_prev1;
     float op1_prev2;
+
+    // Fixed-point engine state
+    float cached_frequency;  // Frequency the phase increments were computed for
+    int32_t fb_prev1;
+    int32_t fb_prev2;
 } FMChannel;
 
 FMChannel fm_channels[MAX_CHANNELS];
 
+// Use the float engine instead of the fixed-point one (RP2350 high quality)
+bool use_float_fm = false;
+
+// Per-control-step envelope coefficients in Q15: (1 - rate/31)^FM_CONTROL_RATE,
+// so envelopes keep the timing of the original per-sample update
+int32_t fm_env_coeff[32];
+
+void init_fm_tables() {
+    for (int rate = 0; rate < 32; rate++) {
+        int64_t k = ((31 - rate) * 32768) / 31;
+        for (int i = 1; i < FM_CONTROL_RATE; i <<= 1) {
+            k = (k * k) >> 15;
+        }
+        fm_env_coeff[rate] = (int32_t)k;
+    }
+}
+
 void init_fm_channel(uint8_t channel_id, uint8_t algorithm) {
     if (channel_id >= MAX_CHANNELS) return;
     
@@ -731,8 +1207,9 @@ void init_fm_channel(uint8_t channel_id, uint8_t algorithm) {
     channels[channel_id].active = false;
     
     // Initialize FM parameters
-    fm_channels[channel_id].algorithm = algorithm;
+    fm_channels[channel_id].algorithm = algorithm & 7;
     fm_channels[channel_id].feedback = 0;
+    fm_channels[channel_id].cached_frequency = -1.0f;
     
     // Reset all operators
     for (int i = 0; i < 4; i++) {
@@ -753,21 +1230,350 @@ void init_fm_channel(uint8_t channel_id, uint8_t algorithm) {
         op->envelope_level = 0;
         op->envelope_state = 0;
         op->enabled = true;
+        op->phase_inc = 0;
+        op->env_q15 = 0;
     }
     
     // Reset feedback
     fm_channels[channel_id].op1_prev1 = 0;
     fm_channels[channel_id].op1_prev2 = 0;
+    fm_channels[channel_id].fb_prev1 = 0;
+    fm_channels[channel_id].fb_prev2 = 0;
 }
 
-float compute_operator_output(uint8_t channel_id, uint8_t op_id, uint32_t phase_inc, float modulation) {
-    FMOperator* op = &fm_channels[channel_id].operators[op_id];
-    
-    if (!op->enabled || op->envelope_state == 0) {
-        return 0.0f;
+// Recompute operator phase increments; only needed when the note, multiple
+// or detune changes
+void update_fm_phase_increments(uint8_t channel_id) {
+    FMChannel* fm = &fm_channels[channel_id];
+    float base_inc = channels[channel_id].frequency * 4294967296.0f / SAMPLE_RATE;
+
+    for (int i = 0; i < 4; i++) {
+        FMOperator* op = &fm->operators[i];
+        op->phase_inc = (uint32_t)(base_inc * op->multiple * (1.0f + op->detune * 0.01f));
     }
-    
-    // Apply frequency multiple and detune
+
+    fm->cached_frequency = channels[channel_id].frequency;
+}
+
+// Advance one operator's envelope by a control step and return the new level
+int32_t advance_fm_envelope(FMOperator* op) {
+    int32_t level = op->env_q15;
+    int32_t sustain = (op->sustain_level * FM_ENV_MAX) / 31;
+
+    switch (op->envelope_state) {
+        case 1: // Attack
+            level = FM_ENV_MAX - (((FM_ENV_MAX - level) * fm_env_coeff[op->attack_rate & 31]) >> 15);
+            if (level >= (FM_ENV_MAX * 99) / 100) {
+                level = FM_ENV_MAX;
+                op->envelope_state = 2; // Move to decay
+            }
+            break;
+
+        case 2: // Decay
+            level = sustain + (((level - sustain) * fm_env_coeff[op->decay_rate & 31]) >> 15);
+            if (level <= sustain + FM_ENV_MAX / 100) {
+                level = sustain;
+                op->envelope_state = 3; // Move to sustain
+            }
+            break;
+
+        case 3: // Sustain
+            break;
+
+        case 4: // Release
+            level = (level * fm_env_coeff[op->release_rate & 31]) >> 15;
+            if (level < FM_ENV_MAX / 1000) {
+                level = 0;
+                op->envelope_state = 0; // Note off
+            }
+            break;
+
+        default:
+            level = 0;
+            break;
+    }
+
+    op->env_q15 = level;
+    return level;
+}
+
+static inline __attribute__((always_inline))
+int32_t fm_wave(uint32_t phase, const uint8_t waveform) {
+    switch (waveform) {
+        case 0: // Sine
+            return sine_table[phase >> 24];
+        case 1: // Square
+            return (phase & 0x80000000u) ? 32767 : -32767;
+        case 2: // Sawtooth
+            return (int32_t)(phase >> 16) - 32768;
+        default: // Triangle
+            {
+                int32_t p = phase >> 16;
+                return (p < 32768) ? p * 2 - 32768 : 98303 - p * 2;
+            }
+    }
+}
+
+// Generic operator kernel: renders count samples with a linear envelope ramp.
+// The waveform and routing flags are constants in every instantiation below,
+// so each variant compiles to a branch-free loop.
+static inline __attribute__((always_inline))
+void fm_operator_kernel(FMOperator* op, const int32_t* mod, int32_t* out, uint32_t count,
+                        int32_t env, int32_t env_step,
+                        const uint8_t waveform, const bool modulated, const bool accumulate) {
+    uint32_t phase = op->phase;
+    uint32_t inc = op->phase_inc;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t p = modulated ? phase + ((uint32_t)mod[i] << FM_MOD_SHIFT) : phase;
+        int32_t value = (fm_wave(p, waveform) * env) >> 15;
+
+        if (accumulate) {
+            out[i] += value;
+        } else {
+            out[i] = value;
+        }
+
+        phase += inc;
+        env += env_step;
+    }
+
+    op->phase = phase;
+}
+
+typedef void (*FMOperatorKernel)(FMOperator* op, const int32_t* mod, int32_t* out, uint32_t count,
+                                 int32_t env, int32_t env_step);
+
+#define DEFINE_FM_KERNEL(name, wave, mod, acc) \
+    void name(FMOperator* op, const int32_t* m, int32_t* out, uint32_t count, int32_t env, int32_t env_step) { \
+        fm_operator_kernel(op, m, out, count, env, env_step, wave, mod, acc); \
+    }
+
+DEFINE_FM_KERNEL(fm_op_sine,         0, false, false)
+DEFINE_FM_KERNEL(fm_op_sine_acc,     0, false, true)
+DEFINE_FM_KERNEL(fm_op_sine_mod,     0, true,  false)
+DEFINE_FM_KERNEL(fm_op_sine_mod_acc, 0, true,  true)
+DEFINE_FM_KERNEL(fm_op_square,         1, false, false)
+DEFINE_FM_KERNEL(fm_op_square_acc,     1, false, true)
+DEFINE_FM_KERNEL(fm_op_square_mod,     1, true,  false)
+DEFINE_FM_KERNEL(fm_op_square_mod_acc, 1, true,  true)
+DEFINE_FM_KERNEL(fm_op_saw,         2, false, false)
+DEFINE_FM_KERNEL(fm_op_saw_acc,     2, false, true)
+DEFINE_FM_KERNEL(fm_op_saw_mod,     2, true,  false)
+DEFINE_FM_KERNEL(fm_op_saw_mod_acc, 2, true,  true)
+DEFINE_FM_KERNEL(fm_op_triangle,         3, false, false)
+DEFINE_FM_KERNEL(fm_op_triangle_acc,     3, false, true)
+DEFINE_FM_KERNEL(fm_op_triangle_mod,     3, true,  false)
+DEFINE_FM_KERNEL(fm_op_triangle_mod_acc, 3, true,  true)
+
+// Indexed [waveform][modulated][accumulate]
+FMOperatorKernel fm_kernels[4][2][2] = {
+    {{fm_op_sine, fm_op_sine_acc}, {fm_op_sine_mod, fm_op_sine_mod_acc}},
+    {{fm_op_square, fm_op_square_acc}, {fm_op_square_mod, fm_op_square_mod_acc}},
+    {{fm_op_saw, fm_op_saw_acc}, {fm_op_saw_mod, fm_op_saw_mod_acc}},
+    {{fm_op_triangle, fm_op_triangle_acc}, {fm_op_triangle_mod, fm_op_triangle_mod_acc}}
+};
+
+// Run one operator over a sub-block: mod may be NULL, out is overwritten or
+// accumulated into
+static inline void fm_run_operator(FMOperator* op, const int32_t* mod, int32_t* out,
+                                   uint32_t count, bool accumulate) {
+    int32_t env_start = op->env_q15;
+    int32_t env_end = advance_fm_envelope(op);
+
+    if (!op->enabled || (env_start == 0 && env_end == 0)) {
+        // Silent operator - keep its phase running so it stays coherent
+        op->phase += op->phase_inc * count;
+        if (!accumulate) {
+            memset(out, 0, count * sizeof(int32_t));
+        }
+        return;
+    }
+
+    int32_t env_step = (env_end - env_start) / (int32_t)count;
+    fm_kernels[op->waveform & 3][mod != NULL][accumulate](op, mod, out, count, env_start, env_step);
+}
+
+// Operator 1 with self-feedback. The recursion through the last two outputs
+// keeps this one sample at a time, but the waveform is still resolved at
+// compile time.
+static inline __attribute__((always_inline))
+void fm_feedback_kernel(FMChannel* fm, int32_t* out, uint32_t count,
+                        int32_t env, int32_t env_step, const uint8_t waveform) {
+    FMOperator* op = &fm->operators[0];
+    uint32_t phase = op->phase;
+    uint32_t inc = op->phase_inc;
+    int32_t prev1 = fm->fb_prev1;
+    int32_t prev2 = fm->fb_prev2;
+    int32_t feedback = fm->feedback;
+
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t fb = ((prev1 + prev2) * feedback) / 100;
+        int32_t value = (fm_wave(phase + ((uint32_t)fb << FM_MOD_SHIFT), waveform) * env) >> 15;
+
+        out[i] = value;
+        prev2 = prev1;
+        prev1 = value;
+        phase += inc;
+        env += env_step;
+    }
+
+    op->phase = phase;
+    fm->fb_prev1 = prev1;
+    fm->fb_prev2 = prev2;
+}
+
+typedef void (*FMFeedbackKernel)(FMChannel* fm, int32_t* out, uint32_t count, int32_t env, int32_t env_step);
+
+#define DEFINE_FM_FEEDBACK_KERNEL(name, wave) \
+    void name(FMChannel* fm, int32_t* out, uint32_t count, int32_t env, int32_t env_step) { \
+        fm_feedback_kernel(fm, out, count, env, env_step, wave); \
+    }
+
+DEFINE_FM_FEEDBACK_KERNEL(fm_fb_sine, 0)
+DEFINE_FM_FEEDBACK_KERNEL(fm_fb_square, 1)
+DEFINE_FM_FEEDBACK_KERNEL(fm_fb_saw, 2)
+DEFINE_FM_FEEDBACK_KERNEL(fm_fb_triangle, 3)
+
+FMFeedbackKernel fm_feedback_kernels[4] = {
+    fm_fb_sine, fm_fb_square, fm_fb_saw, fm_fb_triangle
+};
+
+void fm_run_feedback_operator(FMChannel* fm, int32_t* out, uint32_t count) {
+    FMOperator* op = &fm->operators[0];
+
+    if (fm->feedback == 0) {
+        fm_run_operator(op, NULL, out, count, false);
+        return;
+    }
+
+    int32_t env_start = op->env_q15;
+    int32_t env_end = advance_fm_envelope(op);
+
+    if (!op->enabled || (env_start == 0 && env_end == 0)) {
+        op->phase += op->phase_inc * count;
+        fm->fb_prev1 = 0;
+        fm->fb_prev2 = 0;
+        memset(out, 0, count * sizeof(int32_t));
+        return;
+    }
+
+    int32_t env_step = (env_end - env_start) / (int32_t)count;
+    fm_feedback_kernels[op->waveform & 3](fm, out, count, env_start, env_step);
+}
+
+// Generic algorithm body; algorithm is a constant in each instantiation
+static inline __attribute__((always_inline))
+void fm_render_algorithm(FMChannel* fm, int32_t* out, uint32_t count, const uint8_t algorithm) {
+    int32_t a[FM_CONTROL_RATE];
+    int32_t b[FM_CONTROL_RATE];
+    FMOperator* op = fm->operators;
+
+    switch (algorithm) {
+        case 0: // Serial 1->2->3->4
+            fm_run_feedback_operator(fm, a, count);
+            fm_run_operator(&op[1], a, b, count, false);
+            fm_run_operator(&op[2], b, a, count, false);
+            fm_run_operator(&op[3], a, out, count, false);
+            break;
+
+        case 1: // 1->2->4, 3->4
+            fm_run_feedback_operator(fm, a, count);
+            fm_run_operator(&op[1], a, b, count, false);
+            fm_run_operator(&op[2], NULL, b, count, true);
+            fm_run_operator(&op[3], b, out, count, false);
+            break;
+
+        case 2: // 1->4, 2->3->4
+            fm_run_operator(&op[1], NULL, a, count, false);
+            fm_run_operator(&op[2], a, b, count, false);
+            fm_run_feedback_operator(fm, a, count);
+            for (uint32_t i = 0; i < count; i++) b[i] += a[i];
+            fm_run_operator(&op[3], b, out, count, false);
+            break;
+
+        case 3: // (1 + 2)->3->4
+            fm_run_feedback_operator(fm, a, count);
+            fm_run_operator(&op[1], NULL, a, count, true);
+            fm_run_operator(&op[2], a, b, count, false);
+            fm_run_operator(&op[3], b, out, count, false);
+            break;
+
+        case 4: // 1->2, 3->4
+            fm_run_feedback_operator(fm, a, count);
+            fm_run_operator(&op[1], a, out, count, false);
+            fm_run_operator(&op[2], NULL, b, count, false);
+            fm_run_operator(&op[3], b, out, count, true);
+            break;
+
+        case 5: // 1->2, 1->3, 1->4
+            fm_run_feedback_operator(fm, a, count);
+            fm_run_operator(&op[1], a, out, count, false);
+            fm_run_operator(&op[2], a, out, count, true);
+            fm_run_operator(&op[3], a, out, count, true);
+            break;
+
+        case 6: // 1->2, 3, 4
+            fm_run_feedback_operator(fm, a, count);
+            fm_run_operator(&op[1], a, out, count, false);
+            fm_run_operator(&op[2], NULL, out, count, true);
+            fm_run_operator(&op[3], NULL, out, count, true);
+            break;
+
+        default: // 1 with feedback, 2,3,4 independent
+            fm_run_feedback_operator(fm, out, count);
+            fm_run_operator(&op[1], NULL, out, count, true);
+            fm_run_operator(&op[2], NULL, out, count, true);
+            fm_run_operator(&op[3], NULL, out, count, true);
+            break;
+    }
+}
+
+typedef void (*FMAlgorithmRenderer)(FMChannel* fm, int32_t* out, uint32_t count);
+
+#define DEFINE_FM_ALGORITHM(n) \
+    void fm_render_algorithm_##n(FMChannel* fm, int32_t* out, uint32_t count) { \
+        fm_render_algorithm(fm, out, count, n); \
+    }
+
+DEFINE_FM_ALGORITHM(0)
+DEFINE_FM_ALGORITHM(1)
+DEFINE_FM_ALGORITHM(2)
+DEFINE_FM_ALGORITHM(3)
+DEFINE_FM_ALGORITHM(4)
+DEFINE_FM_ALGORITHM(5)
+DEFINE_FM_ALGORITHM(6)
+DEFINE_FM_ALGORITHM(7)
+
+FMAlgorithmRenderer fm_algorithms[8] = {
+    fm_render_algorithm_0, fm_render_algorithm_1, fm_render_algorithm_2, fm_render_algorithm_3,
+    fm_render_algorithm_4, fm_render_algorithm_5, fm_render_algorithm_6, fm_render_algorithm_7
+};
+
+// Fixed-point block renderer. Operators run a control-rate sub-block at a
+// time with envelopes ramped across it; the channel output is Q15.
+void render_fm_channel_fixed(uint8_t channel_id, int32_t* out, uint32_t sample_count) {
+    FMChannel* fm = &fm_channels[channel_id];
+
+    if (fm->cached_frequency != channels[channel_id].frequency) {
+        update_fm_phase_increments(channel_id);
+    }
+
+    FMAlgorithmRenderer render = fm_algorithms[fm->algorithm & 7];
+    for (uint32_t pos = 0; pos < sample_count; pos += FM_CONTROL_RATE) {
+        uint32_t count = MIN(FM_CONTROL_RATE, sample_count - pos);
+        render(fm, &out[pos], count);
+    }
+}
+
+float compute_operator_output(uint8_t channel_id, uint8_t op_id, uint32_t phase_inc, float modulation) {
+    FMOperator* op = &fm_channels[channel_id].operators[op_id];
+    
+    if (!op->enabled || op->envelope_state == 0) {
+        return 0.0f;
+    }
+    
+    // Apply frequency multiple and detune
     uint32_t adjusted_phase_inc = phase_inc * op->multiple;
     
     // Add detune
@@ -816,15 +1622,14 @@ float compute_operator_output(uint8_t channel_id, uint8_t op_id, uint32_t phase_
     return value;
 }
 
-void render_fm_channel(uint8_t channel_id, float* buffer, uint32_t sample_count) {
+// Float reference engine, kept as the RP2350 high-quality path
+void render_fm_channel_float(uint8_t channel_id, float* out, uint32_t sample_count) {
     FMChannel* fm = &fm_channels[channel_id];
     Channel* ch = &channels[channel_id];
     
     if (!ch->active) return;
     
     uint32_t phase_inc = (uint32_t)(ch->frequency * 4294967296.0f / SAMPLE_RATE);
-    float vol_left = ch->volume * (255 - ch->pan) / 65025.0f;
-    float vol_right = ch->volume * ch->pan / 65025.0f;
     
     for (uint32_t i = 0; i < sample_count; i++) {
         float output = 0.0f;
@@ -872,10 +1677,46 @@ void render_fm_channel(uint8_t channel_id, float* buffer, uint32_t sample_count)
                 break;
         }
         
-        // Add to stereo mix buffer
-        buffer[i*2] += output * vol_left;
-        buffer[i*2+1] += output * vol_right;
+        out[i] = output;
+    }
+}
+
+// Voice renderers write the dry, unpanned voice into planar scratch and
+// return how many planes they filled: 1 (mono, left only), 2 (stereo) or 0
+// (silent). Volume, pan, filter and sends are applied by the voice strip.
+uint8_t render_fm_channel(uint8_t channel_id, float* left, float* right, uint32_t sample_count) {
+    Channel* ch = &channels[channel_id];
+    (void)right;  // FM voices are mono
+    
+    if (!ch->active) return 0;
+
+    if (use_float_fm) {
+        render_fm_channel_float(channel_id, left, sample_count);
+        return 1;
+    }
+
+    // Both cores render voices, so each gets its own scratch block
+    static int32_t fm_blocks[2][AUDIO_BUFFER_SIZE];
+    int32_t* fm_block = fm_blocks[get_core_num()];
+
+    for (uint32_t pos = 0; pos < sample_count; pos += AUDIO_BUFFER_SIZE) {
+        uint32_t count = MIN(AUDIO_BUFFER_SIZE, sample_count - pos);
+        render_fm_channel_fixed(channel_id, fm_block, count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            left[pos + i] = fm_block[i] * (1.0f / 32768.0f);
+        }
     }
+    return 1;
+}
+
+// Fixed mixing bus: the operator engine already produces a Q15 mono block
+uint8_t render_fm_channel_q15(uint8_t channel_id, int32_t* left, int32_t* right, uint32_t sample_count) {
+    (void)right;  // FM voices are mono
+    if (!channels[channel_id].active) return 0;
+
+    render_fm_channel_fixed(channel_id, left, sample_count);
+    return 1;
 }
 
 // Sample Playback Engine
@@ -884,11 +1725,18 @@ typedef struct {
     uint8_t* data;
     uint32_t size;
     uint16_t sample_rate;
-    uint16_t loop_start;
-    uint16_t loop_end;
+    uint32_t loop_start;  // Frames
+    uint32_t loop_end;
     bool is_16bit;
     bool is_stereo;
     uint8_t bytes_per_sample;
+    uint32_t received;       // Bytes that have arrived; loaded once all are in
+    bool in_flash;           // data points into the asset pack (SAMPLE_MAP), not the heap
+    
+    // Streaming samples: data stays at the source, size is the clip length
+    bool streaming;
+    uint8_t stream_source;   // STREAM_SOURCE_FLASH / STREAM_SOURCE_CPU
+    uint32_t stream_offset;  // Flash offset of the clip
 } Sample;
 
 typedef struct {
@@ -896,22 +1744,28 @@ typedef struct {
     uint32_t position;
     float position_frac;
     float step;
+    uint32_t frac_fixed;  // 16.16 stepping for the fixed mixing bus
+    uint32_t step_fixed;
     float pitch_ratio;
     uint8_t loop_mode; // 0=none, 1=forward, 2=ping-pong
     int8_t direction;  // 1=forward, -1=reverse (for ping-pong)
+    int8_t stream_id;  // Prefetch ring for streaming samples, -1 if resident
 } SampleChannel;
 
 Sample samples[MAX_SAMPLES];
 SampleChannel sample_channels[MAX_CHANNELS];
 
 void load_sample(uint8_t sample_id, uint8_t format, uint16_t sample_rate, 
-                uint16_t loop_start, uint16_t loop_end, uint16_t size, const uint8_t* data) {
-    if (sample_id >= MAX_SAMPLES) return;
+                uint16_t loop_start, uint16_t loop_end, uint16_t size, const uint8_t* data,
+                uint16_t length) {
+    if (sample_id >= MAX_SAMPLES || length > size) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
     
     // Free previous sample if it exists
-    if (samples[sample_id].data != NULL) {
-        free(samples[sample_id].data);
-    }
+    samples[sample_id].loaded = false;
+    release_sample_data(sample_id);
     
     // Parse format flags
     bool is_16bit = (format & 1);
@@ -924,10 +1778,14 @@ void load_sample(uint8_t sample_id, uint8_t format, uint16_t sample_rate,
         return;
     }
     
-    memcpy(sample_memory, data, size);
+    // Anything past this frame follows in SAMPLE_LOAD_DATA
+    memcpy(sample_memory, data, length);
+    samples[sample_id].received = length;
     
     // Initialize sample
-    samples[sample_id].loaded = true;
+    samples[sample_id].loaded = (length == size);
+    samples[sample_id].streaming = false;
+    samples[sample_id].in_flash = false;
     samples[sample_id].data = sample_memory;
     samples[sample_id].size = size;
     samples[sample_id].sample_rate = sample_rate;
@@ -940,11 +1798,565 @@ void load_sample(uint8_t sample_id, uint8_t format, uint16_t sample_rate,
     send_ack_to_cpu(CMD_SAMPLE_LOAD);
 }
 
+void append_sample_data(uint8_t sample_id, const uint8_t* data, uint16_t length) {
+    if (sample_id >= MAX_SAMPLES || samples[sample_id].data == NULL ||
+        samples[sample_id].streaming || samples[sample_id].in_flash ||
+        samples[sample_id].received + length > samples[sample_id].size) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    memcpy(samples[sample_id].data + samples[sample_id].received, data, length);
+    samples[sample_id].received += length;
+    samples[sample_id].loaded = (samples[sample_id].received == samples[sample_id].size);
+    
+    send_ack_to_cpu(CMD_SAMPLE_LOAD_DATA);
+}
+
+// Cartridge asset pack
+// Samples and wavetables can be written to the APU's own flash as an asset
+// pack and played in place through XIP, so the CPU only sends a descriptor
+// (SAMPLE_MAP, WAVE_MAP_TABLE) and sample RAM is left for data that is loaded
+// at run time. Playback reads go through the XIP cache, which suits short,
+// frequently used clips; long ones are better off with SAMPLE_STREAM_DEFINE.
+// Pack header: [magic:4] [version:2] [entryCount:2] [packSize:4], little-endian.
+#define ASSET_PACK_FLASH_OFFSET 0x100000   // Past the firmware image
+#define ASSET_PACK_MAGIC 0x50414254        // "TBAP"
+
+const uint8_t* asset_pack = NULL;
+uint32_t asset_pack_size = 0;
+
+void init_asset_pack() {
+    const uint8_t* pack = (const uint8_t*)(XIP_BASE + ASSET_PACK_FLASH_OFFSET);
+    
+    if (read_le32(pack) == ASSET_PACK_MAGIC) {
+        asset_pack = pack;
+        asset_pack_size = read_le32(&pack[8]);
+        printf("Asset pack found: %lu bytes\n", asset_pack_size);
+    } else {
+        asset_pack = NULL;
+        asset_pack_size = 0;
+    }
+}
+
+// Pack data at offset, or NULL if the range isn't inside the pack
+static const uint8_t* asset_pack_data(uint32_t offset, uint32_t size) {
+    if (asset_pack == NULL || (offset & 3) != 0 ||
+        offset > asset_pack_size || size > asset_pack_size - offset) {
+        return NULL;
+    }
+    return asset_pack + offset;
+}
+
+// Drop a sample's resident data (pack data is just forgotten)
+static void release_sample_data(uint8_t sample_id) {
+    if (samples[sample_id].data != NULL && !samples[sample_id].in_flash) {
+        free(samples[sample_id].data);
+    }
+    samples[sample_id].data = NULL;
+    samples[sample_id].in_flash = false;
+}
+
+// Streaming samples
+// A streaming sample plays from a per-voice prefetch ring rather than
+// resident RAM. The ring is filled in playback order, so a loop jump simply
+// continues the byte sequence and interpolation needs no special case at
+// chunk or loop boundaries. Chunks are DMA'd from the APU's QSPI flash, or
+// requested from the CPU (which can feed them from SD).
+#define MAX_SAMPLE_STREAMS 4
+#define STREAM_CHUNK_SIZE 512               // Prefetch / request granularity
+#define STREAM_REQUEST_TIMEOUT_US 20000     // Re-issue a CPU request after this long
+#define STREAM_SOURCE_FLASH 0
+#define STREAM_SOURCE_CPU 1
+
+// Flash-sourced clips must lie inside the APU's flash
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+typedef struct {
+    bool active;
+    uint8_t channel_id;
+    uint8_t sample_id;
+    uint8_t* ring;
+    volatile uint32_t write_seq;  // Playback-order bytes delivered (core 0)
+    volatile uint32_t read_seq;   // Oldest byte a renderer still needs
+    uint32_t source_pos;          // Next source byte to deliver
+    uint32_t request_pending;     // CPU source: bytes asked for, not yet received
+    uint32_t request_time;
+    bool source_done;             // Non-looping clip fully delivered
+    bool started;                 // Primed; underruns count from here on
+    uint32_t underruns;
+} SampleStream;
+
+SampleStream sample_streams[MAX_SAMPLE_STREAMS];
+uint32_t stream_ring_size = 0;
+uint32_t stream_ring_mask = 0;
+int stream_dma_channel = -1;
+int8_t stream_dma_owner = -1;     // Stream with a flash chunk in flight
+uint32_t stream_dma_bytes = 0;
+
+void init_sample_streams(bool is_rp2350) {
+    stream_ring_size = is_rp2350 ? 8192 : 4096;
+    stream_ring_mask = stream_ring_size - 1;
+    
+    for (int i = 0; i < MAX_SAMPLE_STREAMS; i++) {
+        sample_streams[i].active = false;
+        sample_streams[i].ring = malloc(stream_ring_size);
+    }
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        sample_channels[ch].stream_id = -1;
+    }
+    
+    stream_dma_channel = dma_claim_unused_channel(true);
+}
+
+static inline bool stream_loops(const Sample* sample) {
+    return sample->loop_end > sample->loop_start &&
+           sample->loop_end * sample->bytes_per_sample <= sample->size;
+}
+
+// End of the source span currently being delivered
+static inline uint32_t stream_segment_end(const Sample* sample) {
+    return stream_loops(sample) ? sample->loop_end * sample->bytes_per_sample : sample->size;
+}
+
+static inline uint32_t stream_free(const SampleStream* st) {
+    return stream_ring_size - (st->write_seq - st->read_seq);
+}
+
+// Publish bytes just written at write_seq and step the source position,
+// jumping back to the loop start at the loop end
+static void stream_delivered(SampleStream* st, const Sample* sample, uint32_t bytes) {
+    st->source_pos += bytes;
+    if (st->source_pos >= stream_segment_end(sample)) {
+        if (stream_loops(sample)) {
+            st->source_pos = sample->loop_start * sample->bytes_per_sample;
+        } else {
+            st->source_done = true;
+        }
+        st->request_pending = 0;
+    }
+    
+    __dmb();
+    st->write_seq += bytes;
+}
+
+void release_sample_stream(int8_t stream_id) {
+    if (stream_id < 0) return;
+    
+    SampleStream* st = &sample_streams[stream_id];
+    if (stream_dma_owner == stream_id) {
+        dma_channel_abort(stream_dma_channel);
+        stream_dma_owner = -1;
+    }
+    if (sample_channels[st->channel_id].stream_id == stream_id) {
+        sample_channels[st->channel_id].stream_id = -1;
+    }
+    st->active = false;
+}
+
+int8_t start_sample_stream(uint8_t channel_id, uint8_t sample_id) {
+    int8_t id = sample_channels[channel_id].stream_id;
+    
+    // Reuse the channel's stream, otherwise take a free one
+    if (id < 0) {
+        for (int i = 0; i < MAX_SAMPLE_STREAMS; i++) {
+            if (!sample_streams[i].active && sample_streams[i].ring != NULL) {
+                id = i;
+                break;
+            }
+        }
+        if (id < 0) return -1;
+    } else {
+        release_sample_stream(id);
+    }
+    
+    SampleStream* st = &sample_streams[id];
+    st->channel_id = channel_id;
+    st->sample_id = sample_id;
+    st->write_seq = 0;
+    st->read_seq = 0;
+    st->source_pos = 0;
+    st->request_pending = 0;
+    st->source_done = false;
+    st->started = false;
+    st->underruns = 0;
+    __dmb();
+    st->active = true;
+    
+    return id;
+}
+
+void define_sample_stream(uint8_t sample_id, uint8_t format, uint16_t sample_rate, uint8_t source,
+                          uint32_t offset, uint32_t length, uint32_t loop_start, uint32_t loop_end) {
+    if (sample_id >= MAX_SAMPLES || source > STREAM_SOURCE_CPU || stream_ring_size == 0) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Lengths arrive in frames, the stream works in source bytes
+    bool is_16bit = (format & 1);
+    bool is_stereo = (format & 2);
+    uint8_t bytes_per_sample = (is_16bit ? 2 : 1) * (is_stereo ? 2 : 1);
+    uint64_t size = (uint64_t)length * bytes_per_sample;
+    
+    // XIP DMA reads straight from offset, so the clip has to fit in flash
+    if (size > UINT32_MAX ||
+        (source == STREAM_SOURCE_FLASH &&
+         (offset > PICO_FLASH_SIZE_BYTES || size > PICO_FLASH_SIZE_BYTES - offset))) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Drop resident data and any voice still streaming the old definition
+    release_sample_data(sample_id);
+    for (int i = 0; i < MAX_SAMPLE_STREAMS; i++) {
+        if (sample_streams[i].active && sample_streams[i].sample_id == sample_id) {
+            release_sample_stream(i);
+        }
+    }
+    
+    samples[sample_id].loaded = true;
+    samples[sample_id].streaming = true;
+    samples[sample_id].stream_source = source;
+    samples[sample_id].stream_offset = offset;
+    samples[sample_id].size = (uint32_t)size;
+    samples[sample_id].sample_rate = sample_rate;
+    samples[sample_id].loop_start = loop_start;
+    samples[sample_id].loop_end = loop_end;
+    samples[sample_id].is_16bit = is_16bit;
+    samples[sample_id].is_stereo = is_stereo;
+    samples[sample_id].bytes_per_sample = bytes_per_sample;
+    
+    send_ack_to_cpu(CMD_SAMPLE_STREAM_DEFINE);
+}
+
+// Define a resident sample whose data stays in the pack
+void map_sample(uint8_t sample_id, uint8_t format, uint16_t sample_rate, uint32_t pack_offset,
+                uint32_t size, uint32_t loop_start, uint32_t loop_end) {
+    const uint8_t* source = asset_pack_data(pack_offset, size);
+    if (sample_id >= MAX_SAMPLES || source == NULL) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Drop resident data and any voice still streaming an old definition
+    samples[sample_id].loaded = false;
+    release_sample_data(sample_id);
+    for (int i = 0; i < MAX_SAMPLE_STREAMS; i++) {
+        if (sample_streams[i].active && sample_streams[i].sample_id == sample_id) {
+            release_sample_stream(i);
+        }
+    }
+    
+    bool is_16bit = (format & 1);
+    bool is_stereo = (format & 2);
+    
+    samples[sample_id].loaded = true;
+    samples[sample_id].streaming = false;
+    samples[sample_id].in_flash = true;
+    samples[sample_id].data = (uint8_t*)source;
+    samples[sample_id].size = size;
+    samples[sample_id].received = size;
+    samples[sample_id].sample_rate = sample_rate;
+    samples[sample_id].loop_start = loop_start;
+    samples[sample_id].loop_end = loop_end;
+    samples[sample_id].is_16bit = is_16bit;
+    samples[sample_id].is_stereo = is_stereo;
+    samples[sample_id].bytes_per_sample = (is_16bit ? 2 : 1) * (is_stereo ? 2 : 1);
+    
+    send_ack_to_cpu(CMD_SAMPLE_MAP);
+}
+
+// CPU-sourced chunk. Data that does not continue the stream (stale after a
+// restart or loop jump, or a duplicate of a re-issued request) is dropped.
+// Not acknowledged: the next STATUS_STREAM_REQUEST is the flow control.
+void push_sample_stream_data(uint8_t channel_id, uint32_t source_offset, const uint8_t* data, uint32_t size) {
+    if (channel_id >= MAX_CHANNELS || sample_channels[channel_id].stream_id < 0) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    SampleStream* st = &sample_streams[sample_channels[channel_id].stream_id];
+    Sample* sample = &samples[st->sample_id];
+    if (!st->active || st->source_done || source_offset != st->source_pos) return;
+    
+    size = MIN(size, stream_segment_end(sample) - st->source_pos);
+    size = MIN(size, stream_free(st));
+    
+    uint32_t pos = st->write_seq & stream_ring_mask;
+    uint32_t first = MIN(size, stream_ring_size - pos);
+    memcpy(&st->ring[pos], data, first);
+    memcpy(st->ring, data + first, size - first);
+    
+    st->request_pending = (st->request_pending > size) ? st->request_pending - size : 0;
+    stream_delivered(st, sample, size);
+}
+
+static void request_stream_data(int8_t stream_id, SampleStream* st, const Sample* sample) {
+    uint32_t bytes = MIN(stream_free(st), stream_segment_end(sample) - st->source_pos);
+    if (bytes == 0) return;
+    
+    uint8_t request[8];
+    request[0] = st->channel_id;
+    request[1] = st->sample_id;
+    request[2] = st->source_pos & 0xFF;
+    request[3] = (st->source_pos >> 8) & 0xFF;
+    request[4] = (st->source_pos >> 16) & 0xFF;
+    request[5] = (st->source_pos >> 24) & 0xFF;
+    request[6] = bytes & 0xFF;
+    request[7] = (bytes >> 8) & 0xFF;
+    send_data_to_cpu(STATUS_STREAM_REQUEST, request, 8);
+    
+    st->request_pending = bytes;
+    st->request_time = time_us_32();
+}
+
+// Core 0: keep every active stream's ring topped up. One flash chunk is in
+// flight at a time, going to the stream with the least data buffered.
+void service_sample_streams() {
+    if (stream_dma_owner >= 0) {
+        if (dma_channel_is_busy(stream_dma_channel)) return;
+        
+        SampleStream* st = &sample_streams[stream_dma_owner];
+        if (st->active) stream_delivered(st, &samples[st->sample_id], stream_dma_bytes);
+        stream_dma_owner = -1;
+    }
+    
+    int8_t flash_next = -1;
+    uint32_t flash_least = UINT32_MAX;
+    
+    for (int8_t i = 0; i < MAX_SAMPLE_STREAMS; i++) {
+        SampleStream* st = &sample_streams[i];
+        if (!st->active) continue;
+        
+        // Voice ended, was retriggered elsewhere or its sample was cleared
+        Sample* sample = &samples[st->sample_id];
+        if (!channels[st->channel_id].active || sample_channels[st->channel_id].stream_id != i ||
+            !sample->loaded || !sample->streaming) {
+            release_sample_stream(i);
+            continue;
+        }
+        
+        if (st->source_done || stream_free(st) < STREAM_CHUNK_SIZE) continue;
+        
+        if (sample->stream_source == STREAM_SOURCE_CPU) {
+            if (st->request_pending == 0 ||
+                time_us_32() - st->request_time > STREAM_REQUEST_TIMEOUT_US) {
+                request_stream_data(i, st, sample);
+            }
+        } else {
+            uint32_t buffered = st->write_seq - st->read_seq;
+            if (buffered < flash_least) {
+                flash_least = buffered;
+                flash_next = i;
+            }
+        }
+    }
+    
+    if (flash_next < 0) return;
+    
+    // Flash chunk: contiguous in the ring and within the current segment
+    SampleStream* st = &sample_streams[flash_next];
+    Sample* sample = &samples[st->sample_id];
+    uint32_t pos = st->write_seq & stream_ring_mask;
+    uint32_t bytes = MIN(STREAM_CHUNK_SIZE, stream_ring_size - pos);
+    bytes = MIN(bytes, stream_segment_end(sample) - st->source_pos);
+    
+    // Uncached window: stream data should not evict code from the XIP cache
+    uint32_t src = XIP_NOCACHE_NOALLOC_BASE + sample->stream_offset + st->source_pos;
+    uint8_t* dst = &st->ring[pos];
+    bool words = ((src | (uint32_t)dst | bytes) & 3) == 0;
+    
+    dma_channel_config config = dma_channel_get_default_config(stream_dma_channel);
+    channel_config_set_transfer_data_size(&config, words ? DMA_SIZE_32 : DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, true);
+    dma_channel_configure(stream_dma_channel, &config, dst, (const void*)src,
+                          words ? bytes / 4 : bytes, true);
+    
+    stream_dma_owner = flash_next;
+    stream_dma_bytes = bytes;
+}
+
+// Ring access. Byte offsets are in playback order and wrap with the mask;
+// a frame never straddles the ring end since the ring size is a multiple
+// of every frame size.
+static inline int32_t stream_read_q15(const SampleStream* st, uint32_t byte, bool is_16bit) {
+    if (is_16bit) {
+        return *(const int16_t*)&st->ring[byte & stream_ring_mask];
+    }
+    return ((int32_t)st->ring[byte & stream_ring_mask] - 128) << 8;
+}
+
+// True once the renderer may play: primed with half a ring (or the whole
+// clip), so startup latency isn't counted as underruns
+static bool stream_ready(SampleStream* st, const Sample* sample) {
+    if (!st->started) {
+        st->started = st->source_done || st->write_seq >= MIN(stream_ring_size / 2, sample->size);
+    }
+    return st->started;
+}
+
+// Frames [pos, pos + count) are buffered
+static inline bool stream_has_frames(const SampleStream* st, uint32_t pos, uint32_t count, uint32_t bps) {
+    return (int32_t)(st->write_seq - (pos + count) * bps) >= 0;
+}
+
+// Streams play forward from the start; loop_start/loop_end of the stream
+// definition give the loop, independent of loop_mode
+uint8_t render_stream_channel_q15(uint8_t channel_id, int32_t* out_left, int32_t* out_right, uint32_t sample_count) {
+    Channel* ch = &channels[channel_id];
+    SampleChannel* sc = &sample_channels[channel_id];
+    Sample* sample = &samples[sc->sample_id];
+    
+    if (sc->stream_id < 0) return 0;
+    
+    SampleStream* st = &sample_streams[sc->stream_id];
+    uint32_t bps = sample->bytes_per_sample;
+    uint32_t plane_bytes = sample->is_16bit ? 2 : 1;
+    uint32_t total = stream_loops(sample) ? UINT32_MAX : sample->size / bps;
+    
+    uint32_t i = 0;
+    if (stream_ready(st, sample)) {
+        bool starved = false;
+        
+        for (; i < sample_count; i++) {
+            uint32_t pos = sc->position;
+            if (pos >= total) {
+                ch->active = false;
+                break;
+            }
+            
+            // Interpolate towards the next frame unless this is the last one
+            uint32_t need = (pos + 1 < total) ? 2 : 1;
+            if (!stream_has_frames(st, pos, need, bps)) {
+                // Underrun: hold position and output silence
+                if (!starved) st->underruns++;
+                starved = true;
+                out_left[i] = 0;
+                out_right[i] = 0;
+                continue;
+            }
+            
+            int32_t frac = (need == 2) ? sc->frac_fixed : 0;
+            uint32_t byte = pos * bps;
+            int32_t a = stream_read_q15(st, byte, sample->is_16bit);
+            int32_t b = stream_read_q15(st, byte + bps, sample->is_16bit);
+            out_left[i] = a + (((b - a) * frac) >> 16);
+            
+            if (sample->is_stereo) {
+                a = stream_read_q15(st, byte + plane_bytes, sample->is_16bit);
+                b = stream_read_q15(st, byte + plane_bytes + bps, sample->is_16bit);
+                out_right[i] = a + (((b - a) * frac) >> 16);
+            }
+            
+            sc->frac_fixed += sc->step_fixed;
+            sc->position += sc->frac_fixed >> 16;
+            sc->frac_fixed &= 0xFFFF;
+        }
+        
+        // Keep one frame of history for cubic interpolation
+        st->read_seq = (sc->position ? sc->position - 1 : 0) * bps;
+    }
+    
+    for (; i < sample_count; i++) {
+        out_left[i] = 0;
+        out_right[i] = 0;
+    }
+    
+    return sample->is_stereo ? 2 : 1;
+}
+
+uint8_t render_stream_channel(uint8_t channel_id, float* out_left, float* out_right, uint32_t sample_count) {
+    Channel* ch = &channels[channel_id];
+    SampleChannel* sc = &sample_channels[channel_id];
+    Sample* sample = &samples[sc->sample_id];
+    
+    if (sc->stream_id < 0) return 0;
+    
+    SampleStream* st = &sample_streams[sc->stream_id];
+    uint32_t bps = sample->bytes_per_sample;
+    uint32_t plane_bytes = sample->is_16bit ? 2 : 1;
+    uint32_t total = stream_loops(sample) ? UINT32_MAX : sample->size / bps;
+    int planes = sample->is_stereo ? 2 : 1;
+    float* out[2] = { out_left, out_right };
+    
+    uint32_t i = 0;
+    if (stream_ready(st, sample)) {
+        bool starved = false;
+        
+        for (; i < sample_count; i++) {
+            uint32_t pos = sc->position;
+            if (pos >= total) {
+                ch->active = false;
+                break;
+            }
+            
+            // Cubic needs frames pos-1 .. pos+2; clamp at the clip edges
+            uint32_t ahead = MIN(3, total - pos);
+            if (!stream_has_frames(st, pos, ahead, bps)) {
+                if (!starved) st->underruns++;
+                starved = true;
+                out_left[i] = 0.0f;
+                out_right[i] = 0.0f;
+                continue;
+            }
+            
+            for (int plane = 0; plane < planes; plane++) {
+                // Gather the window contiguously so advanced_sample_interpolation()
+                // sees a plain mono buffer regardless of ring wrap
+                uint8_t window[8];
+                for (int k = 0; k < 4; k++) {
+                    int32_t f = (int32_t)pos + k - 1;
+                    if (f < 0) f = 0;
+                    if (f > (int32_t)(pos + ahead - 1)) f = pos + ahead - 1;
+                    
+                    uint32_t byte = (f * bps + plane * plane_bytes) & stream_ring_mask;
+                    window[k * plane_bytes] = st->ring[byte];
+                    if (plane_bytes == 2) window[k * 2 + 1] = st->ring[byte + 1];
+                }
+                
+                float frac = (ahead > 1) ? sc->position_frac : 0.0f;
+                out[plane][i] = advanced_sample_interpolation(window, 1, frac, sample->is_16bit, 4) / 32768.0f;
+            }
+            
+            sc->position_frac += sc->step;
+            while (sc->position_frac >= 1.0f) {
+                sc->position_frac -= 1.0f;
+                sc->position++;
+            }
+        }
+        
+        st->read_seq = (sc->position ? sc->position - 1 : 0) * bps;
+    }
+    
+    for (; i < sample_count; i++) {
+        out_left[i] = 0.0f;
+        out_right[i] = 0.0f;
+    }
+    
+    return planes;
+}
+
 void play_sample(uint8_t channel_id, uint8_t sample_id, uint8_t pitch, uint8_t volume) {
     if (channel_id >= MAX_CHANNELS || sample_id >= MAX_SAMPLES || !samples[sample_id].loaded) {
         return;
     }
     
+    // Streaming samples need a prefetch ring; resident ones give theirs up
+    if (samples[sample_id].streaming) {
+        int8_t stream_id = start_sample_stream(channel_id, sample_id);
+        if (stream_id < 0) {
+            send_error(ERROR_OUT_OF_MEMORY);
+            return;
+        }
+        sample_channels[channel_id].stream_id = stream_id;
+    } else {
+        release_sample_stream(sample_channels[channel_id].stream_id);
+    }
+    
     // Configure channel
     channels[channel_id].type = CHANNEL_TYPE_SAMPLE;
     channels[channel_id].active = true;
@@ -962,6 +2374,8 @@ void play_sample(uint8_t channel_id, uint8_t sample_id, uint8_t pitch, uint8_t v
     // Calculate step size for position advancement
     float step = (float)samples[sample_id].sample_rate * sample_channels[channel_id].pitch_ratio / (float)SAMPLE_RATE;
     sample_channels[channel_id].step = step;
+    sample_channels[channel_id].step_fixed = (uint32_t)(step * 65536.0f);
+    sample_channels[channel_id].frac_fixed = 0;
     
     // Default to no looping
     sample_channels[channel_id].loop_mode = 0;
@@ -984,17 +2398,15 @@ int16_t interpolate_sample(const uint8_t* data, uint32_t pos, float frac, bool i
     return sample1 + (int16_t)((sample2 - sample1) * frac);
 }
 
-void render_sample_channel(uint8_t channel_id, float* buffer, uint32_t sample_count) {
+uint8_t render_sample_channel(uint8_t channel_id, float* out_left, float* out_right, uint32_t sample_count) {
     Channel* ch = &channels[channel_id];
     SampleChannel* sc = &sample_channels[channel_id];
     
-    if (!ch->active) return;
+    if (!ch->active) return 0;
     
     Sample* sample = &samples[sc->sample_id];
-    if (!sample->loaded) return;
-    
-    float vol_left = ch->volume * (255 - ch->pan) / 65025.0f;
-    float vol_right = ch->volume * ch->pan / 65025.0f;
+    if (!sample->loaded) return 0;
+    if (sample->streaming) return render_stream_channel(channel_id, out_left, out_right, sample_count);
     
     uint32_t sample_end = sample->size / sample->bytes_per_sample;
     uint32_t loop_start = sample->loop_start;
@@ -1004,7 +2416,8 @@ void render_sample_channel(uint8_t channel_id, float* buffer, uint32_t sample_co
     if (loop_end > sample_end) loop_end = sample_end;
     if (loop_start >= loop_end) loop_start = 0;
     
-    for (uint32_t i = 0; i < sample_count; i++) {
+    uint32_t i = 0;
+    for (; i < sample_count; i++) {
         // Check if we've reached the end
         if (sc->position >= sample_end) {
             if (sc->loop_mode == 0) {
@@ -1046,17 +2459,108 @@ void render_sample_channel(uint8_t channel_id, float* buffer, uint32_t sample_co
             left = right = interpolate_sample(sample->data, pos, frac, sample->is_16bit);
         }
         
-        // Mix into output buffer
-        buffer[i*2] += left * vol_left / 32768.0f;
-        buffer[i*2+1] += right * vol_right / 32768.0f;
+        // Write the dry voice
+        out_left[i] = left / 32768.0f;
+        if (sample->is_stereo) out_right[i] = right / 32768.0f;
+        
+        // Advance position
+        sc->position_frac += sc->step;
+        while (sc->position_frac >= 1.0f) {
+            sc->position_frac -= 1.0f;
+            sc->position += sc->direction;
+        }
+    }
+    
+    // Silence the rest of the block if playback ended
+    for (; i < sample_count; i++) {
+        out_left[i] = 0.0f;
+        out_right[i] = 0.0f;
+    }
+    
+    return sample->is_stereo ? 2 : 1;
+}
+
+// Integer interpolation; stride is the distance to the next frame in samples
+static inline int32_t interpolate_sample_fixed(const uint8_t* data, uint32_t pos, uint32_t stride,
+                                               uint32_t frac, bool is_16bit) {
+    int32_t sample1, sample2;
+    
+    if (is_16bit) {
+        const int16_t* data16 = (const int16_t*)data;
+        sample1 = data16[pos];
+        sample2 = data16[pos + stride];
+    } else {
+        sample1 = ((int32_t)data[pos] - 128) << 8;
+        sample2 = ((int32_t)data[pos + stride] - 128) << 8;
+    }
+    
+    return sample1 + (((sample2 - sample1) * (int32_t)frac) >> 16);
+}
+
+uint8_t render_sample_channel_q15(uint8_t channel_id, int32_t* out_left, int32_t* out_right, uint32_t sample_count) {
+    Channel* ch = &channels[channel_id];
+    SampleChannel* sc = &sample_channels[channel_id];
+    
+    if (!ch->active) return 0;
+    
+    Sample* sample = &samples[sc->sample_id];
+    if (!sample->loaded) return 0;
+    if (sample->streaming) return render_stream_channel_q15(channel_id, out_left, out_right, sample_count);
+    
+    uint32_t sample_end = sample->size / sample->bytes_per_sample;
+    uint32_t loop_start = sample->loop_start;
+    uint32_t loop_end = sample->loop_end;
+    
+    // Ensure loop points are valid
+    if (loop_end > sample_end) loop_end = sample_end;
+    if (loop_start >= loop_end) loop_start = 0;
+    
+    uint32_t stride = sample->is_stereo ? 2 : 1;
+    
+    uint32_t i = 0;
+    for (; i < sample_count; i++) {
+        // Same loop handling as the float renderer
+        if (sc->position >= sample_end) {
+            if (sc->loop_mode == 0) {
+                ch->active = false;
+                break;
+            } else if (sc->loop_mode == 1) {
+                sc->position = loop_start;
+                sc->frac_fixed = 0;
+            } else if (sc->loop_mode == 2) {
+                sc->position = loop_end - 1;
+                sc->frac_fixed = 0;
+                sc->direction = -1;
+            }
+        } else if (sc->position < loop_start && sc->direction < 0 && sc->loop_mode == 2) {
+            sc->position = loop_start;
+            sc->frac_fixed = 0;
+            sc->direction = 1;
+        }
+        
+        // The last frame has no successor to interpolate towards
+        uint32_t frac = (sc->position + 1 < sample_end) ? sc->frac_fixed : 0;
+        uint32_t pos = sc->position * stride;
+        int32_t left = interpolate_sample_fixed(sample->data, pos, stride, frac, sample->is_16bit);
+        int32_t right = sample->is_stereo
+            ? interpolate_sample_fixed(sample->data, pos + 1, stride, frac, sample->is_16bit)
+            : left;
+        
+        out_left[i] = left;
+        if (sample->is_stereo) out_right[i] = right;
         
         // Advance position
-        sc->position_frac += sc->step;
-        while (sc->position_frac >= 1.0f) {
-            sc->position_frac -= 1.0f;
-            sc->position += sc->direction;
-        }
+        sc->frac_fixed += sc->step_fixed;
+        sc->position += (int32_t)(sc->frac_fixed >> 16) * sc->direction;
+        sc->frac_fixed &= 0xFFFF;
+    }
+    
+    for (; i < sample_count; i++) {
+        out_left[i] = 0;
+        out_right[i] = 0;
     }
+    
+    return sample->is_stereo ? 2 : 1;
 }
 
 // Wavetable Synthesis Engine
@@ -1064,12 +2568,14 @@ typedef struct {
     int16_t* data;
     uint16_t size;
     uint16_t mask; // For fast indexing (size-1)
+    bool in_flash; // data points into the asset pack (WAVE_MAP_TABLE)
 } Wavetable;
 
 typedef struct {
     uint8_t table_id;
     float position;
     float position_frac;
+    uint32_t phase_fixed;  // 16.16 table position for the fixed mixing bus
     
     uint8_t sweep_start_table;
     uint8_t sweep_end_table;
@@ -1088,6 +2594,14 @@ typedef struct {
 Wavetable wavetables[MAX_WAVETABLES];
 WaveChannel wave_channels[MAX_CHANNELS];
 
+static void release_wavetable_data(uint8_t table_id) {
+    if (wavetables[table_id].data != NULL && !wavetables[table_id].in_flash) {
+        free(wavetables[table_id].data);
+    }
+    wavetables[table_id].data = NULL;
+    wavetables[table_id].in_flash = false;
+}
+
 void define_wavetable(uint8_t table_id, uint8_t wave_size, const uint8_t* data) {
     if (table_id >= MAX_WAVETABLES) return;
     
@@ -1102,9 +2616,7 @@ void define_wavetable(uint8_t table_id, uint8_t wave_size, const uint8_t* data)
     }
     
     // Free existing wavetable if any
-    if (wavetables[table_id].data != NULL) {
-        free(wavetables[table_id].data);
-    }
+    release_wavetable_data(table_id);
     
     // Allocate memory
     int16_t* wave_memory = malloc(actual_size * sizeof(int16_t));
@@ -1128,10 +2640,31 @@ void define_wavetable(uint8_t table_id, uint8_t wave_size, const uint8_t* data)
     wavetables[table_id].data = wave_memory;
     wavetables[table_id].size = actual_size;
     wavetables[table_id].mask = actual_size - 1;
+    wavetables[table_id].in_flash = false;
     
     send_ack_to_cpu(CMD_WAVE_DEFINE_TABLE);
 }
 
+// Map a wavetable already stored in the pack as signed 16-bit samples
+void map_wavetable(uint8_t table_id, uint16_t wave_size, uint32_t pack_offset) {
+    const uint8_t* source = asset_pack_data(pack_offset, wave_size * sizeof(int16_t));
+    
+    // Indexing masks the phase, so the size has to be a power of two
+    if (table_id >= MAX_WAVETABLES || source == NULL || wave_size < 32 || wave_size > 512 ||
+        (wave_size & (wave_size - 1)) != 0) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    release_wavetable_data(table_id);
+    wavetables[table_id].data = (int16_t*)source;
+    wavetables[table_id].size = wave_size;
+    wavetables[table_id].mask = wave_size - 1;
+    wavetables[table_id].in_flash = true;
+    
+    send_ack_to_cpu(CMD_WAVE_MAP_TABLE);
+}
+
 void set_wavetable_sweep(uint8_t channel_id, uint8_t start_table, uint8_t end_table, uint8_t sweep_rate) {
     if (channel_id >= MAX_CHANNELS) return;
     
@@ -1161,22 +2694,51 @@ void set_wavetable_sweep(uint8_t channel_id, uint8_t start_table, uint8_t end_ta
     send_ack_to_cpu(CMD_WAVE_SET_SWEEP);
 }
 
-void render_wavetable_channel(uint8_t channel_id, float* buffer, uint32_t sample_count) {
+// Pick the tables for this block and step the morph; returns the morph
+// position (0-255) between *wave_data and *morph_data
+static uint8_t advance_wavetable_sweep(WaveChannel* wc, uint8_t table_id,
+                                       int16_t** wave_data, int16_t** morph_data) {
+    if (!wc->sweep_active) {
+        *wave_data = wavetables[table_id].data;
+        *morph_data = NULL;
+        return 0;
+    }
+    
+    *wave_data = wavetables[wc->sweep_start_table].data;
+    *morph_data = wavetables[wc->sweep_end_table].data;
+    uint8_t morph = wc->sweep_position;
+    
+    // Advance morphing
+    wc->sweep_position += wc->sweep_rate;
+    if (wc->sweep_position > 255) {
+        if (wc->sweep_oscillate) {
+            // Swap tables and continue morphing
+            uint8_t temp = wc->sweep_start_table;
+            wc->sweep_start_table = wc->sweep_end_table;
+            wc->sweep_end_table = temp;
+            wc->sweep_position = 0;
+        } else {
+            // Clamp at end
+            wc->sweep_position = 255;
+        }
+    }
+    
+    return morph;
+}
+
+uint8_t render_wavetable_channel(uint8_t channel_id, float* out, float* unused, uint32_t sample_count) {
     Channel* ch = &channels[channel_id];
     WaveChannel* wc = &wave_channels[channel_id];
     
-    if (!ch->active) return;
+    if (!ch->active) return 0;
     
     // Get wavetable
     uint8_t table_id = wc->table_id;
     if (table_id >= MAX_WAVETABLES || wavetables[table_id].data == NULL) {
         ch->active = false;
-        return;
+        return 0;
     }
     
-    float vol_left = ch->volume * (255 - ch->pan) / 65025.0f;
-    float vol_right = ch->volume * ch->pan / 65025.0f;
-    
     uint16_t wave_size = wavetables[table_id].size;
     uint16_t wave_mask = wavetables[table_id].mask;
     
@@ -1185,31 +2747,8 @@ void render_wavetable_channel(uint8_t channel_id, float* buffer, uint32_t sample
     
     // Handle wavetable morphing
     int16_t* wave_data;
-    int16_t* morph_data = NULL;
-    float morph_factor = 0.0f;
-    
-    if (wc->sweep_active) {
-        wave_data = wavetables[wc->sweep_start_table].data;
-        morph_data = wavetables[wc->sweep_end_table].data;
-        morph_factor = wc->sweep_position / 255.0f;
-        
-        // Advance morphing
-        wc->sweep_position += wc->sweep_rate;
-        if (wc->sweep_position > 255) {
-            if (wc->sweep_oscillate) {
-                // Swap tables and continue morphing
-                uint8_t temp = wc->sweep_start_table;
-                wc->sweep_start_table = wc->sweep_end_table;
-                wc->sweep_end_table = temp;
-                wc->sweep_position = 0;
-            } else {
-                // Clamp at end
-                wc->sweep_position = 255;
-            }
-        }
-    } else {
-        wave_data = wavetables[table_id].data;
-    }
+    int16_t* morph_data;
+    float morph_factor = advance_wavetable_sweep(wc, table_id, &wave_data, &morph_data) / 255.0f;
     
     for (uint32_t i = 0; i < sample_count; i++) {
         float sample;
@@ -1245,9 +2784,7 @@ void render_wavetable_channel(uint8_t channel_id, float* buffer, uint32_t sample
             sample = sample1 + (sample2 - sample1) * frac;
         }
         
-        // Apply to stereo mix buffer
-        buffer[i*2] += sample * vol_left / 32768.0f;
-        buffer[i*2+1] += sample * vol_right / 32768.0f;
+        out[i] = sample / 32768.0f;
         
         // Advance wavetable position
         wc->position += phase_inc;
@@ -1255,16 +2792,95 @@ void render_wavetable_channel(uint8_t channel_id, float* buffer, uint32_t sample
             wc->position -= wave_size;
         }
     }
+    
+    return 1;
+}
+
+uint8_t render_wavetable_channel_q15(uint8_t channel_id, int32_t* out, int32_t* unused, uint32_t sample_count) {
+    Channel* ch = &channels[channel_id];
+    WaveChannel* wc = &wave_channels[channel_id];
+    
+    if (!ch->active) return 0;
+    
+    uint8_t table_id = wc->table_id;
+    if (table_id >= MAX_WAVETABLES || wavetables[table_id].data == NULL) {
+        ch->active = false;
+        return 0;
+    }
+    
+    uint16_t wave_mask = wavetables[table_id].mask;
+    uint32_t phase_mask = ((uint32_t)wavetables[table_id].size << 16) - 1;
+    uint32_t phase_inc = (uint32_t)(ch->frequency * wavetables[table_id].size * 65536.0f / SAMPLE_RATE);
+    
+    int16_t* wave_data;
+    int16_t* morph_data;
+    int32_t morph = advance_wavetable_sweep(wc, table_id, &wave_data, &morph_data);
+    uint32_t phase = wc->phase_fixed & phase_mask;
+    
+    for (uint32_t i = 0; i < sample_count; i++) {
+        uint16_t pos = (phase >> 16) & wave_mask;
+        uint16_t pos_next = (pos + 1) & wave_mask;
+        int32_t frac = phase & 0xFFFF;
+        
+        int32_t sample = wave_data[pos] + (((wave_data[pos_next] - wave_data[pos]) * frac) >> 16);
+        if (morph_data != NULL) {
+            int32_t target = morph_data[pos] + (((morph_data[pos_next] - morph_data[pos]) * frac) >> 16);
+            sample += ((target - sample) * morph) >> 8;
+        }
+        
+        out[i] = sample;
+        
+        phase = (phase + phase_inc) & phase_mask;
+    }
+    
+    wc->phase_fixed = phase;
+    return 1;
 }
 
 // Tracker/Sequencer System
+//
+// Songs arrive precompiled by the CPU (compile_tracker_song in cpu.c) as a
+// sparse event stream, so playback cost follows the number of events rather
+// than rows x channels. Song image, little-endian:
+//   [channels:1] [patterns:1] [songLength:1] [tempo:1] [ticksPerRow:1] [flags:1] [curves:1] [reserved:1]
+//   [sequence:songLength]
+//   curves x   [mode:1] [length:1] [values:length x int16]
+//   patterns x [rows:1] [eventBytes:2] [events:eventBytes]
+// Each event is [rowDelta:1] [flags|channel:1] followed by the fields its
+// flags select, in order: note, instrument, volume, control. A control byte
+// selects further fields in order: pitch curve, volume curve, speed, tempo.
+#define TRACKER_HEADER_SIZE 8
+#define TRACKER_SONG_LOOP 0x01
+
+#define TRACKER_EVENT_CHANNEL 0x0F
+#define TRACKER_EVENT_NOTE 0x10
+#define TRACKER_EVENT_INSTRUMENT 0x20
+#define TRACKER_EVENT_VOLUME 0x40
+#define TRACKER_EVENT_CONTROL 0x80
+
+#define TRACKER_CTRL_PITCH_CURVE 0x01
+#define TRACKER_CTRL_VOLUME_CURVE 0x02
+#define TRACKER_CTRL_SPEED 0x04
+#define TRACKER_CTRL_TEMPO 0x08
+
+// Per-tick effect curves. Looping curves are offsets from the note's base;
+// ramps add one step per tick and hold the running total.
+#define TRACKER_CURVE_VOLUME 0x01   // Targets volume instead of pitch
+#define TRACKER_CURVE_RAMP 0x02
+#define TRACKER_CURVE_NONE 0xFF     // Curve id that stops the running curve
+#define MAX_TRACKER_CURVES 64
+
+#define TRACKER_PITCH_STEPS 192     // Pitch curves count in 1/16 semitones
+#define TRACKER_PITCH_LIMIT (TRACKER_PITCH_STEPS * 8)
+
 typedef struct {
-    uint8_t note;        // 0=none, 1-96=note, 97=note off
-    uint8_t instrument;
-    uint8_t volume;      // 0=no change
-    uint8_t effect;      // 0=none
-    uint8_t effect_param;
-} TrackerNote;
+    uint8_t pitch_curve;
+    uint8_t pitch_pos;
+    int16_t pitch_offset;
+    uint8_t volume_curve;
+    uint8_t volume_pos;
+    int16_t volume_offset;
+} TrackerVoice;
 
 typedef struct {
     bool playing;
@@ -1274,105 +2890,208 @@ typedef struct {
     uint8_t channel_map[MAX_TRACKER_CHANNELS]; // Maps tracker channels to audio channels
     
     uint8_t song_length;
-    uint8_t pattern_sequence[256];
+    uint8_t num_patterns;
+    uint8_t num_curves;
+    const uint8_t* pattern_sequence;
     
     uint8_t current_pattern;
     uint8_t current_row;
     uint8_t position_in_sequence;
     uint8_t tick_counter;
-    
-    TrackerNote* pattern_data;
+    uint32_t tick_accumulator;
+    
+    // Compiled song, filled by TRACKER_LOAD and TRACKER_LOAD_DATA
+    uint8_t* song_data;
+    uint16_t song_size;
+    uint16_t song_received;
+    uint16_t pattern_offset[MAX_PATTERNS];
+    uint16_t curve_offset[MAX_TRACKER_CURVES];
+    
+    // Playback cursor into the current pattern's events
+    uint16_t cursor;
+    uint16_t pattern_end;
+    uint16_t event_row;
     uint8_t rows_per_pattern;
     
+    TrackerVoice voices[MAX_TRACKER_CHANNELS];
+    uint16_t curve_mask;   // Tracker channels with a running curve
+    
     bool loop_enabled;
 } Tracker;
 
 Tracker trackers[MAX_TRACKERS];
+float tracker_pitch_ratio[TRACKER_PITCH_STEPS];
 
-void load_tracker(uint8_t tracker_id, uint16_t data_size, const uint8_t* data) {
-    if (tracker_id >= MAX_TRACKERS) {
-        send_error(ERROR_INVALID_PARAMETER);
+void init_tracker_pitch_table() {
+    for (int i = 0; i < TRACKER_PITCH_STEPS; i++) {
+        tracker_pitch_ratio[i] = powf(2.0f, (float)i / TRACKER_PITCH_STEPS);
+    }
+}
+
+// Frequency ratio for a pitch offset in 1/16 semitones
+static inline float tracker_pitch_scale(int32_t steps) {
+    int32_t octave = (steps >= 0) ? steps / TRACKER_PITCH_STEPS
+                                  : -((TRACKER_PITCH_STEPS - 1 - steps) / TRACKER_PITCH_STEPS);
+    return ldexpf(tracker_pitch_ratio[steps - octave * TRACKER_PITCH_STEPS], octave);
+}
+
+// Index curves and patterns once the whole song has arrived
+static bool index_tracker_song(Tracker* tr) {
+    const uint8_t* song = tr->song_data;
+    uint32_t size = tr->song_size;
+    
+    if (size < TRACKER_HEADER_SIZE) return false;
+    
+    tr->num_channels = (song[0] <= MAX_TRACKER_CHANNELS) ? song[0] : MAX_TRACKER_CHANNELS;
+    tr->num_patterns = song[1];
+    tr->song_length = song[2];
+    tr->tempo = song[3];
+    tr->ticks_per_row = song[4];
+    tr->loop_enabled = (song[5] & TRACKER_SONG_LOOP) != 0;
+    tr->num_curves = song[6];
+    
+    if (tr->num_patterns == 0 || tr->num_patterns > MAX_PATTERNS ||
+        tr->num_curves > MAX_TRACKER_CURVES || tr->song_length == 0 ||
+        tr->tempo == 0 || tr->ticks_per_row == 0) {
+        return false;
+    }
+    
+    uint32_t pos = TRACKER_HEADER_SIZE;
+    if (pos + tr->song_length > size) return false;
+    tr->pattern_sequence = &song[pos];
+    for (int i = 0; i < tr->song_length; i++) {
+        if (song[pos + i] >= tr->num_patterns) return false;
+    }
+    pos += tr->song_length;
+    
+    for (int i = 0; i < tr->num_curves; i++) {
+        if (pos + 2 > size || song[pos + 1] == 0) return false;
+        tr->curve_offset[i] = pos;
+        pos += 2 + song[pos + 1] * 2;
+    }
+    
+    for (int i = 0; i < tr->num_patterns; i++) {
+        if (pos + 3 > size || song[pos] == 0) return false;
+        tr->pattern_offset[i] = pos;
+        pos += 3 + (song[pos + 1] | (song[pos + 2] << 8));
+    }
+    
+    return pos <= size;
+}
+
+static void finish_tracker_load(uint8_t tracker_id, uint8_t cmd_id) {
+    Tracker* tr = &trackers[tracker_id];
+    
+    if (tr->song_received < tr->song_size) {
+        // More TRACKER_LOAD_DATA to come
+        send_ack_to_cpu(cmd_id);
         return;
     }
     
-    // Stop if playing
-    trackers[tracker_id].playing = false;
+    if (!index_tracker_song(tr)) {
+        free(tr->song_data);
+        tr->song_data = NULL;
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
     
-    // Parse header
-    uint8_t num_channels = data[0];
-    uint8_t num_patterns = data[1];
-    uint8_t num_instruments = data[2];
-    uint8_t song_length = data[3];
-    uint8_t default_tempo = data[4];
+    // Setup default channel mapping (1:1)
+    for (int i = 0; i < tr->num_channels; i++) {
+        tr->channel_map[i] = i;
+    }
     
-    // Configure tracker
-    trackers[tracker_id].num_channels = (num_channels <= MAX_TRACKER_CHANNELS) ? 
-                                      num_channels : MAX_TRACKER_CHANNELS;
-    trackers[tracker_id].song_length = song_length;
-    trackers[tracker_id].tempo = default_tempo;
-    trackers[tracker_id].ticks_per_row = 6; // Default value
-    trackers[tracker_id].position_in_sequence = 0;
+    send_ack_to_cpu(cmd_id);
+}
 
-    // Copy pattern sequence
-    memcpy(trackers[tracker_id].pattern_sequence, &data[5], song_length);
+void load_tracker(uint8_t tracker_id, uint16_t data_size, const uint8_t* data, uint16_t length) {
+    if (tracker_id >= MAX_TRACKERS || data_size < TRACKER_HEADER_SIZE || length > data_size) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
     
-    // Pattern data starts after the header and sequence
-    uint16_t pattern_data_offset = 5 + song_length;
+    Tracker* tr = &trackers[tracker_id];
+    
+    // Stop if playing
+    tr->playing = false;
     
-    // Allocate pattern data memory
-    uint32_t pattern_size = num_patterns * MAX_ROWS_PER_PATTERN * num_channels * sizeof(TrackerNote);
-    if (trackers[tracker_id].pattern_data != NULL) {
-        free(trackers[tracker_id].pattern_data);
+    if (tr->song_data != NULL) {
+        free(tr->song_data);
     }
     
-    trackers[tracker_id].pattern_data = malloc(pattern_size);
-    if (trackers[tracker_id].pattern_data == NULL) {
+    tr->song_data = malloc(data_size);
+    if (tr->song_data == NULL) {
         send_error(ERROR_OUT_OF_MEMORY);
         return;
     }
     
-    // Parse and store pattern data
-    for (int p = 0; p < num_patterns; p++) {
-        uint8_t rows = data[pattern_data_offset++];
-        
-        for (int r = 0; r < rows; r++) {
-            for (int c = 0; c < num_channels; c++) {
-                TrackerNote* note = &trackers[tracker_id].pattern_data[
-                    (p * MAX_ROWS_PER_PATTERN * num_channels) + 
-                    (r * num_channels) + c];
-                
-                note->note = data[pattern_data_offset++];
-                note->instrument = data[pattern_data_offset++];
-                note->volume = data[pattern_data_offset++];
-                note->effect = data[pattern_data_offset++];
-                note->effect_param = data[pattern_data_offset++];
-            }
-        }
+    memcpy(tr->song_data, data, length);
+    tr->song_size = data_size;
+    tr->song_received = length;
+    
+    finish_tracker_load(tracker_id, CMD_TRACKER_LOAD);
+}
+
+void append_tracker_data(uint8_t tracker_id, const uint8_t* data, uint16_t length) {
+    if (tracker_id >= MAX_TRACKERS) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
     }
     
-    // Setup default channel mapping (1:1)
-    for (int i = 0; i < trackers[tracker_id].num_channels; i++) {
-        trackers[tracker_id].channel_map[i] = i;
+    Tracker* tr = &trackers[tracker_id];
+    if (tr->song_data == NULL || tr->song_received + length > tr->song_size) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    memcpy(tr->song_data + tr->song_received, data, length);
+    tr->song_received += length;
+    
+    finish_tracker_load(tracker_id, CMD_TRACKER_LOAD_DATA);
+}
+
+static void set_tracker_curve(Tracker* tr, uint8_t c, uint8_t channel_id, bool volume, uint8_t curve);
+
+// Point the cursor at the first event of the current sequence entry
+static void enter_tracker_pattern(Tracker* tr) {
+    // Effects don't carry across patterns; each one is compiled from a clean state
+    while (tr->curve_mask) {
+        uint8_t c = __builtin_ctz(tr->curve_mask);
+        set_tracker_curve(tr, c, tr->channel_map[c], false, TRACKER_CURVE_NONE);
+        set_tracker_curve(tr, c, tr->channel_map[c], true, TRACKER_CURVE_NONE);
     }
     
-    // Default to looping enabled
-    trackers[tracker_id].loop_enabled = true;
+    tr->current_pattern = tr->pattern_sequence[tr->position_in_sequence];
     
-    send_ack_to_cpu(CMD_TRACKER_LOAD);
+    const uint8_t* pattern = &tr->song_data[tr->pattern_offset[tr->current_pattern]];
+    tr->rows_per_pattern = pattern[0];
+    tr->cursor = tr->pattern_offset[tr->current_pattern] + 3;
+    tr->pattern_end = tr->cursor + (pattern[1] | (pattern[2] << 8));
+    tr->current_row = 0;
+    tr->event_row = (tr->cursor < tr->pattern_end) ? tr->song_data[tr->cursor] : 0xFFFF;
 }
 
 void play_tracker(uint8_t tracker_id) {
-    if (tracker_id >= MAX_TRACKERS || trackers[tracker_id].pattern_data == NULL) {
+    if (tracker_id >= MAX_TRACKERS || trackers[tracker_id].song_data == NULL ||
+        trackers[tracker_id].song_received < trackers[tracker_id].song_size) {
         send_error(ERROR_INVALID_PARAMETER);
         return;
     }
     
+    Tracker* tr = &trackers[tracker_id];
+    
     // Initialize playback state
-    trackers[tracker_id].playing = true;
-    trackers[tracker_id].position_in_sequence = 0;
-    trackers[tracker_id].current_row = 0;
-    trackers[tracker_id].tick_counter = 0;
-    trackers[tracker_id].current_pattern = trackers[tracker_id].pattern_sequence[0];
+    tr->tempo = tr->song_data[3];
+    tr->ticks_per_row = tr->song_data[4];
+    tr->position_in_sequence = 0;
+    tr->tick_counter = 0;
+    tr->tick_accumulator = 0;
+    tr->curve_mask = 0;
+    for (int c = 0; c < MAX_TRACKER_CHANNELS; c++) {
+        tr->voices[c].pitch_curve = TRACKER_CURVE_NONE;
+        tr->voices[c].volume_curve = TRACKER_CURVE_NONE;
+    }
+    enter_tracker_pattern(tr);
+    tr->playing = true;
     
     // Process first row to start playing notes
     process_tracker_row(tracker_id);
@@ -1380,74 +3099,155 @@ void play_tracker(uint8_t tracker_id) {
     send_ack_to_cpu(CMD_TRACKER_PLAY);
 }
 
-void process_tracker_row(uint8_t tracker_id) {
-    Tracker* tr = &trackers[tracker_id];
-    uint8_t pattern = tr->current_pattern;
-    uint8_t row = tr->current_row;
+// Swap the curve driving one side of a voice. Stopping a looping curve puts
+// the base back; stopping a ramp keeps where it got to.
+static void set_tracker_curve(Tracker* tr, uint8_t c, uint8_t channel_id, bool volume, uint8_t curve) {
+    TrackerVoice* v = &tr->voices[c];
+    uint8_t* current = volume ? &v->volume_curve : &v->pitch_curve;
     
-    // Get pointer to this row's notes
-    TrackerNote* row_data = &tr->pattern_data[
-        (pattern * MAX_ROWS_PER_PATTERN * tr->num_channels) + 
-        (row * tr->num_channels)];
+    if (curve != TRACKER_CURVE_NONE && curve >= tr->num_curves) return;
+    if (*current == curve) return;
     
-    // Process each channel
-    for (int c = 0; c < tr->num_channels; c++) {
-        TrackerNote* note = &row_data[c];
-        uint8_t channel_id = tr->channel_map[c];
-        
-        // Skip if this channel isn't allocated
-        if (channel_id >= MAX_CHANNELS) continue;
-        
-        // Process note
-        if (note->note > 0) {
-            if (note->note == 97) { // Note off
-                channels[channel_id].active = false;
-            } else if (note->note <= 96) { // Regular note
-                // Calculate frequency from note number (1=C-0, 96=B-7)
-                float freq = 32.7032f * powf(2.0f, (note->note - 1) / 12.0f);
-                
-                // Load instrument if specified
-                if (note->instrument > 0) {
-                    // This would load the appropriate instrument
-                    // For simplicity, we'll just set channel type here
-                    if (note->instrument <= 32) {
-                        channels[channel_id].type = CHANNEL_TYPE_FM;
-                    } else if (note->instrument <= 64) {
-                        channels[channel_id].type = CHANNEL_TYPE_SAMPLE;
-                    } else {
-                        channels[channel_id].type = CHANNEL_TYPE_WAVETABLE;
-                    }
-                }
-                
-                // Start note
-                channels[channel_id].active = true;
-                channels[channel_id].frequency = freq;
-                
-                // Trigger according to channel type
-                switch (channels[channel_id].type) {
-                    case CHANNEL_TYPE_FM:
-                        trigger_fm_note(channel_id, freq);
-                        break;
-                        
-                    case CHANNEL_TYPE_SAMPLE:
-                        trigger_sample_note(channel_id, freq);
-                        break;
-                        
-                    case CHANNEL_TYPE_WAVETABLE:
-                        trigger_wavetable_note(channel_id, freq);
-                        break;
-                }
+    if (*current != TRACKER_CURVE_NONE && channel_id < MAX_CHANNELS) {
+        bool ramp = tr->song_data[tr->curve_offset[*current]] & TRACKER_CURVE_RAMP;
+        if (volume) {
+            if (ramp) channels[channel_id].base_volume = channels[channel_id].volume;
+            else channels[channel_id].volume = channels[channel_id].base_volume;
+        } else {
+            if (ramp) {
+                channels[channel_id].base_frequency = channels[channel_id].frequency;
+            } else {
+                channels[channel_id].frequency = channels[channel_id].base_frequency;
+                update_channel_frequency(channel_id);
             }
         }
-        
-        // Process volume change
-        if (note->volume > 0) {
-            channels[channel_id].volume = note->volume;
+    }
+    
+    *current = curve;
+    if (volume) {
+        v->volume_pos = 0;
+        v->volume_offset = 0;
+    } else {
+        v->pitch_pos = 0;
+        v->pitch_offset = 0;
+    }
+    
+    if (v->pitch_curve != TRACKER_CURVE_NONE || v->volume_curve != TRACKER_CURVE_NONE) {
+        tr->curve_mask |= 1u << c;
+    } else {
+        tr->curve_mask &= ~(1u << c);
+    }
+}
+
+static void trigger_tracker_note(uint8_t channel_id, uint8_t note, uint8_t instrument) {
+    if (note == 97) { // Note off
+        channels[channel_id].active = false;
+        return;
+    }
+    if (note == 0 || note > 96) return;
+    
+    // Calculate frequency from note number (1=C-0, 96=B-7)
+    float freq = 32.7032f * tracker_pitch_scale((note - 1) * 16);
+    
+    // Load instrument if specified
+    if (instrument > 0) {
+        // This would load the appropriate instrument
+        // For simplicity, we'll just set channel type here
+        if (instrument <= 32) {
+            channels[channel_id].type = CHANNEL_TYPE_FM;
+        } else if (instrument <= 64) {
+            channels[channel_id].type = CHANNEL_TYPE_SAMPLE;
+        } else {
+            channels[channel_id].type = CHANNEL_TYPE_WAVETABLE;
         }
+    }
+    
+    // Trigger according to channel type
+    switch (channels[channel_id].type) {
+        case CHANNEL_TYPE_FM:
+            trigger_fm_note(channel_id, freq);
+            break;
+            
+        case CHANNEL_TYPE_SAMPLE:
+            trigger_sample_note(channel_id, freq);
+            break;
+            
+        case CHANNEL_TYPE_WAVETABLE:
+            trigger_wavetable_note(channel_id, freq);
+            break;
+    }
+}
+
+// Decode one event whose flags byte is at pos. Returns the offset past it, or
+// the end of the pattern if the event runs past it; a truncated event is
+// dropped whole.
+static uint16_t dispatch_tracker_event(Tracker* tr, uint16_t pos) {
+    const uint8_t* song = tr->song_data;
+    uint16_t end = tr->pattern_end;
+    
+    if (pos >= end) return end;
+    uint8_t flags = song[pos++];
+    uint8_t c = flags & TRACKER_EVENT_CHANNEL;
+    uint8_t channel_id = (c < tr->num_channels) ? tr->channel_map[c] : MAX_CHANNELS;
+    
+    // One operand byte per flag, then one per control bit
+    if (pos + __builtin_popcount(flags & ~TRACKER_EVENT_CHANNEL) > end) return end;
+    uint8_t note = (flags & TRACKER_EVENT_NOTE) ? song[pos++] : 0;
+    uint8_t instrument = (flags & TRACKER_EVENT_INSTRUMENT) ? song[pos++] : 0;
+    uint8_t volume = (flags & TRACKER_EVENT_VOLUME) ? song[pos++] : 0;
+    uint8_t control = (flags & TRACKER_EVENT_CONTROL) ? song[pos++] : 0;
+    
+    uint8_t control_mask = TRACKER_CTRL_PITCH_CURVE | TRACKER_CTRL_VOLUME_CURVE |
+                           TRACKER_CTRL_SPEED | TRACKER_CTRL_TEMPO;
+    if (pos + __builtin_popcount(control & control_mask) > end) return end;
+    uint8_t pitch_curve = (control & TRACKER_CTRL_PITCH_CURVE) ? song[pos++] : 0;
+    uint8_t volume_curve = (control & TRACKER_CTRL_VOLUME_CURVE) ? song[pos++] : 0;
+    
+    // Timing applies even when the channel isn't allocated
+    if (control & TRACKER_CTRL_SPEED) {
+        uint8_t speed = song[pos++];
+        if (speed > 0) tr->ticks_per_row = speed;
+    }
+    if (control & TRACKER_CTRL_TEMPO) {
+        uint8_t tempo = song[pos++];
+        if (tempo > 0) tr->tempo = tempo;
+    }
+    
+    // Skip if this channel isn't allocated
+    if (channel_id >= MAX_CHANNELS) return pos;
+    
+    if (note > 0) {
+        trigger_tracker_note(channel_id, note, instrument);
         
-        // Process effect
-        if (note->effect > 0) {
-            process_tracker_effect(tracker_id, channel_id, note->effect, note->effect_param);
+        // Curves restart with the note they shape
+        TrackerVoice* v = &tr->voices[c];
+        v->pitch_pos = v->volume_pos = 0;
+        v->pitch_offset = v->volume_offset = 0;
+    }
+    
+    if (volume > 0) {
+        channels[channel_id].volume = volume;
+        channels[channel_id].base_volume = volume;
+    }
+    
+    if (control & TRACKER_CTRL_PITCH_CURVE) {
+        set_tracker_curve(tr, c, channel_id, false, pitch_curve);
+    }
+    if (control & TRACKER_CTRL_VOLUME_CURVE) {
+        set_tracker_curve(tr, c, channel_id, true, volume_curve);
+    }
+    
+    return pos;
+}
+
+void process_tracker_row(uint8_t tracker_id) {
+    Tracker* tr = &trackers[tracker_id];
+    
+    // Only rows that carry events cost anything
+    while (tr->cursor < tr->pattern_end && tr->event_row == tr->current_row) {
+        tr->cursor = dispatch_tracker_event(tr, tr->cursor + 1);
+        if (tr->cursor < tr->pattern_end) {
+            tr->event_row += tr->song_data[tr->cursor];
         }
     }
 }
@@ -1458,14 +3258,14 @@ void update_tracker(uint32_t elapsed_us) {
         
         if (!tr->playing) continue;
         
-        // Calculate tick duration based on tempo
-        uint32_t tick_us = 2500000 / tr->tempo; // 2.5M = 60 sec * 1M microseconds / 24 ticks per quarter note
-        
         // Add elapsed time to accumulator
         tr->tick_accumulator += elapsed_us;
         
         // Process ticks
-        while (tr->tick_accumulator >= tick_us) {
+        while (tr->playing) {
+            // Calculate tick duration based on tempo
+            uint32_t tick_us = 2500000 / tr->tempo; // 2.5M = 60 sec * 1M microseconds / 24 ticks per quarter note
+            if (tr->tick_accumulator < tick_us) break;
             tr->tick_accumulator -= tick_us;
             
             // Increment tick counter
@@ -1480,8 +3280,6 @@ void update_tracker(uint32_t elapsed_us) {
                 
                 // Check if we've reached the end of the pattern
                 if (tr->current_row >= tr->rows_per_pattern) {
-                    tr->current_row = 0;
-                    
                     // Move to next pattern
                     tr->position_in_sequence++;
                     
@@ -1495,182 +3293,78 @@ void update_tracker(uint32_t elapsed_us) {
                         }
                     }
                     
-                    // Set current pattern
-                    tr->current_pattern = tr->pattern_sequence[tr->position_in_sequence];
+                    enter_tracker_pattern(tr);
                 }
                 
                 // Process new row
                 process_tracker_row(t);
             } else {
-                // Process per-tick effects (like arpeggio, vibrato, etc.)
+                // Step the per-tick effect curves
                 process_tracker_tick_effects(t);
             }
         }
     }
 }
 
-void process_tracker_effect(uint8_t tracker_id, uint8_t channel_id, uint8_t effect, uint8_t param) {
-    // Apply appropriate effect based on code and parameter
-    switch (effect) {
-        case 0x0: // Arpeggio
-            if (param != 0) {
-                channels[channel_id].arpeggio_enabled = true;
-                channels[channel_id].arpeggio_note1 = param >> 4;    // First semitone offset
-                channels[channel_id].arpeggio_note2 = param & 0x0F;  // Second semitone offset
-                channels[channel_id].arpeggio_counter = 0;
-            } else {
-                channels[channel_id].arpeggio_enabled = false;
-            }
-            break;
-            
-        case 0x1: // Portamento up
-            channels[channel_id].portamento_up = param;
-            channels[channel_id].portamento_active = true;
-            break;
-            
-        case 0x2: // Portamento down
-            channels[channel_id].portamento_down = param;
-            channels[channel_id].portamento_active = true;
-            break;
-            
-        case 0x4: // Vibrato
-            channels[channel_id].vibrato_speed = param >> 4;
-            channels[channel_id].vibrato_depth = param & 0x0F;
-            channels[channel_id].vibrato_active = true;
-            break;
-            
-        case 0x7: // Tremolo
-            channels[channel_id].tremolo_speed = param >> 4;
-            channels[channel_id].tremolo_depth = param & 0x0F;
-            channels[channel_id].tremolo_active = true;
-            break;
-            
-        case 0xA: // Volume slide
-            {
-                uint8_t up = param >> 4;
-                uint8_t down = param & 0x0F;
-                
-                if (up > 0) {
-                    channels[channel_id].volume_slide = up;
-                    channels[channel_id].volume_slide_direction = 1;
-                } else {
-                    channels[channel_id].volume_slide = down;
-                    channels[channel_id].volume_slide_direction = -1;
-                }
-                
-                channels[channel_id].volume_slide_active = true;
-            }
-            break;
-            
-        case 0xF: // Set tempo/speed
-            if (param <= 0x1F) {
-                trackers[tracker_id].ticks_per_row = param;
-            } else {
-                trackers[tracker_id].tempo = param;
-            }
-            break;
+// Advance a curve one tick and return the voice's new offset
+static int16_t step_tracker_curve(const Tracker* tr, uint8_t curve, uint8_t* pos, int16_t offset, int16_t limit) {
+    const uint8_t* data = &tr->song_data[tr->curve_offset[curve]];
+    uint8_t length = data[1];
+    const uint8_t* value = &data[2 + *pos * 2];
+    int32_t step = (int16_t)(value[0] | (value[1] << 8));
+    
+    *pos = (*pos + 1 < length) ? *pos + 1 : 0;
+    
+    if (data[0] & TRACKER_CURVE_RAMP) {
+        step += offset;
+        if (step > limit) step = limit;
+        if (step < -limit) step = -limit;
     }
+    return (int16_t)step;
 }
 
 void process_tracker_tick_effects(uint8_t tracker_id) {
     Tracker* tr = &trackers[tracker_id];
     
-    // Process active tick effects for each channel
-    for (int c = 0; c < tr->num_channels; c++) {
+    // Visit only the channels with a curve running
+    uint16_t pending = tr->curve_mask;
+    while (pending) {
+        uint8_t c = __builtin_ctz(pending);
+        pending &= pending - 1;
+        
+        TrackerVoice* v = &tr->voices[c];
         uint8_t channel_id = tr->channel_map[c];
         
         if (channel_id >= MAX_CHANNELS || !channels[channel_id].active) continue;
         
-        // Apply arpeggio
-        if (channels[channel_id].arpeggio_enabled) {
-            float base_freq = channels[channel_id].base_frequency;
-            int semitones = 0;
-            
-            switch (channels[channel_id].arpeggio_counter % 3) {
-                case 0: semitones = 0; break;
-                case 1: semitones = channels[channel_id].arpeggio_note1; break;
-                case 2: semitones = channels[channel_id].arpeggio_note2; break;
-            }
-            
-            if (semitones > 0) {
-                channels[channel_id].frequency = base_freq * powf(2.0f, semitones / 12.0f);
-                update_channel_frequency(channel_id);
-            } else {
-                channels[channel_id].frequency = base_freq;
-                update_channel_frequency(channel_id);
-            }
-            
-            channels[channel_id].arpeggio_counter++;
-        }
-        
-        // Apply portamento
-        if (channels[channel_id].portamento_active) {
-            if (channels[channel_id].portamento_up > 0) {
-                channels[channel_id].frequency *= powf(2.0f, channels[channel_id].portamento_up / (12.0f * 16.0f));
-                update_channel_frequency(channel_id);
-            } else if (channels[channel_id].portamento_down > 0) {
-                channels[channel_id].frequency /= powf(2.0f, channels[channel_id].portamento_down / (12.0f * 16.0f));
-                update_channel_frequency(channel_id);
-            }
-        }
-        
-        // Apply vibrato
-        if (channels[channel_id].vibrato_active) {
-            float depth = channels[channel_id].vibrato_depth / 16.0f;  // Semitones
-            
-            // Calculate vibrato sine wave
-            channels[channel_id].vibrato_phase += channels[channel_id].vibrato_speed;
-            float vibrato_value = sinf(channels[channel_id].vibrato_phase * 0.1f) * depth;
-            
-            // Apply to frequency
-            float base_freq = channels[channel_id].base_frequency;
-            channels[channel_id].frequency = base_freq * powf(2.0f, vibrato_value / 12.0f);
+        if (v->pitch_curve != TRACKER_CURVE_NONE) {
+            v->pitch_offset = step_tracker_curve(tr, v->pitch_curve, &v->pitch_pos,
+                                                 v->pitch_offset, TRACKER_PITCH_LIMIT);
+            channels[channel_id].frequency = channels[channel_id].base_frequency *
+                                             tracker_pitch_scale(v->pitch_offset);
             update_channel_frequency(channel_id);
         }
         
-        // Apply tremolo
-        if (channels[channel_id].tremolo_active) {
-            uint8_t depth = channels[channel_id].tremolo_depth;
-            
-            // Calculate tremolo sine wave
-            channels[channel_id].tremolo_phase += channels[channel_id].tremolo_speed;
-            float tremolo_value = (sinf(channels[channel_id].tremolo_phase * 0.1f) + 1.0f) * 0.5f;
-            
-            // Apply to volume
-            uint8_t base_volume = channels[channel_id].base_volume;
-            uint8_t tremolo_amount = (uint8_t)(depth * tremolo_value);
-            
-            if (tremolo_amount > base_volume) {
-                channels[channel_id].volume = 0;
-            } else {
-                channels[channel_id].volume = base_volume - tremolo_amount;
-            }
-        }
-        
-        // Apply volume slide
-        if (channels[channel_id].volume_slide_active) {
-            if (channels[channel_id].volume_slide_direction > 0) {
-                channels[channel_id].volume += channels[channel_id].volume_slide;
-                if (channels[channel_id].volume > 255) {
-                    channels[channel_id].volume = 255;
-                }
-            } else {
-                if (channels[channel_id].volume < channels[channel_id].volume_slide) {
-                    channels[channel_id].volume = 0;
-                } else {
-                    channels[channel_id].volume -= channels[channel_id].volume_slide;
-                }
-            }
+        if (v->volume_curve != TRACKER_CURVE_NONE) {
+            v->volume_offset = step_tracker_curve(tr, v->volume_curve, &v->volume_pos,
+                                                  v->volume_offset, 255);
+            int32_t volume = channels[channel_id].base_volume + v->volume_offset;
+            channels[channel_id].volume = (volume < 0) ? 0 : (volume > 255) ? 255 : volume;
         }
     }
 }
 
 //Effects Processing
+#define REVERB_LINES 6          // Four parallel combs, then two allpasses in series
+#define MIX_BUS_LIMIT 65535     // Q15 bus saturates just under +/-2.0 before the effects
+#define FILTER_STATE_LIMIT MIX_BUS_LIMIT  // Keeps voice * Q15 gain inside 32 bits
+
 typedef struct {
     bool enabled;
     uint8_t room_size;
     uint8_t damping;
     uint8_t wet;
+    uint8_t dry;
     
     // Reverb algorithm parameters
     float feedback;
@@ -1678,14 +3372,25 @@ typedef struct {
     float wet_gain;
     float dry_gain;
     
-    // Delay lines
-    float* buffer;
-    uint32_t buffer_size;
-    uint32_t comb1_idx, comb2_idx, comb3_idx, comb4_idx;
-    uint32_t ap1_idx, ap2_idx;
+    // Q15 copies for the fixed mixing bus
+    int32_t feedback_q15;
+    int32_t damp_q15;        // 1 - lp_coeff
+    int32_t wet_q15;
+    int32_t dry_q15;
+    
+    // Delay lines: each gets its own power-of-two region of the buffer and
+    // is read at (pos - length) & mask against one shared write counter
+    float* buffer;           // Float pipeline
+    int16_t* buffer_q15;     // Fixed pipeline
+    uint32_t buffer_size;    // Entries across all lines
+    uint32_t line_offset[REVERB_LINES];
+    uint32_t line_length[REVERB_LINES];
+    uint32_t line_mask[REVERB_LINES];
+    uint32_t pos;
     
     // Filter state
-    float comb1_lp, comb2_lp, comb3_lp, comb4_lp;
+    float comb_lp[4];
+    int32_t comb_lp_q15[4];
     
     uint8_t prev_room_size;
 } Reverb;
@@ -1702,10 +3407,14 @@ typedef struct {
     float feedback_gain;
     float wet_gain;
     float dry_gain;
+    int32_t feedback_q15;
+    int32_t wet_q15;
+    int32_t dry_q15;
     
-    // Delay buffer
+    // Delay buffer: interleaved stereo frames, power-of-two capacity
     int16_t* buffer;
-    uint32_t buffer_size;
+    uint32_t buffer_frames;
+    uint32_t frame_mask;
     uint32_t write_pos;
     uint32_t prev_samples;
 } Delay;
@@ -1718,15 +3427,59 @@ typedef struct {
     
     // Filter coefficients
     float a0, a1, a2, b1, b2;
+    int32_t a0_q14, a1_q14, a2_q14, b1_q14, b2_q14;
     
-    // Filter state
-    float x1, x2, y1, y2;
+    // Filter state, one set per stereo side
+    float x1[2], x2[2], y1[2], y2[2];
+    int32_t xq1[2], xq2[2], yq1[2], yq2[2];
 } Filter;
 
 Reverb reverb;
 Delay delay;
 Filter filters[MAX_CHANNELS];
 
+static inline int32_t saturate_q15(int32_t value) {
+    return value > 32767 ? 32767 : (value < -32768 ? -32768 : value);
+}
+
+static void clear_reverb_lines() {
+    if (reverb.buffer) memset(reverb.buffer, 0, reverb.buffer_size * sizeof(float));
+    if (reverb.buffer_q15) memset(reverb.buffer_q15, 0, reverb.buffer_size * sizeof(int16_t));
+    memset(reverb.comb_lp, 0, sizeof(reverb.comb_lp));
+    memset(reverb.comb_lp_q15, 0, sizeof(reverb.comb_lp_q15));
+}
+
+// Lay the comb and allpass lines out in power-of-two regions. Only the
+// buffer for the active mixing pipeline is allocated.
+bool init_reverb_lines() {
+    static const uint32_t lengths[REVERB_LINES] = {
+        REVERB_COMB1_LENGTH, REVERB_COMB2_LENGTH, REVERB_COMB3_LENGTH,
+        REVERB_COMB4_LENGTH, REVERB_AP1_LENGTH, REVERB_AP2_LENGTH
+    };
+    
+    uint32_t offset = 0;
+    for (int line = 0; line < REVERB_LINES; line++) {
+        uint32_t capacity = 1;
+        while (capacity < lengths[line]) capacity <<= 1;
+        
+        reverb.line_offset[line] = offset;
+        reverb.line_length[line] = lengths[line];
+        reverb.line_mask[line] = capacity - 1;
+        offset += capacity;
+    }
+    
+    reverb.buffer_size = offset;
+    reverb.pos = 0;
+    if (use_fixed_mixing) {
+        reverb.buffer_q15 = malloc(offset * sizeof(int16_t));
+    } else {
+        reverb.buffer = malloc(offset * sizeof(float));
+    }
+    
+    clear_reverb_lines();
+    return reverb.buffer != NULL || reverb.buffer_q15 != NULL;
+}
+
 void configure_reverb(uint8_t room_size, uint8_t damping, uint8_t wet) {
     reverb.room_size = room_size;
     reverb.damping = damping;
@@ -1744,13 +3497,18 @@ void configure_reverb(uint8_t room_size, uint8_t damping, uint8_t wet) {
     reverb.wet_gain = normalized_wet;
     reverb.dry_gain = 1.0f - normalized_wet * 0.5f;
     
+    reverb.feedback_q15 = (int32_t)(reverb.feedback * 32768.0f);
+    reverb.damp_q15 = (int32_t)((1.0f - reverb.lp_coeff) * 32768.0f);
+    reverb.wet_q15 = (int32_t)(reverb.wet_gain * 32767.0f);
+    reverb.dry_q15 = (int32_t)(reverb.dry_gain * 32767.0f);
+    
     // Clear buffer if room size changed significantly
     if (abs(reverb.prev_room_size - room_size) > 50) {
-        memset(reverb.buffer, 0, reverb.buffer_size * sizeof(float));
+        clear_reverb_lines();
     }
     
     reverb.prev_room_size = room_size;
-    reverb.enabled = (wet > 0);
+    reverb.enabled = (wet > 0) && (reverb.buffer != NULL || reverb.buffer_q15 != NULL);
     
     send_ack_to_cpu(CMD_EFFECT_SET_REVERB);
 }
@@ -1760,8 +3518,8 @@ void configure_delay(uint16_t delay_time, uint8_t feedback, uint8_t wet) {
     uint32_t delay_samples = (delay_time * SAMPLE_RATE) / 1000;
     
     // Ensure delay_samples is within buffer capacity
-    if (delay_samples > delay.buffer_size / 2) {
-        delay_samples = delay.buffer_size / 2;
+    if (delay_samples > delay.frame_mask) {
+        delay_samples = delay.frame_mask;
     }
     
     delay.time = delay_time;
@@ -1774,15 +3532,18 @@ void configure_delay(uint16_t delay_time, uint8_t feedback, uint8_t wet) {
     delay.feedback_gain = feedback / 255.0f;
     delay.wet_gain = wet / 255.0f;
     delay.dry_gain = delay.dry / 255.0f;
+    delay.feedback_q15 = (feedback * 32767) / 255;
+    delay.wet_q15 = (wet * 32767) / 255;
+    delay.dry_q15 = (delay.dry * 32767) / 255;
     
     // Clear buffer if delay time changed significantly
     if (abs((int32_t)delay.prev_samples - (int32_t)delay_samples) > SAMPLE_RATE / 50) {
-        memset(delay.buffer, 0, delay.buffer_size * sizeof(int16_t));
+        memset(delay.buffer, 0, delay.buffer_frames * 2 * sizeof(int16_t));
     }
     
     delay.prev_samples = delay_samples;
     delay.write_pos = 0;
-    delay.enabled = (wet > 0);
+    delay.enabled = (wet > 0) && (delay.buffer != NULL);
     
     send_ack_to_cpu(CMD_EFFECT_SET_DELAY);
 }
@@ -1822,132 +3583,262 @@ void configure_filter(uint8_t channel_id, uint8_t filter_type, uint8_t cutoff, u
             return;
     }
     
+    // Q14 leaves room for the |b1| < 2 pole coefficient
+    filter->a0_q14 = (int32_t)(filter->a0 * 16384.0f);
+    filter->a1_q14 = (int32_t)(filter->a1 * 16384.0f);
+    filter->a2_q14 = (int32_t)(filter->a2 * 16384.0f);
+    filter->b1_q14 = (int32_t)(filter->b1 * 16384.0f);
+    filter->b2_q14 = (int32_t)(filter->b2 * 16384.0f);
+    
     // Reset filter state
-    filter->x1 = 0;
-    filter->x2 = 0;
-    filter->y1 = 0;
-    filter->y2 = 0;
+    memset(filter->x1, 0, sizeof(filter->x1));
+    memset(filter->x2, 0, sizeof(filter->x2));
+    memset(filter->y1, 0, sizeof(filter->y1));
+    memset(filter->y2, 0, sizeof(filter->y2));
+    memset(filter->xq1, 0, sizeof(filter->xq1));
+    memset(filter->xq2, 0, sizeof(filter->xq2));
+    memset(filter->yq1, 0, sizeof(filter->yq1));
+    memset(filter->yq2, 0, sizeof(filter->yq2));
     
     filter->enabled = true;
     
     send_ack_to_cpu(CMD_EFFECT_SET_FILTER);
 }
 
-void apply_reverb(float* buffer, uint32_t num_samples) {
-    if (!reverb.enabled) return;
+// Per-voice reverb/delay sends; voices start routed to every effect
+void configure_channel_routing(uint8_t channel_id, uint8_t effect_mask) {
+    if (channel_id >= MAX_CHANNELS) {
+        send_error(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    channels[channel_id].effect_routing = effect_mask;
+    
+    send_ack_to_cpu(CMD_EFFECT_CHANNEL_ROUTING);
+}
+
+// Send/return: reads the reverb send bus and adds the wet return into bus
+void apply_reverb(float* bus, const float* send, uint32_t num_samples) {
+    if (!reverb.enabled || reverb.buffer == NULL) return;
     
+    float* lines = reverb.buffer;
     float feedback = reverb.feedback;
     float lp_coeff = reverb.lp_coeff;
+    uint32_t pos = reverb.pos;
     
     for (uint32_t i = 0; i < num_samples; i++) {
-        // Get current stereo sample
-        float left = buffer[i*2];
-        float right = buffer[i*2+1];
-        
-        // Mix to mono for reverb processing
-        float mono_input = (left + right) * 0.5f;
-        
-        // Apply comb filters (parallel)
-        float comb1 = reverb.buffer[reverb.comb1_idx];
-        float comb2 = reverb.buffer[reverb.comb2_idx];
-        float comb3 = reverb.buffer[reverb.comb3_idx];
-        float comb4 = reverb.buffer[reverb.comb4_idx];
-        
-        // Apply lowpass filtering and feedback
-        reverb.comb1_lp = (reverb.comb1_lp * lp_coeff) + (comb1 * (1.0f - lp_coeff));
-        reverb.comb2_lp = (reverb.comb2_lp * lp_coeff) + (comb2 * (1.0f - lp_coeff));
-        reverb.comb3_lp = (reverb.comb3_lp * lp_coeff) + (comb3 * (1.0f - lp_coeff));
-        reverb.comb4_lp = (reverb.comb4_lp * lp_coeff) + (comb4 * (1.0f - lp_coeff));
-        
-        // Write back to comb filters
-        reverb.buffer[reverb.comb1_idx] = mono_input + (reverb.comb1_lp * feedback);
-        reverb.buffer[reverb.comb2_idx] = mono_input + (reverb.comb2_lp * feedback);
-        reverb.buffer[reverb.comb3_idx] = mono_input + (reverb.comb3_lp * feedback);
-        reverb.buffer[reverb.comb4_idx] = mono_input + (reverb.comb4_lp * feedback);
-        
-        // Advance comb indices with wraparound
-        reverb.comb1_idx = (reverb.comb1_idx + 1) % REVERB_COMB1_LENGTH;
-        reverb.comb2_idx = (reverb.comb2_idx + 1) % REVERB_COMB2_LENGTH;
-        reverb.comb3_idx = (reverb.comb3_idx + 1) % REVERB_COMB3_LENGTH;
-        reverb.comb4_idx = (reverb.comb4_idx + 1) % REVERB_COMB4_LENGTH;
+        // Mix the send to mono for reverb processing
+        float mono_input = (send[i*2] + send[i*2+1]) * 0.5f;
+        
+        // Comb filters (parallel) with lowpass filtering in the feedback path
+        float comb_sum = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            float* line = &lines[reverb.line_offset[c]];
+            uint32_t mask = reverb.line_mask[c];
+            float comb = line[(pos - reverb.line_length[c]) & mask];
+            
+            reverb.comb_lp[c] = (reverb.comb_lp[c] * lp_coeff) + (comb * (1.0f - lp_coeff));
+            line[pos & mask] = mono_input + (reverb.comb_lp[c] * feedback);
+            comb_sum += comb;
+        }
         
         // Sum comb outputs and apply allpass filters in series
-        float allpass_input = (comb1 + comb2 + comb3 + comb4) * 0.25f;
+        float allpass = comb_sum * 0.25f;
+        for (int a = 4; a < REVERB_LINES; a++) {
+            float* line = &lines[reverb.line_offset[a]];
+            uint32_t mask = reverb.line_mask[a];
+            float ap_out = line[(pos - reverb.line_length[a]) & mask] - allpass * 0.5f;
+            
+            line[pos & mask] = allpass + ap_out * 0.5f;
+            allpass = ap_out;
+        }
+        
+        pos++;
+        
+        // Return; the dry gain was applied per voice
+        bus[i*2] += allpass * reverb.wet_gain;
+        bus[i*2+1] += allpass * reverb.wet_gain;
+    }
+    
+    reverb.pos = pos;
+}
+
+// Same topology on the Q15 bus; lines are int16 and saturate on write
+void apply_reverb_q15(int32_t* bus, const int32_t* send, uint32_t num_samples) {
+    if (!reverb.enabled || reverb.buffer_q15 == NULL) return;
+    
+    int16_t* lines = reverb.buffer_q15;
+    int32_t feedback = reverb.feedback_q15;
+    int32_t damp = reverb.damp_q15;
+    uint32_t pos = reverb.pos;
+    
+    for (uint32_t i = 0; i < num_samples; i++) {
+        int32_t mono_input = (send[i*2] + send[i*2+1]) >> 1;
+        
+        int32_t comb_sum = 0;
+        for (int c = 0; c < 4; c++) {
+            int16_t* line = &lines[reverb.line_offset[c]];
+            uint32_t mask = reverb.line_mask[c];
+            int32_t comb = line[(pos - reverb.line_length[c]) & mask];
+            
+            reverb.comb_lp_q15[c] += ((comb - reverb.comb_lp_q15[c]) * damp) >> 15;
+            line[pos & mask] = saturate_q15(mono_input + ((reverb.comb_lp_q15[c] * feedback) >> 15));
+            comb_sum += comb;
+        }
         
-        // First allpass filter
-        float ap1_in = allpass_input;
-        float ap1_out = reverb.buffer[reverb.ap1_idx] - ap1_in * 0.5f;
-        reverb.buffer[reverb.ap1_idx] = ap1_in + ap1_out * 0.5f;
-        reverb.ap1_idx = (reverb.ap1_idx + 1) % REVERB_AP1_LENGTH;
+        int32_t allpass = comb_sum >> 2;
+        for (int a = 4; a < REVERB_LINES; a++) {
+            int16_t* line = &lines[reverb.line_offset[a]];
+            uint32_t mask = reverb.line_mask[a];
+            int32_t ap_out = line[(pos - reverb.line_length[a]) & mask] - (allpass >> 1);
+            
+            line[pos & mask] = saturate_q15(allpass + (ap_out >> 1));
+            allpass = ap_out;
+        }
         
-        // Second allpass filter
-        float ap2_in = ap1_out;
-        float ap2_out = reverb.buffer[reverb.ap2_idx] - ap2_in * 0.5f;
-        reverb.buffer[reverb.ap2_idx] = ap2_in + ap2_out * 0.5f;
-        reverb.ap2_idx = (reverb.ap2_idx + 1) % REVERB_AP2_LENGTH;
+        pos++;
         
-        // Mix reverb output with dry signal
-        buffer[i*2] = left * reverb.dry_gain + ap2_out * reverb.wet_gain;
-        buffer[i*2+1] = right * reverb.dry_gain + ap2_out * reverb.wet_gain;
+        int32_t wet = (allpass * reverb.wet_q15) >> 15;
+        bus[i*2] += wet;
+        bus[i*2+1] += wet;
     }
+    
+    reverb.pos = pos;
 }
 
-void apply_delay(float* buffer, uint32_t num_samples) {
+// Send/return like the reverb
+void apply_delay(float* bus, const float* send, uint32_t num_samples) {
     if (!delay.enabled) return;
     
+    uint32_t mask = delay.frame_mask;
+    
     for (uint32_t i = 0; i < num_samples; i++) {
         // Calculate read position
-        uint32_t read_pos = (delay.write_pos + delay.buffer_size - delay.samples) % delay.buffer_size;
+        uint32_t read_pos = (delay.write_pos - delay.samples) & mask;
         
         // Get delayed sample
         float delay_left = delay.buffer[read_pos*2] / 32768.0f;
         float delay_right = delay.buffer[read_pos*2+1] / 32768.0f;
         
-        // Get current sample
-        float left = buffer[i*2];
-        float right = buffer[i*2+1];
+        // Get current send sample
+        float left = send[i*2];
+        float right = send[i*2+1];
         
         // Calculate new sample with feedback
         float new_left = left + delay_left * delay.feedback_gain;
         float new_right = right + delay_right * delay.feedback_gain;
         
         // Write to delay buffer (convert to int16_t)
-        delay.buffer[delay.write_pos*2] = (int16_t)(new_left * 32767.0f);
-        delay.buffer[delay.write_pos*2+1] = (int16_t)(new_right * 32767.0f);
+        delay.buffer[delay.write_pos*2] = (int16_t)saturate_q15((int32_t)(new_left * 32767.0f));
+        delay.buffer[delay.write_pos*2+1] = (int16_t)saturate_q15((int32_t)(new_right * 32767.0f));
         
         // Advance write position
-        delay.write_pos = (delay.write_pos + 1) % delay.buffer_size;
+        delay.write_pos = (delay.write_pos + 1) & mask;
+        
+        // Return the delayed signal
+        bus[i*2] += delay_left * delay.wet_gain;
+        bus[i*2+1] += delay_right * delay.wet_gain;
+    }
+}
+
+void apply_delay_q15(int32_t* bus, const int32_t* send, uint32_t num_samples) {
+    if (!delay.enabled) return;
+    
+    int16_t* line = delay.buffer;
+    uint32_t mask = delay.frame_mask;
+    uint32_t write_pos = delay.write_pos;
+    
+    for (uint32_t i = 0; i < num_samples; i++) {
+        uint32_t read_pos = (write_pos - delay.samples) & mask;
+        int32_t delay_left = line[read_pos*2];
+        int32_t delay_right = line[read_pos*2+1];
+        
+        int32_t left = send[i*2];
+        int32_t right = send[i*2+1];
         
-        // Mix delayed and dry signal
-        buffer[i*2] = left * delay.dry_gain + delay_left * delay.wet_gain;
-        buffer[i*2+1] = right * delay.dry_gain + delay_right * delay.wet_gain;
+        line[write_pos*2] = saturate_q15(left + ((delay_left * delay.feedback_q15) >> 15));
+        line[write_pos*2+1] = saturate_q15(right + ((delay_right * delay.feedback_q15) >> 15));
+        write_pos = (write_pos + 1) & mask;
+        
+        bus[i*2] += (delay_left * delay.wet_q15) >> 15;
+        bus[i*2+1] += (delay_right * delay.wet_q15) >> 15;
     }
+    
+    delay.write_pos = write_pos;
 }
 
-void apply_filter(uint8_t channel_id, float* buffer, uint32_t num_samples) {
+// Biquad over a planar voice block (one or two planes), state per plane
+void apply_filter(uint8_t channel_id, float* left, float* right, uint8_t planes, uint32_t num_samples) {
     Filter* filter = &filters[channel_id];
     
     if (!filter->enabled) return;
     
-    for (uint32_t i = 0; i < num_samples; i++) {
-        // Get input sample
-        float input = buffer[i];
+    for (int side = 0; side < planes; side++) {
+        float* buffer = side ? right : left;
+        float x1 = filter->x1[side], x2 = filter->x2[side];
+        float y1 = filter->y1[side], y2 = filter->y2[side];
+        
+        for (uint32_t i = 0; i < num_samples; i++) {
+            float input = buffer[i];
+            
+            // Apply biquad filter
+            float output = filter->a0 * input + 
+                          filter->a1 * x1 + 
+                          filter->a2 * x2 - 
+                          filter->b1 * y1 - 
+                          filter->b2 * y2;
+            
+            x2 = x1;
+            x1 = input;
+            y2 = y1;
+            y1 = output;
+            
+            buffer[i] = output;
+        }
         
-        // Apply biquad filter
-        float output = filter->a0 * input + 
-                      filter->a1 * filter->x1 + 
-                      filter->a2 * filter->x2 - 
-                      filter->b1 * filter->y1 - 
-                      filter->b2 * filter->y2;
+        filter->x1[side] = x1;
+        filter->x2[side] = x2;
+        filter->y1[side] = y1;
+        filter->y2[side] = y2;
+    }
+}
+
+void apply_filter_q15(uint8_t channel_id, int32_t* left, int32_t* right, uint8_t planes, uint32_t num_samples) {
+    Filter* filter = &filters[channel_id];
+    
+    if (!filter->enabled) return;
+    
+    for (int side = 0; side < planes; side++) {
+        int32_t* buffer = side ? right : left;
+        int32_t x1 = filter->xq1[side], x2 = filter->xq2[side];
+        int32_t y1 = filter->yq1[side], y2 = filter->yq2[side];
         
-        // Update filter state
-        filter->x2 = filter->x1;
-        filter->x1 = input;
-        filter->y2 = filter->y1;
-        filter->y1 = output;
+        for (uint32_t i = 0; i < num_samples; i++) {
+            int32_t input = buffer[i];
+            
+            int64_t acc = (int64_t)filter->a0_q14 * input +
+                          (int64_t)filter->a1_q14 * x1 +
+                          (int64_t)filter->a2_q14 * x2 -
+                          (int64_t)filter->b1_q14 * y1 -
+                          (int64_t)filter->b2_q14 * y2;
+            int32_t output = (int32_t)(acc >> 14);
+            
+            // Keep a ringing high-resonance filter from running away
+            if (output > FILTER_STATE_LIMIT) output = FILTER_STATE_LIMIT;
+            if (output < -FILTER_STATE_LIMIT) output = -FILTER_STATE_LIMIT;
+            
+            x2 = x1;
+            x1 = input;
+            y2 = y1;
+            y1 = output;
+            
+            buffer[i] = output;
+        }
         
-        // Write output
-        buffer[i] = output;
+        filter->xq1[side] = x1;
+        filter->xq2[side] = x2;
+        filter->yq1[side] = y1;
+        filter->yq2[side] = y2;
     }
 }
 
@@ -1974,82 +3865,383 @@ void generate_wavetable_sample(Waveform* wave, float phase, float morph) {
 
 //Main Audio Processing and Output
 // Buffer for final audio output
-float mix_buffer[AUDIO_BUFFER_SIZE * 2];  // Stereo
+// Each core accumulates into its own dry bus and effect send buses; core 1
+// merges core 0's set into its own. Only one pipeline is live, so the float
+// and Q15 views share storage.
+#define MIX_BUS_DRY 0
+#define MIX_BUS_DELAY 1
+#define MIX_BUS_REVERB 2
+#define MIX_BUS_COUNT 3
+
+typedef union {
+    float f[AUDIO_BUFFER_SIZE * 2];     // Interleaved stereo
+    int32_t q15[AUDIO_BUFFER_SIZE * 2]; // Q15 samples, 16 bits of headroom
+} MixBus;
+
+typedef union {
+    float f[2][AUDIO_BUFFER_SIZE];      // Planar left/right voice block
+    int32_t q15[2][AUDIO_BUFFER_SIZE];
+} VoiceScratch;
+
+MixBus mix_buses[2][MIX_BUS_COUNT];
+VoiceScratch voice_scratch[2];
+int16_t pcm_buffer[AUDIO_BUFFER_SIZE * 2]; // Final 16-bit stereo, feeds both PWM and I2S
+
+// Soft clipper shared by both pipelines: unity below the knee, then a tanh
+// shoulder that leaves the knee at unity slope and approaches full scale
+#define SOFT_CLIP_KNEE 0.75f
+
+static inline float soft_clip_curve(float x) {
+    float magnitude = fabsf(x);
+    if (magnitude < SOFT_CLIP_KNEE) return x;
+    float y = SOFT_CLIP_KNEE + (1.0f - SOFT_CLIP_KNEE) *
+              tanhf((magnitude - SOFT_CLIP_KNEE) / (1.0f - SOFT_CLIP_KNEE));
+    return (x < 0.0f) ? -y : y;
+}
 
-// Generate audio data
-void generate_audio_buffer() {
-    // Clear mix buffer
-    memset(mix_buffer, 0, AUDIO_BUFFER_SIZE * 2 * sizeof(float));
+// The fixed pipeline's copy of the curve, indexed by Q15 magnitude over
+// [0, 4.0) and linearly interpolated
+#define SOFT_CLIP_LUT_BITS 10
+#define SOFT_CLIP_LUT_SHIFT 7
+#define SOFT_CLIP_LUT_SIZE (1 << SOFT_CLIP_LUT_BITS)
+
+int16_t soft_clip_lut[SOFT_CLIP_LUT_SIZE + 1];
+
+void init_soft_clip_lut() {
+    for (int i = 0; i <= SOFT_CLIP_LUT_SIZE; i++) {
+        float y = soft_clip_curve(i * 4.0f / SOFT_CLIP_LUT_SIZE);
+        soft_clip_lut[i] = (int16_t)MIN(y * 32767.0f, 32767.0f);
+    }
+}
+
+// Master volume as a Q8 gain for both pipelines: 255 is exactly unity
+static inline int32_t master_gain_q8() {
+    return (master_volume * 256 + 127) / 255;
+}
+
+static inline int16_t soft_clip_q15(int32_t sample) {
+    uint32_t magnitude = (sample < 0) ? -sample : sample;
+    uint32_t index = magnitude >> SOFT_CLIP_LUT_SHIFT;
+    int32_t output;
+    
+    if (index >= SOFT_CLIP_LUT_SIZE) {
+        output = soft_clip_lut[SOFT_CLIP_LUT_SIZE];
+    } else {
+        int32_t a = soft_clip_lut[index];
+        int32_t b = soft_clip_lut[index + 1];
+        int32_t frac = magnitude & ((1 << SOFT_CLIP_LUT_SHIFT) - 1);
+        output = a + (((b - a) * frac) >> SOFT_CLIP_LUT_SHIFT);
+    }
+    
+    return (sample < 0) ? -output : output;
+}
+
+// Voice strip
+// Each voice renders dry into its core's planar scratch, then gets its own
+// filter, volume/pan and effect sends, and is accumulated once into the
+// core's dry bus and send buses. An effect's dry gain is folded into the
+// dry level of the voices routed to it.
+typedef uint8_t (*VoiceRenderer)(uint8_t channel_id, float* left, float* right, uint32_t sample_count);
+typedef uint8_t (*VoiceRendererQ15)(uint8_t channel_id, int32_t* left, int32_t* right, uint32_t sample_count);
+
+VoiceRenderer voice_renderers[3] = {
+    render_fm_channel, render_sample_channel, render_wavetable_channel
+};
+VoiceRendererQ15 voice_renderers_q15[3] = {
+    render_fm_channel_q15, render_sample_channel_q15, render_wavetable_channel_q15
+};
+
+static inline void channel_gains_q15(const Channel* ch, int32_t* gain_left, int32_t* gain_right) {
+    *gain_left = (ch->volume * (255 - ch->pan) * 32768) / 65025;
+    *gain_right = (ch->volume * ch->pan * 32768) / 65025;
+}
+
+static void mix_voice_float(uint8_t channel_id, float* left, float* right, uint8_t planes, MixBus* buses) {
+    Channel* ch = &channels[channel_id];
+    
+    if (filters[channel_id].enabled) {
+        apply_filter(channel_id, left, right, planes, AUDIO_BUFFER_SIZE);
+    }
+    
+    bool to_delay = delay.enabled && (ch->effect_routing & EFFECT_ROUTE_DELAY);
+    bool to_reverb = reverb.enabled && (ch->effect_routing & EFFECT_ROUTE_REVERB);
+    float dry = (to_delay ? delay.dry_gain : 1.0f) * (to_reverb ? reverb.dry_gain : 1.0f);
+    
+    float vol_left = ch->volume * (255 - ch->pan) / 65025.0f;
+    float vol_right = ch->volume * ch->pan / 65025.0f;
+    const float* src_right = (planes == 2) ? right : left;
+    float* dry_bus = buses[MIX_BUS_DRY].f;
+    
+    // Pan in place; the panned planes feed the sends below
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+        float l = left[i] * vol_left;
+        float r = src_right[i] * vol_right;
+        left[i] = l;
+        right[i] = r;
+        dry_bus[i*2] += l * dry;
+        dry_bus[i*2+1] += r * dry;
+    }
+    
+    for (int bus = MIX_BUS_DELAY; bus <= MIX_BUS_REVERB; bus++) {
+        if (!(bus == MIX_BUS_DELAY ? to_delay : to_reverb)) continue;
+        
+        float* send = buses[bus].f;
+        for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+            send[i*2] += left[i];
+            send[i*2+1] += right[i];
+        }
+    }
+}
+
+static void mix_voice_q15(uint8_t channel_id, int32_t* left, int32_t* right, uint8_t planes, MixBus* buses) {
+    Channel* ch = &channels[channel_id];
+    
+    if (filters[channel_id].enabled) {
+        apply_filter_q15(channel_id, left, right, planes, AUDIO_BUFFER_SIZE);
+    }
+    
+    bool to_delay = delay.enabled && (ch->effect_routing & EFFECT_ROUTE_DELAY);
+    bool to_reverb = reverb.enabled && (ch->effect_routing & EFFECT_ROUTE_REVERB);
+    int32_t dry = 32767;
+    if (to_delay) dry = (dry * delay.dry_q15) >> 15;
+    if (to_reverb) dry = (dry * reverb.dry_q15) >> 15;
+    
+    int32_t gain_left, gain_right;
+    channel_gains_q15(ch, &gain_left, &gain_right);
+    const int32_t* src_right = (planes == 2) ? right : left;
+    int32_t* dry_bus = buses[MIX_BUS_DRY].q15;
+    
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+        int32_t l = (left[i] * gain_left) >> 15;
+        int32_t r = (src_right[i] * gain_right) >> 15;
+        left[i] = l;
+        right[i] = r;
+        dry_bus[i*2] += (l * dry) >> 15;
+        dry_bus[i*2+1] += (r * dry) >> 15;
+    }
+    
+    for (int bus = MIX_BUS_DELAY; bus <= MIX_BUS_REVERB; bus++) {
+        if (!(bus == MIX_BUS_DELAY ? to_delay : to_reverb)) continue;
+        
+        int32_t* send = buses[bus].q15;
+        for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+            send[i*2] += left[i];
+            send[i*2+1] += right[i];
+        }
+    }
+}
+
+// Voice split
+// Each period active voices are handed out longest-first to whichever core has
+// the smaller estimated load, using a running average of each channel's
+// measured render time. Core 1 asks for a period over the inter-core FIFO;
+// core 0 plans the split once it has stopped dispatching, both cores render
+// their lists, and core 0 waits for core 1 before going back to commands, so
+// command handlers never change voice state while either core is rendering.
+// Core 1 merges the two sub-mixes and runs the master effects.
+//
+// Core 0 looks for the request between commands, so core 1 waits at most one
+// command (or batch) plus a stream top-up and tracker tick; a command that
+// runs longer than the output ring's headroom will still underrun it.
+#define AUDIO_JOB_RENDER 0xA0D10001  // Core 1 -> 0: render a period
+#define AUDIO_JOB_START 0xA0D10002   // Core 0 -> 1: split planned, voices are free to render
+#define AUDIO_JOB_DONE 0xA0D10003    // Either way: this core's share is mixed
+#define VOICE_COST_SHIFT 2          // Average over ~4 periods
+
+typedef struct {
+    uint8_t channels[MAX_CHANNELS];
+    uint8_t count;
+} VoiceJob;
+
+VoiceJob voice_jobs[2];
+uint32_t voice_cost[MAX_CHANNELS];  // Render time per period, 1/16 us
+uint32_t master_stage_cost = 0;     // Merge + effects + output, 1/16 us
+
+// Seed for voices that have not been measured yet; FM costs several
+// times a sample or wavetable voice
+static const uint32_t voice_default_cost[3] = { 16 * 400, 16 * 80, 16 * 100 };
+
+static void plan_voice_split() {
+    uint8_t order[MAX_CHANNELS];
+    uint32_t cost[MAX_CHANNELS];
+    int count = 0;
     
-    // Process all active channels
+    // Insertion sort of the active voices by descending cost
     for (int ch = 0; ch < MAX_CHANNELS; ch++) {
         if (!channels[ch].active) continue;
         
-        // Process channel based on type
-        switch (channels[ch].type) {
-            case CHANNEL_TYPE_FM:
-                render_fm_channel(ch, mix_buffer, AUDIO_BUFFER_SIZE);
-                break;
-                
-            case CHANNEL_TYPE_SAMPLE:
-                render_sample_channel(ch, mix_buffer, AUDIO_BUFFER_SIZE);
-                break;
-                
-            case CHANNEL_TYPE_WAVETABLE:
-                render_wavetable_channel(ch, mix_buffer, AUDIO_BUFFER_SIZE);
-                break;
+        uint32_t c = voice_cost[ch];
+        if (c == 0) c = voice_default_cost[channels[ch].type % 3];
+        
+        int i = count++;
+        while (i > 0 && cost[i - 1] < c) {
+            order[i] = order[i - 1];
+            cost[i] = cost[i - 1];
+            i--;
         }
+        order[i] = ch;
+        cost[i] = c;
+    }
+    
+    // Core 1 starts out carrying the master stage
+    uint32_t load[2] = { 0, master_stage_cost };
+    voice_jobs[0].count = 0;
+    voice_jobs[1].count = 0;
+    
+    for (int i = 0; i < count; i++) {
+        int core = (load[0] <= load[1]) ? 0 : 1;
+        voice_jobs[core].channels[voice_jobs[core].count++] = order[i];
+        load[core] += cost[i];
+    }
+}
+
+// Render one core's share of the voices into that core's buses
+void render_voice_job(uint core) {
+    VoiceJob* job = &voice_jobs[core];
+    MixBus* buses = mix_buses[core];
+    VoiceScratch* scratch = &voice_scratch[core];
+    
+    memset(buses, 0, sizeof(mix_buses[core]));
+    
+    for (int i = 0; i < job->count; i++) {
+        uint8_t ch = job->channels[i];
+        uint8_t type = channels[ch].type;
+        if (type > CHANNEL_TYPE_WAVETABLE) continue;
         
-        // Apply channel filter if enabled
-        if (filters[ch].enabled) {
-            // Apply filter separately to left and right channels
-            for (int side = 0; side < 2; side++) {
-                float temp_buffer[AUDIO_BUFFER_SIZE];
-                
-                // Extract single channel
-                for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
-                    temp_buffer[i] = mix_buffer[i*2 + side];
-                }
-                
-                // Apply filter
-                apply_filter(ch, temp_buffer, AUDIO_BUFFER_SIZE);
-                
-                // Put back
-                for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
-                    mix_buffer[i*2 + side] = temp_buffer[i];
-                }
-            }
+        uint32_t start = time_us_32();
+        
+        if (use_fixed_mixing) {
+            uint8_t planes = voice_renderers_q15[type](ch, scratch->q15[0], scratch->q15[1], AUDIO_BUFFER_SIZE);
+            if (planes) mix_voice_q15(ch, scratch->q15[0], scratch->q15[1], planes, buses);
+        } else {
+            uint8_t planes = voice_renderers[type](ch, scratch->f[0], scratch->f[1], AUDIO_BUFFER_SIZE);
+            if (planes) mix_voice_float(ch, scratch->f[0], scratch->f[1], planes, buses);
+        }
+        
+        uint32_t measured = (time_us_32() - start) << 4;
+        voice_cost[ch] += ((int32_t)(measured - voice_cost[ch])) >> VOICE_COST_SHIFT;
+    }
+}
+
+// Core 0 side: run a period's render if core 1 has asked for one. Returns
+// whether it did.
+bool service_voice_job(uint32_t timeout_us) {
+    uint32_t job;
+    if (!multicore_fifo_pop_timeout_us(timeout_us, &job) || job != AUDIO_JOB_RENDER) {
+        return false;
+    }
+    
+    plan_voice_split();
+    __dmb();
+    multicore_fifo_push_blocking(AUDIO_JOB_START);
+    
+    render_voice_job(0);
+    __dmb();
+    multicore_fifo_push_blocking(AUDIO_JOB_DONE);
+    
+    // Core 1 may still be reading voice state
+    multicore_fifo_pop_blocking();
+    return true;
+}
+
+// Float pipeline (RP2350 default)
+static void finish_audio_buffer_float() {
+    MixBus* buses = mix_buses[1];
+    float* mix = buses[MIX_BUS_DRY].f;
+    
+    // Merge core 0's buses
+    for (int bus = 0; bus < MIX_BUS_COUNT; bus++) {
+        float* dst = buses[bus].f;
+        const float* src = mix_buses[0][bus].f;
+        for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
+            dst[i] += src[i];
         }
     }
     
-    // Apply global effects in order
+    // Effect returns
     if (delay.enabled) {
-        apply_delay(mix_buffer, AUDIO_BUFFER_SIZE);
+        apply_delay(mix, buses[MIX_BUS_DELAY].f, AUDIO_BUFFER_SIZE);
     }
     
     if (reverb.enabled) {
-        apply_reverb(mix_buffer, AUDIO_BUFFER_SIZE);
+        apply_reverb(mix, buses[MIX_BUS_REVERB].f, AUDIO_BUFFER_SIZE);
     }
     
     // Convert to final output format and apply master volume
-    float master_gain = master_volume / 255.0f;
+    float master_gain = master_gain_q8() / 256.0f;
     
     for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
         // Apply master volume
-        float sample = mix_buffer[i] * master_gain;
+        float sample = mix[i] * master_gain;
         
         // Soft clipping to prevent harsh distortion
-        if (sample > 1.0f || sample < -1.0f) {
-            sample = tanhf(sample);
-        }
-        
-        // Convert to output format
-        // For PWM, we scale to 8-bit unsigned (0-255)
-        output_buffer[i] = (uint8_t)((sample * 0.5f + 0.5f) * 255.0f);
+        sample = soft_clip_curve(sample);
         
-        // For I2S, we'd convert to signed 16-bit or 24-bit
-        // i2s_buffer[i] = (int16_t)(sample * 32767.0f);
+        pcm_buffer[i] = (int16_t)(sample * 32767.0f);
+    }
+}
+
+// Fixed-point pipeline (RP2040 default): no float work per sample
+static void finish_audio_buffer_fixed() {
+    MixBus* buses = mix_buses[1];
+    int32_t* mix = buses[MIX_BUS_DRY].q15;
+    
+    // Merge core 0's buses and saturate into the effects' headroom so
+    // their Q15 products fit in 32 bits
+    for (int bus = 0; bus < MIX_BUS_COUNT; bus++) {
+        int32_t* dst = buses[bus].q15;
+        const int32_t* src = mix_buses[0][bus].q15;
+        for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
+            int32_t sample = dst[i] + src[i];
+            if (sample > MIX_BUS_LIMIT) sample = MIX_BUS_LIMIT;
+            else if (sample < -MIX_BUS_LIMIT) sample = -MIX_BUS_LIMIT;
+            dst[i] = sample;
+        }
+    }
+    
+    if (delay.enabled) {
+        apply_delay_q15(mix, buses[MIX_BUS_DELAY].q15, AUDIO_BUFFER_SIZE);
+    }
+    
+    if (reverb.enabled) {
+        apply_reverb_q15(mix, buses[MIX_BUS_REVERB].q15, AUDIO_BUFFER_SIZE);
     }
+    
+    int32_t master = master_gain_q8();
+    for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
+        pcm_buffer[i] = soft_clip_q15((mix[i] * master) >> 8);
+    }
+}
+
+// Generate audio data (core 1)
+void generate_audio_buffer() {
+    // Core 0 plans the split once it is out of its command handlers
+    multicore_fifo_push_blocking(AUDIO_JOB_RENDER);
+    multicore_fifo_pop_blocking();
+    __dmb();
+    
+    // Both cores render their voices in parallel
+    render_voice_job(1);
+    __dmb();
+    multicore_fifo_push_blocking(AUDIO_JOB_DONE);
+    multicore_fifo_pop_blocking();
+    __dmb();
+    
+    uint32_t start = time_us_32();
+    
+    if (use_fixed_mixing) {
+        finish_audio_buffer_fixed();
+    } else {
+        finish_audio_buffer_float();
+    }
+    
+    // For PWM, we scale to 8-bit unsigned (0-255)
+    for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
+        output_buffer[i] = (uint8_t)((pcm_buffer[i] + 32768) >> 8);
+    }
+    
+    uint32_t measured = (time_us_32() - start) << 4;
+    master_stage_cost += ((int32_t)(measured - master_stage_cost)) >> VOICE_COST_SHIFT;
 }
 
 // Initialize audio output
@@ -2096,69 +4288,185 @@ void init_memory_allocation() {
         sample_memory_size = 256 * 1024;  // 256KB
         pattern_memory_size = 128 * 1024; // 128KB
         instrument_memory_size = 64 * 1024; // 64KB
-        // ~72KB for working buffers
+        command_buffer_size = 16 * 1024;    // 16KB command receive ring
+        // ~56KB for working buffers
     } else {
         // RP2040 allocation (264KB)
         sample_memory_size = 128 * 1024;  // 128KB
         pattern_memory_size = 64 * 1024;  // 64KB
         instrument_memory_size = 32 * 1024; // 32KB
-        // ~40KB for working buffers
+        command_buffer_size = 8 * 1024;     // 8KB command receive ring
+        // ~32KB for working buffers
     }
     
-    // Allocate reverb buffer
-    reverb.buffer_size = is_rp2350 ? 32768 : 16384;
-    reverb.buffer = malloc(reverb.buffer_size * sizeof(float));
+    // Pick the mixing pipeline before sizing the effect buffers
+#if APU_MIX_MODE == APU_MIX_AUTO
+    use_fixed_mixing = !is_rp2350;
+#endif
+    init_soft_clip_lut();
+    init_tracker_pitch_table();
     
-    // Allocate delay buffer (2-second stereo buffer at full sample rate)
-    delay.buffer_size = is_rp2350 ? SAMPLE_RATE * 2 * 2 : SAMPLE_RATE * 1.5 * 2;
-    delay.buffer = malloc(delay.buffer_size * sizeof(int16_t));
+    // Allocate reverb delay lines (8960 entries at the default lengths)
+    init_reverb_lines();
     
-    // Initialize indices for reverb
-    reverb.comb1_idx = 0;
-    reverb.comb2_idx = 0;
-    reverb.comb3_idx = 0;
-    reverb.comb4_idx = 0;
-    reverb.ap1_idx = 0;
-    reverb.ap2_idx = 0;
+    // Prefetch rings for streaming samples
+    init_sample_streams(is_rp2350);
+    
+    // Samples and wavetables the CPU can map instead of uploading
+    init_asset_pack();
+    
+    // Allocate delay buffer (stereo frames, power of two: ~370ms / ~740ms)
+    delay.buffer_frames = is_rp2350 ? 32768 : 16384;
+    delay.frame_mask = delay.buffer_frames - 1;
+    delay.buffer = malloc(delay.buffer_frames * 2 * sizeof(int16_t));
+    delay.write_pos = 0;
     
     // Clear buffers
-    memset(reverb.buffer, 0, reverb.buffer_size * sizeof(float));
-    memset(delay.buffer, 0, delay.buffer_size * sizeof(int16_t));
+    if (delay.buffer) memset(delay.buffer, 0, delay.buffer_frames * 2 * sizeof(int16_t));
 }
 
-// Audio processing function for Core 1
-void core1_audio_processing() {
-    // Timing variables
-    uint32_t next_sample_time = 0;
-    uint32_t sample_interval = 1000000 / SAMPLE_RATE; // in microseconds
-    uint32_t audio_position = 0;
+// Audio Output
+// generate_audio_buffer() fills a ring of AUDIO_OUTPUT_PERIODS periods of
+// AUDIO_BUFFER_SIZE frames. Two DMA channels chain into each other through
+// the ring, paced by the PWM wrap DREQ (or the I2S PIO TX DREQ). Each
+// completion IRQ re-points the channel that just finished at the next ready
+// period, or at silence if synthesis fell behind, so playback never waits
+// on rendering.
+#define AUDIO_OUTPUT_PERIODS 4
+
+typedef struct {
+    uint32_t underruns;          // Periods replaced by silence
+    uint32_t periods_played;
+    uint32_t latency_frames;     // Frames queued ahead of the DAC after the last refill
+    uint32_t max_latency_frames;
+} AudioOutputStats;
+
+uint32_t audio_ring[AUDIO_OUTPUT_PERIODS][AUDIO_BUFFER_SIZE];  // One word per stereo frame
+uint32_t audio_silence[AUDIO_BUFFER_SIZE];
+int audio_dma_channel[2];
+bool audio_dma_from_ring[2];            // Channel is playing a ring period, not silence
+bool audio_output_i2s = false;
+volatile uint32_t audio_fill_count = 0;  // Periods rendered (core 1 loop)
+volatile uint32_t audio_queue_count = 0; // Periods handed to DMA (IRQ)
+volatile uint32_t audio_done_count = 0;  // Periods finished playing (IRQ)
+AudioOutputStats audio_output_stats;
+
+void audio_dma_irq_handler() {
+    for (int i = 0; i < 2; i++) {
+        int chan = audio_dma_channel[i];
+        if (!(dma_hw->ints0 & (1u << chan))) continue;
+        dma_hw->ints0 = 1u << chan;
+        
+        if (audio_dma_from_ring[i]) {
+            audio_done_count++;
+            audio_output_stats.periods_played++;
+        }
+        
+        // The other channel is already playing; queue the one that went idle
+        const uint32_t* next;
+        if (audio_queue_count != audio_fill_count) {
+            next = audio_ring[audio_queue_count % AUDIO_OUTPUT_PERIODS];
+            audio_queue_count++;
+            audio_dma_from_ring[i] = true;
+        } else {
+            next = audio_silence;
+            audio_dma_from_ring[i] = false;
+            audio_output_stats.underruns++;
+        }
+        dma_channel_set_read_addr(chan, next, false);
+    }
     
-    // Initialize output buffer index
-    audio_position = 0;
+    // Wake the render loop
+    __sev();
+}
+
+// Render one period into the next free ring slot in the active output format
+static void render_audio_period() {
+    uint32_t start = time_us_32();
     
-    while (true) {
-        // Generate audio buffer when needed
-        if (audio_position == 0) {
-            generate_audio_buffer();
+    trace_begin(ZONE_APU_MIX, audio_fill_count & 0xFFFF);
+    generate_audio_buffer();
+    trace_end(ZONE_APU_MIX, audio_fill_count & 0xFFFF);
+    
+    uint32_t* dst = audio_ring[audio_fill_count % AUDIO_OUTPUT_PERIODS];
+    if (audio_output_i2s) {
+        // 16-bit I2S: left in the high half-word, sent first
+        for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+            dst[i] = ((uint32_t)(uint16_t)pcm_buffer[i*2] << 16) | (uint16_t)pcm_buffer[i*2+1];
         }
-        
-        // Wait until it's time for the next sample
-        uint32_t current_time = time_us_32();
-        if (current_time < next_sample_time) {
-            // Sleep for a short time to save power
-            sleep_us(10);
-            continue;
+    } else {
+        // PWM CC register: channel A (left) low, channel B (right) high
+        for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+            dst[i] = output_buffer[i*2] | ((uint32_t)output_buffer[i*2+1] << 16);
         }
+    }
+    
+    __dmb();
+    audio_fill_count++;
+    
+    uint32_t latency = (audio_fill_count - audio_done_count) * AUDIO_BUFFER_SIZE;
+    audio_output_stats.latency_frames = latency;
+    if (latency > audio_output_stats.max_latency_frames) {
+        audio_output_stats.max_latency_frames = latency;
+    }
+    
+    // Render time as a share of the period's playback time
+    audio_cpu_load = ((time_us_32() - start) * SAMPLE_RATE) / (AUDIO_BUFFER_SIZE * 10000);
+}
+
+// Prime the ring and start the DMA pair. Must run on the core that services
+// the IRQ (core 1), since DMA_IRQ_0 is only enabled there.
+void start_audio_output(volatile void* write_addr, uint dreq) {
+    uint32_t silence = audio_output_i2s ? 0 : (128 | (128 << 16));
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+        audio_silence[i] = silence;
+    }
+    
+    for (int p = 0; p < AUDIO_OUTPUT_PERIODS; p++) {
+        render_audio_period();
+    }
+    
+    audio_dma_channel[0] = dma_claim_unused_channel(true);
+    audio_dma_channel[1] = dma_claim_unused_channel(true);
+    
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config config = dma_channel_get_default_config(audio_dma_channel[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+        channel_config_set_read_increment(&config, true);
+        channel_config_set_write_increment(&config, false);
+        channel_config_set_dreq(&config, dreq);
+        channel_config_set_chain_to(&config, audio_dma_channel[i ^ 1]);
         
-        // Calculate time for next sample
-        next_sample_time = current_time + sample_interval;
-        
-        // Output current sample to PWM
-        pwm_set_gpio_level(AUDIO_PIN_LEFT, output_buffer[audio_position*2]);
-        pwm_set_gpio_level(AUDIO_PIN_RIGHT, output_buffer[audio_position*2+1]);
-        
-        // Advance position
-        audio_position = (audio_position + 1) % AUDIO_BUFFER_SIZE;
+        dma_channel_configure(audio_dma_channel[i], &config, write_addr,
+                              audio_ring[i], AUDIO_BUFFER_SIZE, false);
+        audio_dma_from_ring[i] = true;
+    }
+    audio_queue_count = 2;
+    
+    irq_set_exclusive_handler(DMA_IRQ_0, audio_dma_irq_handler);
+    dma_channel_set_irq0_enabled(audio_dma_channel[0], true);
+    dma_channel_set_irq0_enabled(audio_dma_channel[1], true);
+    irq_set_enabled(DMA_IRQ_0, true);
+    
+    dma_channel_start(audio_dma_channel[0]);
+}
+
+// Audio processing function for Core 1
+void core1_audio_processing() {
+    if (audio_output_i2s) {
+        start_audio_output(&pio0->txf[0], pio_get_dreq(pio0, 0, true));
+    } else {
+        uint slice = pwm_gpio_to_slice_num(AUDIO_PIN_LEFT);
+        start_audio_output(&pwm_hw->slice[slice].cc, pwm_get_dreq(slice));
+    }
+    
+    while (true) {
+        // Keep the ring full; the IRQ's __sev() wakes us when a period frees up
+        if (audio_fill_count - audio_done_count < AUDIO_OUTPUT_PERIODS) {
+            render_audio_period();
+        } else {
+            __wfe();
+        }
     }
 }
 
@@ -2175,6 +4483,12 @@ int main() {
     
     // Initialize memory allocation
     init_memory_allocation();
+
+    // Receive CPU commands by DMA into the command buffer ring
+    if (!init_command_rx(command_buffer_size)) {
+        printf("Failed to allocate command buffer!\n");
+        while (1) tight_loop_contents();
+    }
     
     // Initialize audio output
     init_audio_output();
@@ -2184,6 +4498,7 @@ int main() {
         channels[i].active = false;
         channels[i].volume = 255;
         channels[i].pan = 128; // center
+        channels[i].effect_routing = EFFECT_ROUTE_ALL;
         channels[i].type = CHANNEL_TYPE_FM; // default
     }
     
@@ -2191,6 +4506,7 @@ int main() {
     for (int i = 0; i < SINE_WAVE_SIZE; i++) {
         sine_table[i] = (int16_t)(sinf(i * 2.0f * 3.14159f / SINE_WAVE_SIZE) * 32767.0f);
     }
+    init_fm_tables();
     
     // Start Core 1 for audio processing
     multicore_launch_core1(core1_audio_processing);
@@ -2200,24 +4516,11 @@ int main() {
     
     // Main loop on Core 0
     while (true) {
-        // Check for commands from CPU
-        if (!gpio_get(CPU_CS_PIN)) {
-            // CS asserted, receive command
-            uint8_t cmd_id = 0;
-            uint8_t cmd_length = 0;
-            
-            // Read command ID and length
-            spi_read_blocking(SPI_PORT, 0xFF, &cmd_id, 1);
-            spi_read_blocking(SPI_PORT, 0xFF, &cmd_length, 1);
-            
-            // Read command data if any
-            if (cmd_length > 2) {
-                spi_read_blocking(SPI_PORT, 0xFF, cmd_buffer, cmd_length - 2);
-            }
-            
-            // Process the command
-            process_command(cmd_id, cmd_buffer, cmd_length - 2);
-        }
+        // Dispatch everything the receive DMA has collected so far
+        uint32_t dispatched = process_received_commands();
+        
+        // Top up streaming sample rings
+        service_sample_streams();
         
         // Update timing-based effects and tracker sequencer
         uint32_t current_time = time_us_32();
@@ -2231,8 +4534,9 @@ int main() {
             last_update_time = current_time;
         }
         
-        // Small delay to reduce CPU usage
-        sleep_us(50);
+        // Render our share of the voices when core 1 asks. With nothing else
+        // to do, wait on the FIFO instead of sleeping so the job starts at once.
+        service_voice_job(dispatched == 0 ? 50 : 0);
     }
     
     return 0;
@@ -2257,9 +4561,8 @@ void send_memory_status() {
     
     // Count pattern memory
     for (int i = 0; i < MAX_TRACKERS; i++) {
-        if (trackers[i].pattern_data != NULL) {
-            pattern_memory_used += sizeof(TrackerNote) * MAX_ROWS_PER_PATTERN * 
-                                  trackers[i].num_channels * 256; // Approximate
+        if (trackers[i].song_data != NULL) {
+            pattern_memory_used += trackers[i].song_size;
         }
     }
     
@@ -2303,6 +4606,31 @@ void send_memory_status() {
     send_data_to_cpu(STATUS_MEMORY, status, 16);
 }
 
+// Output ring health: underruns and buffering latency
+void send_audio_status() {
+    uint8_t status[16];
+    AudioOutputStats stats = audio_output_stats;
+    
+    status[0] = stats.underruns >> 24;
+    status[1] = stats.underruns >> 16;
+    status[2] = stats.underruns >> 8;
+    status[3] = stats.underruns;
+    status[4] = stats.periods_played >> 24;
+    status[5] = stats.periods_played >> 16;
+    status[6] = stats.periods_played >> 8;
+    status[7] = stats.periods_played;
+    status[8] = stats.latency_frames >> 8;
+    status[9] = stats.latency_frames;
+    status[10] = stats.max_latency_frames >> 8;
+    status[11] = stats.max_latency_frames;
+    status[12] = AUDIO_OUTPUT_PERIODS;
+    status[13] = audio_cpu_load;
+    status[14] = (audio_output_i2s ? 1 : 0) | (use_fixed_mixing ? 2 : 0);
+    status[15] = 0;
+    
+    send_data_to_cpu(STATUS_AUDIO, status, 16);
+}
+
 // Clear samples from memory
 void cmd_mem_clear_samples() {
     // Stop any active sample playback
@@ -2315,8 +4643,7 @@ void cmd_mem_clear_samples() {
     // Free all sample memory
     for (int i = 0; i < MAX_SAMPLES; i++) {
         if (samples[i].data != NULL) {
-            free(samples[i].data);
-            samples[i].data = NULL;
+            release_sample_data(i);
             samples[i].loaded = false;
             samples[i].size = 0;
         }
@@ -2345,8 +4672,7 @@ void cmd_mem_optimize() {
         
         // If not in use, we can free it
         if (!in_use && samples[i].data != NULL) {
-            free(samples[i].data);
-            samples[i].data = NULL;
+            release_sample_data(i);
             samples[i].loaded = false;
             samples[i].size = 0;
         }
@@ -2377,8 +4703,7 @@ void cmd_mem_optimize() {
         
         // If not in use, we can free it
         if (!in_use && wavetables[i].data != NULL) {
-            free(wavetables[i].data);
-            wavetables[i].data = NULL;
+            release_wavetable_data(i);
             wavetables[i].size = 0;
         }
     }
@@ -2417,6 +4742,9 @@ void init_rp2350_enhancements() {
     
     // Higher quality interpolation
     use_cubic_interpolation = true;
+
+    // Float FM engine with per-sample envelopes
+    use_float_fm = true;
     
     // Additional wavetable features
     enable_wavetable_fm = true;
@@ -2483,68 +4811,8 @@ void setup_i2s_output() {
     
     pio_i2s_init(&config);
     
-    // Configure DMA for I2S
-    i2s_dma_channel = dma_claim_unused_channel(true);
-    dma_channel_config dma_config = dma_channel_get_default_config(i2s_dma_channel);
-    
-    channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_16); // or DMA_SIZE_32 for 24-bit
-    channel_config_set_read_increment(&dma_config, true);
-    channel_config_set_write_increment(&dma_config, false);
-    channel_config_set_dreq(&dma_config, pio_get_dreq(pio0, 0, true));
-    
-    dma_channel_configure(
-        i2s_dma_channel,
-        &dma_config,
-        &pio0->txf[0],     // Write to PIO TX FIFO
-        i2s_buffer,        // Read from I2S buffer
-        AUDIO_BUFFER_SIZE, // Number of transfers
-        false              // Don't start yet
-    );
-    
-    // Use double-buffering
-    use_i2s_double_buffer = true;
-}
-
-// RP2350: Enhanced audio output function for Core 1
-void core1_audio_processing_enhanced() {
-    // Double buffering variables
-    bool current_buffer = false;
-    
-    while (true) {
-        // Generate audio for the inactive buffer
-        generate_audio_buffer();
-        
-        // If using I2S, transfer via DMA
-        if (use_i2s_double_buffer) {
-            // Convert float buffer to I2S format
-            for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
-                // For 16-bit
-                i2s_buffer[i] = (int16_t)(mix_buffer[i] * 32767.0f);
-                
-                // For 24-bit, we'd use a different buffer format
-                // i2s_buffer_24bit[i] = (int32_t)(mix_buffer[i] * 8388607.0f) << 8;
-            }
-            
-            // Wait for previous transfer to complete
-            dma_channel_wait_for_finish_blocking(i2s_dma_channel);
-            
-            // Start new transfer
-            dma_channel_set_read_addr(i2s_dma_channel, i2s_buffer, true);
-        } else {
-            // Original PWM-based output
-            for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
-                // Wait until it's time for the next sample
-                sleep_us(1000000 / SAMPLE_RATE);
-                
-                // Output current sample to PWM
-                pwm_set_gpio_level(AUDIO_PIN_LEFT, output_buffer[i*2]);
-                pwm_set_gpio_level(AUDIO_PIN_RIGHT, output_buffer[i*2+1]);
-            }
-        }
-        
-        // Swap buffers
-        current_buffer = !current_buffer;
-    }
+    // The output ring feeds the PIO TX FIFO instead of PWM
+    audio_output_i2s = true;
 }
 
 /*
@@ -2632,8 +4900,8 @@ void update_channel_frequency(uint8_t channel_id) {
     // Update frequency based on channel type
     switch (ch->type) {
         case CHANNEL_TYPE_FM:
-            // Calculate phase increment for FM operators
-            // Need to update FM operator frequencies
+            // Recompute the operators' phase increments for the new pitch
+            update_fm_phase_increments(channel_id);
             break;
 
         case CHANNEL_TYPE_SAMPLE:
@@ -2662,13 +4930,7 @@ void reset_audio_system() {
         channels[i].type = CHANNEL_TYPE_FM;
         channels[i].frequency = 440.0f;
         channels[i].base_frequency = 440.0f;
-
-        // Reset effects state
-        channels[i].arpeggio_enabled = false;
-        channels[i].portamento_active = false;
-        channels[i].vibrato_active = false;
-        channels[i].tremolo_active = false;
-        channels[i].volume_slide_active = false;
+        channels[i].base_volume = 255;
     }
 
     // Reset global state
@@ -2722,7 +4984,22 @@ void trigger_fm_note(uint8_t channel_id, float freq) {
     ch->frequency = freq;
     ch->base_frequency = freq;
 
-    // Need to initialize FM synthesis for this note
+    // Key on: restart every operator's envelope from silence
+    FMChannel* fm = &fm_channels[channel_id];
+    for (int i = 0; i < 4; i++) {
+        FMOperator* op = &fm->operators[i];
+        op->phase = 0;
+        op->envelope_level = 0.0f;
+        op->env_q15 = 0;
+        op->envelope_state = op->enabled ? 1 : 0;
+    }
+    fm->op1_prev1 = 0;
+    fm->op1_prev2 = 0;
+    fm->fb_prev1 = 0;
+    fm->fb_prev2 = 0;
+
+    // Phase increments follow the new note
+    update_fm_phase_increments(channel_id);
 }
 
 void trigger_sample_note(uint8_t channel_id, float freq) {
@@ -45,6 +45,8 @@ Architecture:
 #include "pico/multicore.h"
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
 #include "hardware/timer.h"
 #include "hardware/watchdog.h"
 #include "hardware/rtc.h"
@@ -59,7 +61,7 @@ Architecture:
 #define MAX_LAYERS 4
 #define MAX_DIRTY_REGIONS 16
 #define MAX_ASSETS 256
-#define MAX_CACHED_ASSETS 32
+#define MAX_CACHED_ASSETS 64
 #define MAX_RECOVERY_ATTEMPTS 3
 #define SYNC_INTERVAL_MS 1000
 
@@ -167,6 +169,17 @@ void load_apu_assets_qspi(FILE* file, struct apu_assets* assets);
 void close_file(FILE* file);
 void process_enhanced_queue(CommandQueue* queue);
 void prepare_rendering();
+void move_sprite(uint8_t sprite_id, int16_t x, int16_t y);
+void scroll_background(uint8_t layer_id, int16_t x, int16_t y);
+void sync_shadow_oam();
+void trace_begin(uint8_t zone, uint16_t arg);
+void trace_end(uint8_t zone, uint16_t arg);
+void capture_frame_trace(uint32_t frames);
+void finish_frame_trace();
+extern volatile uint32_t trace_frames_left;
+void invalidate_shadow_oam();
+bool queue_gpu_command(uint8_t cmd_id, uint8_t length, const uint8_t* data);
+void vsync_irq_handler(uint gpio, uint32_t events);
 void prepare_audio();
 void process_input();
 void update_game_state();
@@ -239,6 +252,7 @@ void init_hardware() {
     gpio_init(VSYNC_PIN);
     gpio_set_dir(VSYNC_PIN, GPIO_IN);
     gpio_pull_up(VSYNC_PIN);
+    gpio_set_irq_enabled_with_callback(VSYNC_PIN, GPIO_IRQ_EDGE_FALL, true, &vsync_irq_handler);
     
     // Initialize buttons
     gpio_init(BTN_UP_PIN);
@@ -272,7 +286,17 @@ void init_hardware() {
     printf("Hardware initialization complete\n");
 }
 
+// Profiler zones recorded on the CPU; GPU zones are 0x10-0x1F, APU 0x20-0x2F
+enum {
+    ZONE_CPU_FRAME = 0x01,        // arg = low bits of the frame counter
+    ZONE_CPU_GPU_QUEUE = 0x02,    // arg = bytes streamed (end event)
+    ZONE_CPU_APU_QUEUE = 0x03,    // arg = bytes streamed (end event)
+    ZONE_CPU_GAME_UPDATE = 0x04
+};
+
 // Clock Synchronization Implementation
+#define CMD_CLOCK_SYNC 0xF8
+
 // Global timing variables
 volatile uint32_t global_frame_counter = 0;
 volatile uint64_t master_clock_timestamp = 0;
@@ -293,17 +317,18 @@ void send_clock_sync() {
     master_clock_timestamp = time_us_64();
 
     // Send clock sync to GPU
-    uint8_t gpu_sync_cmd[10] = {
-        0xF1,                             // Clock sync command ID
-        10,                               // Command length
+    uint8_t gpu_sync_cmd[11] = {
+        CMD_CLOCK_SYNC,                   // Clock sync command ID
+        11,                               // Command length
         (global_frame_counter >> 24) & 0xFF, // Frame counter bytes
         (global_frame_counter >> 16) & 0xFF,
         (global_frame_counter >> 8) & 0xFF,
         global_frame_counter & 0xFF,
-        (master_clock_timestamp >> 32) & 0xFF, // Timestamp bytes (high)
+        (master_clock_timestamp >> 32) & 0xFF, // Timestamp bytes (40 bits)
         (master_clock_timestamp >> 24) & 0xFF,
         (master_clock_timestamp >> 16) & 0xFF,
-        (master_clock_timestamp >> 8) & 0xFF
+        (master_clock_timestamp >> 8) & 0xFF,
+        master_clock_timestamp & 0xFF
     };
 
     // Critical section - ensure atomic access to SPI
@@ -311,7 +336,7 @@ void send_clock_sync() {
 
     // Send to GPU with high priority
     gpio_put(GPU_CS_PIN, 0);
-    spi_write_blocking(GPU_SPI_PORT, gpu_sync_cmd, 10);
+    spi_write_blocking(GPU_SPI_PORT, gpu_sync_cmd, 11);
     // Wait for acknowledgment
     uint8_t ack = 0;
     spi_read_blocking(GPU_SPI_PORT, 0xFF, &ack, 1);
@@ -319,7 +344,7 @@ void send_clock_sync() {
 
     // Send to APU with high priority
     gpio_put(APU_CS_PIN, 0);
-    spi_write_blocking(APU_SPI_PORT, gpu_sync_cmd, 10);
+    spi_write_blocking(APU_SPI_PORT, gpu_sync_cmd, 11);
     // Wait for acknowledgment
     spi_read_blocking(APU_SPI_PORT, 0xFF, &ack, 1);
     gpio_put(APU_CS_PIN, 1);
@@ -333,11 +358,160 @@ void send_clock_sync() {
     }
 }
 
+// Frame Scheduler
+// Frames are paced by the GPU. It pulses VSYNC once a frame has gone out to the
+// display, which opens the submission window for the next one, and a frame's
+// commands are closed with FRAME_COMMIT so the GPU renders each frame once and
+// only when all of it has arrived. Work from VSYNC to commit has a budget;
+// overrunning it raises the degrade level (level 1 skips optional effects,
+// level 2 also halves animation updates) and a run of frames well inside the
+// budget lowers it again.
+#define CMD_FRAME_COMMIT 0x0A
+#define FRAME_PERIOD_US 16667          // 60fps, used while there is no VSYNC
+#define FRAME_BUDGET_US 12000          // Leaves the GPU the rest of the frame
+#define FRAME_VSYNC_TIMEOUT_US 50000   // Longest wait for one VSYNC
+#define FRAME_VSYNC_LOST_US 100000     // No VSYNC for this long: pace by the CPU timer
+#define FRAME_DEGRADE_MAX 2
+#define FRAME_RECOVER_FRAMES 60        // Frames inside the budget before stepping back
+#define FRAME_RECOVER_PERCENT 70       // "Inside" = work below this share of the budget
+
+typedef struct {
+    volatile uint32_t vsync_count;  // VSYNC edges seen by the IRQ
+    volatile uint32_t vsync_time;   // time_us_32() of the last edge
+    volatile uint32_t period_us;    // Smoothed VSYNC period
+    uint32_t seen_vsync;            // vsync_count the current frame started on
+    uint32_t frame_start;           // When the current frame's work began
+    uint32_t budget_us;             // Submission deadline after frame start
+    uint32_t work_us;               // Last frame, start to commit
+    uint32_t avg_work_us;           // Smoothed work time
+    uint32_t overruns;              // Frames committed after their deadline
+    uint32_t vsync_timeouts;        // Frames started without a VSYNC
+    uint8_t degrade_level;          // 0 = full, 1 = no optional effects, 2 = half-rate animation
+    uint8_t frames_inside_budget;
+    bool committed;                 // FRAME_COMMIT queued for the current frame
+} FrameScheduler;
+
+FrameScheduler frame_scheduler = {
+    .period_us = FRAME_PERIOD_US,
+    .budget_us = FRAME_BUDGET_US
+};
+
+void vsync_irq_handler(uint gpio, uint32_t events) {
+    if (gpio != VSYNC_PIN || !(events & GPIO_IRQ_EDGE_FALL)) {
+        return;
+    }
+
+    uint32_t now = time_us_32();
+    uint32_t period = now - frame_scheduler.vsync_time;
+    if (frame_scheduler.vsync_count > 0 && period < FRAME_VSYNC_TIMEOUT_US) {
+        frame_scheduler.period_us = (frame_scheduler.period_us * 7 + period) / 8;
+    }
+
+    frame_scheduler.vsync_time = now;
+    frame_scheduler.vsync_count++;
+}
+
+// Block until the GPU opens the next frame with VSYNC. Without a VSYNC signal
+// (vblank callback off, GPU in recovery) frames are paced by the CPU timer.
+void wait_for_frame_start() {
+    FrameScheduler* fs = &frame_scheduler;
+
+    bool vsync_running = fs->vsync_count != 0 &&
+                         time_us_32() - fs->vsync_time < FRAME_VSYNC_LOST_US;
+
+    if (vsync_running) {
+        while (fs->vsync_count == fs->seen_vsync) {
+            if (time_us_32() - fs->frame_start >= FRAME_VSYNC_TIMEOUT_US) {
+                fs->vsync_timeouts++;
+                break;
+            }
+            tight_loop_contents();
+        }
+    } else {
+        while (time_us_32() - fs->frame_start < FRAME_PERIOD_US) {
+            tight_loop_contents();
+        }
+    }
+
+    fs->seen_vsync = fs->vsync_count;
+    fs->frame_start = time_us_32();
+}
+
+// Close the frame: everything queued for the GPU so far is rendered together
+void commit_frame() {
+    FrameScheduler* fs = &frame_scheduler;
+
+    uint8_t data[2] = {
+        (global_frame_counter >> 8) & 0xFF,
+        global_frame_counter & 0xFF
+    };
+    queue_gpu_command(CMD_FRAME_COMMIT, 4, data);
+
+    fs->work_us = time_us_32() - fs->frame_start;
+    fs->committed = true;
+}
+
+// Optional effects are dropped from degrade level 1
+bool frame_effects_enabled() {
+    return frame_scheduler.degrade_level < 1;
+}
+
+// How far animations advance this frame: 1 normally; at level 2 they update
+// every other frame, 2 steps at a time, so their speed stays the same
+uint8_t frame_animation_step() {
+    if (frame_scheduler.degrade_level < 2) {
+        return 1;
+    }
+    return (global_frame_counter & 1) ? 0 : 2;
+}
+
+// Fold the last frame's work time into the degrade level
+void update_frame_budget() {
+    FrameScheduler* fs = &frame_scheduler;
+
+    if (!fs->committed) {
+        return;
+    }
+    fs->committed = false;
+
+    fs->avg_work_us = (fs->avg_work_us * 7 + fs->work_us) / 8;
+
+    if (fs->work_us > fs->budget_us) {
+        fs->overruns++;
+        fs->frames_inside_budget = 0;
+        if (fs->degrade_level < FRAME_DEGRADE_MAX) {
+            fs->degrade_level++;
+        }
+
+        if (debug_enabled) {
+            printf("Frame time: %lu us (over budget, degrade level %d)\n",
+                   fs->work_us, fs->degrade_level);
+        }
+    } else if (fs->work_us < fs->budget_us * FRAME_RECOVER_PERCENT / 100) {
+        if (fs->degrade_level > 0 && ++fs->frames_inside_budget >= FRAME_RECOVER_FRAMES) {
+            fs->degrade_level--;
+            fs->frames_inside_budget = 0;
+        }
+    } else {
+        fs->frames_inside_budget = 0;
+    }
+}
+
 // Called every frame in the main game loop
 void update_frame_timing() {
+    trace_end(ZONE_CPU_FRAME, global_frame_counter & 0xFFFF);
+
+    update_frame_budget();
+
     // Increment frame counter
     global_frame_counter++;
 
+    // Finish a requested trace capture once its frames have run
+    if (trace_frames_left > 0 && --trace_frames_left == 0) {
+        finish_frame_trace();
+    }
+    trace_begin(ZONE_CPU_FRAME, global_frame_counter & 0xFFFF);
+
     // Trigger periodic clock sync if needed
     uint32_t current_time = time_ms_32();
     if (current_time - last_sync_time >= SYNC_INTERVAL_MS) {
@@ -347,345 +521,920 @@ void update_frame_timing() {
 }
 
 // Command Queue Management
-// Command structure for GPU and APU
+// Each device gets a single-producer/single-consumer byte ring. Core 0 encodes
+// commands ([cmd][len][data...]) straight into the ring and publishes them by
+// advancing head; the consumer (core 1 once it is running) streams everything
+// between tail and head to SPI by DMA under a single CS assertion. Head and
+// tail are free-running counters, so no lock is needed on either side.
+#define COMMAND_RING_SIZE_RP2040 (16 * 1024) // Must be a power of two
+#define COMMAND_RING_SIZE_RP2350 (32 * 1024)
+
+// Batch container understood by the GPU and APU:
+// [CMD_BATCH][count][size_hi][size_lo] followed by count sub-commands
+#define CMD_BATCH 0xF6
+#define BATCH_HEADER_SIZE 4
+#define BATCH_MAX_SIZE 4096      // Stays well inside the receivers' rings
+#define BATCH_MAX_COMMANDS 255
+
+// Sequenced delivery for commands that must arrive (asset and song uploads):
+// [CMD_SEQUENCED][seq] followed by the command. Up to SEQ_WINDOW of them are in
+// flight; every device ACK and error carries [next expected seq][held mask],
+// which retires the delivered ones and marks those waiting behind a gap, so a
+// timeout resends only what the device is missing.
+#define CMD_SEQUENCED 0xE9
+#define SEQ_HEADER_SIZE 2
+#define SEQ_WINDOW 8                 // Matches the devices' reorder buffer
+#define SEQ_TIMEOUT_US 50000         // Resend after this long without an ACK
+#define SEQ_MAX_RETRIES 3
+
 typedef struct {
-    uint8_t command_id;
-    uint8_t length;
-    uint8_t data[256]; // Maximum command data size
-} Command;
+    uint8_t bytes[SEQ_HEADER_SIZE + 255];  // The frame as sent
+    uint16_t length;
+    uint32_t sent_at;
+    uint8_t retries;
+    bool held;                   // The device has it, waiting on an earlier one
+} SeqSlot;
 
-// Command queue structure
 typedef struct {
-    Command* commands;
-    uint16_t capacity;
-    uint16_t head;
-    uint16_t tail;
-    uint16_t count;
-    mutex_t lock;
+    uint8_t* buffer;
+    uint32_t size;
+    uint32_t mask;
+    volatile uint32_t head;      // Written only by the producer (core 0)
+    volatile uint32_t tail;      // Written only by the consumer
+    uint32_t write_pos;          // Producer's encode position, ahead of head while a batch is open
+    bool batch_open;
+    uint32_t batch_start;
+    uint8_t batch_count;
+    volatile uint8_t consumer_core;
+    uint32_t dropped;            // Commands rejected because the ring was full
+    uint32_t bytes_sent;
+    uint32_t acks_received;
+    uint8_t last_acked_cmd;
+    SeqSlot* seq_slots;          // SEQ_WINDOW frames kept until acknowledged
+    uint8_t seq_base;            // Oldest unacknowledged sequence number
+    uint8_t seq_next;            // Next sequence number to assign
+    uint32_t seq_resent;
+    uint32_t seq_failed;         // Commands given up on after SEQ_MAX_RETRIES
+    mutex_t seq_lock;
+    int dma_channel;
+    dma_channel_config dma_config;
+    spi_inst_t* spi;
+    uint cs_pin;
 } CommandQueue;
 
 // Global command queues
 CommandQueue gpu_queue;
 CommandQueue apu_queue;
 
+// Responses are read by the ring consumer; this keeps the trace export,
+// which reads on core 0, from taking a reply meant for the poller
+mutex_t response_lock;
+
+// Set up one ring and its TX DMA channel. On allocation failure the ring is
+// left without storage and every command sent through it is refused.
+static bool init_command_ring(CommandQueue* queue, spi_inst_t* spi, uint cs_pin, uint32_t size) {
+    queue->buffer = malloc(size);
+    queue->seq_slots = malloc(SEQ_WINDOW * sizeof(SeqSlot));
+    if (queue->buffer == NULL || queue->seq_slots == NULL) {
+        free(queue->buffer);
+        free(queue->seq_slots);
+        queue->buffer = NULL;
+        queue->seq_slots = NULL;
+        size = 0;
+    }
+
+    queue->size = size;
+    queue->mask = size - 1;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->write_pos = 0;
+    queue->batch_open = false;
+    queue->batch_start = 0;
+    queue->batch_count = 0;
+    queue->consumer_core = 0; // Core 0 drains until core 1 takes over
+    queue->dropped = 0;
+    queue->bytes_sent = 0;
+    queue->acks_received = 0;
+    queue->last_acked_cmd = 0;
+    queue->seq_base = 0;
+    queue->seq_next = 0;
+    queue->seq_resent = 0;
+    queue->seq_failed = 0;
+    mutex_init(&queue->seq_lock);
+    queue->spi = spi;
+    queue->cs_pin = cs_pin;
+
+    if (queue->buffer == NULL) {
+        return false;
+    }
+
+    queue->dma_channel = dma_claim_unused_channel(true);
+    queue->dma_config = dma_channel_get_default_config(queue->dma_channel);
+    channel_config_set_transfer_data_size(&queue->dma_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&queue->dma_config, true);
+    channel_config_set_write_increment(&queue->dma_config, false);
+    channel_config_set_dreq(&queue->dma_config, spi_get_dreq(spi, true));
+    return true;
+}
+
 // Initialize command queues
-void init_command_queues() {
+bool init_command_queues() {
     // Determine if we're on RP2040 or RP2350
     bool is_rp2350 = check_if_rp2350();
-    
-    // Allocate GPU command queue
-    gpu_queue.capacity = is_rp2350 ? 256 : 128;
-    gpu_queue.commands = malloc(sizeof(Command) * gpu_queue.capacity);
-    gpu_queue.head = 0;
-    gpu_queue.tail = 0;
-    gpu_queue.count = 0;
-    mutex_init(&gpu_queue.lock);
-    
-    // Allocate APU command queue
-    apu_queue.capacity = is_rp2350 ? 256 : 128;
-    apu_queue.commands = malloc(sizeof(Command) * apu_queue.capacity);
-    apu_queue.head = 0;
-    apu_queue.tail = 0;
-    apu_queue.count = 0;
-    mutex_init(&apu_queue.lock);
-    
+    uint32_t ring_size = is_rp2350 ? COMMAND_RING_SIZE_RP2350 : COMMAND_RING_SIZE_RP2040;
+
+    bool gpu_ok = init_command_ring(&gpu_queue, GPU_SPI_PORT, GPU_CS_PIN, ring_size);
+    bool apu_ok = init_command_ring(&apu_queue, APU_SPI_PORT, APU_CS_PIN, ring_size);
+    mutex_init(&response_lock);
+
+    if (!gpu_ok || !apu_ok) {
+        printf("Failed to allocate command queues\n");
+        return false;
+    }
+
     printf("Command queues initialized\n");
+    return true;
 }
 
-// Add a command to the GPU queue
-bool queue_gpu_command(uint8_t cmd_id, uint8_t length, const uint8_t* data) {
-    mutex_enter_blocking(&gpu_queue.lock);
-    
-    // Check if queue is full
-    if (gpu_queue.count >= gpu_queue.capacity) {
-        mutex_exit(&gpu_queue.lock);
-        return false;
+// Copy bytes into the ring at a free-running position, splitting at the wrap
+static inline void command_ring_write(CommandQueue* queue, uint32_t pos, const uint8_t* src, uint32_t count) {
+    uint32_t offset = pos & queue->mask;
+    uint32_t first = queue->size - offset;
+
+    if (first >= count) {
+        memcpy(&queue->buffer[offset], src, count);
+    } else {
+        memcpy(&queue->buffer[offset], src, first);
+        memcpy(queue->buffer, src + first, count - first);
     }
-    
-    // Add command to queue
-    Command* cmd = &gpu_queue.commands[gpu_queue.tail];
-    cmd->command_id = cmd_id;
-    cmd->length = length;
-    
-    // Copy command data
-    if (length > 2) {
-        memcpy(cmd->data, data, length - 2);
+}
+
+// Write the batch header and publish the whole batch
+void end_command_batch(CommandQueue* queue) {
+    if (!queue->batch_open) {
+        return;
     }
-    
-    // Update queue
-    gpu_queue.tail = (gpu_queue.tail + 1) % gpu_queue.capacity;
-    gpu_queue.count++;
-    
-    mutex_exit(&gpu_queue.lock);
-    return true;
+    queue->batch_open = false;
+
+    if (queue->batch_count == 0) {
+        // Nothing was added - drop the reserved header
+        queue->write_pos = queue->batch_start;
+        return;
+    }
+
+    uint16_t size = queue->write_pos - queue->batch_start - BATCH_HEADER_SIZE;
+    uint8_t header[BATCH_HEADER_SIZE] = {
+        CMD_BATCH, queue->batch_count, (size >> 8) & 0xFF, size & 0xFF
+    };
+    command_ring_write(queue, queue->batch_start, header, BATCH_HEADER_SIZE);
+
+    __dmb();
+    queue->head = queue->write_pos;
 }
 
-// Add a command to the APU queue
-bool queue_apu_command(uint8_t cmd_id, uint8_t length, const uint8_t* data) {
-    mutex_enter_blocking(&apu_queue.lock);
-    
-    // Check if queue is full
-    if (apu_queue.count >= apu_queue.capacity) {
-        mutex_exit(&apu_queue.lock);
-        return false;
+// Start collecting commands into one batch; the device runs them together
+// and answers with a single ACK (or the first error)
+bool begin_command_batch(CommandQueue* queue) {
+    if (queue->batch_open) {
+        return true;
     }
-    
-    // Add command to queue
-    Command* cmd = &apu_queue.commands[apu_queue.tail];
-    cmd->command_id = cmd_id;
-    cmd->length = length;
-    
-    // Copy command data
-    if (length > 2) {
-        memcpy(cmd->data, data, length - 2);
+
+    if (queue->size - (queue->write_pos - queue->tail) < BATCH_HEADER_SIZE) {
+        return false;
     }
-    
-    // Update queue
-    apu_queue.tail = (apu_queue.tail + 1) % apu_queue.capacity;
-    apu_queue.count++;
-    
-    mutex_exit(&apu_queue.lock);
+
+    // Reserve the header; it is filled in once the size is known
+    queue->batch_open = true;
+    queue->batch_start = queue->write_pos;
+    queue->batch_count = 0;
+    queue->write_pos += BATCH_HEADER_SIZE;
     return true;
 }
 
-// Process commands from the GPU queue
-void process_gpu_queue() {
-    const int MAX_BATCH = 10; // Process up to 10 commands at once
-    int processed = 0;
-    
-    while (processed < MAX_BATCH) {
-        mutex_enter_blocking(&gpu_queue.lock);
-        
-        // Check if queue is empty
-        if (gpu_queue.count == 0) {
-            mutex_exit(&gpu_queue.lock);
-            break;
-        }
-        
-        // Get command from queue
-        Command* cmd = &gpu_queue.commands[gpu_queue.head];
-        
-        // Prepare buffer for SPI transfer
-        uint8_t buffer[258]; // Maximum command size
-        buffer[0] = cmd->command_id;
-        buffer[1] = cmd->length;
-        
-        if (cmd->length > 2) {
-            memcpy(&buffer[2], cmd->data, cmd->length - 2);
-        }
-        
-        // Update queue pointers
-        gpu_queue.head = (gpu_queue.head + 1) % gpu_queue.capacity;
-        gpu_queue.count--;
-        
-        // Release lock before SPI communication
-        mutex_exit(&gpu_queue.lock);
-        
-        // Send command to GPU
-        gpio_put(GPU_CS_PIN, 0); // Select GPU
-        spi_write_blocking(GPU_SPI_PORT, buffer, cmd->length);
-        gpio_put(GPU_CS_PIN, 1); // Deselect GPU
-        
-        processed++;
-        
-        // Brief delay between commands
-        sleep_us(10);
+bool send_command_now(CommandQueue* queue, uint8_t cmd_id, uint8_t length, const uint8_t* data);
+void reset_sequenced_commands(CommandQueue* queue);
+
+// Encode a command into the ring. Only core 0 produces into the ring; commands
+// issued on core 1 (asset loads) go straight to the bus instead.
+bool queue_command(CommandQueue* queue, uint8_t cmd_id, uint8_t length, const uint8_t* data) {
+    if (length < 2 || queue->buffer == NULL) {
+        return false;
     }
-}
 
-// Process commands from the APU queue
-void process_apu_queue() {
-    const int MAX_BATCH = 10; // Process up to 10 commands at once
-    int processed = 0;
-    
-    while (processed < MAX_BATCH) {
-        mutex_enter_blocking(&apu_queue.lock);
-        
-        // Check if queue is empty
-        if (apu_queue.count == 0) {
-            mutex_exit(&apu_queue.lock);
-            break;
-        }
-        
-        // Get command from queue
-        Command* cmd = &apu_queue.commands[apu_queue.head];
-        
-        // Prepare buffer for SPI transfer
-        uint8_t buffer[258]; // Maximum command size
-        buffer[0] = cmd->command_id;
-        buffer[1] = cmd->length;
-        
-        if (cmd->length > 2) {
-            memcpy(&buffer[2], cmd->data, cmd->length - 2);
+    // RESET_GPU and RESET_AUDIO (both 0x01) restart the device's numbering
+    if (cmd_id == 0x01) {
+        reset_sequenced_commands(queue);
+    }
+
+    if (get_core_num() != 0) {
+        return send_command_now(queue, cmd_id, length, data);
+    }
+
+    // Split batches that would outgrow the receiver's ring
+    if (queue->batch_open &&
+        (queue->batch_count == BATCH_MAX_COMMANDS ||
+         queue->write_pos - queue->batch_start + length > BATCH_MAX_SIZE)) {
+        end_command_batch(queue);
+        begin_command_batch(queue);
+    }
+
+    uint32_t pos = queue->write_pos;
+    uint32_t free_space = queue->size - (pos - queue->tail);
+
+    // Check if ring is full
+    if (length > free_space) {
+        queue->dropped++;
+        return false;
+    }
+
+    uint8_t header[2] = {cmd_id, length};
+    command_ring_write(queue, pos, header, 2);
+
+    if (length > 2 && data != NULL) {
+        command_ring_write(queue, pos + 2, data, length - 2);
+    } else if (length > 2) {
+        // No payload supplied - send zeros rather than stale ring contents
+        uint8_t zeros[32] = {0};
+        for (uint32_t done = 0; done < length - 2u; ) {
+            uint32_t chunk = MIN(sizeof(zeros), length - 2u - done);
+            command_ring_write(queue, pos + 2 + done, zeros, chunk);
+            done += chunk;
         }
-        
-        // Update queue pointers
-        apu_queue.head = (apu_queue.head + 1) % apu_queue.capacity;
-        apu_queue.count--;
-        
-        // Release lock before SPI communication
-        mutex_exit(&apu_queue.lock);
-        
-        // Send command to APU
-        gpio_put(APU_CS_PIN, 0); // Select APU
-        spi_write_blocking(APU_SPI_PORT, buffer, cmd->length);
-        gpio_put(APU_CS_PIN, 1); // Deselect APU
-        
-        processed++;
-        
-        // Brief delay between commands
-        sleep_us(10);
     }
+
+    queue->write_pos = pos + length;
+
+    if (queue->batch_open) {
+        // Published when the batch is closed
+        queue->batch_count++;
+        return true;
+    }
+
+    // Make the command bytes visible before publishing the new head
+    __dmb();
+    queue->head = queue->write_pos;
+    return true;
 }
 
-// CPU Reception of Acknowledgments
+// Add a command to the GPU queue
+bool queue_gpu_command(uint8_t cmd_id, uint8_t length, const uint8_t* data) {
+    return queue_command(&gpu_queue, cmd_id, length, data);
+}
 
-void process_ack_packet(uint8_t device_id, uint8_t* packet) {
-    // Extract original command ID and status
-    uint8_t cmd_id = packet[2];
-    uint8_t status = packet[3];
+// Add a command to the APU queue
+bool queue_apu_command(uint8_t cmd_id, uint8_t length, const uint8_t* data) {
+    return queue_command(&apu_queue, cmd_id, length, data);
+}
 
-    // Get appropriate command queue
-    EnhancedCommandQueue* queue = (device_id == 1) ? &gpu_queue : &apu_queue;
+// Hand ownership of the consumer side of both rings to the calling core
+void claim_command_queues() {
+    gpu_queue.consumer_core = get_core_num();
+    apu_queue.consumer_core = get_core_num();
+    __dmb();
+}
 
-    mutex_enter_blocking(&queue->lock);
+// Finish a transfer and release CS
+static void release_command_bus(CommandQueue* queue) {
+    // Let the last frame leave the shifter before releasing CS
+    while (spi_is_busy(queue->spi)) {
+        tight_loop_contents();
+    }
 
-    // Find the command in the queue
-    int found = 0;
-    uint16_t index = queue->head;
-    for (uint16_t i = 0; i < queue->count; i++) {
-        EnhancedCommand* cmd = &queue->commands[index];
-        if (cmd->command_id == cmd_id && cmd->requires_ack && !cmd->completed) {
-            // Mark command as completed
-            cmd->completed = true;
-            found = 1;
+    // Discard what was clocked in while writing, as spi_write_blocking does
+    while (spi_is_readable(queue->spi)) {
+        (void)spi_get_hw(queue->spi)->dr;
+    }
+    spi_get_hw(queue->spi)->icr = SPI_SSPICR_RORIC_BITS;
 
-            if (debug_enabled) {
-                printf("Received ACK for command 0x%02X from device %d\n",
-                      cmd_id, device_id);
-            }
+    gpio_put(queue->cs_pin, 1);
+}
 
-            break;
+// Stream every published byte to the device under one CS assertion.
+// Returns the number of bytes sent.
+uint32_t flush_command_queue(CommandQueue* queue) {
+    // Only the consumer core may move tail; anyone else waits for it to drain
+    if (get_core_num() != queue->consumer_core) {
+        uint32_t target = queue->head;
+        while ((int32_t)(target - queue->tail) > 0) {
+            tight_loop_contents();
         }
-        index = (index + 1) % queue->capacity;
+        return 0;
     }
 
-    mutex_exit(&queue->lock);
+    uint32_t head = queue->head;
+    __dmb();
+    uint32_t tail = queue->tail;
 
-    if (!found && debug_enabled) {
-        printf("Received ACK for unknown command 0x%02X\n", cmd_id);
+    if (head == tail) {
+        return 0;
     }
-}
-
-void check_for_device_responses() {
-    // Check GPU data ready pin
-    if (gpio_get(GPU_DATA_READY_PIN)) {
-        // Read response from GPU
-        uint8_t response[4];
 
-        gpio_put(GPU_CS_PIN, 0);
-        spi_read_blocking(GPU_SPI_PORT, 0xFF, response, 4);
-        gpio_put(GPU_CS_PIN, 1);
+    gpio_put(queue->cs_pin, 0);
 
-        // Process based on response type
-        if (response[0] == 0xFA) {
-            // Acknowledgment
-            process_ack_packet(1, response);
-        } else if (response[0] == 0xFE) {
-            // Error
-            process_error_packet(1, response);
+    // At most two spans: tail up to the end of the buffer, then the wrapped rest
+    while (tail != head) {
+        uint32_t offset = tail & queue->mask;
+        uint32_t span = head - tail;
+        if (span > queue->size - offset) {
+            span = queue->size - offset;
         }
+
+        dma_channel_configure(queue->dma_channel, &queue->dma_config,
+                              &spi_get_hw(queue->spi)->dr,
+                              &queue->buffer[offset], span, true);
+        dma_channel_wait_for_finish_blocking(queue->dma_channel);
+        tail += span;
     }
 
-    // Check APU data ready pin
-    if (gpio_get(APU_DATA_READY_PIN)) {
-        // Read response from APU
-        uint8_t response[4];
+    release_command_bus(queue);
 
-        gpio_put(APU_CS_PIN, 0);
-        spi_read_blocking(APU_SPI_PORT, 0xFF, response, 4);
-        gpio_put(APU_CS_PIN, 1);
+    uint32_t sent = head - queue->tail;
+    queue->bytes_sent += sent;
+
+    // DMA has finished reading the span, so the producer may reuse it
+    __dmb();
+    queue->tail = tail;
+    return sent;
+}
 
-        // Process based on response type
-        if (response[0] == 0xFA) {
-            // Acknowledgment
-            process_ack_packet(2, response);
-        } else if (response[0] == 0xFE) {
-            // Error
-            process_error_packet(2, response);
+// Write one command straight to the device, outside the ring. Only the
+// consumer core may do this; the ring is flushed first so the device still
+// sees commands in the order they were issued.
+bool send_command_now(CommandQueue* queue, uint8_t cmd_id, uint8_t length, const uint8_t* data) {
+    if (get_core_num() != queue->consumer_core) {
+        return false;
+    }
+
+    flush_command_queue(queue);
+
+    uint8_t header[2] = {cmd_id, length};
+    gpio_put(queue->cs_pin, 0);
+    spi_write_blocking(queue->spi, header, 2);
+    if (length > 2 && data != NULL) {
+        spi_write_blocking(queue->spi, data, length - 2);
+    } else if (length > 2) {
+        // No payload supplied - send zeros, as the ring path does
+        uint8_t zeros[32] = {0};
+        for (uint32_t done = 0; done < length - 2u; ) {
+            uint32_t chunk = MIN(sizeof(zeros), length - 2u - done);
+            spi_write_blocking(queue->spi, zeros, chunk);
+            done += chunk;
         }
     }
+    release_command_bus(queue);
+
+    queue->bytes_sent += length;
+    return true;
 }
 
-// CPU Error Recovery System
+// Sequenced delivery
 
-typedef enum {
-    ERR_NONE = 0,
-    ERR_TIMEOUT = 1,
-    ERR_INVALID_COMMAND = 2,
-    ERR_MEMORY_FULL = 3,
-    ERR_INVALID_PARAMETER = 4,
-    ERR_DEVICE_BUSY = 5,
-    ERR_COMMUNICATION_FAILURE = 6,
-    ERR_SYNC_LOST = 7
-} ErrorCode;
+// Put a sequenced frame on its way: into the ring on core 0, straight onto the
+// bus from the consumer core, as queue_command() does for plain commands
+static bool queue_command_frame(CommandQueue* queue, const uint8_t* frame, uint32_t length) {
+    if (get_core_num() != 0) {
+        if (get_core_num() != queue->consumer_core) {
+            return false;
+        }
 
-typedef struct {
-    uint8_t device_id;    // 1=GPU, 2=APU
-    ErrorCode error_code;
-    uint8_t command_id;
-    uint32_t timestamp;
-    bool handled;
-} ErrorRecord;
+        flush_command_queue(queue);
+        gpio_put(queue->cs_pin, 0);
+        spi_write_blocking(queue->spi, frame, length);
+        release_command_bus(queue);
+        queue->bytes_sent += length;
+        return true;
+    }
 
-#define ERROR_LOG_SIZE 32
-ErrorRecord error_log[ERROR_LOG_SIZE];
-uint8_t error_log_index = 0;
-uint8_t unhandled_errors = 0;
+    // The batch parser reads a sub-command's second byte as its length, so a
+    // frame goes between batches
+    bool reopen = queue->batch_open;
+    end_command_batch(queue);
 
-void log_error(uint8_t device_id, ErrorCode code, uint8_t cmd_id) {
-    // Add to error log
-    ErrorRecord* record = &error_log[error_log_index];
-    record->device_id = device_id;
-    record->error_code = code;
-    record->command_id = cmd_id;
-    record->timestamp = time_ms_32();
-    record->handled = false;
+    uint32_t pos = queue->write_pos;
+    if (length > queue->size - (pos - queue->tail)) {
+        queue->dropped++;
+        if (reopen) {
+            begin_command_batch(queue);
+        }
+        return false;
+    }
 
-    // Increment counters
-    error_log_index = (error_log_index + 1) % ERROR_LOG_SIZE;
-    unhandled_errors++;
+    command_ring_write(queue, pos, frame, length);
+    queue->write_pos = pos + length;
 
-    // Log error for debugging
-    if (debug_enabled) {
-        const char* device = (device_id == 1) ? "GPU" : "APU";
-        printf("ERROR: %s cmd 0x%02X error code %d\n", device, cmd_id, code);
+    __dmb();
+    queue->head = queue->write_pos;
+
+    if (reopen) {
+        begin_command_batch(queue);
     }
+    return true;
 }
 
-void process_error_packet(uint8_t device_id, uint8_t* packet) {
-    uint8_t cmd_id = packet[2];
-    uint8_t error_code = packet[3];
+// Apply the sequence state from an ACK or error packet
+void acknowledge_sequenced(CommandQueue* queue, uint8_t next_expected, uint8_t held) {
+    mutex_enter_blocking(&queue->seq_lock);
 
-    // Log the error
-    log_error(device_id, error_code, cmd_id);
+    uint8_t in_flight = queue->seq_next - queue->seq_base;
+    uint8_t delivered = next_expected - queue->seq_base;
 
-    // Handle specific errors
-    handle_device_error(device_id, error_code, cmd_id);
-}
+    // Anything else is from before a reset
+    if (delivered <= in_flight) {
+        queue->seq_base = next_expected;
 
-void handle_device_error(uint8_t device_id, ErrorCode error_code, uint8_t cmd_id) {
-    switch (error_code) {
-        case ERR_MEMORY_FULL:
-            // Device ran out of memory - try recovery
-            if (device_id == 1) {
-                // GPU memory issue - try to free resources
-                queue_gpu_command(0xD0, 2, NULL); // Request memory cleanup
-            } else {
-                // APU memory issue
-                queue_apu_command(0xD0, 2, NULL); // Request memory cleanup
+        for (uint8_t i = 0; i < SEQ_WINDOW - 1; i++) {
+            uint8_t seq = next_expected + 1 + i;
+            if (((held >> i) & 1) && (uint8_t)(seq - queue->seq_base) < (uint8_t)(queue->seq_next - queue->seq_base)) {
+                queue->seq_slots[seq % SEQ_WINDOW].held = true;
             }
-            break;
+        }
+    }
+
+    mutex_exit(&queue->seq_lock);
+}
+
+// Resend sequenced commands whose ACK is overdue. The device keeps the ones
+// that arrived after a loss, so only the missing ones go again. When one runs
+// out of retries the window is dropped and numbering jumps past it, which the
+// device takes as a restart. The loss is counted in seq_failed, which
+// wait_sequenced_delivery() reports to the asset load that sent it.
+void service_sequenced_commands(CommandQueue* queue) {
+    uint32_t now = time_us_32();
+
+    mutex_enter_blocking(&queue->seq_lock);
+
+    for (uint8_t seq = queue->seq_base; seq != queue->seq_next; seq++) {
+        SeqSlot* slot = &queue->seq_slots[seq % SEQ_WINDOW];
+        if (slot->held || now - slot->sent_at < SEQ_TIMEOUT_US) {
+            continue;
+        }
+
+        if (slot->retries >= SEQ_MAX_RETRIES) {
+            uint8_t lost = queue->seq_next - queue->seq_base;
+            printf("Command 0x%02X not acknowledged after %d retries, dropping %d\n",
+                   slot->bytes[SEQ_HEADER_SIZE], slot->retries, lost);
+            queue->seq_failed += lost;
+            queue->seq_next += SEQ_WINDOW;
+            queue->seq_base = queue->seq_next;
+            break;
+        }
+
+        if (queue_command_frame(queue, slot->bytes, slot->length)) {
+            slot->retries++;
+            slot->sent_at = now;
+            queue->seq_resent++;
+        }
+    }
+
+    mutex_exit(&queue->seq_lock);
+}
+
+// Forget everything in flight, for when the device is reset with us
+void reset_sequenced_commands(CommandQueue* queue) {
+    mutex_enter_blocking(&queue->seq_lock);
+    queue->seq_base = 0;
+    queue->seq_next = 0;
+    mutex_exit(&queue->seq_lock);
+}
+
+void poll_device_responses(uint8_t device_id);
+
+// Queue a command that must arrive. It is numbered and kept until the device
+// acknowledges it, and resent if that takes too long. A full window waits: on
+// the consumer core by polling for ACKs itself, on core 0 for the consumer to
+// do so. Either way it opens, as ACKs come in or a command runs out of retries.
+// Only a full ring refuses the command.
+bool queue_sequenced_command(CommandQueue* queue, uint8_t cmd_id, uint8_t length, const uint8_t* data) {
+    if (length < 2 || queue->seq_slots == NULL) {
+        return false;
+    }
+
+    uint8_t device_id = (queue == &gpu_queue) ? 1 : 2;
+
+    while (true) {
+        mutex_enter_blocking(&queue->seq_lock);
+        if ((uint8_t)(queue->seq_next - queue->seq_base) < SEQ_WINDOW) {
+            break;
+        }
+        mutex_exit(&queue->seq_lock);
+
+        if (get_core_num() != queue->consumer_core) {
+            tight_loop_contents();
+            continue;
+        }
+
+        poll_device_responses(device_id);
+        service_sequenced_commands(queue);
+    }
+
+    SeqSlot* slot = &queue->seq_slots[queue->seq_next % SEQ_WINDOW];
+    slot->bytes[0] = CMD_SEQUENCED;
+    slot->bytes[1] = queue->seq_next;
+    slot->bytes[2] = cmd_id;
+    slot->bytes[3] = length;
+    if (data != NULL) {
+        memcpy(&slot->bytes[SEQ_HEADER_SIZE + 2], data, length - 2);
+    } else {
+        memset(&slot->bytes[SEQ_HEADER_SIZE + 2], 0, length - 2);
+    }
+    slot->length = SEQ_HEADER_SIZE + length;
+    slot->sent_at = time_us_32();
+    slot->retries = 0;
+    slot->held = false;
+
+    bool sent = queue_command_frame(queue, slot->bytes, slot->length);
+    if (sent) {
+        queue->seq_next++;
+    }
+
+    mutex_exit(&queue->seq_lock);
+    return sent;
+}
+
+// Wait until nothing sequenced is in flight: every command has been
+// acknowledged or given up on. Returns false if any was given up on since
+// seq_failed read failed_mark, so a caller can tell it was lost.
+bool wait_sequenced_delivery(CommandQueue* queue, uint32_t failed_mark) {
+    uint8_t device_id = (queue == &gpu_queue) ? 1 : 2;
+
+    while (true) {
+        mutex_enter_blocking(&queue->seq_lock);
+        bool idle = (queue->seq_base == queue->seq_next);
+        uint32_t failed = queue->seq_failed;
+        mutex_exit(&queue->seq_lock);
+
+        if (idle) {
+            return failed == failed_mark;
+        }
+
+        if (get_core_num() != queue->consumer_core) {
+            tight_loop_contents();
+            continue;
+        }
+
+        poll_device_responses(device_id);
+        service_sequenced_commands(queue);
+    }
+}
+
+// Process commands from the GPU queue
+void process_gpu_queue() {
+    trace_begin(ZONE_CPU_GPU_QUEUE, 0);
+    uint32_t sent = flush_command_queue(&gpu_queue);
+    trace_end(ZONE_CPU_GPU_QUEUE, MIN(sent, 0xFFFF));
+}
+
+// Process commands from the APU queue
+void process_apu_queue() {
+    trace_begin(ZONE_CPU_APU_QUEUE, 0);
+    uint32_t sent = flush_command_queue(&apu_queue);
+    trace_end(ZONE_CPU_APU_QUEUE, MIN(sent, 0xFFFF));
+}
+
+// CPU Reception of Acknowledgments
+
+void process_ack_packet(uint8_t device_id, uint8_t* packet) {
+    // Extract original command ID and status
+    uint8_t cmd_id = packet[2];
+    uint8_t status = packet[3];
+
+    // Commands leave the ring as soon as they are streamed out, so an ACK
+    // only updates the per-device bookkeeping
+    CommandQueue* queue = (device_id == 1) ? &gpu_queue : &apu_queue;
+    queue->acks_received++;
+    queue->last_acked_cmd = cmd_id;
+
+    // Devices that number commands append their sequence state
+    if (packet[1] >= 6) {
+        acknowledge_sequenced(queue, packet[4], packet[5]);
+    }
+
+    if (debug_enabled) {
+        printf("Received ACK for command 0x%02X from device %d (status %d)\n",
+              cmd_id, device_id, status);
+    }
+}
+
+uint8_t read_device_packet(uint8_t device_id, uint8_t* packet, uint32_t timeout_us);
+void answer_stream_request(const uint8_t* packet, uint8_t length);
+
+// Handle a response a device has raised DATA_READY for. Only the core that
+// drains the rings polls, so replies are never read from two cores at once.
+void poll_device_responses(uint8_t device_id) {
+    CommandQueue* queue = (device_id == 1) ? &gpu_queue : &apu_queue;
+    uint data_ready_pin = (device_id == 1) ? GPU_DATA_READY_PIN : APU_DATA_READY_PIN;
+    if (get_core_num() != queue->consumer_core || !gpio_get(data_ready_pin)) {
+        return;
+    }
+
+    // A trace export is reading replies itself
+    if (!mutex_try_enter(&response_lock, NULL)) {
+        return;
+    }
+
+    uint8_t response[256];
+    uint8_t length = read_device_packet(device_id, response, 0);
+    mutex_exit(&response_lock);
+
+    if (length < 4) {
+        return;
+    }
+
+    // Process based on response type
+    if (response[0] == 0xFA) {
+        // Acknowledgment
+        process_ack_packet(device_id, response);
+    } else if (response[0] == 0xFE) {
+        // Error
+        process_error_packet(device_id, response);
+    } else if (response[0] == 0xE2 && device_id == 2) {
+        // The APU wants more of a CPU-sourced sample stream
+        answer_stream_request(response, length);
+    }
+}
+
+void check_for_device_responses() {
+    poll_device_responses(1);
+    poll_device_responses(2);
+}
+
+// Frame Profiler
+// Every chip records begin/end events of its hot paths into one lock-free ring
+// per core, stamped in master time (the CPU's clock, which GPU and APU follow
+// through the clock sync). capture_frame_trace() starts recording on all three;
+// when the requested frames have run the device rings are pulled with
+// PROFILE_READ and everything is printed as a Chrome trace / Perfetto JSON
+// timeline: pid 0/1/2 = CPU/GPU/APU, tid = core.
+#define CMD_PROFILE_START 0xE6
+#define CMD_PROFILE_STOP 0xE7
+#define CMD_PROFILE_READ 0xE8
+#define TRACE_RING_SIZE 512          // Events per core, power of two
+#define TRACE_READ_TIMEOUT_US 20000  // Wait for a device reply
+
+#define TRACE_BEGIN 0
+#define TRACE_END 1
+
+typedef struct {
+    uint32_t timestamp;   // Microseconds, low 32 bits
+    uint8_t zone;
+    uint8_t phase;        // TRACE_BEGIN or TRACE_END
+    uint16_t arg;
+} TraceEvent;
+
+TraceEvent trace_rings[2][TRACE_RING_SIZE];
+volatile uint32_t trace_heads[2];   // Events ever recorded on each core
+uint32_t trace_starts[2];           // Heads when the capture began
+volatile bool trace_enabled = false;
+volatile uint32_t trace_frames_left = 0;
+bool trace_first_event = true;
+
+// Only the calling core writes its ring, so no lock is needed
+void trace_record(uint8_t zone, uint8_t phase, uint16_t arg) {
+    if (!trace_enabled) {
+        return;
+    }
+
+    uint core = get_core_num();
+    uint32_t head = trace_heads[core];
+    TraceEvent* event = &trace_rings[core][head & (TRACE_RING_SIZE - 1)];
+    event->timestamp = (uint32_t)time_us_64();
+    event->zone = zone;
+    event->phase = phase;
+    event->arg = arg;
+
+    // Make the event visible before the index that covers it
+    __dmb();
+    trace_heads[core] = head + 1;
+}
+
+void trace_begin(uint8_t zone, uint16_t arg) {
+    trace_record(zone, TRACE_BEGIN, arg);
+}
+
+void trace_end(uint8_t zone, uint16_t arg) {
+    trace_record(zone, TRACE_END, arg);
+}
+
+const char* trace_zone_name(uint8_t zone) {
+    switch (zone) {
+        case ZONE_CPU_FRAME:       return "frame";
+        case ZONE_CPU_GPU_QUEUE:   return "process_gpu_queue";
+        case ZONE_CPU_APU_QUEUE:   return "process_apu_queue";
+        case ZONE_CPU_GAME_UPDATE: return "game_update";
+        case 0x10:                 return "process_command";
+        case 0x11:                 return "frame";
+        case 0x12:                 return "render_layer";
+        case 0x13:                 return "render_sprites_at_priority";
+        case 0x14:                 return "send_frame_to_display";
+        case 0x15:                 return "present_wait";
+        case 0x20:                 return "process_command";
+        case 0x21:                 return "generate_audio_buffer";
+        default:                   return "zone";
+    }
+}
+
+void print_trace_event(uint8_t device_id, uint8_t core, uint32_t timestamp,
+                       uint8_t zone, uint8_t phase, uint16_t arg) {
+    printf("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%u}}\n",
+           trace_first_event ? "" : ",", trace_zone_name(zone),
+           phase == TRACE_END ? 'E' : 'B', timestamp, device_id, core, arg);
+    trace_first_event = false;
+}
+
+// Read one response packet ([type][length][data...]) once the device raises
+// DATA_READY. Returns the packet length, or 0 on timeout.
+uint8_t read_device_packet(uint8_t device_id, uint8_t* packet, uint32_t timeout_us) {
+    uint data_ready_pin = (device_id == 1) ? GPU_DATA_READY_PIN : APU_DATA_READY_PIN;
+    uint cs_pin = (device_id == 1) ? GPU_CS_PIN : APU_CS_PIN;
+    spi_inst_t* spi = (device_id == 1) ? GPU_SPI_PORT : APU_SPI_PORT;
+
+    uint32_t start = time_us_32();
+    while (!gpio_get(data_ready_pin)) {
+        if (time_us_32() - start > timeout_us) {
+            return 0;
+        }
+        tight_loop_contents();
+    }
+
+    gpio_put(cs_pin, 0);
+    spi_read_blocking(spi, 0xFF, packet, 2);
+    uint8_t length = packet[1] < 2 ? 2 : packet[1];
+    if (length > 2) {
+        spi_read_blocking(spi, 0xFF, &packet[2], length - 2);
+    }
+    gpio_put(cs_pin, 1);
+
+    return length;
+}
+
+// Pull one core's ring from a device: [0xE8][len][core][first sequence:4][count][events]
+void export_device_trace(uint8_t device_id, uint8_t core) {
+    CommandQueue* queue = (device_id == 1) ? &gpu_queue : &apu_queue;
+    uint8_t packet[256];
+
+    mutex_enter_blocking(&response_lock);
+
+    while (true) {
+        queue_command(queue, CMD_PROFILE_READ, 3, &core);
+        flush_command_queue(queue);
+
+        // ACKs still in flight (PROFILE_STOP) come first
+        uint8_t length;
+        while ((length = read_device_packet(device_id, packet, TRACE_READ_TIMEOUT_US)) >= 4 &&
+               packet[0] == 0xFA) {
+            process_ack_packet(device_id, packet);
+        }
+
+        if (length < 8 || packet[0] != CMD_PROFILE_READ) {
+            break;
+        }
+
+        uint8_t count = packet[7];
+        if (count == 0 || length < 8 + count * 8) {
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const uint8_t* e = &packet[8 + i * 8];
+            uint32_t timestamp = ((uint32_t)e[0] << 24) | (e[1] << 16) | (e[2] << 8) | e[3];
+            print_trace_event(device_id, core, timestamp, e[4], e[5], (e[6] << 8) | e[7]);
+        }
+    }
+
+    mutex_exit(&response_lock);
+}
+
+// Record the next `frames` frames on all three chips, then print the trace.
+// Call from core 0, between frames.
+void capture_frame_trace(uint32_t frames) {
+    if (frames == 0 || trace_frames_left > 0) {
+        return;
+    }
+
+    // Fresh clock offsets so the three timelines line up
+    send_clock_sync();
+
+    queue_gpu_command(CMD_PROFILE_START, 2, NULL);
+    queue_apu_command(CMD_PROFILE_START, 2, NULL);
+
+    trace_starts[0] = trace_heads[0];
+    trace_starts[1] = trace_heads[1];
+    __dmb();
+    trace_enabled = true;
+    trace_frames_left = frames;
+}
+
+// Stop recording everywhere and print the whole capture. Core 0 stalls while
+// the device rings are read, so only use this while debugging.
+void finish_frame_trace() {
+    trace_enabled = false;
+    queue_gpu_command(CMD_PROFILE_STOP, 2, NULL);
+    queue_apu_command(CMD_PROFILE_STOP, 2, NULL);
+
+    printf("{\"traceEvents\":[\n");
+    trace_first_event = true;
+
+    // CPU rings; the oldest events are gone if a core recorded more than a ring
+    for (int core = 0; core < 2; core++) {
+        uint32_t head = trace_heads[core];
+        uint32_t first = trace_starts[core];
+        if (head - first > TRACE_RING_SIZE) {
+            first = head - TRACE_RING_SIZE;
+        }
+        for (uint32_t i = first; i != head; i++) {
+            const TraceEvent* event = &trace_rings[core][i & (TRACE_RING_SIZE - 1)];
+            print_trace_event(0, core, event->timestamp, event->zone, event->phase, event->arg);
+        }
+    }
+
+    for (int core = 0; core < 2; core++) {
+        export_device_trace(1, core);
+        export_device_trace(2, core);
+    }
+
+    const char* names[3] = {"CPU", "GPU", "APU"};
+    for (int i = 0; i < 3; i++) {
+        printf("%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}\n",
+               trace_first_event ? "" : ",", i, names[i]);
+        trace_first_event = false;
+    }
+    printf("]}\n");
+}
+
+// CPU Error Recovery System
+
+typedef enum {
+    ERR_NONE = 0,
+    ERR_TIMEOUT = 1,
+    ERR_INVALID_COMMAND = 2,
+    ERR_MEMORY_FULL = 3,
+    ERR_INVALID_PARAMETER = 4,
+    ERR_DEVICE_BUSY = 5,
+    ERR_COMMUNICATION_FAILURE = 6,
+    ERR_SYNC_LOST = 7
+} ErrorCode;
+
+typedef struct {
+    uint8_t device_id;    // 1=GPU, 2=APU
+    ErrorCode error_code;
+    uint8_t command_id;
+    uint32_t timestamp;
+    bool handled;
+} ErrorRecord;
+
+#define ERROR_LOG_SIZE 32
+ErrorRecord error_log[ERROR_LOG_SIZE];
+uint8_t error_log_index = 0;
+uint8_t unhandled_errors = 0;
+
+void log_error(uint8_t device_id, ErrorCode code, uint8_t cmd_id) {
+    // Add to error log
+    ErrorRecord* record = &error_log[error_log_index];
+    record->device_id = device_id;
+    record->error_code = code;
+    record->command_id = cmd_id;
+    record->timestamp = time_ms_32();
+    record->handled = false;
+
+    // Increment counters
+    error_log_index = (error_log_index + 1) % ERROR_LOG_SIZE;
+    unhandled_errors++;
+
+    // Log error for debugging
+    if (debug_enabled) {
+        const char* device = (device_id == 1) ? "GPU" : "APU";
+        printf("ERROR: %s cmd 0x%02X error code %d\n", device, cmd_id, code);
+    }
+}
+
+void process_error_packet(uint8_t device_id, uint8_t* packet) {
+    uint8_t cmd_id = packet[2];
+    uint8_t error_code = packet[3];
+
+    // A failed command was still delivered
+    if (packet[1] >= 6) {
+        acknowledge_sequenced((device_id == 1) ? &gpu_queue : &apu_queue, packet[4], packet[5]);
+    }
+
+    // Log the error
+    log_error(device_id, error_code, cmd_id);
+
+    // Handle specific errors
+    handle_device_error(device_id, error_code, cmd_id);
+}
+
+void handle_device_error(uint8_t device_id, ErrorCode error_code, uint8_t cmd_id) {
+    switch (error_code) {
+        case ERR_MEMORY_FULL:
+            // Device ran out of memory - try recovery
+            if (device_id == 1) {
+                // GPU memory issue - try to free resources
+                queue_gpu_command(0xD0, 2, NULL); // Request memory cleanup
+            } else {
+                // APU memory issue
+                queue_apu_command(0xD0, 2, NULL); // Request memory cleanup
+            }
+            break;
 
         case ERR_SYNC_LOST:
             // Synchronization lost - initiate resync
@@ -780,24 +1529,6 @@ bool check_device_health(uint8_t device_id) {
     return success;
 }
 
-// Improved Command Queue Error Handling
-bool queue_command(CommandQueue* queue, uint8_t cmd_id, uint8_t length, const uint8_t* data) {
-    mutex_enter_blocking(&queue->lock);
-    if (queue->count >= queue->capacity) {
-        mutex_exit(&queue->lock);
-        send_error_to_cpu(ERROR_QUEUE_FULL);
-        return false;
-    }
-    Command* cmd = &queue->commands[queue->tail];
-    cmd->command_id = cmd_id;
-    cmd->length = length;
-    memcpy(cmd->data, data, length - 2);
-    queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count++;
-    mutex_exit(&queue->lock);
-    return true;
-}
-
 // Asset Management System
 // Asset types
 typedef enum {
@@ -808,7 +1539,8 @@ typedef enum {
     ASSET_TYPE_SAMPLE,
     ASSET_TYPE_MUSIC,
     ASSET_TYPE_FONT,
-    ASSET_TYPE_LEVEL
+    ASSET_TYPE_LEVEL,
+    ASSET_TYPE_WAVETABLE  // Signed 16-bit table; only mapped from a cartridge pack
 } AssetType;
 
 // Asset information structure
@@ -819,48 +1551,144 @@ typedef struct {
     uint32_t offset;  // Offset in asset file
     bool loaded;
     uint8_t target;   // 0=CPU, 1=GPU, 2=APU
+    uint8_t tile_width;  // Tilesets: tile size; sprites: pattern size (pixels, multiples of 8)
+    uint8_t tile_height;
+    uint8_t bpp;         // 4 or 8
     char name[32];    // Asset name for debugging
 } AssetInfo;
 
+// Geometry of registry entries that leave it at zero
+#define ASSET_DEFAULT_TILE_SIZE 8      // 8x8 tiles
+#define ASSET_DEFAULT_PATTERN_SIZE 16  // 16x16 sprite patterns
+#define ASSET_DEFAULT_BPP 8
+
+// Asset cache
+// Cached assets live in one byte-budgeted arena allocated at boot, so long
+// sessions don't fragment the heap. Eviction is GreedyDual-Size-Frequency:
+// an entry's priority is the inflation clock plus hits x (reload cost / size),
+// where reloading costs a fixed SD seek plus the bytes themselves. Small,
+// often used assets therefore outlive a single large one, and the clock
+// (raised to each victim's priority) ages out entries that stop being hit.
+#define ASSET_ARENA_SIZE_RP2040 (64 * 1024)
+#define ASSET_ARENA_SIZE_RP2350 (128 * 1024)
+#define ASSET_ARENA_ALIGN 4
+#define ASSET_SEEK_COST_BYTES 4096   // An SD seek costs about as much as this many bytes read
+#define ASSET_HASH_SIZE 512          // Power of two, at least 2x MAX_ASSETS
+
 // Asset cache entry
 typedef struct {
     uint32_t asset_id;
-    uint8_t* data;
+    uint16_t asset_index;  // Registry slot of the asset
+    uint32_t offset;       // Position in the arena
     uint32_t size;
-    uint32_t last_used;  // For LRU replacement
+    uint32_t last_used;
+    uint32_t hits;
+    uint32_t priority;     // GDSF priority
+    bool used;
+    bool ready;            // False while a stream is still filling it
 } AssetCacheEntry;
 
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t bytes_hit;      // Bytes served from the cache instead of SD
+    uint32_t bytes_loaded;   // Bytes written into the cache
+    uint32_t evictions;
+    uint32_t bytes_evicted;
+    uint32_t compactions;
+} AssetCacheStats;
+
 // Global asset state
 #define MAX_ASSETS 256
-#define MAX_CACHED_ASSETS 32
+#define MAX_CACHED_ASSETS 64
 
 AssetInfo assets[MAX_ASSETS];
 uint32_t asset_count = 0;
+uint16_t asset_hash[ASSET_HASH_SIZE];     // Registry index + 1, 0 = empty
+int8_t asset_cache_slot[MAX_ASSETS];      // Cache entry per registry slot, or -1
+bool asset_pinned[MAX_ASSETS];            // Never evicted once cached
+const uint8_t* asset_flash[MAX_ASSETS];   // Data in the cartridge pack, or NULL if on SD
+uint32_t asset_device_offset[MAX_ASSETS]; // Copy in the target device's pack
+#define ASSET_NOT_ON_DEVICE 0xFFFFFFFF
 
 AssetCacheEntry asset_cache[MAX_CACHED_ASSETS];
-uint32_t asset_cache_count = 0;
+uint8_t* asset_arena = NULL;
+uint32_t asset_arena_size = 0;
+uint32_t asset_arena_used = 0;
+uint32_t asset_cache_clock = 0;           // GDSF inflation value
+AssetCacheStats asset_cache_stats;
 uint32_t frame_counter = 0;
 
 // SD card file handle
 FIL asset_file;
 bool asset_file_open = false;
 
+bool asset_stream_uses(const uint8_t* data);
+
+static inline uint32_t asset_hash_slot(uint32_t asset_id) {
+    // Fibonacci hashing spreads sequential ids
+    return (asset_id * 2654435769u) >> (32 - 9);
+}
+
+static void reset_asset_cache();
+
+// Reset loaded state and index every asset by id (linear probing)
+static void index_asset_registry() {
+    // Cached data belonged to the previous registry
+    reset_asset_cache();
+    memset(asset_pinned, 0, sizeof(asset_pinned));
+    
+    memset(asset_hash, 0, sizeof(asset_hash));
+    for (uint32_t i = 0; i < asset_count; i++) {
+        assets[i].loaded = false;
+        
+        // Graphics without geometry keep the formats they always had
+        if (assets[i].type == ASSET_TYPE_TILESET || assets[i].type == ASSET_TYPE_SPRITE) {
+            uint8_t size = (assets[i].type == ASSET_TYPE_TILESET) ? ASSET_DEFAULT_TILE_SIZE
+                                                                  : ASSET_DEFAULT_PATTERN_SIZE;
+            if (assets[i].tile_width == 0) assets[i].tile_width = size;
+            if (assets[i].tile_height == 0) assets[i].tile_height = size;
+            if (assets[i].bpp == 0) assets[i].bpp = ASSET_DEFAULT_BPP;
+        }
+        
+        uint32_t slot = asset_hash_slot(assets[i].id);
+        while (asset_hash[slot] != 0) {
+            slot = (slot + 1) & (ASSET_HASH_SIZE - 1);
+        }
+        asset_hash[slot] = i + 1;
+    }
+}
+
+// Drop every cached asset (the registry changed underneath it)
+static void reset_asset_cache() {
+    memset(asset_cache, 0, sizeof(asset_cache));
+    memset(asset_cache_slot, -1, sizeof(asset_cache_slot));
+    asset_arena_used = 0;
+    asset_cache_clock = 0;
+}
+
 // Initialize asset system
 void init_asset_system() {
     // Clear asset registry
     memset(assets, 0, sizeof(assets));
+    memset(asset_hash, 0, sizeof(asset_hash));
+    memset(asset_pinned, 0, sizeof(asset_pinned));
+    memset(asset_flash, 0, sizeof(asset_flash));
     asset_count = 0;
     
-    // Clear asset cache
-    for (int i = 0; i < MAX_CACHED_ASSETS; i++) {
-        asset_cache[i].asset_id = 0;
-        asset_cache[i].data = NULL;
-        asset_cache[i].size = 0;
-        asset_cache[i].last_used = 0;
+    // One arena for the whole session; sized to the asset buffer budget
+    if (asset_arena == NULL) {
+        asset_arena_size = check_if_rp2350() ? ASSET_ARENA_SIZE_RP2350 : ASSET_ARENA_SIZE_RP2040;
+        asset_arena = malloc(asset_arena_size);
+        if (asset_arena == NULL) {
+            asset_arena_size = 0;
+        }
     }
-    asset_cache_count = 0;
     
-    printf("Asset system initialized\n");
+    reset_asset_cache();
+    memset(&asset_cache_stats, 0, sizeof(asset_cache_stats));
+    
+    printf("Asset system initialized: %lu byte cache\n", asset_arena_size);
 }
 
 // Load asset registry from a file
@@ -898,23 +1726,98 @@ bool load_asset_registry(const char* filename) {
     // Close file
     f_close(&f);
     
-    // Reset loaded state for all assets
-    for (uint32_t i = 0; i < asset_count; i++) {
-        assets[i].loaded = false;
-    }
+    // Everything comes from the asset file
+    memset(asset_flash, 0, sizeof(asset_flash));
+    index_asset_registry();
     
     printf("Loaded asset registry: %lu assets\n", asset_count);
     return true;
 }
 
-// Open the main asset data file
-bool open_asset_file(const char* filename) {
-    FRESULT fr;
+// Cartridge asset pack
+// A cartridge can carry the game's assets as a pack in XIP-mapped flash,
+// with the same layout written to the GPU's and APU's own flash by the
+// packaging tool. Entries are 4-byte aligned and stored in the format the
+// devices use, so nothing is read into RAM: the CPU uses its copy in place,
+// and for an asset the target device also holds it only sends a small
+// descriptor (MAP_TILESET, MAP_SPRITE_PATTERN, SAMPLE_MAP, WAVE_MAP_TABLE).
+// Header: [magic:4] [version:2] [entryCount:2] [packSize:4] [gameId:4],
+// little-endian, followed by entryCount AssetPackEntry records.
+#define CART_PACK_XIP_OFFSET 0x100000    // Cartridge flash past the firmware image
+#define ASSET_PACK_MAGIC 0x50414254      // "TBAP"
+#define ASSET_PACK_HEADER_SIZE 16
+#define ASSET_PACK_ON_DEVICE 0x0001      // Target device's pack holds a copy at device_offset
+
+typedef struct {
+    uint32_t id;
+    uint8_t type;           // AssetType
+    uint8_t target;         // 0=CPU, 1=GPU, 2=APU
+    uint16_t flags;
+    uint32_t offset;        // From the start of this pack
+    uint32_t size;
+    uint32_t device_offset; // From the start of the target device's pack
+    uint8_t tile_width;     // As in AssetInfo; 0 for the default
+    uint8_t tile_height;
+    uint8_t bpp;
+    uint8_t reserved;
+} AssetPackEntry;
+
+// Build the registry from the cartridge pack if it holds this game
+bool mount_asset_pack(uint32_t game_id) {
+    const uint8_t* pack = (const uint8_t*)(XIP_BASE + CART_PACK_XIP_OFFSET);
+    const uint32_t* header = (const uint32_t*)pack;
+    
+    if (header[0] != ASSET_PACK_MAGIC || header[3] != game_id) {
+        return false;
+    }
     
-    // Close previous file if open
-    if (asset_file_open) {
-        f_close(&asset_file);
-        asset_file_open = false;
+    uint32_t pack_size = header[2];
+    uint32_t count = header[1] >> 16;
+    if (count > MAX_ASSETS) {
+        count = MAX_ASSETS;
+    }
+    
+    const AssetPackEntry* entries = (const AssetPackEntry*)(pack + ASSET_PACK_HEADER_SIZE);
+    asset_count = 0;
+    memset(asset_flash, 0, sizeof(asset_flash));
+    
+    for (uint32_t i = 0; i < count; i++) {
+        const AssetPackEntry* entry = &entries[i];
+        if (entry->offset > pack_size || entry->size > pack_size - entry->offset) {
+            continue; // Corrupt entry
+        }
+        
+        AssetInfo* asset = &assets[asset_count];
+        memset(asset, 0, sizeof(AssetInfo));
+        asset->id = entry->id;
+        asset->type = entry->type;
+        asset->size = entry->size;
+        asset->offset = entry->offset;
+        asset->target = entry->target;
+        asset->tile_width = entry->tile_width;
+        asset->tile_height = entry->tile_height;
+        asset->bpp = entry->bpp;
+        
+        asset_flash[asset_count] = pack + entry->offset;
+        asset_device_offset[asset_count] = (entry->flags & ASSET_PACK_ON_DEVICE) ? entry->device_offset
+                                                                               : ASSET_NOT_ON_DEVICE;
+        asset_count++;
+    }
+    
+    index_asset_registry();
+    
+    printf("Mounted cartridge asset pack: %lu assets\n", asset_count);
+    return true;
+}
+
+// Open the main asset data file
+bool open_asset_file(const char* filename) {
+    FRESULT fr;
+    
+    // Close previous file if open
+    if (asset_file_open) {
+        f_close(&asset_file);
+        asset_file_open = false;
     }
     
     // Open asset data file
@@ -930,82 +1833,244 @@ bool open_asset_file(const char* filename) {
 
 // Find asset by ID
 AssetInfo* find_asset(uint32_t asset_id) {
-    for (uint32_t i = 0; i < asset_count; i++) {
-        if (assets[i].id == asset_id) {
-            return &assets[i];
+    uint32_t slot = asset_hash_slot(asset_id);
+    while (asset_hash[slot] != 0) {
+        AssetInfo* asset = &assets[asset_hash[slot] - 1];
+        if (asset->id == asset_id) {
+            return asset;
         }
+        slot = (slot + 1) & (ASSET_HASH_SIZE - 1);
     }
     return NULL;
 }
 
+static uint32_t asset_cache_priority(const AssetCacheEntry* entry) {
+    // hits x reload cost per byte, scaled by 256 to keep integer precision
+    uint64_t value = (uint64_t)entry->hits * (ASSET_SEEK_COST_BYTES + entry->size) * 256 / entry->size;
+    return asset_cache_clock + (uint32_t)MIN(value, 0x7FFFFFFFu);
+}
+
 // Find asset in cache
 uint8_t* find_asset_in_cache(uint32_t asset_id, uint32_t* size) {
-    for (uint32_t i = 0; i < asset_cache_count; i++) {
-        if (asset_cache[i].asset_id == asset_id) {
-            asset_cache[i].last_used = frame_counter;
-            if (size != NULL) {
-                *size = asset_cache[i].size;
-            }
-            return asset_cache[i].data;
+    AssetInfo* asset = find_asset(asset_id);
+    int8_t slot = (asset != NULL) ? asset_cache_slot[asset - assets] : -1;
+    
+    if (slot < 0 || !asset_cache[slot].ready) {
+        asset_cache_stats.misses++;
+        return NULL;
+    }
+    
+    AssetCacheEntry* entry = &asset_cache[slot];
+    entry->last_used = frame_counter;
+    entry->hits++;
+    entry->priority = asset_cache_priority(entry);
+    asset_cache_stats.hits++;
+    asset_cache_stats.bytes_hit += entry->size;
+    
+    if (size != NULL) {
+        *size = entry->size;
+    }
+    return asset_arena + entry->offset;
+}
+
+// Keep an asset's cached copy resident (boot assets, UI, etc.)
+void pin_asset(uint32_t asset_id, bool pinned) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset != NULL) {
+        asset_pinned[asset - assets] = pinned;
+    }
+}
+
+// Release an entry's arena space
+static void drop_cached_asset(int slot) {
+    AssetCacheEntry* entry = &asset_cache[slot];
+    asset_cache_slot[entry->asset_index] = -1;
+    asset_arena_used -= entry->size;
+    entry->used = false;
+}
+
+static void evict_cached_asset(int slot) {
+    AssetCacheEntry* entry = &asset_cache[slot];
+    
+    // Later entries start from at least this priority
+    if (entry->priority > asset_cache_clock) {
+        asset_cache_clock = entry->priority;
+    }
+    
+    asset_cache_stats.evictions++;
+    asset_cache_stats.bytes_evicted += entry->size;
+    drop_cached_asset(slot);
+}
+
+// Live entries in arena order
+static int sort_cache_by_offset(uint8_t* order) {
+    int count = 0;
+    for (int i = 0; i < MAX_CACHED_ASSETS; i++) {
+        if (!asset_cache[i].used) continue;
+        
+        int j = count++;
+        while (j > 0 && asset_cache[order[j - 1]].offset > asset_cache[i].offset) {
+            order[j] = order[j - 1];
+            j--;
         }
+        order[j] = i;
     }
-    return NULL;
+    return count;
 }
 
-// Add asset to cache
-void cache_asset(uint32_t asset_id, uint8_t* data, uint32_t size) {
-    // Check if already in cache
-    for (uint32_t i = 0; i < asset_cache_count; i++) {
-        if (asset_cache[i].asset_id == asset_id) {
-            // Already cached, update
-            if (asset_cache[i].size != size) {
-                // Resize buffer
-                free(asset_cache[i].data);
-                asset_cache[i].data = malloc(size);
-                asset_cache[i].size = size;
-            }
-            memcpy(asset_cache[i].data, data, size);
-            asset_cache[i].last_used = frame_counter;
-            return;
+// First gap between live blocks (or the tail) that holds size bytes
+static bool find_arena_gap(uint32_t size, uint32_t* offset) {
+    uint8_t order[MAX_CACHED_ASSETS];
+    int count = sort_cache_by_offset(order);
+    uint32_t end = 0;
+    
+    for (int i = 0; i < count; i++) {
+        AssetCacheEntry* entry = &asset_cache[order[i]];
+        if (entry->offset - end >= size) {
+            *offset = end;
+            return true;
         }
+        end = (entry->offset + entry->size + ASSET_ARENA_ALIGN - 1) & ~(ASSET_ARENA_ALIGN - 1);
     }
     
-    // Not in cache, find a slot
-    uint32_t slot;
+    if (asset_arena_size - end >= size) {
+        *offset = end;
+        return true;
+    }
+    return false;
+}
+
+// Slide blocks down over the gaps. Blocks a stream is reading stay put.
+static void compact_asset_arena() {
+    uint8_t order[MAX_CACHED_ASSETS];
+    int count = sort_cache_by_offset(order);
+    uint32_t end = 0;
+    
+    for (int i = 0; i < count; i++) {
+        AssetCacheEntry* entry = &asset_cache[order[i]];
+        if (entry->offset > end && !asset_stream_uses(asset_arena + entry->offset)) {
+            memmove(asset_arena + end, asset_arena + entry->offset, entry->size);
+            entry->offset = end;
+        }
+        end = (entry->offset + entry->size + ASSET_ARENA_ALIGN - 1) & ~(ASSET_ARENA_ALIGN - 1);
+    }
+    asset_cache_stats.compactions++;
+}
+
+// Lowest-priority entry that may go, or -1
+static int pick_cache_victim() {
+    int victim = -1;
+    for (int i = 0; i < MAX_CACHED_ASSETS; i++) {
+        AssetCacheEntry* entry = &asset_cache[i];
+        if (!entry->used || asset_pinned[entry->asset_index] ||
+            asset_stream_uses(asset_arena + entry->offset)) {
+            continue;
+        }
+        if (victim < 0 || entry->priority < asset_cache[victim].priority) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+// Claim cache space for an asset, evicting by priority until it fits. The
+// entry is not ready until it is filled. The returned pointer stays valid
+// until the next reservation (which may compact the arena).
+uint8_t* reserve_cached_asset(uint32_t asset_id, uint32_t size) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset == NULL || size == 0 || size > asset_arena_size) {
+        return NULL;
+    }
+    uint16_t index = asset - assets;
     
-    if (asset_cache_count < MAX_CACHED_ASSETS) {
-        // Use next empty slot
-        slot = asset_cache_count++;
-    } else {
-        // Find least recently used asset
-        uint32_t oldest_time = 0xFFFFFFFF;
-        uint32_t oldest_index = 0;
+    // Replace any copy we already hold
+    if (asset_cache_slot[index] >= 0) {
+        AssetCacheEntry* entry = &asset_cache[asset_cache_slot[index]];
+        if (asset_stream_uses(asset_arena + entry->offset)) {
+            return NULL;
+        }
+        drop_cached_asset(asset_cache_slot[index]);
+    }
+    
+    int slot = -1;
+    uint32_t offset = 0;
+    while (true) {
+        // Need a free entry as well as the bytes
+        slot = -1;
+        for (int i = 0; i < MAX_CACHED_ASSETS && slot < 0; i++) {
+            if (!asset_cache[i].used) slot = i;
+        }
         
-        for (uint32_t i = 0; i < MAX_CACHED_ASSETS; i++) {
-            if (asset_cache[i].last_used < oldest_time) {
-                oldest_time = asset_cache[i].last_used;
-                oldest_index = i;
+        if (slot >= 0 && find_arena_gap(size, &offset)) {
+            break;
+        }
+        
+        // Enough bytes in total, just not together
+        if (slot >= 0 && asset_arena_size - asset_arena_used >= size + MAX_CACHED_ASSETS * ASSET_ARENA_ALIGN) {
+            compact_asset_arena();
+            if (find_arena_gap(size, &offset)) {
+                break;
             }
         }
         
-        // Free the LRU asset
-        slot = oldest_index;
-        free(asset_cache[slot].data);
+        int victim = pick_cache_victim();
+        if (victim < 0) {
+            return NULL;
+        }
+        evict_cached_asset(victim);
     }
     
-    // Store new asset
-    asset_cache[slot].asset_id = asset_id;
-    asset_cache[slot].data = malloc(size);
-    asset_cache[slot].size = size;
-    asset_cache[slot].last_used = frame_counter;
+    AssetCacheEntry* entry = &asset_cache[slot];
+    entry->asset_id = asset_id;
+    entry->asset_index = index;
+    entry->offset = offset;
+    entry->size = size;
+    entry->last_used = frame_counter;
+    entry->hits = 1;
+    entry->priority = asset_cache_priority(entry);
+    entry->used = true;
+    entry->ready = false;
+    
+    asset_cache_slot[index] = slot;
+    asset_arena_used += size;
+    asset_cache_stats.bytes_loaded += size;
+    
+    return asset_arena + offset;
+}
+
+// Mark a reserved slot as complete
+void mark_asset_cached(uint32_t asset_id) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset != NULL && asset_cache_slot[asset - assets] >= 0) {
+        asset_cache[asset_cache_slot[asset - assets]].ready = true;
+    }
+}
+
+// Throw away a reserved slot that never got filled
+void discard_cached_asset(uint32_t asset_id) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset != NULL && asset_cache_slot[asset - assets] >= 0) {
+        drop_cached_asset(asset_cache_slot[asset - assets]);
+    }
+}
+
+// Add asset to cache
+void cache_asset(uint32_t asset_id, uint8_t* data, uint32_t size) {
+    uint8_t* slot = reserve_cached_asset(asset_id, size);
     
     // Copy data
-    if (asset_cache[slot].data != NULL) {
-        memcpy(asset_cache[slot].data, data, size);
+    if (slot != NULL) {
+        memcpy(slot, data, size);
+        mark_asset_cached(asset_id);
     }
 }
 
-// Load asset data from file
+AssetCacheStats get_asset_cache_stats() {
+    return asset_cache_stats;
+}
+
+// Load asset data from file into the cache. The pointer belongs to the
+// cache and stays valid until the next asset is cached.
 bool load_asset_data(uint32_t asset_id, uint8_t** data, uint32_t* size) {
     // Find asset info
     AssetInfo* asset = find_asset(asset_id);
@@ -1014,6 +2079,13 @@ bool load_asset_data(uint32_t asset_id, uint8_t** data, uint32_t* size) {
         return false;
     }
     
+    // Cartridge assets are already addressable
+    if (asset_flash[asset - assets] != NULL) {
+        *data = (uint8_t*)asset_flash[asset - assets];
+        *size = asset->size;
+        return true;
+    }
+    
     // Check if asset is already loaded in cache
     uint8_t* cached_data = find_asset_in_cache(asset_id, size);
     if (cached_data != NULL) {
@@ -1034,8 +2106,8 @@ bool load_asset_data(uint32_t asset_id, uint8_t** data, uint32_t* size) {
         return false;
     }
     
-    // Allocate buffer for asset data
-    uint8_t* buffer = malloc(asset->size);
+    // Read straight into cache space
+    uint8_t* buffer = reserve_cached_asset(asset_id, asset->size);
     if (buffer == NULL) {
         printf("Failed to allocate memory for asset: %lu bytes\n", asset->size);
         return false;
@@ -1046,12 +2118,10 @@ bool load_asset_data(uint32_t asset_id, uint8_t** data, uint32_t* size) {
     fr = f_read(&asset_file, buffer, asset->size, &br);
     if (fr != FR_OK || br != asset->size) {
         printf("Failed to read asset data: %lu bytes\n", asset->size);
-        free(buffer);
+        discard_cached_asset(asset_id);
         return false;
     }
-    
-    // Cache the asset
-    cache_asset(asset_id, buffer, asset->size);
+    mark_asset_cached(asset_id);
     
     // Return asset data
     *data = buffer;
@@ -1063,65 +2133,56 @@ bool load_asset_data(uint32_t asset_id, uint8_t** data, uint32_t* size) {
     return true;
 }
 
-// Send asset to target device (GPU or APU)
-bool send_asset_to_device(uint32_t asset_id) {
-    // Load asset data
-    uint8_t* data = NULL;
-    uint32_t size = 0;
-    
-    if (!load_asset_data(asset_id, &data, &size)) {
-        return false;
-    }
-    
-    // Find asset info
-    AssetInfo* asset = find_asset(asset_id);
-    if (asset == NULL) {
-        free(data);
-        return false;
-    }
-    
-    bool result = false;
-    
-    // Send to appropriate device
-    switch (asset->target) {
-        case 1: // GPU
-            result = send_asset_to_gpu(asset, data, size);
-            break;
-            
-        case 2: // APU
-            result = send_asset_to_apu(asset, data, size);
-            break;
-            
-        default: // CPU or unknown
-            result = true; // Already loaded to CPU memory
-            break;
-    }
-    
-    // Free data if we don't need to keep it
-    if (asset->target != 0) {
-        free(data);
+// Asset frames
+// Tilesets, tilemaps, palettes and samples can be split on whole units
+// (tiles, map rows, RGB entries, bytes), so they reach the device as a run
+// of small commands that each fit one frame. This is what lets the loader
+// forward data as it comes off the SD card.
+#define ASSET_FRAME_PAYLOAD 240     // Data bytes per forwarded command
+#define ASSET_MAP_ROW_BYTES 64      // 32 tiles, 2 bytes each
+
+// Bytes in one tile of a tileset, or in a sprite pattern
+static uint32_t asset_tile_bytes(const AssetInfo* asset) {
+    return (asset->tile_width * asset->tile_height * asset->bpp) / 8;
+}
+
+// Bytes per forwarded command, or 0 if the asset has to go in one piece
+static uint32_t asset_frame_bytes(const AssetInfo* asset) {
+    switch (asset->type) {
+        case ASSET_TYPE_TILESET:
+            // Tiles larger than a frame can't be sent at all; send_asset_to_gpu refuses them
+            return (ASSET_FRAME_PAYLOAD / asset_tile_bytes(asset)) * asset_tile_bytes(asset);
+        case ASSET_TYPE_TILEMAP:
+            return (ASSET_FRAME_PAYLOAD / ASSET_MAP_ROW_BYTES) * ASSET_MAP_ROW_BYTES;
+        case ASSET_TYPE_PALETTE:
+            return (ASSET_FRAME_PAYLOAD / 3) * 3;
+        case ASSET_TYPE_SAMPLE:
+            return ASSET_FRAME_PAYLOAD;
+        default:
+            return 0;
     }
-    
-    return result;
 }
 
-// Send asset to GPU
-bool send_asset_to_gpu(AssetInfo* asset, uint8_t* data, uint32_t size) {
-    // Determine appropriate GPU command based on asset type
-    uint8_t cmd_id;
-    uint8_t header[16]; // Command header buffer
+// Send the piece of an asset that starts at offset
+static bool send_asset_frame(const AssetInfo* asset, uint32_t offset, const uint8_t* data, uint32_t count) {
+    uint8_t cmd_buffer[16 + ASSET_FRAME_PAYLOAD];
+    uint8_t* header = cmd_buffer;
     uint8_t header_size = 0;
+    uint8_t cmd_id;
+    uint32_t tiles, first, rows;
     
     switch (asset->type) {
         case ASSET_TYPE_TILESET:
             cmd_id = 0x21; // LOAD_TILESET
             
             // Prepare header (layer, start tile, count, compression)
+            tiles = count / asset_tile_bytes(asset);
+            first = offset / asset_tile_bytes(asset);
             header[0] = 0; // Default to layer 0
-            header[1] = 0; // Tile start index high byte
-            header[2] = 0; // Tile start index low byte
-            header[3] = (size / 64) >> 8; // Assuming 8x8 tiles, 8bpp
-            header[4] = (size / 64) & 0xFF;
+            header[1] = first >> 8; // Tile start index high byte
+            header[2] = first & 0xFF;
+            header[3] = tiles >> 8;
+            header[4] = tiles & 0xFF;
             header[5] = 0; // No compression
             header_size = 6;
             break;
@@ -1130,125 +2191,523 @@ bool send_asset_to_gpu(AssetInfo* asset, uint8_t* data, uint32_t size) {
             cmd_id = 0x22; // LOAD_TILEMAP
             
             // Prepare header (layer, x, y, width, height, compression)
+            rows = count / ASSET_MAP_ROW_BYTES;
             header[0] = 0; // Default to layer 0
             header[1] = 0; // X position
-            header[2] = 0; // Y position
+            header[2] = offset / ASSET_MAP_ROW_BYTES; // Y position of the first row
             header[3] = 32; // Default width in tiles
-            header[4] = size / (32 * 2); // Height based on size (assuming 2 bytes per tile)
+            header[4] = rows;
             header[5] = 0; // No compression
             header_size = 6;
             break;
             
+        case ASSET_TYPE_PALETTE:
+            cmd_id = 0x11; // LOAD_PALETTE
+            
+            // Prepare header (start index, count)
+            header[0] = offset / 3; // Start index
+            header[1] = count / 3; // Count (3 bytes per color: RGB)
+            header_size = 2;
+            break;
+            
+        case ASSET_TYPE_SAMPLE:
+            if (offset == 0) {
+                cmd_id = 0x70; // SAMPLE_LOAD
+                
+                // Prepare header (sample ID, format, sample rate, loop points, size)
+                header[0] = asset->id & 0xFF; // Sample ID
+                header[1] = 0; // Format (8-bit mono)
+                header[2] = 44; // Sample rate (11025Hz) low byte
+                header[3] = 43; // Sample rate high byte
+                header[4] = 0; // Loop start low byte
+                header[5] = 0; // Loop start high byte
+                header[6] = 0; // Loop end low byte
+                header[7] = 0; // Loop end high byte
+                header[8] = asset->size & 0xFF; // Size low byte
+                header[9] = (asset->size >> 8) & 0xFF; // Size high byte
+                header_size = 10;
+            } else {
+                cmd_id = 0x7E; // SAMPLE_LOAD_DATA
+                header[0] = asset->id & 0xFF; // Sample ID
+                header_size = 1;
+            }
+            break;
+            
+        default:
+            return false;
+    }
+    
+    memcpy(cmd_buffer + header_size, data, count);
+    
+    CommandQueue* queue = (asset->target == 1) ? &gpu_queue : &apu_queue;
+    return queue_sequenced_command(queue, cmd_id, header_size + count + 2, cmd_buffer);
+}
+
+// Forward as many whole frames as the data holds; with final set the short
+// tail goes too. Returns the bytes consumed.
+static uint32_t send_asset_frames(const AssetInfo* asset, uint32_t offset, const uint8_t* data,
+                                  uint32_t count, bool final) {
+    uint32_t frame = asset_frame_bytes(asset);
+    uint32_t done = 0;
+    
+    while (count - done >= frame || (final && done < count)) {
+        uint32_t piece = MIN(frame, count - done);
+        if (!send_asset_frame(asset, offset + done, data + done, piece)) {
+            break;
+        }
+        done += piece;
+    }
+    
+    return done;
+}
+
+// Tell the device to use its own copy of an asset. False if the type has
+// no descriptor form and the data has to be sent.
+static bool send_asset_descriptor(const AssetInfo* asset, uint32_t device_offset) {
+    uint8_t cmd[20];
+    uint32_t tiles;
+    
+    switch (asset->type) {
+        case ASSET_TYPE_TILESET:
+            // Same placement as the LOAD_TILESET path: layer 0 from tile 0
+            tiles = asset->size / asset_tile_bytes(asset);
+            cmd[0] = 0;
+            cmd[1] = 0;
+            cmd[2] = 0;
+            cmd[3] = tiles >> 8;
+            cmd[4] = tiles & 0xFF;
+            cmd[5] = device_offset >> 24;
+            cmd[6] = (device_offset >> 16) & 0xFF;
+            cmd[7] = (device_offset >> 8) & 0xFF;
+            cmd[8] = device_offset & 0xFF;
+            return queue_gpu_command(0x2C, 9 + 2, cmd); // MAP_TILESET
+            
+        case ASSET_TYPE_SPRITE:
+            cmd[0] = asset->id & 0xFF; // Pattern ID
+            cmd[1] = asset->tile_width / 8; // Size in 8-pixel units
+            cmd[2] = asset->tile_height / 8;
+            cmd[3] = asset->bpp;
+            cmd[4] = device_offset >> 24;
+            cmd[5] = (device_offset >> 16) & 0xFF;
+            cmd[6] = (device_offset >> 8) & 0xFF;
+            cmd[7] = device_offset & 0xFF;
+            return queue_gpu_command(0x4D, 8 + 2, cmd); // MAP_SPRITE_PATTERN
+            
+        case ASSET_TYPE_SAMPLE:
+            // 8-bit mono at 11025Hz, no loop, as with SAMPLE_LOAD
+            memset(cmd, 0, sizeof(cmd));
+            cmd[0] = asset->id & 0xFF;
+            cmd[2] = 11025 & 0xFF;
+            cmd[3] = 11025 >> 8;
+            memcpy(&cmd[4], &device_offset, 4);
+            memcpy(&cmd[8], &asset->size, 4);
+            return queue_apu_command(0x7F, 20 + 2, cmd); // SAMPLE_MAP
+            
+        case ASSET_TYPE_WAVETABLE:
+            cmd[0] = asset->id & 0xFF;
+            cmd[1] = (asset->size / 2) & 0xFF;
+            cmd[2] = (asset->size / 2) >> 8;
+            memcpy(&cmd[3], &device_offset, 4);
+            return queue_apu_command(0x9A, 7 + 2, cmd); // WAVE_MAP_TABLE
+            
+        default:
+            return false;
+    }
+}
+
+// Send asset to GPU
+bool send_asset_to_gpu(AssetInfo* asset, uint8_t* data, uint32_t size) {
+    // Determine appropriate GPU command based on asset type
+    uint8_t cmd_id;
+    uint8_t header[16]; // Command header buffer
+    uint8_t header_size = 0;
+    
+    switch (asset->type) {
+        case ASSET_TYPE_TILESET:
+            if (asset_frame_bytes(asset) == 0) {
+                printf("Tiles too large for one GPU command: %lu bytes\n", asset_tile_bytes(asset));
+                return false;
+            }
+            return send_asset_frames(asset, 0, data, size, true) == size;
+            
+        case ASSET_TYPE_TILEMAP:
+        case ASSET_TYPE_PALETTE:
+            return send_asset_frames(asset, 0, data, size, true) == size;
+            
         case ASSET_TYPE_SPRITE:
             cmd_id = 0x40; // LOAD_SPRITE_PATTERN
             
             // Prepare header (pattern ID, width, height, bpp, compression)
             header[0] = asset->id & 0xFF; // Pattern ID
-            header[1] = 2; // Width in 8-pixel units (16 pixels)
-            header[2] = 2; // Height in 8-pixel units (16 pixels)
-            header[3] = 8; // 8bpp
+            header[1] = asset->tile_width / 8; // Width in 8-pixel units
+            header[2] = asset->tile_height / 8; // Height in 8-pixel units
+            header[3] = asset->bpp;
             header[4] = 0; // No compression
             header_size = 5;
             break;
             
-        case ASSET_TYPE_PALETTE:
-            cmd_id = 0x11; // LOAD_PALETTE
-            
-            // Prepare header (start index, count)
-            header[0] = 0; // Start index
-            header[1] = size / 3; // Count (3 bytes per color: RGB)
-            header_size = 2;
-            break;
-            
         default:
             printf("Unsupported asset type for GPU: %d\n", asset->type);
             return false;
     }
     
+    // A pattern has to arrive in one command
+    if (header_size + size + 2 > 255) {
+        printf("Asset too large for one GPU command: %lu bytes\n", size);
+        return false;
+    }
+    
     // Send command header
     uint8_t cmd_buffer[header_size + size];
     memcpy(cmd_buffer, header, header_size);
     memcpy(cmd_buffer + header_size, data, size);
     
     // Queue command
-    return queue_gpu_command(cmd_id, header_size + 2, cmd_buffer);
+    return queue_sequenced_command(&gpu_queue, cmd_id, header_size + size + 2, cmd_buffer);
 }
 
-// Send asset to APU
-bool send_asset_to_apu(AssetInfo* asset, uint8_t* data, uint32_t size) {
-    // Determine appropriate APU command based on asset type
-    uint8_t cmd_id;
-    uint8_t header[16]; // Command header buffer
-    uint8_t header_size = 0;
+// Music compilation
+//
+// Songs are authored as full pattern grids (the old TRACKER_LOAD layout:
+// [channels:1] [patterns:1] [instruments:1] [songLength:1] [tempo:1]
+// [sequence:songLength], then per pattern [rows:1] and rows x channels cells
+// of [note] [instrument] [volume] [effect] [param]). The APU replays a sparse
+// event stream instead, so music is compiled here before upload: empty cells
+// vanish and per-tick effects become small curve tables the APU steps
+// through. The stream layout is documented with the APU tracker.
+#define TRACKER_HEADER_SIZE 8
+#define TRACKER_SONG_LOOP 0x01
+#define TRACKER_EVENT_NOTE 0x10
+#define TRACKER_EVENT_INSTRUMENT 0x20
+#define TRACKER_EVENT_VOLUME 0x40
+#define TRACKER_EVENT_CONTROL 0x80
+#define TRACKER_CTRL_PITCH_CURVE 0x01
+#define TRACKER_CTRL_VOLUME_CURVE 0x02
+#define TRACKER_CTRL_SPEED 0x04
+#define TRACKER_CTRL_TEMPO 0x08
+#define TRACKER_CURVE_VOLUME 0x01
+#define TRACKER_CURVE_RAMP 0x02
+#define TRACKER_CURVE_NONE 0xFF
+#define MAX_TRACKER_CURVES 64
+#define MAX_TRACKER_CURVE_LENGTH 64
+#define MAX_TRACKER_CHANNELS 16
+#define TRACKER_LOAD_CHUNK 250       // Payload left after [trackerId] [size:2]
+#define TRACKER_DATA_CHUNK 252       // Payload left after [trackerId]
+
+typedef struct {
+    uint8_t effect;
+    uint8_t param;
+} TrackerCurveKey;
+
+typedef struct {
+    TrackerCurveKey keys[MAX_TRACKER_CURVES];
+    uint8_t count;
+} TrackerCurveSet;
+
+// Curve a cell's effect needs on each side, or TRACKER_CURVE_NONE
+static uint8_t find_tracker_curve(TrackerCurveSet* set, uint8_t effect, uint8_t param) {
+    for (int i = 0; i < set->count; i++) {
+        if (set->keys[i].effect == effect && set->keys[i].param == param) {
+            return i;
+        }
+    }
+    if (set->count == MAX_TRACKER_CURVES) {
+        return TRACKER_CURVE_NONE; // Out of curves: the effect is dropped
+    }
+    set->keys[set->count].effect = effect;
+    set->keys[set->count].param = param;
+    return set->count++;
+}
+
+static void classify_tracker_effect(TrackerCurveSet* set, uint8_t effect, uint8_t param,
+                                    uint8_t* pitch_curve, uint8_t* volume_curve) {
+    *pitch_curve = TRACKER_CURVE_NONE;
+    *volume_curve = TRACKER_CURVE_NONE;
     
-    switch (asset->type) {
-        case ASSET_TYPE_SAMPLE:
-            cmd_id = 0x70; // SAMPLE_LOAD
+    switch (effect) {
+        case 0x0: // Arpeggio
+        case 0x1: // Portamento up
+        case 0x2: // Portamento down
+            if (param != 0) *pitch_curve = find_tracker_curve(set, effect, param);
+            break;
             
-            // Prepare header (sample ID, format, sample rate, loop points, size)
-            header[0] = asset->id & 0xFF; // Sample ID
-            header[1] = 0; // Format (8-bit mono)
-            header[2] = 44; // Sample rate (11025Hz) low byte
-            header[3] = 43; // Sample rate high byte
-            header[4] = 0; // Loop start low byte
-            header[5] = 0; // Loop start high byte
-            header[6] = 0; // Loop end low byte
-            header[7] = 0; // Loop end high byte
-            header[8] = size & 0xFF; // Size low byte
-            header[9] = (size >> 8) & 0xFF; // Size high byte
-            header_size = 10;
+        case 0x4: // Vibrato
+            if ((param >> 4) != 0 && (param & 0x0F) != 0) {
+                *pitch_curve = find_tracker_curve(set, effect, param);
+            }
             break;
             
-        case ASSET_TYPE_MUSIC:
-            cmd_id = 0x10; // TRACKER_LOAD
+        case 0x7: // Tremolo
+            if ((param >> 4) != 0 && (param & 0x0F) != 0) {
+                *volume_curve = find_tracker_curve(set, effect, param);
+            }
+            break;
             
-            // Prepare header (tracker ID, data size)
-            header[0] = asset->id & 0xFF; // Tracker ID
-            header[1] = size & 0xFF; // Size low byte
-            header[2] = (size >> 8) & 0xFF; // Size high byte
-            header_size = 3;
+        case 0xA: // Volume slide
+            if (param != 0) *volume_curve = find_tracker_curve(set, effect, param);
+            break;
+    }
+}
+
+// Write one curve table; returns bytes written
+static uint32_t emit_tracker_curve(const TrackerCurveKey* key, uint8_t* out) {
+    int16_t values[MAX_TRACKER_CURVE_LENGTH];
+    uint8_t mode = 0;
+    uint8_t length = 1;
+    uint8_t hi = key->param >> 4;
+    uint8_t lo = key->param & 0x0F;
+    
+    switch (key->effect) {
+        case 0x0: // Arpeggio: base, +hi, +lo semitones, repeating
+            length = 3;
+            values[0] = 0;
+            values[1] = hi * 16;
+            values[2] = lo * 16;
             break;
             
-        default:
-            printf("Unsupported asset type for APU: %d\n", asset->type);
-            return false;
+        case 0x1: // Portamento up, param/16 semitone per tick
+            mode = TRACKER_CURVE_RAMP;
+            values[0] = key->param;
+            break;
+            
+        case 0x2: // Portamento down
+            mode = TRACKER_CURVE_RAMP;
+            values[0] = -key->param;
+            break;
+            
+        case 0x4: // Vibrato: one sine period, depth/16 semitones
+        case 0x7: // Tremolo: volume dips by up to depth
+            {
+                // Speed s advances the phase 0.1 * s radians per tick
+                int period = (int)(62.83f / hi + 0.5f);
+                length = (period < 2) ? 2 : (period > MAX_TRACKER_CURVE_LENGTH) ? MAX_TRACKER_CURVE_LENGTH : period;
+                for (int i = 0; i < length; i++) {
+                    float wave = sinf(2.0f * 3.14159265f * i / length);
+                    values[i] = (key->effect == 0x4) ? (int16_t)lroundf(wave * lo)
+                                                     : (int16_t)-lroundf((wave + 1.0f) * 0.5f * lo);
+                }
+                if (key->effect == 0x7) mode = TRACKER_CURVE_VOLUME;
+            }
+            break;
+            
+        case 0xA: // Volume slide
+            mode = TRACKER_CURVE_VOLUME | TRACKER_CURVE_RAMP;
+            values[0] = (hi > 0) ? hi : -lo;
+            break;
     }
     
-    // For large assets like samples, we need to send in chunks
-    if (asset->type == ASSET_TYPE_SAMPLE && size > 240) {
-        // First send the header
-        if (!queue_apu_command(cmd_id, header_size + 2, header)) {
-            return false;
-        }
-        
-        // Then send the data in chunks
-        const uint16_t CHUNK_SIZE = 240;
-        uint32_t remaining = size;
-        uint32_t offset = 0;
-        
-        while (remaining > 0) {
-            uint16_t chunk_size = (remaining > CHUNK_SIZE) ? CHUNK_SIZE : remaining;
+    out[0] = mode;
+    out[1] = length;
+    for (int i = 0; i < length; i++) {
+        out[2 + i * 2] = values[i] & 0xFF;
+        out[3 + i * 2] = (values[i] >> 8) & 0xFF;
+    }
+    return 2 + length * 2;
+}
+
+// Compile one pattern grid to events. Returns bytes written, or 0 if the
+// grid runs past the end of the input.
+static uint32_t compile_tracker_pattern(const uint8_t* cells, uint8_t rows, uint8_t num_channels,
+                                        TrackerCurveSet* curves, uint8_t* out) {
+    uint8_t pitch_state[MAX_TRACKER_CHANNELS];
+    uint8_t volume_state[MAX_TRACKER_CHANNELS];
+    memset(pitch_state, TRACKER_CURVE_NONE, sizeof(pitch_state));
+    memset(volume_state, TRACKER_CURVE_NONE, sizeof(volume_state));
+    
+    uint32_t pos = 0;
+    uint8_t last_row = 0;
+    
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < num_channels; c++) {
+            const uint8_t* cell = &cells[(r * num_channels + c) * 5];
+            uint8_t note = cell[0];
+            uint8_t instrument = cell[1];
+            uint8_t volume = cell[2];
+            uint8_t effect = cell[3];
+            uint8_t param = cell[4];
             
-            // Use custom data transfer command
-            uint8_t* chunk_data = data + offset;
+            // Channels past the APU's limit are dropped
+            if (c >= MAX_TRACKER_CHANNELS) continue;
             
-            if (!queue_apu_command(0xF0, chunk_size + 2, chunk_data)) {
-                return false;
+            uint8_t pitch_curve, volume_curve;
+            classify_tracker_effect(curves, effect, param, &pitch_curve, &volume_curve);
+            
+            uint8_t control = 0;
+            if (pitch_curve != pitch_state[c]) control |= TRACKER_CTRL_PITCH_CURVE;
+            if (volume_curve != volume_state[c]) control |= TRACKER_CTRL_VOLUME_CURVE;
+            if (effect == 0xF && param != 0) {
+                control |= (param <= 0x1F) ? TRACKER_CTRL_SPEED : TRACKER_CTRL_TEMPO;
             }
             
-            offset += chunk_size;
-            remaining -= chunk_size;
+            uint8_t flags = c;
+            if (note > 0) flags |= TRACKER_EVENT_NOTE;
+            if (note > 0 && instrument > 0) flags |= TRACKER_EVENT_INSTRUMENT;
+            if (volume > 0) flags |= TRACKER_EVENT_VOLUME;
+            if (control) flags |= TRACKER_EVENT_CONTROL;
+            
+            // Empty cells cost nothing
+            if (flags == c) continue;
+            
+            out[pos++] = r - last_row;
+            out[pos++] = flags;
+            last_row = r;
+            
+            if (flags & TRACKER_EVENT_NOTE) out[pos++] = note;
+            if (flags & TRACKER_EVENT_INSTRUMENT) out[pos++] = instrument;
+            if (flags & TRACKER_EVENT_VOLUME) out[pos++] = volume;
+            if (control) {
+                out[pos++] = control;
+                if (control & TRACKER_CTRL_PITCH_CURVE) out[pos++] = pitch_curve;
+                if (control & TRACKER_CTRL_VOLUME_CURVE) out[pos++] = volume_curve;
+                if (control & (TRACKER_CTRL_SPEED | TRACKER_CTRL_TEMPO)) out[pos++] = param;
+            }
+            
+            pitch_state[c] = pitch_curve;
+            volume_state[c] = volume_curve;
         }
+    }
+    
+    return pos;
+}
+
+// Compile a pattern-grid song into the APU's event stream. Returns a malloc'd
+// song image, or NULL if the input is malformed or the result won't fit a
+// TRACKER_LOAD (64KB).
+uint8_t* compile_tracker_song(const uint8_t* raw, uint32_t raw_size, uint32_t* out_size) {
+    if (raw_size < 5) return NULL;
+    
+    uint8_t num_channels = raw[0];
+    uint8_t num_patterns = raw[1];
+    uint8_t song_length = raw[3];
+    uint8_t tempo = raw[4];
+    
+    if (num_channels == 0 || num_patterns == 0 || song_length == 0 ||
+        raw_size < 5u + song_length) {
+        return NULL;
+    }
+    
+    // An event never takes more than 9 bytes for a 5-byte cell
+    uint32_t event_max = raw_size * 9 / 5 + num_patterns * 3;
+    uint8_t* events = malloc(event_max);
+    TrackerCurveSet* curves = malloc(sizeof(TrackerCurveSet));
+    if (events == NULL || curves == NULL) {
+        free(events);
+        free(curves);
+        return NULL;
+    }
+    curves->count = 0;
+    
+    // Patterns first: curves are discovered along the way
+    uint32_t in = 5 + song_length;
+    uint32_t events_size = 0;
+    for (int p = 0; p < num_patterns; p++) {
+        if (in >= raw_size) goto fail;
+        uint8_t rows = raw[in++];
+        uint32_t grid = (uint32_t)rows * num_channels * 5;
+        if (rows == 0 || in + grid > raw_size) goto fail;
         
-        return true;
-    } else {
-        // Send command with header and data
-        uint8_t cmd_buffer[header_size + size];
-        memcpy(cmd_buffer, header, header_size);
-        memcpy(cmd_buffer + header_size, data, size);
-        
-        // Queue command
-        return queue_apu_command(cmd_id, header_size + size + 2, cmd_buffer);
+        uint8_t* block = &events[events_size];
+        uint32_t used = compile_tracker_pattern(&raw[in], rows, num_channels, curves, block + 3);
+        block[0] = rows;
+        block[1] = used & 0xFF;
+        block[2] = (used >> 8) & 0xFF;
+        events_size += 3 + used;
+        in += grid;
+    }
+    
+    uint32_t size = TRACKER_HEADER_SIZE + song_length +
+                    curves->count * (2 + MAX_TRACKER_CURVE_LENGTH * 2) + events_size;
+    uint8_t* song = malloc(size);
+    if (song == NULL) goto fail;
+    
+    song[0] = (num_channels <= MAX_TRACKER_CHANNELS) ? num_channels : MAX_TRACKER_CHANNELS;
+    song[1] = num_patterns;
+    song[2] = song_length;
+    song[3] = tempo ? tempo : 125;
+    song[4] = 6; // Default ticks per row
+    song[5] = TRACKER_SONG_LOOP;
+    song[6] = curves->count;
+    song[7] = 0;
+    memcpy(&song[TRACKER_HEADER_SIZE], &raw[5], song_length);
+    
+    uint32_t pos = TRACKER_HEADER_SIZE + song_length;
+    for (int i = 0; i < curves->count; i++) {
+        pos += emit_tracker_curve(&curves->keys[i], &song[pos]);
+    }
+    memcpy(&song[pos], events, events_size);
+    pos += events_size;
+    
+    free(events);
+    free(curves);
+    
+    if (pos > 0xFFFF) {
+        free(song);
+        return NULL;
+    }
+    
+    *out_size = pos;
+    return song;
+    
+fail:
+    free(events);
+    free(curves);
+    return NULL;
+}
+
+// Upload a compiled song: TRACKER_LOAD carries the size and the first chunk,
+// TRACKER_LOAD_DATA the rest
+bool send_tracker_song_to_apu(uint8_t tracker_id, const uint8_t* song, uint32_t size) {
+    uint8_t cmd_buffer[3 + TRACKER_LOAD_CHUNK];
+    uint32_t chunk = MIN(size, TRACKER_LOAD_CHUNK);
+    
+    cmd_buffer[0] = tracker_id;
+    cmd_buffer[1] = size & 0xFF;
+    cmd_buffer[2] = (size >> 8) & 0xFF;
+    memcpy(&cmd_buffer[3], song, chunk);
+    if (!queue_sequenced_command(&apu_queue, 0x10, 3 + chunk + 2, cmd_buffer)) { // TRACKER_LOAD
+        return false;
+    }
+    
+    for (uint32_t offset = chunk; offset < size; offset += chunk) {
+        chunk = MIN(size - offset, TRACKER_DATA_CHUNK);
+        cmd_buffer[0] = tracker_id;
+        memcpy(&cmd_buffer[1], song + offset, chunk);
+        if (!queue_sequenced_command(&apu_queue, 0x20, 1 + chunk + 2, cmd_buffer)) { // TRACKER_LOAD_DATA
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Compile a pattern-grid song and upload it to a tracker slot
+bool load_tracker_song(uint8_t tracker_id, const uint8_t* raw, uint32_t raw_size) {
+    uint32_t size;
+    uint8_t* song = compile_tracker_song(raw, raw_size, &size);
+    if (song == NULL) {
+        printf("Music asset could not be compiled\n");
+        return false;
+    }
+    
+    bool sent = send_tracker_song_to_apu(tracker_id, song, size);
+    free(song);
+    return sent;
+}
+
+// Send asset to APU
+bool send_asset_to_apu(AssetInfo* asset, uint8_t* data, uint32_t size) {
+    switch (asset->type) {
+        case ASSET_TYPE_SAMPLE:
+            // SAMPLE_LOAD carries the header and first chunk, SAMPLE_LOAD_DATA the rest
+            return send_asset_frames(asset, 0, data, size, true) == size;
+            
+        case ASSET_TYPE_MUSIC:
+            // Compiled to an event stream and sent in chunks
+            return load_tracker_song(asset->id & 0xFF, data, size);
+            
+        default:
+            printf("Unsupported asset type for APU: %d\n", asset->type);
+            return false;
     }
 }
 
@@ -1347,95 +2806,558 @@ void update_button_with_debounce(bool* button_state, bool raw_state, uint8_t* co
         // Button state is different from current state
         (*counter)++;
         
-        if (*counter >= DEBOUNCE_THRESHOLD) {
-            // Debounce threshold reached, update state
-            *button_state = raw_state;
-            *counter = 0;
+        if (*counter >= DEBOUNCE_THRESHOLD) {
+            // Debounce threshold reached, update state
+            *button_state = raw_state;
+            *counter = 0;
+        }
+    } else {
+        // Button state matches current state, reset counter
+        *counter = 0;
+    }
+}
+
+// Check if a button was just pressed
+bool button_pressed(bool current, bool previous) {
+    return current && !previous;
+}
+
+// Check if a button was just released
+bool button_released(bool current, bool previous) {
+    return !current && previous;
+}
+
+// Get directional input as a vector
+void get_direction(int* dx, int* dy) {
+    *dx = 0;
+    *dy = 0;
+    
+    if (current_buttons.left) *dx -= 1;
+    if (current_buttons.right) *dx += 1;
+    if (current_buttons.up) *dy -= 1;
+    if (current_buttons.down) *dy += 1;
+}
+
+// Inter-Core Communication
+// Message types for inter-core communication
+typedef enum {
+    MSG_LOAD_ASSET,
+    MSG_PROCESS_GPU_QUEUE,
+    MSG_PROCESS_APU_QUEUE,
+    MSG_GAME_EVENT
+} MessageType;
+
+// Message structure
+typedef struct {
+    MessageType type;
+    uint32_t param1;
+    uint32_t param2;
+    void* data;
+} CoreMessage;
+
+// Inter-core queues
+queue_t core0_to_core1_queue;
+queue_t core1_to_core0_queue;
+
+// Initialize inter-core communication
+void init_inter_core_communication() {
+    queue_init(&core0_to_core1_queue, sizeof(CoreMessage), 8);
+    queue_init(&core1_to_core0_queue, sizeof(CoreMessage), 8);
+}
+
+// Send a message from Core 0 to Core 1
+void send_message_to_core1(MessageType type, uint32_t param1, uint32_t param2, void* data) {
+    CoreMessage msg = {
+        .type = type,
+        .param1 = param1,
+        .param2 = param2,
+        .data = data
+    };
+    
+    queue_add_blocking(&core0_to_core1_queue, &msg);
+}
+
+// Send a message from Core 1 to Core 0
+void send_message_to_core0(MessageType type, uint32_t param1, uint32_t param2, void* data) {
+    CoreMessage msg = {
+        .type = type,
+        .param1 = param1,
+        .param2 = param2,
+        .data = data
+    };
+    
+    queue_add_blocking(&core1_to_core0_queue, &msg);
+}
+
+// Asset Streaming
+// Loads run on core 1 as a pipeline. Each call to service_asset_streams()
+// reads at most one SD chunk and forwards the whole frames it completes
+// straight to the device, so splittable assets are never staged in full and
+// the frame queues get flushed between chunks. Sprite patterns and songs
+// can't be split on the wire; those are gathered into the cache first.
+//
+// Demand loads always run ahead of prefetches. A prefetch only fills the
+// CPU-side cache, so it can't clobber what the devices are showing; when the
+// asset is asked for later it goes out from RAM with no SD wait.
+#define ASSET_CHUNK_SIZE 512        // One SD sector per step
+#define MAX_ASSET_REQUESTS 32
+#define ASSET_PRIORITY_DEMAND 0
+#define ASSET_PRIORITY_PREFETCH 1
+#define ASSET_PRIORITY_LEVELS 2
+
+typedef struct {
+    uint32_t asset_id;
+    uint8_t priority;
+} AssetRequest;
+
+typedef struct {
+    AssetInfo* asset;
+    bool active;
+    bool deliver;           // Forward to the device (demand) or just cache it
+    uint32_t read;          // Bytes taken from the source so far
+    uint32_t sent;          // Bytes forwarded to the device so far
+    uint8_t* cache;         // Whole-asset buffer, or NULL when streaming through
+    bool from_cache;        // Source is an already cached copy, not SD
+    uint32_t pending;       // Bytes in buffer not yet forwarded
+    uint32_t seq_failed_mark; // Target queue's seq_failed when delivery started
+    uint8_t buffer[ASSET_CHUNK_SIZE + ASSET_FRAME_PAYLOAD];
+} AssetStream;
+
+AssetRequest asset_requests[MAX_ASSET_REQUESTS];
+uint32_t asset_request_count = 0;
+AssetStream asset_streams[ASSET_PRIORITY_LEVELS];
+
+bool asset_stream_uses(const uint8_t* data) {
+    for (int i = 0; i < ASSET_PRIORITY_LEVELS; i++) {
+        if (asset_streams[i].active && asset_streams[i].cache == data) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Queue a load. A demand for an asset already waiting as a prefetch upgrades it.
+bool request_asset_load(uint32_t asset_id, uint8_t priority) {
+    for (uint32_t i = 0; i < asset_request_count; i++) {
+        if (asset_requests[i].asset_id == asset_id) {
+            if (priority < asset_requests[i].priority) {
+                asset_requests[i].priority = priority;
+            }
+            return true;
+        }
+    }
+    
+    if (asset_request_count == MAX_ASSET_REQUESTS) {
+        printf("Asset request queue full, dropping %lu\n", asset_id);
+        return false;
+    }
+    
+    asset_requests[asset_request_count].asset_id = asset_id;
+    asset_requests[asset_request_count].priority = priority;
+    asset_request_count++;
+    return true;
+}
+
+// Take the oldest request at the given priority
+static bool take_asset_request(uint8_t priority, uint32_t* asset_id) {
+    for (uint32_t i = 0; i < asset_request_count; i++) {
+        if (asset_requests[i].priority == priority) {
+            *asset_id = asset_requests[i].asset_id;
+            memmove(&asset_requests[i], &asset_requests[i + 1],
+                    (asset_request_count - i - 1) * sizeof(AssetRequest));
+            asset_request_count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The queue an asset's data goes out on, NULL for CPU-only assets
+static CommandQueue* asset_target_queue(const AssetInfo* asset) {
+    switch (asset->target) {
+        case 1: return &gpu_queue;
+        case 2: return &apu_queue;
+        default: return NULL;
+    }
+}
+
+// Remember the target's lost-command count, for finish_asset_stream() to
+// compare against once the asset is out
+static void mark_asset_delivery(AssetStream* stream) {
+    CommandQueue* queue = asset_target_queue(stream->asset);
+    if (queue != NULL) {
+        stream->seq_failed_mark = queue->seq_failed;
+    }
+}
+
+static bool start_asset_stream(AssetStream* stream, uint32_t asset_id, bool deliver) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset == NULL) {
+        printf("Asset not found: %lu\n", asset_id);
+        return false;
+    }
+    
+    // Cartridge assets need no loading: the device maps its own copy if it
+    // has one, otherwise the data goes out straight from XIP
+    uint16_t index = asset - assets;
+    if (asset_flash[index] != NULL) {
+        if (!deliver) {
+            return false;
+        }
+        if (asset_device_offset[index] != ASSET_NOT_ON_DEVICE &&
+            send_asset_descriptor(asset, asset_device_offset[index])) {
+            asset->loaded = true;
+            return false;
+        }
+    }
+    
+    // Nothing to do for a prefetch of something already cached or on the device
+    uint32_t cached_size = asset->size;
+    uint8_t* cached = (asset_flash[index] != NULL) ? (uint8_t*)asset_flash[index]
+                                                   : find_asset_in_cache(asset_id, &cached_size);
+    if (!deliver && (cached != NULL || asset->loaded)) {
+        return false;
+    }
+    
+    stream->asset = asset;
+    stream->deliver = deliver;
+    stream->read = 0;
+    stream->sent = 0;
+    stream->pending = 0;
+    stream->from_cache = (cached != NULL && cached_size == asset->size);
+    stream->cache = stream->from_cache ? cached : NULL;
+    mark_asset_delivery(stream);
+    
+    if (!stream->from_cache) {
+        if (!asset_file_open) {
+            printf("Asset file not open\n");
+            return false;
+        }
+        
+        // Prefetches, pinned and unsplittable assets are gathered whole; the
+        // rest passes through the chunk buffer
+        if (!deliver || asset->target == 0 || asset_frame_bytes(asset) == 0 ||
+            asset_pinned[asset - assets]) {
+            stream->cache = reserve_cached_asset(asset_id, asset->size);
+            if (stream->cache == NULL) {
+                printf("Failed to allocate memory for asset: %lu bytes\n", asset->size);
+                return false;
+            }
+        }
+    }
+    
+    stream->active = true;
+    return true;
+}
+
+static void finish_asset_stream(AssetStream* stream, bool ok) {
+    AssetInfo* asset = stream->asset;
+    
+    if (stream->cache != NULL && !stream->from_cache) {
+        if (ok) {
+            mark_asset_cached(asset->id);
+        } else {
+            discard_cached_asset(asset->id);
+        }
+    }
+    
+    if (ok && stream->deliver) {
+        // Whole-asset types go out now that all of it is here
+        if (asset->target != 0 && asset_frame_bytes(asset) == 0) {
+            ok = (asset->target == 1) ? send_asset_to_gpu(asset, stream->cache, asset->size)
+                                      : send_asset_to_apu(asset, stream->cache, asset->size);
+        }
+        
+        // Queued is not delivered: a frame that ran out of retries was lost
+        CommandQueue* queue = asset_target_queue(asset);
+        if (ok && queue != NULL && !wait_sequenced_delivery(queue, stream->seq_failed_mark)) {
+            printf("Asset %lu was not acknowledged by the device\n", asset->id);
+            ok = false;
+        }
+        asset->loaded = ok;
+    }
+    
+    if (!ok) {
+        printf("Asset load failed: %lu\n", asset->id);
+    }
+    
+    stream->active = false;
+}
+
+// One step: read a chunk (or take one from the cache) and forward what it completes
+static void step_asset_stream(AssetStream* stream) {
+    AssetInfo* asset = stream->asset;
+    bool splittable = stream->deliver && asset->target != 0 && asset_frame_bytes(asset) != 0;
+    
+    if (stream->from_cache) {
+        // Already in RAM: pace it at the same chunk rate so frames still interleave
+        uint32_t chunk = MIN(ASSET_CHUNK_SIZE, asset->size - stream->sent);
+        if (splittable) {
+            bool final = (stream->sent + chunk == asset->size);
+            uint32_t used = send_asset_frames(asset, stream->sent, stream->cache + stream->sent, chunk, final);
+            if (used == 0 && chunk > 0) {
+                finish_asset_stream(stream, false);
+                return;
+            }
+            stream->sent += used;
+        } else {
+            stream->sent = asset->size;
+        }
+        
+        if (stream->sent == asset->size) {
+            finish_asset_stream(stream, true);
+        }
+        return;
+    }
+    
+    uint32_t chunk = MIN(ASSET_CHUNK_SIZE, asset->size - stream->read);
+    uint8_t* dst = (stream->cache != NULL) ? stream->cache + stream->read
+                                           : stream->buffer + stream->pending;
+    
+    // The other priority level may have moved the file position
+    UINT br;
+    if (f_lseek(&asset_file, asset->offset + stream->read) != FR_OK ||
+        f_read(&asset_file, dst, chunk, &br) != FR_OK || br != chunk) {
+        printf("Failed to read asset data: %lu bytes\n", asset->size);
+        finish_asset_stream(stream, false);
+        return;
+    }
+    stream->read += chunk;
+    bool final = (stream->read == asset->size);
+    
+    if (splittable) {
+        // Forward the complete frames; a partial unit waits for the next chunk
+        uint8_t* src = (stream->cache != NULL) ? stream->cache + stream->sent : stream->buffer;
+        uint32_t available = (stream->cache != NULL) ? stream->read - stream->sent
+                                                     : stream->pending + chunk;
+        uint32_t used = send_asset_frames(asset, stream->sent, src, available, final);
+        stream->sent += used;
+        
+        // Whole frames left over mean the device queue refused one. Fail the
+        // load rather than let the chunk buffer fill up behind it.
+        if (available - used >= asset_frame_bytes(asset)) {
+            finish_asset_stream(stream, false);
+            return;
+        }
+        
+        if (stream->cache == NULL) {
+            stream->pending = available - used;
+            memmove(stream->buffer, stream->buffer + used, stream->pending);
+        }
+        
+        if (final && stream->sent != asset->size) {
+            finish_asset_stream(stream, false);
+            return;
         }
-    } else {
-        // Button state matches current state, reset counter
-        *counter = 0;
+    }
+    
+    if (final) {
+        finish_asset_stream(stream, true);
     }
 }
 
-// Check if a button was just pressed
-bool button_pressed(bool current, bool previous) {
-    return current && !previous;
+// Called from core 1's loop after the frame queues have been flushed
+bool service_asset_streams() {
+    AssetStream* demand = &asset_streams[ASSET_PRIORITY_DEMAND];
+    AssetStream* prefetch = &asset_streams[ASSET_PRIORITY_PREFETCH];
+    uint32_t asset_id;
+    
+    // A demand for the asset being prefetched takes the prefetch over
+    while (!demand->active && take_asset_request(ASSET_PRIORITY_DEMAND, &asset_id)) {
+        if (prefetch->active && prefetch->asset->id == asset_id) {
+            *demand = *prefetch;
+            demand->deliver = true;
+            mark_asset_delivery(demand);
+            prefetch->active = false;
+            break;
+        }
+        start_asset_stream(demand, asset_id, true);
+    }
+    
+    if (demand->active) {
+        step_asset_stream(demand);
+        return true;
+    }
+    
+    while (!prefetch->active && take_asset_request(ASSET_PRIORITY_PREFETCH, &asset_id)) {
+        start_asset_stream(prefetch, asset_id, false);
+    }
+    
+    if (prefetch->active) {
+        step_asset_stream(prefetch);
+        return true;
+    }
+    
+    return false;
 }
 
-// Check if a button was just released
-bool button_released(bool current, bool previous) {
-    return !current && previous;
+static bool asset_request_pending(uint32_t asset_id) {
+    for (uint32_t i = 0; i < asset_request_count; i++) {
+        if (asset_requests[i].asset_id == asset_id &&
+            asset_requests[i].priority == ASSET_PRIORITY_DEMAND) {
+            return true;
+        }
+    }
+    return false;
 }
 
-// Get directional input as a vector
-void get_direction(int* dx, int* dy) {
-    *dx = 0;
-    *dy = 0;
+// Load an asset and send it to its device. On the core that owns the bus
+// this runs the pipeline until the asset is done (anything queued ahead of
+// it goes first); from the other core it hands the load to core 1.
+bool send_asset_to_device(uint32_t asset_id) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset == NULL) {
+        printf("Asset not found: %lu\n", asset_id);
+        return false;
+    }
     
-    if (current_buttons.left) *dx -= 1;
-    if (current_buttons.right) *dx += 1;
-    if (current_buttons.up) *dy -= 1;
-    if (current_buttons.down) *dy += 1;
+    if (get_core_num() != gpu_queue.consumer_core) {
+        send_message_to_core1(MSG_LOAD_ASSET, asset_id, ASSET_PRIORITY_DEMAND, NULL);
+        return true;
+    }
+    
+    asset->loaded = false;
+    request_asset_load(asset_id, ASSET_PRIORITY_DEMAND);
+    
+    AssetStream* demand = &asset_streams[ASSET_PRIORITY_DEMAND];
+    while (asset_request_pending(asset_id) || (demand->active && demand->asset == asset)) {
+        if (!service_asset_streams()) {
+            break;
+        }
+        process_gpu_queue();
+        process_apu_queue();
+    }
+    
+    return asset->loaded;
 }
 
-// Inter-Core Communication
-// Message types for inter-core communication
-typedef enum {
-    MSG_LOAD_ASSET,
-    MSG_PROCESS_GPU_QUEUE,
-    MSG_PROCESS_APU_QUEUE,
-    MSG_GAME_EVENT
-} MessageType;
+// Ask core 1 to start loading assets ahead of need, e.g. the next level
+// section. They land in the CPU cache and go to the device on first use.
+void prefetch_assets(uint32_t first_id, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        AssetInfo* asset = find_asset(first_id + i);
+        if (asset != NULL && !asset->loaded) {
+            send_message_to_core1(MSG_LOAD_ASSET, first_id + i, ASSET_PRIORITY_PREFETCH, NULL);
+        }
+    }
+}
 
-// Message structure
-typedef struct {
-    MessageType type;
-    uint32_t param1;
-    uint32_t param2;
-    void* data;
-} CoreMessage;
+// CPU-sourced sample streams
+// A sample streamed from the asset file stays on SD. The APU asks for each
+// stretch of it with STATUS_STREAM_REQUEST (0xE2) [channelId] [sampleId]
+// [sourceOffset:4] [bytes:2] and gets SAMPLE_STREAM_DATA (0x7D) back. Requests
+// are answered by the response poller on core 1, so SD reads stay on the core
+// that runs the asset pipeline. Each request is answered in full: the APU only
+// asks again once everything it asked for has arrived (or after a timeout).
+#define STREAM_SAMPLE_SLOTS 64       // APU sample slots
+#define STREAM_DATA_PAYLOAD 240      // Sample bytes per SAMPLE_STREAM_DATA
 
-// Inter-core queues
-queue_t core0_to_core1_queue;
-queue_t core1_to_core0_queue;
+typedef struct {
+    bool defined;
+    uint32_t asset_id;
+} StreamSampleSource;
 
-// Initialize inter-core communication
-void init_inter_core_communication() {
-    queue_init(&core0_to_core1_queue, sizeof(CoreMessage), 8);
-    queue_init(&core1_to_core0_queue, sizeof(CoreMessage), 8);
-}
+StreamSampleSource stream_sample_sources[STREAM_SAMPLE_SLOTS];
+uint8_t stream_read_buffer[ASSET_CHUNK_SIZE];
 
-// Send a message from Core 0 to Core 1
-void send_message_to_core1(MessageType type, uint32_t param1, uint32_t param2, void* data) {
-    CoreMessage msg = {
-        .type = type,
-        .param1 = param1,
-        .param2 = param2,
-        .data = data
-    };
+// Define an APU sample that streams from an asset instead of being loaded.
+// Format bits as SAMPLE_LOAD: bit 0 = 16-bit, bit 1 = stereo. Loop points are
+// in frames, loop_end 0 for none.
+bool stream_sample_from_asset(uint8_t sample_id, uint32_t asset_id, uint8_t format, uint16_t sample_rate,
+                              uint32_t loop_start, uint32_t loop_end) {
+    AssetInfo* asset = find_asset(asset_id);
+    if (asset == NULL || sample_id >= STREAM_SAMPLE_SLOTS) {
+        printf("Cannot stream asset %lu as sample %d\n", asset_id, sample_id);
+        return false;
+    }
     
-    queue_add_blocking(&core0_to_core1_queue, &msg);
+    stream_sample_sources[sample_id].asset_id = asset_id;
+    __dmb();
+    stream_sample_sources[sample_id].defined = true;
+    
+    uint32_t frame_bytes = ((format & 1) ? 2 : 1) * ((format & 2) ? 2 : 1);
+    uint32_t frames = asset->size / frame_bytes;
+    uint32_t offset = 0;
+    
+    uint8_t cmd[21];
+    cmd[0] = sample_id;
+    cmd[1] = format;
+    cmd[2] = sample_rate & 0xFF;
+    cmd[3] = sample_rate >> 8;
+    cmd[4] = 1; // Source: CPU
+    memcpy(&cmd[5], &offset, 4);
+    memcpy(&cmd[9], &frames, 4);
+    memcpy(&cmd[13], &loop_start, 4);
+    memcpy(&cmd[17], &loop_end, 4);
+    return queue_apu_command(0x7C, 21 + 2, cmd); // SAMPLE_STREAM_DEFINE
 }
 
-// Send a message from Core 1 to Core 0
-void send_message_to_core0(MessageType type, uint32_t param1, uint32_t param2, void* data) {
-    CoreMessage msg = {
-        .type = type,
-        .param1 = param1,
-        .param2 = param2,
-        .data = data
-    };
+// Answer a STATUS_STREAM_REQUEST from the APU
+void answer_stream_request(const uint8_t* packet, uint8_t length) {
+    if (length < 10) {
+        return;
+    }
     
-    queue_add_blocking(&core1_to_core0_queue, &msg);
+    uint8_t channel_id = packet[2];
+    uint8_t sample_id = packet[3];
+    uint32_t source_offset = packet[4] | (packet[5] << 8) | (packet[6] << 16) | ((uint32_t)packet[7] << 24);
+    uint32_t bytes = packet[8] | (packet[9] << 8);
+    
+    if (sample_id >= STREAM_SAMPLE_SLOTS || !stream_sample_sources[sample_id].defined) {
+        return;
+    }
+    
+    AssetInfo* asset = find_asset(stream_sample_sources[sample_id].asset_id);
+    if (asset == NULL || source_offset >= asset->size) {
+        return;
+    }
+    bytes = MIN(bytes, asset->size - source_offset);
+    
+    const uint8_t* flash = asset_flash[asset - assets];
+    uint8_t cmd[5 + STREAM_DATA_PAYLOAD];
+    cmd[0] = channel_id;
+    
+    while (bytes > 0) {
+        // One SD sector at a time, split into commands on the way out
+        uint32_t chunk = MIN(bytes, ASSET_CHUNK_SIZE);
+        const uint8_t* src = (flash != NULL) ? flash + source_offset : stream_read_buffer;
+        
+        if (flash == NULL) {
+            UINT br;
+            if (!asset_file_open ||
+                f_lseek(&asset_file, asset->offset + source_offset) != FR_OK ||
+                f_read(&asset_file, stream_read_buffer, chunk, &br) != FR_OK || br != chunk) {
+                printf("Failed to read stream data for sample %d\n", sample_id);
+                return;
+            }
+        }
+        
+        for (uint32_t done = 0; done < chunk; ) {
+            uint32_t piece = MIN(chunk - done, STREAM_DATA_PAYLOAD);
+            uint32_t offset = source_offset + done;
+            memcpy(&cmd[1], &offset, 4);
+            memcpy(&cmd[5], src + done, piece);
+            
+            // Not acknowledged; a lost piece is asked for again
+            if (!queue_apu_command(0x7D, 5 + piece + 2, cmd)) { // SAMPLE_STREAM_DATA
+                return;
+            }
+            done += piece;
+        }
+        
+        source_offset += chunk;
+        bytes -= chunk;
+    }
 }
 
 // Core 1 main function - handles system management
 void core1_main() {
     printf("CPU Core 1 started - System Management\n");
+
+    // From here on core 1 is the only consumer of the command rings
+    claim_command_queues();
     
     CoreMessage msg;
-    bool vsync_pending = false;
     
     while (true) {
         // Check for messages from Core 0
@@ -1443,10 +3365,8 @@ void core1_main() {
             // Process message
             switch (msg.type) {
                 case MSG_LOAD_ASSET:
-                    {
-                        uint32_t asset_id = msg.param1;
-                        send_asset_to_device(asset_id);
-                    }
+                    // param2 is the priority; the pipeline below does the work
+                    request_asset_load(msg.param1, msg.param2);
                     break;
                     
                 case MSG_PROCESS_GPU_QUEUE:
@@ -1464,27 +3384,28 @@ void core1_main() {
             }
         }
         
-        // Process GPU and APU queues regularly
-        if (gpu_queue.count > 0) {
+        // Stream out whatever core 0 has published since the last pass
+        if (gpu_queue.head != gpu_queue.tail) {
             process_gpu_queue();
         }
         
-        if (apu_queue.count > 0) {
+        if (apu_queue.head != apu_queue.tail) {
             process_apu_queue();
         }
         
-        // Check for VSYNC signal from GPU
-        if (!gpio_get(VSYNC_PIN) && !vsync_pending) {
-            vsync_pending = true;
-            
-            // Notify Core 0
-            send_message_to_core0(MSG_GAME_EVENT, EVENT_VSYNC, 0, NULL);
-        } else if (gpio_get(VSYNC_PIN)) {
-            vsync_pending = false;
-        }
+        // Responses from GPU/APU; ACKs free sequenced slots, overdue ones go again
+        check_for_device_responses();
+        service_sequenced_commands(&gpu_queue);
+        service_sequenced_commands(&apu_queue);
+        
+        // One chunk of asset loading between queue flushes
+        // (VSYNC is latched by an IRQ on core 0, see the frame scheduler)
+        bool streaming = service_asset_streams();
         
-        // Yield to save power
-        sleep_us(100);
+        // Yield to save power, unless a load is in flight
+        if (!streaming) {
+            sleep_us(100);
+        }
     }
 }
 
@@ -1549,11 +3470,14 @@ bool load_game(const char* filename) {
     game_state.game_id = header.game_id;
     strncpy(game_state.title, header.title, sizeof(game_state.title));
     
-    // Load asset registry
-    load_asset_registry(header.asset_registry);
-    
-    // Open asset file
-    open_asset_file(header.asset_file);
+    // Assets come from the cartridge when it carries this game, else from SD
+    if (!mount_asset_pack(header.game_id)) {
+        // Load asset registry
+        load_asset_registry(header.asset_registry);
+        
+        // Open asset file
+        open_asset_file(header.asset_file);
+    }
     
     // Load game code
     if (header.code_size > 0) {
@@ -1565,9 +3489,11 @@ bool load_game(const char* filename) {
     // Close file
     f_close(&f);
     
-    // Load essential assets (first N assets marked as required)
+    // Load essential assets (first N assets marked as required) and keep
+    // them cached so a device reset can restore them without the SD card
     for (uint32_t i = 0; i < asset_count && i < 20; i++) {
         if (assets[i].id < 100) { // Assuming IDs < 100 are essential
+            pin_asset(assets[i].id, true);
             send_asset_to_device(assets[i].id);
         }
     }
@@ -1588,6 +3514,9 @@ void init_gpu() {
     // Reset GPU
     uint8_t reset_cmd[1] = {0};
     queue_gpu_command(0x01, 2, reset_cmd); // RESET_GPU
+
+    // Sprites and layers are resent in full with the next frame
+    invalidate_shadow_oam();
     
     // Set display mode (320x240x8bpp)
     uint8_t display_cmd[5] = {
@@ -1649,12 +3578,7 @@ void update_game() {
     if (player_y > 232) player_y = 232;
     
     // Update sprite position
-    uint8_t move_cmd[5] = {
-        0,                           // Sprite ID
-        (player_x >> 8) & 0xFF, player_x & 0xFF,  // X position
-        (player_y >> 8) & 0xFF, player_y & 0xFF   // Y position
-    };
-    queue_gpu_command(0x42, 6, move_cmd); // MOVE_SPRITE
+    move_sprite(0, player_x, player_y);
     
     // Check for A button press
     if (button_pressed(current_buttons.a, previous_buttons.a)) {
@@ -1679,17 +3603,9 @@ void update_game() {
 
 // Main game loop with enhanced synchronization
 void run_enhanced_game_loop() {
-    // Game loop variables
-    uint32_t frame_start_time;
-    uint32_t frame_time;
-    const uint32_t TARGET_FRAME_TIME = 16667; // 60fps in microseconds
-
     while (true) {
-        // Start frame timing
-        frame_start_time = time_us_32();
-
-        // Check for responses from GPU/APU
-        check_for_device_responses();
+        // Start the frame on the GPU's VSYNC
+        wait_for_frame_start();
 
         // Update frame counter and sync
         update_frame_timing();
@@ -1709,31 +3625,24 @@ void run_enhanced_game_loop() {
 
         // Update game state only if devices are healthy
         if (!in_system_recovery) {
+            trace_begin(ZONE_CPU_GAME_UPDATE, 0);
             process_input();
             update_game_state();
             prepare_rendering();
+            sync_shadow_oam();
+            trace_end(ZONE_CPU_GAME_UPDATE, 0);
         } else {
             // In recovery mode - display error screen
             display_system_error();
         }
 
+        // The frame is complete; the GPU renders it once it has all of it
+        commit_frame();
+
         // Process command queues regardless of game state
         // (allows recovery commands to be sent)
         process_enhanced_queue(&gpu_queue);
         process_enhanced_queue(&apu_queue);
-
-        // Calculate frame time
-        frame_time = time_us_32() - frame_start_time;
-
-        // Sleep to maintain target frame rate
-        if (frame_time < TARGET_FRAME_TIME) {
-            sleep_us(TARGET_FRAME_TIME - frame_time);
-        } else if (frame_time > TARGET_FRAME_TIME + 5000) {
-            // Frame took too long (>5ms over budget)
-            if (debug_enabled) {
-                printf("Frame time: %lu us (over budget)\n", frame_time);
-            }
-        }
     }
 }
 
@@ -1775,70 +3684,48 @@ void handle_device_failure(uint8_t device_id) {
 // Main Game Loop
 void run_game_loop() {
     // Main game loop runs on Core 0
-    
-    // Initialize game timer
-    uint32_t frame_start_time = time_us_32();
-    uint32_t target_frame_time = 16667; // ~60fps (microseconds)
-    
-    // Wait for VSYNC
-    bool vsync_received = false;
-    
     while (game_state.game_active) {
-        // Start frame timing
-        frame_start_time = time_us_32();
+        // Start the frame on the GPU's VSYNC
+        wait_for_frame_start();
         
         // Process any messages from Core 1
         CoreMessage msg;
         while (queue_try_remove(&core1_to_core0_queue, &msg)) {
-            if (msg.type == MSG_GAME_EVENT && msg.param1 == EVENT_VSYNC) {
-                vsync_received = true;
+            if (msg.type == MSG_GAME_EVENT) {
+                handle_game_event(msg.param1, msg.param2, msg.data);
             }
         }
         
+        // Update frame counter and sync
+        update_frame_timing();
+        
+        // Collect this frame's commands into one batch per device
+        begin_command_batch(&gpu_queue);
+        begin_command_batch(&apu_queue);
+        
         // Process game logic
+        trace_begin(ZONE_CPU_GAME_UPDATE, 0);
         update_game();
         
         // Prepare rendering for next frame
         prepare_rendering();
+        sync_shadow_oam();
+        trace_end(ZONE_CPU_GAME_UPDATE, 0);
+        commit_frame();
+        end_command_batch(&gpu_queue);
         
         // Send message to Core 1 to process GPU commands
         send_message_to_core1(MSG_PROCESS_GPU_QUEUE, 0, 0, NULL);
         
         // Prepare audio commands
         prepare_audio();
+        end_command_batch(&apu_queue);
         
         // Send message to Core 1 to process APU commands
         send_message_to_core1(MSG_PROCESS_APU_QUEUE, 0, 0, NULL);
         
         // Check if we need to load any new assets
         check_asset_requirements();
-        
-        // Calculate frame time
-        uint32_t frame_end_time = time_us_32();
-        uint32_t frame_duration = frame_end_time - frame_start_time;
-        
-        // Wait for VSYNC if needed
-        if (!vsync_received) {
-            // Wait until we get VSYNC or timeout
-            uint32_t wait_start = time_us_32();
-            while (!vsync_received && time_us_32() - wait_start < 20000) {
-                // Check for VSYNC message
-                if (queue_try_remove(&core1_to_core0_queue, &msg)) {
-                    if (msg.type == MSG_GAME_EVENT && msg.param1 == EVENT_VSYNC) {
-                        vsync_received = true;
-                    }
-                }
-                sleep_us(100);
-            }
-        }
-        
-        // Reset VSYNC flag
-        vsync_received = false;
-        
-        // Sleep if we have time left to maintain target frame rate
-        if (frame_duration < target_frame_time) {
-            sleep_us(target_frame_time - frame_duration);
-        }
     }
 }
 
@@ -1851,15 +3738,10 @@ void prepare_rendering() {
     static uint16_t scroll_x = 0;
     
     // Scroll the background layer
-    uint8_t scroll_cmd[5] = {
-        0,                        // Layer ID
-        (scroll_x >> 8) & 0xFF, scroll_x & 0xFF,  // X scroll
-        0, 0                      // Y scroll
-    };
-    queue_gpu_command(0x23, 6, scroll_cmd); // SCROLL_LAYER
+    scroll_background(0, scroll_x, 0);
     
     // Update scroll position for next frame
-    scroll_x = (scroll_x + 1) % 1024;
+    scroll_x = (scroll_x + frame_animation_step()) % 1024;
 }
 
 // Prepare audio commands for APU
@@ -1903,10 +3785,13 @@ void check_asset_requirements() {
             AssetInfo* asset = find_asset(asset_id);
             if (asset != NULL && !asset->loaded) {
                 // Queue the asset for loading
-                send_message_to_core1(MSG_LOAD_ASSET, asset_id, 0, NULL);
+                send_message_to_core1(MSG_LOAD_ASSET, asset_id, ASSET_PRIORITY_DEMAND, NULL);
             }
         }
         
+        // Start pulling in the next level while this one plays
+        prefetch_assets(level_start_id + 10, 10);
+        
         last_level = game_state.level;
     }
 }
@@ -1918,7 +3803,10 @@ void boot_sequence() {
     init_hardware();
     
     // Initialize subsystems
-    init_command_queues();
+    if (!init_command_queues()) {
+        // Nothing can reach the GPU or APU without the rings
+        return;
+    }
     init_asset_system();
     init_input();
     init_inter_core_communication();
@@ -1984,6 +3872,9 @@ void initialize_gpu() {
     // Reset GPU
     uint8_t reset_cmd[1] = {0};
     queue_gpu_command(0x01, 2, reset_cmd); // RESET_GPU
+
+    // Sprites and layers are resent in full with the next frame
+    invalidate_shadow_oam();
     
     // Set display mode (320x240x8bpp)
     uint8_t display_cmd[5] = {
@@ -1993,6 +3884,10 @@ void initialize_gpu() {
     };
     queue_gpu_command(0x02, 7, display_cmd); // SET_DISPLAY_MODE
     
+    // Enable VSYNC notification, the frame scheduler runs on it
+    uint8_t vsync_cmd[1] = {1};
+    queue_gpu_command(0x03, 3, vsync_cmd); // SET_VBLANK_CALLBACK
+    
     // Process commands
     process_gpu_queue();
 }
@@ -2060,20 +3955,8 @@ void load_boot_assets() {
         fr = f_read(&f, music_data, size, &br);
         
         if (fr == FR_OK && br == size) {
-            // Send music to APU
-            uint8_t header[3] = {
-                0,    // Tracker ID
-                size & 0xFF,
-                (size >> 8) & 0xFF
-            };
-            
-            uint8_t* cmd_data = malloc(size + 3);
-            memcpy(cmd_data, header, 3);
-            memcpy(cmd_data + 3, music_data, size);
-            
-            queue_apu_command(0x10, 3 + 2, cmd_data); // TRACKER_LOAD
-            
-            free(cmd_data);
+            // Send music to APU as tracker 0
+            load_tracker_song(0, music_data, size);
         }
         
         free(music_data);
@@ -2155,30 +4038,201 @@ int main() {
 }
 
 // High-Level Game Development APIs
+// Shadow OAM
+// set_sprite(), move_sprite(), hide_sprite() and scroll_background() only update
+// these shadow registers. At the end of the frame sync_shadow_oam() compares them
+// with what the GPU was last sent and queues one BATCH_SPRITE_UPDATE carrying only
+// the changed fields of the changed sprites, so idle sprites cost nothing.
+#define OAM_X          0x01
+#define OAM_Y          0x02
+#define OAM_PATTERN    0x04
+#define OAM_ATTRIBUTES 0x08
+#define OAM_PALETTE    0x10
+#define OAM_SCALE      0x20
+#define OAM_VISIBLE    0x40
+#define OAM_ALL        0x7F
+
+#define OAM_BATCH_MAX_PAYLOAD 250    // Room left under the 255-byte command length
+#define OAM_BATCH_HEADER 5           // [first sprite][changed mask:4]
+#define OAM_BATCH_LAYER_BYTES (1 + MAX_LAYERS * 4)
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    uint8_t pattern_id;
+    uint8_t attributes;
+    uint8_t palette_offset;
+    uint8_t scale;
+    bool visible;
+} ShadowSprite;
+
+typedef struct {
+    int16_t scroll_x;
+    int16_t scroll_y;
+} ShadowLayer;
+
+ShadowSprite shadow_sprites[MAX_SPRITES];
+ShadowSprite sent_sprites[MAX_SPRITES];
+ShadowLayer shadow_layers[MAX_LAYERS];
+ShadowLayer sent_layers[MAX_LAYERS];
+bool shadow_oam_valid = false;   // false: the GPU state is unknown, send everything
+
+// Forget what the GPU holds, e.g. after it was reset
+void invalidate_shadow_oam() {
+    shadow_oam_valid = false;
+}
+
+// Fields of a sprite that differ from what was sent
+uint8_t shadow_sprite_changes(uint8_t sprite_id) {
+    const ShadowSprite* now = &shadow_sprites[sprite_id];
+    const ShadowSprite* sent = &sent_sprites[sprite_id];
+
+    if (!shadow_oam_valid) return OAM_ALL;
+
+    uint8_t fields = 0;
+    if (now->visible != sent->visible) fields |= OAM_VISIBLE;
+
+    // Nothing else matters while the sprite stays hidden
+    if (!now->visible) return fields;
+
+    if (now->x != sent->x) fields |= OAM_X;
+    if (now->y != sent->y) fields |= OAM_Y;
+    if (now->pattern_id != sent->pattern_id) fields |= OAM_PATTERN;
+    if (now->attributes != sent->attributes) fields |= OAM_ATTRIBUTES;
+    if (now->palette_offset != sent->palette_offset) fields |= OAM_PALETTE;
+    if (now->scale != sent->scale) fields |= OAM_SCALE;
+    return fields;
+}
+
+// Bytes a sprite record takes for the given fields, including the field mask
+uint8_t shadow_record_size(uint8_t fields) {
+    uint8_t size = 1;
+    if (fields & OAM_X) size += 2;
+    if (fields & OAM_Y) size += 2;
+    if (fields & OAM_PATTERN) size++;
+    if (fields & OAM_ATTRIBUTES) size++;
+    if (fields & OAM_PALETTE) size++;
+    if (fields & OAM_SCALE) size++;
+    if (fields & OAM_VISIBLE) size++;
+    return size;
+}
+
+// Queue one BATCH_SPRITE_UPDATE packet: [first sprite][changed mask:4][records][layer mask][layer values]
+void queue_sprite_batch(uint8_t* packet, uint8_t size) {
+    queue_gpu_command(0x4B, size + 2, packet); // BATCH_SPRITE_UPDATE
+}
+
+// Send everything that changed since the last frame
+void sync_shadow_oam() {
+    uint8_t packet[OAM_BATCH_MAX_PAYLOAD];
+    uint8_t pos = OAM_BATCH_HEADER;
+    uint32_t mask = 0;
+    uint8_t first = 0;
+    bool any = false;
+
+    for (int i = 0; i < MAX_SPRITES; i++) {
+        uint8_t fields = shadow_sprite_changes(i);
+        if (fields == 0) continue;
+
+        uint8_t record = shadow_record_size(fields);
+
+        // Start a new packet when the record doesn't fit or is out of mask range
+        // (room is kept for the layer mask and values)
+        if (mask != 0 && (pos + record + OAM_BATCH_LAYER_BYTES > OAM_BATCH_MAX_PAYLOAD || i - first >= 32)) {
+            packet[0] = first;
+            packet[1] = mask >> 24;
+            packet[2] = mask >> 16;
+            packet[3] = mask >> 8;
+            packet[4] = mask;
+            packet[pos++] = 0; // No layers in this packet
+            queue_sprite_batch(packet, pos);
+            pos = OAM_BATCH_HEADER;
+            mask = 0;
+        }
+
+        if (mask == 0) first = i;
+        mask |= 1u << (i - first);
+        any = true;
+
+        const ShadowSprite* sprite = &shadow_sprites[i];
+        packet[pos++] = fields;
+        if (fields & OAM_X) {
+            packet[pos++] = (sprite->x >> 8) & 0xFF;
+            packet[pos++] = sprite->x & 0xFF;
+        }
+        if (fields & OAM_Y) {
+            packet[pos++] = (sprite->y >> 8) & 0xFF;
+            packet[pos++] = sprite->y & 0xFF;
+        }
+        if (fields & OAM_PATTERN) packet[pos++] = sprite->pattern_id;
+        if (fields & OAM_ATTRIBUTES) packet[pos++] = sprite->attributes;
+        if (fields & OAM_PALETTE) packet[pos++] = sprite->palette_offset;
+        if (fields & OAM_SCALE) packet[pos++] = sprite->scale;
+        if (fields & OAM_VISIBLE) packet[pos++] = sprite->visible;
+
+        sent_sprites[i] = *sprite;
+    }
+
+    // Layers: bit n = layer n scroll X changed, bit n+4 = scroll Y, values follow in order
+    uint8_t layer_mask = 0;
+    for (int l = 0; l < MAX_LAYERS; l++) {
+        if (!shadow_oam_valid || shadow_layers[l].scroll_x != sent_layers[l].scroll_x) layer_mask |= 1 << l;
+        if (!shadow_oam_valid || shadow_layers[l].scroll_y != sent_layers[l].scroll_y) layer_mask |= 0x10 << l;
+    }
+
+    shadow_oam_valid = true;
+
+    if (!any && layer_mask == 0) return;
+
+    packet[0] = first;
+    packet[1] = mask >> 24;
+    packet[2] = mask >> 16;
+    packet[3] = mask >> 8;
+    packet[4] = mask;
+    packet[pos++] = layer_mask;
+
+    for (int l = 0; l < MAX_LAYERS; l++) {
+        if (layer_mask & (1 << l)) {
+            packet[pos++] = (shadow_layers[l].scroll_x >> 8) & 0xFF;
+            packet[pos++] = shadow_layers[l].scroll_x & 0xFF;
+        }
+        if (layer_mask & (0x10 << l)) {
+            packet[pos++] = (shadow_layers[l].scroll_y >> 8) & 0xFF;
+            packet[pos++] = shadow_layers[l].scroll_y & 0xFF;
+        }
+        sent_layers[l] = shadow_layers[l];
+    }
+
+    queue_sprite_batch(packet, pos);
+}
+
 // Sprite management
 void set_sprite(uint8_t sprite_id, uint8_t pattern_id, int16_t x, int16_t y, uint8_t attributes) {
-    uint8_t data[9] = {
-        sprite_id,
-        pattern_id,
-        (x >> 8) & 0xFF, x & 0xFF,
-        (y >> 8) & 0xFF, y & 0xFF,
-        attributes,
-        0,    // Default palette offset
-        128   // Default scale (1.0)
-    };
-    
-    queue_gpu_command(0x41, 10, data); // DEFINE_SPRITE
+    if (sprite_id >= MAX_SPRITES) return;
+
+    ShadowSprite* sprite = &shadow_sprites[sprite_id];
+    sprite->pattern_id = pattern_id;
+    sprite->x = x;
+    sprite->y = y;
+    sprite->attributes = attributes;
+    sprite->palette_offset = 0;   // Default palette offset
+    sprite->scale = 128;          // Default scale (1.0)
+    sprite->visible = true;
 }
 
 // Move sprite
 void move_sprite(uint8_t sprite_id, int16_t x, int16_t y) {
-    uint8_t data[5] = {
-        sprite_id,
-        (x >> 8) & 0xFF, x & 0xFF,
-        (y >> 8) & 0xFF, y & 0xFF
-    };
-    
-    queue_gpu_command(0x42, 6, data); // MOVE_SPRITE
+    if (sprite_id >= MAX_SPRITES) return;
+
+    shadow_sprites[sprite_id].x = x;
+    shadow_sprites[sprite_id].y = y;
+}
+
+// Hide sprite
+void hide_sprite(uint8_t sprite_id) {
+    if (sprite_id >= MAX_SPRITES) return;
+
+    shadow_sprites[sprite_id].visible = false;
 }
 
 // Animate sprite
@@ -2196,13 +4250,10 @@ void animate_sprite(uint8_t sprite_id, uint8_t start_frame, uint8_t end_frame, u
 
 // Background scrolling
 void scroll_background(uint8_t layer_id, int16_t x, int16_t y) {
-    uint8_t data[5] = {
-        layer_id,
-        (x >> 8) & 0xFF, x & 0xFF,
-        (y >> 8) & 0xFF, y & 0xFF
-    };
-    
-    queue_gpu_command(0x23, 6, data); // SCROLL_LAYER
+    if (layer_id >= MAX_LAYERS) return;
+
+    shadow_layers[layer_id].scroll_x = x;
+    shadow_layers[layer_id].scroll_y = y;
 }
 
 // Audio control
@@ -2285,36 +4336,6 @@ bool check_if_rp2350() {
     return is_rp2350;
 }
 
-// Enhanced asset management for RP2350
-void init_enhanced_asset_management() {
-    if (!check_if_rp2350()) return;
-    
-    // Increase asset cache size
-    #define ENHANCED_MAX_CACHED_ASSETS 64
-    
-    // Reallocate asset cache with larger size
-    AssetCacheEntry* new_cache = malloc(sizeof(AssetCacheEntry) * ENHANCED_MAX_CACHED_ASSETS);
-    
-    if (new_cache != NULL) {
-        // Copy existing cache entries
-        memcpy(new_cache, asset_cache, sizeof(AssetCacheEntry) * asset_cache_count);
-        
-        // Initialize new entries
-        for (int i = asset_cache_count; i < ENHANCED_MAX_CACHED_ASSETS; i++) {
-            new_cache[i].asset_id = 0;
-            new_cache[i].data = NULL;
-            new_cache[i].size = 0;
-            new_cache[i].last_used = 0;
-        }
-        
-        // Replace old cache
-        free(asset_cache);
-        asset_cache = new_cache;
-        
-        printf("Enhanced asset cache initialized: %d entries\n", ENHANCED_MAX_CACHED_ASSETS);
-    }
-}
-
 // Advanced parallax background for RP2350
 void setup_advanced_parallax(uint8_t num_layers) {
     if (!check_if_rp2350()) return;
@@ -2576,6 +4597,7 @@ void send_gpu_reset_command() {
     gpio_put(GPU_CS_PIN, 0);
     spi_write_blocking(GPU_SPI_PORT, cmd_data, 2);
     gpio_put(GPU_CS_PIN, 1);
+    reset_sequenced_commands(&gpu_queue);
 
     // Wait for GPU to reset (give it some time)
     sleep_ms(50);
@@ -2592,6 +4614,7 @@ void send_apu_reset_command() {
     gpio_put(APU_CS_PIN, 0);
     spi_write_blocking(APU_SPI_PORT, cmd_data, 2);
     gpio_put(APU_CS_PIN, 1);
+    reset_sequenced_commands(&apu_queue);
 
     // Wait for APU to reset (give it some time)
     sleep_ms(50);
@@ -2739,6 +4762,9 @@ void initialize_gpu() {
     uint8_t reset_cmd[1] = {0};
     queue_gpu_command(0x01, 2, reset_cmd); // RESET_GPU
 
+    // Sprites and layers are resent in full with the next frame
+    invalidate_shadow_oam();
+
     // Set display mode (320x240x8bpp)
     uint8_t display_cmd[5] = {
         (320 >> 8) & 0xFF, 320 & 0xFF,  // Width
@@ -2890,8 +4916,7 @@ void handle_game_event(uint32_t event_id, uint32_t param, void* data) {
     // Handle game-specific events
     switch (event_id) {
         case EVENT_VSYNC:
-            // VSYNC occurred, update frame timing
-            update_frame_timing();
+            // Frame timing is driven by the frame scheduler's VSYNC IRQ
             break;
 
         case EVENT_ASSET_LOADED:
@@ -3045,56 +5070,12 @@ void close_file(FILE* file) {
 }
 
 void process_enhanced_queue(CommandQueue* queue) {
-    // Process commands from queue with enhanced error handling
-    const int MAX_BATCH = 10; // Process up to 10 commands at once
-    int processed = 0;
-
-    while (processed < MAX_BATCH) {
-        mutex_enter_blocking(&queue->lock);
+    // Resend overdue sequenced commands first so they go out with the rest
+    service_sequenced_commands(queue);
 
-        // Check if queue is empty
-        if (queue->count == 0) {
-            mutex_exit(&queue->lock);
-            break;
-        }
-
-        // Get command from queue
-        Command* cmd = &queue->commands[queue->head];
-
-        // Prepare buffer for SPI transfer
-        uint8_t buffer[258]; // Maximum command size
-        buffer[0] = cmd->command_id;
-        buffer[1] = cmd->length;
-
-        if (cmd->length > 2) {
-            memcpy(&buffer[2], cmd->data, cmd->length - 2);
-        }
-
-        // Update queue pointers
-        queue->head = (queue->head + 1) % queue->capacity;
-        queue->count--;
-
-        // Release lock before SPI communication
-        mutex_exit(&queue->lock);
-
-        // Determine target device
-        if (queue == &gpu_queue) {
-            // Send command to GPU
-            gpio_put(GPU_CS_PIN, 0); // Select GPU
-            spi_write_blocking(GPU_SPI_PORT, buffer, cmd->length);
-            gpio_put(GPU_CS_PIN, 1); // Deselect GPU
-        } else {
-            // Send command to APU
-            gpio_put(APU_CS_PIN, 0); // Select APU
-            spi_write_blocking(APU_SPI_PORT, buffer, cmd->length);
-            gpio_put(APU_CS_PIN, 1); // Deselect APU
-        }
-
-        processed++;
-
-        // Brief delay between commands
-        sleep_us(10);
-    }
+    // Everything published so far goes out in one CS assertion; when called on
+    // core 0 after core 1 owns the rings this waits for core 1 to drain it
+    flush_command_queue(queue);
 }
 
 
@@ -3107,15 +5088,10 @@ void prepare_rendering() {
     static uint16_t scroll_x = 0;
 
     // Scroll the background layer
-    uint8_t scroll_cmd[5] = {
-        0,                        // Layer ID
-        (scroll_x >> 8) & 0xFF, scroll_x & 0xFF,  // X scroll
-        0, 0                      // Y scroll
-    };
-    queue_gpu_command(0x23, 6, scroll_cmd); // SCROLL_LAYER
+    scroll_background(0, scroll_x, 0);
 
     // Update scroll position for next frame
-    scroll_x = (scroll_x + 1) % 1024;
+    scroll_x = (scroll_x + frame_animation_step()) % 1024;
 }
 
 void prepare_audio() {
@@ -3178,12 +5154,7 @@ void update_game_state() {
     if (player_y > 232) player_y = 232;
 
     // Update sprite position
-    uint8_t move_cmd[5] = {
-        0,                           // Sprite ID
-        (player_x >> 8) & 0xFF, player_x & 0xFF,  // X position
-        (player_y >> 8) & 0xFF, player_y & 0xFF   // Y position
-    };
-    queue_gpu_command(0x42, 6, move_cmd); // MOVE_SPRITE
+    move_sprite(0, player_x, player_y);
 
     // Check for A button press
     if (button_pressed(current_buttons.a, previous_buttons.a)) {
@@ -65,8 +65,15 @@ Graphics pipeline:
 #define MAX_CACHED_TILES 256
 #define MAX_LAYERS 4
 #define MAX_DIRTY_REGIONS 16
+#define PRESENT_MAX_BUFFERS 3    // Whole frames the framebuffer arena is split into at most
+#define PRESENT_QUEUE_SIZE 4     // Composed parts waiting for or in scan-out
+#define MAX_DISPLAY_WIDTH 320
+#define MAX_DISPLAY_HEIGHT 320
+#define LINE_GROUP_HEIGHT 8      // Scanlines composed together by the line renderer
+#define MAX_SPRITES_PER_GROUP 32 // Sprites binned to one line group
 #define SPI_FREQUENCY 8000000
 #define FRAME_INTERVAL_US 16667  // 60fps
+#define FRAME_COMMIT_TIMEOUT_US 100000 // No FRAME_COMMIT for this long: render on the timer again
 
 // SPI configuration
 #define SPI_PORT spi0
@@ -94,29 +101,51 @@ enum {
     CMD_SET_DISPLAY_MODE = 0x02,
     CMD_SET_VBLANK_CALLBACK = 0x03,
     CMD_VSYNC_WAIT = 0x04,
+    CMD_GET_STATUS = 0x05,
+    CMD_FRAME_COMMIT = 0x0A,
     CMD_SET_PALETTE_ENTRY = 0x10,
     CMD_LOAD_PALETTE = 0x11,
+    CMD_CYCLE_PALETTE = 0x14,
     CMD_CONFIGURE_LAYER = 0x20,
     CMD_LOAD_TILESET = 0x21,
     CMD_LOAD_TILEMAP = 0x22,
     CMD_SCROLL_LAYER = 0x23,
     CMD_SET_HSCROLL_TABLE = 0x24,
+    CMD_MAP_TILESET = 0x2C,
+    CMD_SET_LAYER_BLIT = 0x2D,
     CMD_LOAD_SPRITE_PATTERN = 0x40,
     CMD_DEFINE_SPRITE = 0x41,
     CMD_MOVE_SPRITE = 0x42,
     CMD_ANIMATE_SPRITE = 0x46,
+    CMD_GET_SPRITE_COLLISION = 0x4A,
+    CMD_BATCH_SPRITE_UPDATE = 0x4B,
+    CMD_MAP_SPRITE_PATTERN = 0x4D,
     CMD_SET_FADE = 0x60,
     CMD_MOSAIC_EFFECT = 0x61,
     CMD_ROTATION_ZOOM_BACKGROUND = 0x63,
+    CMD_ROTATION_LINE_TABLE = 0x6B,
     CMD_SET_WINDOW = 0x64,
     CMD_COLOR_MATH = 0x65,
+    CMD_FLASH_SCREEN = 0x69,
+    CMD_APPLY_LUT = 0x6A,
     CMD_DRAW_PIXEL = 0x80,
     CMD_DRAW_LINE = 0x81,
     CMD_DRAW_RECT = 0x82,
+    CMD_COPPER_LIST_START = 0xA3,
+    CMD_COPPER_WAIT_LINE = 0xA4,
+    CMD_COPPER_END = 0xA5,
+    CMD_COPPER_SET_REGISTER = 0xA6,
+    CMD_SET_RENDER_TARGET = 0xB1,
     CMD_SET_CELL_BASED_SPRITES = 0xC0,
     CMD_SET_HSCROLL_MODE = 0xC1,
     CMD_SET_DUAL_PLAYFIELD = 0xC2,
-    CMD_SET_SPRITE_COLLISION_DETECTION = 0xC3
+    CMD_SET_SPRITE_COLLISION_DETECTION = 0xC4,
+    CMD_PROFILE_START = 0xE6,
+    CMD_PROFILE_STOP = 0xE7,
+    CMD_PROFILE_READ = 0xE8,
+    CMD_SEQUENCED = 0xE9,
+    CMD_BATCH = 0xF6,
+    CMD_CLOCK_SYNC = 0xF8
 };
 
 // Error codes
@@ -140,6 +169,26 @@ enum {
     ORDER_BY_PRIORITY = 1
 };
 
+// Render modes
+enum {
+    RENDER_MODE_FRAMEBUFFER = 0, // Compose the whole frame, then scan it out
+    RENDER_MODE_LINE = 1         // Compose groups of scanlines straight into scan-out buffers
+};
+
+// Per-layer tile drawing backend (SET_LAYER_BLIT)
+enum {
+    LAYER_BLIT_AUTO = 0,  // DMA tile blitter where the layer allows it, CPU otherwise
+    LAYER_BLIT_CPU = 1    // Always the per-pixel CPU loop
+};
+
+// How composed frames reach the display, reported by GET_STATUS
+enum {
+    PRESENT_MODE_LINES = 0,      // Line renderer, groups go out as they are composed
+    PRESENT_MODE_DOUBLE = 1,     // Two whole frames, one composed while the other goes out
+    PRESENT_MODE_TRIPLE = 2,     // Three whole frames
+    PRESENT_MODE_HALF_FRAME = 3  // One frame, its halves composed while the other half goes out
+};
+
 // RGB color struct
 typedef struct {
     uint8_t r;
@@ -150,11 +199,12 @@ typedef struct {
 // Palette entry
 RGB palette[256];
 
+// Palette converted to RGB565 for scan-out and 16bpp render targets
+uint16_t palette_rgb565[256];
+volatile bool palette_lut_dirty = true;
+
 // Global state variables
 uint8_t* framebuffer = NULL;
-uint8_t* front_buffer = NULL;
-uint8_t* back_buffer = NULL;
-uint8_t* current_draw_buffer = NULL;
 uint8_t cmd_buffer[256];
 uint16_t display_width = 320;
 uint16_t display_height = 240;
@@ -163,12 +213,21 @@ uint32_t framebuffer_size = 0;
 uint32_t sprite_data_size = 0;
 uint32_t command_buffer_size = 0;
 uint8_t sprite_order_mode = ORDER_BY_YPOS;
+uint8_t render_mode = RENDER_MODE_FRAMEBUFFER;
 bool double_buffering_enabled = false;
-bool render_requested = false;
-bool rendering_in_progress = false;
+volatile bool render_requested = false;
+volatile bool rendering_in_progress = false;
 bool clear_screen_requested = false;
 uint32_t last_render_time = 0;
-uint8_t* sprite_collision_buffer = NULL;
+uint32_t animation_tick_time = 0;  // Last 60Hz sprite animation tick
+
+// Frame pacing. Once the CPU closes its frames with FRAME_COMMIT a frame is only
+// rendered after its commit, so one frame's commands never straddle two renders.
+volatile bool frame_committed = false;
+bool frame_pacing_fenced = false;
+uint32_t last_commit_time = 0;
+uint32_t late_commits = 0;        // Render intervals spent waiting for a commit
+bool late_commit_counted = false;
 uint8_t* bg_collision_buffer = NULL;
 bool bg_collision_detection_enabled = false;
 bool sprite_collision_detected = false;
@@ -179,7 +238,6 @@ uint8_t sprite_cell_width = 8;
 uint8_t sprite_cell_height = 8;
 uint8_t hscroll_mode = 0;
 bool dual_playfield_mode = false;
-bool copper_list_enabled = false;
 uint8_t display_dma_channel = 0;
 
 // Function prototypes
@@ -193,15 +251,42 @@ void initialize_default_palette();
 void update_sprite_order();
 void update_sprite_animations();
 void mark_sprite_area_dirty(uint8_t sprite_id);
-void mark_rect_dirty(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void mark_rect_dirty(int x, int y, int width, int height);
+void update_layer_scroll(uint8_t layer_id, uint16_t scroll_x, uint16_t scroll_y);
+void apply_sprite_batch(const uint8_t* data, uint8_t length);
 uint8_t get_pixel_from_tile(uint8_t* data, uint16_t x, uint16_t y, uint16_t width, uint8_t attributes);
 uint8_t get_pixel_from_sprite(uint8_t* data, uint16_t x, uint16_t y, uint16_t width, uint8_t bpp);
-void trigger_copper_execution();
+bool copper_record_command(uint8_t cmd_id, const uint8_t* data, uint8_t length);
+void copper_run_scanout(int16_t line);
 void compact_sprite_memory();
 void flush_tile_cache();
 void clear_sprites();
 void reset_effects();
+void set_palette_cycle(uint8_t slot, uint8_t start, uint8_t count, uint8_t frames_per_step);
+void set_flash_screen(uint8_t r, uint8_t g, uint8_t b, uint8_t frames);
+void apply_color_lut(uint8_t channel, uint8_t start, uint8_t count, const uint8_t* levels);
+void set_mosaic_effect(uint8_t size);
 void flush_tile_cache();
+void send_data_to_cpu(const uint8_t* packet, uint8_t length);
+void send_error_to_cpu(uint8_t command_id, uint8_t error_code);
+void send_gpu_status();
+void send_sprite_collisions();
+void set_sprite_collision_detection(uint8_t mode);
+bool init_tile_cache(uint32_t size);
+void set_render_mode(uint8_t mode);
+void set_rotation_line_table(uint8_t layer_id, uint16_t start_line, uint8_t count, const uint8_t* data);
+void free_line_group_buffers();
+void present_service();
+void init_tile_blitter();
+void set_layer_blit(uint8_t layer_id, uint8_t backend);
+void present_wait_idle();
+void render_wait_idle();
+void configure_present_buffers();
+void set_palette_entry(uint8_t index, uint8_t r, uint8_t g, uint8_t b);
+void load_palette(uint8_t start_index, uint8_t count, const uint8_t* data);
+void map_tileset(uint8_t layer_id, uint16_t tile_start, uint16_t tile_count, uint32_t pack_offset);
+void map_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height, uint8_t bpp,
+                        uint32_t pack_offset);
 
 // Clock Synchronization Implementation
 // Timing variables for clock synchronization
@@ -237,7 +322,7 @@ void process_clock_sync_command(const uint8_t* data) {
     master_clock_timestamp = cpu_timestamp;
 
     // Send acknowledgment
-    send_ack_to_cpu(0xF1);
+    send_ack_to_cpu(CMD_CLOCK_SYNC);
 
     if (debug_enabled) {
         printf("Clock sync received: frame=%lu offset=%lld\n",
@@ -250,15 +335,160 @@ uint64_t get_master_time() {
     return time_us_64() + local_clock_offset;
 }
 
+// Frame Profiler
+// Hot paths record begin/end events into one ring per core. A core only ever
+// writes its own ring, so recording is a few stores and an index bump with no
+// lock. Timestamps are master time, so traces read back from the CPU, GPU and
+// APU line up on one timeline. Zone IDs are unique across the three chips
+// (CPU 0x01-0x0F, GPU 0x10-0x1F, APU 0x20-0x2F) so the CPU can name them when
+// it exports the trace.
+#define TRACE_RING_SIZE 512     // Events per core, power of two
+#define TRACE_READ_MAX 30       // Events per PROFILE_READ reply
+
+#define TRACE_BEGIN 0
+#define TRACE_END 1
+
+enum {
+    ZONE_GPU_COMMAND = 0x10,         // arg = command ID
+    ZONE_GPU_FRAME = 0x11,           // arg = low bits of the frame counter
+    ZONE_GPU_RENDER_LAYER = 0x12,    // arg = layer
+    ZONE_GPU_RENDER_SPRITES = 0x13,  // arg = priority
+    ZONE_GPU_SCANOUT = 0x14,
+    ZONE_GPU_PRESENT_WAIT = 0x15     // arg = present buffer waited for
+};
+
+typedef struct {
+    uint32_t timestamp;   // Master time in microseconds, low 32 bits
+    uint8_t zone;
+    uint8_t phase;        // TRACE_BEGIN or TRACE_END
+    uint16_t arg;
+} TraceEvent;
+
+TraceEvent trace_rings[2][TRACE_RING_SIZE];
+volatile uint32_t trace_heads[2];   // Events ever recorded on each core
+uint32_t trace_read_cursors[2];     // Next event PROFILE_READ returns
+volatile bool trace_enabled = false;
+
+static inline void trace_record(uint8_t zone, uint8_t phase, uint16_t arg) {
+    if (!trace_enabled) {
+        return;
+    }
+
+    uint core = get_core_num();
+    uint32_t head = trace_heads[core];
+    TraceEvent* event = &trace_rings[core][head & (TRACE_RING_SIZE - 1)];
+    event->timestamp = (uint32_t)get_master_time();
+    event->zone = zone;
+    event->phase = phase;
+    event->arg = arg;
+
+    // Make the event visible before the index that covers it
+    __dmb();
+    trace_heads[core] = head + 1;
+}
+
+static inline void trace_begin(uint8_t zone, uint16_t arg) {
+    trace_record(zone, TRACE_BEGIN, arg);
+}
+
+static inline void trace_end(uint8_t zone, uint16_t arg) {
+    trace_record(zone, TRACE_END, arg);
+}
+
+// Start a capture. The heads keep counting, the reader just skips what came before.
+void start_profiling() {
+    trace_read_cursors[0] = trace_heads[0];
+    trace_read_cursors[1] = trace_heads[1];
+    __dmb();
+    trace_enabled = true;
+}
+
+void stop_profiling() {
+    trace_enabled = false;
+}
+
+// Reply with the next unread events of one core:
+// [core][first sequence:4][count][timestamp:4 zone phase arg:2]*count
+// When the ring has lapped the reader the oldest events are dropped, which
+// shows as a gap in the sequence numbers. A margin is kept so the writer
+// can't overwrite events while they are being copied.
+void send_trace_events(uint8_t core) {
+    if (core > 1) {
+        send_error_to_cpu(CMD_PROFILE_READ, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    uint8_t packet[8 + TRACE_READ_MAX * 8];
+    uint32_t head = trace_heads[core];
+    __dmb();
+
+    uint32_t cursor = trace_read_cursors[core];
+    if (head - cursor > TRACE_RING_SIZE - TRACE_READ_MAX) {
+        cursor = head - (TRACE_RING_SIZE - TRACE_READ_MAX);
+    }
+
+    uint32_t count = head - cursor;
+    if (count > TRACE_READ_MAX) {
+        count = TRACE_READ_MAX;
+    }
+
+    uint8_t pos = 2;
+    packet[pos++] = core;
+    packet[pos++] = (cursor >> 24) & 0xFF;
+    packet[pos++] = (cursor >> 16) & 0xFF;
+    packet[pos++] = (cursor >> 8) & 0xFF;
+    packet[pos++] = cursor & 0xFF;
+    packet[pos++] = count;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const TraceEvent* event = &trace_rings[core][(cursor + i) & (TRACE_RING_SIZE - 1)];
+        packet[pos++] = (event->timestamp >> 24) & 0xFF;
+        packet[pos++] = (event->timestamp >> 16) & 0xFF;
+        packet[pos++] = (event->timestamp >> 8) & 0xFF;
+        packet[pos++] = event->timestamp & 0xFF;
+        packet[pos++] = event->zone;
+        packet[pos++] = event->phase;
+        packet[pos++] = event->arg >> 8;
+        packet[pos++] = event->arg & 0xFF;
+    }
+
+    trace_read_cursors[core] = cursor + count;
+
+    packet[0] = CMD_PROFILE_READ;
+    packet[1] = pos;
+    send_data_to_cpu(packet, pos);
+}
+
+// Batch execution state - while a batch runs, responses are folded into
+// a single reply sent when it completes
+bool batch_active = false;
+uint8_t batch_error_cmd = 0;
+uint8_t batch_error_code = 0;
+
+// Sequenced delivery state, reported in every ACK and error packet: the next
+// sequence number expected (everything before it has run) and which of the
+// following ones arrived early and are held
+#define SEQ_WINDOW 8
+uint8_t seq_expected = 0;
+uint16_t seq_held_mask = 0;          // Bit i: seq_expected + i is held
+bool seq_ack_pending = false;
+
 //GPU Command Acknowledgment
 void send_ack_to_cpu(uint8_t command_id) {
+    if (batch_active) {
+        return;
+    }
+
     // Prepare acknowledgment packet
-    uint8_t ack_packet[4] = {
+    uint8_t ack_packet[6] = {
         0xFA,        // ACK command ID
-        4,           // Packet length
+        6,           // Packet length
         command_id,  // Original command being acknowledged
-        0            // Status (0 = success)
+        0,           // Status (0 = success)
+        seq_expected,             // Cumulative sequence ACK
+        seq_held_mask >> 1        // Held: bit i = seq_expected + 1 + i
     };
+    seq_ack_pending = false;
 
     // Wait for CPU to be ready to receive response
     while (gpio_get(CPU_CS_PIN) == 0) {
@@ -277,7 +507,7 @@ void send_ack_to_cpu(uint8_t command_id) {
 
     // If CPU responded, send the acknowledgment
     if (timeout > 0) {
-        spi_write_blocking(SPI_PORT, ack_packet, 4);
+        spi_write_blocking(SPI_PORT, ack_packet, 6);
     }
 
     // Clear data ready signal
@@ -285,13 +515,25 @@ void send_ack_to_cpu(uint8_t command_id) {
 }
 
 void send_error_to_cpu(uint8_t command_id, uint8_t error_code) {
+    if (batch_active) {
+        // Report the first failure once the batch completes
+        if (batch_error_code == ERR_NONE) {
+            batch_error_cmd = command_id;
+            batch_error_code = error_code;
+        }
+        return;
+    }
+
     // Prepare error packet
-    uint8_t error_packet[4] = {
+    uint8_t error_packet[6] = {
         0xFE,        // Error command ID
-        4,           // Packet length
+        6,           // Packet length
         command_id,  // Original command with error
-        error_code   // Error code
+        error_code,  // Error code
+        seq_expected,             // Same sequence state as an ACK
+        seq_held_mask >> 1
     };
+    seq_ack_pending = false;
 
     // Similar pattern as acknowledgment sending
     // Wait for CPU to be ready
@@ -308,7 +550,29 @@ void send_error_to_cpu(uint8_t command_id, uint8_t error_code) {
     }
 
     if (timeout > 0) {
-        spi_write_blocking(SPI_PORT, error_packet, 4);
+        spi_write_blocking(SPI_PORT, error_packet, 6);
+    }
+
+    gpio_put(DATA_READY_PIN, 0);
+}
+
+// Send a response packet (status, query results) to the CPU
+void send_data_to_cpu(const uint8_t* packet, uint8_t length) {
+    // Same handshake as acknowledgment sending
+    while (gpio_get(CPU_CS_PIN) == 0) {
+        sleep_us(10);
+    }
+
+    gpio_put(DATA_READY_PIN, 1);
+
+    uint32_t timeout = 1000;
+    while (gpio_get(CPU_CS_PIN) == 1 && timeout > 0) {
+        sleep_us(1);
+        timeout--;
+    }
+
+    if (timeout > 0) {
+        spi_write_blocking(SPI_PORT, packet, length);
     }
 
     gpio_put(DATA_READY_PIN, 0);
@@ -423,6 +687,11 @@ void reset_spi_interface() {
 
 // Command Processing System
 void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
+    // Copper commands, and commands captured into an open copper list
+    if (copper_record_command(cmd_id, data, length)) {
+        return;
+    }
+
     switch (cmd_id) {
         // System Commands
         case CMD_NOP:
@@ -431,6 +700,9 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             
         case CMD_RESET_GPU:
             reset_gpu();
+            // The CPU restarts its numbering with the reset
+            seq_expected = 0;
+            seq_held_mask = 0;
             send_ack_to_cpu(CMD_RESET_GPU);
             break;
             
@@ -453,6 +725,17 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             cmd_vsync_wait();
             break;
 
+        case CMD_FRAME_COMMIT:
+            // Not acknowledged: the VSYNC pulse after the frame answers it
+            frame_pacing_fenced = true;
+            last_commit_time = time_us_32();
+            frame_committed = true;
+            break;
+
+        case CMD_GET_STATUS:
+            send_gpu_status();
+            break;
+
         // Palette Commands
         case CMD_SET_PALETTE_ENTRY:
             set_palette_entry(data[0], data[1], data[2], data[3]);
@@ -461,6 +744,10 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
         case CMD_LOAD_PALETTE:
             load_palette(data[0], data[1], &data[2]);
             break;
+
+        case CMD_CYCLE_PALETTE:
+            set_palette_cycle(data[0], data[1], data[2], data[3]);
+            break;
         
         // Background Layer Commands
         case CMD_CONFIGURE_LAYER:
@@ -478,6 +765,20 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             }
             break;
             
+        case CMD_MAP_TILESET:
+            {
+                uint8_t layer_id = data[0];
+                uint16_t tile_start = (data[1] << 8) | data[2];
+                uint16_t tile_count = (data[3] << 8) | data[4];
+                uint32_t pack_offset = ((uint32_t)data[5] << 24) | (data[6] << 16) | (data[7] << 8) | data[8];
+                map_tileset(layer_id, tile_start, tile_count, pack_offset);
+            }
+            break;
+            
+        case CMD_SET_LAYER_BLIT:
+            set_layer_blit(data[0], data[1]);
+            break;
+
         case CMD_SCROLL_LAYER:
             {
                 uint8_t layer_id = data[0];
@@ -499,6 +800,17 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             }
             break;
             
+        case CMD_MAP_SPRITE_PATTERN:
+            {
+                uint8_t pattern_id = data[0];
+                uint8_t width = data[1];
+                uint8_t height = data[2];
+                uint8_t bpp = data[3];
+                uint32_t pack_offset = ((uint32_t)data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+                map_sprite_pattern(pattern_id, width, height, bpp, pack_offset);
+            }
+            break;
+            
         case CMD_DEFINE_SPRITE:
             {
                 uint8_t sprite_id = data[0];
@@ -512,10 +824,61 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
             }
             break;
         
+        case CMD_BATCH_SPRITE_UPDATE:
+            apply_sprite_batch(data, length);
+            break;
+
+        case CMD_GET_SPRITE_COLLISION:
+            send_sprite_collisions();
+            break;
+
+        // Profiling and synchronization
+        case CMD_PROFILE_START:
+            start_profiling();
+            send_ack_to_cpu(CMD_PROFILE_START);
+            break;
+
+        case CMD_PROFILE_STOP:
+            stop_profiling();
+            send_ack_to_cpu(CMD_PROFILE_STOP);
+            break;
+
+        case CMD_PROFILE_READ:
+            send_trace_events(length > 0 ? data[0] : 0);
+            break;
+
+        case CMD_CLOCK_SYNC:
+            if (length < 9) {
+                send_error_to_cpu(CMD_CLOCK_SYNC, ERR_INVALID_PARAMETER);
+                break;
+            }
+            process_clock_sync_command(data);
+            break;
+
+        case CMD_SET_SPRITE_COLLISION_DETECTION:
+            set_sprite_collision_detection(data[0]);
+            break;
+        
         // Special Effects Commands
         case CMD_SET_FADE:
             set_fade(data[0], data[1]);
             break;
+
+        case CMD_MOSAIC_EFFECT:
+            set_mosaic_effect(data[0]);
+            break;
+
+        case CMD_FLASH_SCREEN:
+            set_flash_screen(data[0], data[1], data[2], data[3]);
+            break;
+
+        case CMD_APPLY_LUT:
+            if (length < 3 || length < 3 + data[2]) {
+                send_error_to_cpu(CMD_APPLY_LUT, ERR_INVALID_PARAMETER);
+                break;
+            }
+            apply_color_lut(data[0], data[1], data[2], &data[3]);
+            break;
             
         case CMD_ROTATION_ZOOM_BACKGROUND:
             {
@@ -526,7 +889,26 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
                 set_rotation_zoom(layer_id, angle, scale_x, scale_y);
             }
             break;
+
+        case CMD_ROTATION_LINE_TABLE:
+            {
+                uint8_t layer_id = data[0];
+                uint16_t start_line = (data[1] << 8) | data[2];
+                uint8_t count = data[3];
+                if (length < 4 + count * 8) {
+                    send_error_to_cpu(CMD_ROTATION_LINE_TABLE, ERR_INVALID_PARAMETER);
+                    break;
+                }
+                set_rotation_line_table(layer_id, start_line, count, &data[4]);
+            }
+            break;
         
+        // Advanced Features
+        case CMD_SET_RENDER_TARGET:
+            // 0 = full framebuffer, 1 = line renderer
+            set_render_mode(data[0]);
+            break;
+
         // Direct Drawing Commands
         case CMD_DRAW_PIXEL:
             {
@@ -555,6 +937,327 @@ void process_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
     }
 }
 
+// Command Reception
+// The CPU streams commands back to back under one CS assertion, so SPI RX is
+// drained by DMA into a ring (command_buffer_size bytes) and parsed from there
+// rather than with a blocking read per command. A 0xFF in the command ID
+// position is idle fill clocked in while the CPU reads a response and is
+// skipped.
+#define CMD_RX_FILL 0xFF
+#define CMD_RX_TIMEOUT_US 2000       // Drop a partial command after this long
+#define BATCH_HEADER_SIZE 4          // [CMD_BATCH][count][size_hi][size_lo]
+#define CMD_RX_DMA_COUNT 0x0FFFFFFF  // Fits the RP2350 count field as well
+
+uint8_t* cmd_rx_ring = NULL;
+uint32_t cmd_rx_size = 0;
+uint32_t cmd_rx_mask = 0;
+int cmd_rx_dma_channel = -1;
+volatile uint32_t cmd_rx_base = 0;   // Bytes received by completed DMA runs
+uint32_t cmd_rx_read_pos = 0;        // Free-running parse position
+uint32_t cmd_rx_stall_start = 0;
+
+typedef struct {
+    uint32_t commands;
+    uint32_t batches;
+    uint32_t overruns;
+    uint32_t timeouts;
+} CommandRxStats;
+
+CommandRxStats cmd_rx_stats;
+
+void cmd_rx_dma_irq_handler() {
+    if (dma_channel_get_irq1_status(cmd_rx_dma_channel)) {
+        dma_channel_acknowledge_irq1(cmd_rx_dma_channel);
+
+        // Re-arm straight away; the write address keeps wrapping in the ring
+        cmd_rx_base += CMD_RX_DMA_COUNT;
+        dma_channel_set_trans_count(cmd_rx_dma_channel, CMD_RX_DMA_COUNT, true);
+    }
+}
+
+// Allocate the receive ring and start SPI RX DMA into it
+bool init_command_rx(uint32_t size) {
+    // DMA address wrapping needs a power of two no larger than 32KB,
+    // aligned to its own size
+    uint32_t ring_bits = 0;
+    while ((2u << ring_bits) <= size && ring_bits < 15) {
+        ring_bits++;
+    }
+    cmd_rx_size = 1u << ring_bits;
+    cmd_rx_mask = cmd_rx_size - 1;
+
+    cmd_rx_ring = aligned_alloc(cmd_rx_size, cmd_rx_size);
+    if (cmd_rx_ring == NULL) {
+        return false;
+    }
+
+    cmd_rx_base = 0;
+    cmd_rx_read_pos = 0;
+    memset(&cmd_rx_stats, 0, sizeof(cmd_rx_stats));
+
+    cmd_rx_dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(cmd_rx_dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, ring_bits);
+    channel_config_set_dreq(&config, spi_get_dreq(CPU_SPI_PORT, false));
+
+    dma_channel_set_irq1_enabled(cmd_rx_dma_channel, true);
+    irq_set_exclusive_handler(DMA_IRQ_1, cmd_rx_dma_irq_handler);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_configure(cmd_rx_dma_channel, &config, cmd_rx_ring,
+                          &spi_get_hw(CPU_SPI_PORT)->dr, CMD_RX_DMA_COUNT, true);
+    return true;
+}
+
+// Free-running count of bytes DMA has written into the ring
+static inline uint32_t cmd_rx_write_pos() {
+    uint32_t base, remaining;
+    do {
+        base = cmd_rx_base;
+        remaining = dma_hw->ch[cmd_rx_dma_channel].transfer_count;
+    } while (base != cmd_rx_base);
+    return base + (CMD_RX_DMA_COUNT - remaining);
+}
+
+static inline uint8_t cmd_rx_peek(uint32_t offset) {
+    return cmd_rx_ring[(cmd_rx_read_pos + offset) & cmd_rx_mask];
+}
+
+// Pointer to count bytes at offset, copied into scratch only if they wrap
+const uint8_t* cmd_rx_span(uint32_t offset, uint32_t count, uint8_t* scratch) {
+    uint32_t start = (cmd_rx_read_pos + offset) & cmd_rx_mask;
+    if (start + count <= cmd_rx_size) {
+        return &cmd_rx_ring[start];
+    }
+
+    uint32_t first = cmd_rx_size - start;
+    memcpy(scratch, &cmd_rx_ring[start], first);
+    memcpy(scratch + first, cmd_rx_ring, count - first);
+    return scratch;
+}
+
+// Run every sub-command of a batch with ACKs held back, then answer once
+void dispatch_command_batch(uint8_t count, uint16_t size) {
+    uint32_t offset = BATCH_HEADER_SIZE;
+    uint32_t end = BATCH_HEADER_SIZE + size;
+
+    batch_active = true;
+    batch_error_cmd = CMD_BATCH;
+    batch_error_code = ERR_NONE;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (offset + 2 > end) {
+            break;
+        }
+
+        uint8_t cmd_id = cmd_rx_peek(offset);
+        uint8_t length = cmd_rx_peek(offset + 1);
+
+        if (length < 2 || offset + length > end || cmd_id == CMD_BATCH) {
+            // Malformed sub-command - the rest of the batch can't be trusted
+            if (batch_error_code == ERR_NONE) {
+                batch_error_cmd = cmd_id;
+                batch_error_code = ERR_INVALID_DATA;
+            }
+            break;
+        }
+
+        const uint8_t* data = cmd_rx_span(offset + 2, length - 2, cmd_buffer);
+        trace_begin(ZONE_GPU_COMMAND, cmd_id);
+        process_command(cmd_id, data, length - 2);
+        trace_end(ZONE_GPU_COMMAND, cmd_id);
+        cmd_rx_stats.commands++;
+        offset += length;
+    }
+
+    batch_active = false;
+    cmd_rx_stats.batches++;
+
+    if (batch_error_code == ERR_NONE) {
+        send_ack_to_cpu(CMD_BATCH);
+    } else {
+        send_error_to_cpu(batch_error_cmd, batch_error_code);
+    }
+}
+
+// Sequenced commands: [CMD_SEQUENCED][seq] followed by one whole command.
+// They run in sequence order; one that arrives ahead of a gap is held until
+// the gap is resent, a repeat of one that already ran is dropped, and one
+// far outside the window means the CPU restarted its numbering. Instead of
+// an ACK each, the sequence state goes out once the receive ring has been
+// drained, or with the next ACK or error sent anyway.
+#define SEQ_HEADER_SIZE 2
+
+uint8_t seq_held_data[SEQ_WINDOW][256];  // Held commands from their ID byte on
+
+// Run one sequenced command with its ACK folded into the sequence state
+void run_sequenced_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
+    batch_active = true;
+    batch_error_cmd = cmd_id;
+    batch_error_code = ERR_NONE;
+
+    trace_begin(ZONE_GPU_COMMAND, cmd_id);
+    process_command(cmd_id, data, length - 2);
+    trace_end(ZONE_GPU_COMMAND, cmd_id);
+    cmd_rx_stats.commands++;
+
+    batch_active = false;
+    seq_expected++;
+    seq_held_mask >>= 1;
+
+    if (batch_error_code == ERR_NONE) {
+        seq_ack_pending = true;
+    } else {
+        send_error_to_cpu(batch_error_cmd, batch_error_code);
+    }
+}
+
+void dispatch_sequenced_command(uint8_t seq, uint8_t cmd_id, uint8_t length) {
+    uint8_t ahead = seq - seq_expected;
+
+    if (ahead >= SEQ_WINDOW) {
+        if (ahead >= (uint8_t)(256 - 2 * SEQ_WINDOW)) {
+            // Ran already; the CPU missed the ACK
+            seq_ack_pending = true;
+            return;
+        }
+
+        // Numbering restarted - follow it
+        seq_expected = seq;
+        seq_held_mask = 0;
+        ahead = 0;
+    }
+
+    if (ahead > 0) {
+        uint8_t* held = seq_held_data[seq % SEQ_WINDOW];
+        held[0] = cmd_id;
+        held[1] = length;
+        for (uint8_t i = 2; i < length; i++) {
+            held[i] = cmd_rx_peek(SEQ_HEADER_SIZE + i);
+        }
+        seq_held_mask |= 1 << ahead;
+        seq_ack_pending = true;
+        return;
+    }
+
+    seq_held_mask |= 1;
+    const uint8_t* data = cmd_rx_span(SEQ_HEADER_SIZE + 2, length - 2, cmd_buffer);
+    run_sequenced_command(cmd_id, data, length);
+
+    // The gap is closed - run what was held behind it
+    while (seq_held_mask & 1) {
+        const uint8_t* held = seq_held_data[seq_expected % SEQ_WINDOW];
+        run_sequenced_command(held[0], held + 2, held[1]);
+    }
+}
+
+// Parse and dispatch every complete command waiting in the receive ring.
+// Returns the number of commands (or batches) dispatched.
+uint32_t process_received_commands() {
+    uint32_t dispatched = 0;
+
+    while (true) {
+        uint32_t available = cmd_rx_write_pos() - cmd_rx_read_pos;
+
+        if (available > cmd_rx_size) {
+            // The CPU outran us and DMA lapped the parser - resynchronise
+            cmd_rx_stats.overruns++;
+            cmd_rx_read_pos = cmd_rx_write_pos();
+            send_error_to_cpu(0, ERR_COMMUNICATION_FAILURE);
+            break;
+        }
+
+        if (available == 0) {
+            break;
+        }
+
+        uint8_t cmd_id = cmd_rx_peek(0);
+        if (cmd_id == CMD_RX_FILL) {
+            cmd_rx_read_pos++;
+            continue;
+        }
+
+        uint32_t needed = 2;
+        if (available >= 2) {
+            if (cmd_id == CMD_SEQUENCED) {
+                needed = SEQ_HEADER_SIZE + 2;
+                if (available >= SEQ_HEADER_SIZE + 2) {
+                    uint8_t inner_id = cmd_rx_peek(SEQ_HEADER_SIZE);
+                    uint8_t inner_length = cmd_rx_peek(SEQ_HEADER_SIZE + 1);
+                    if (inner_length < 2 || inner_id == CMD_BATCH || inner_id == CMD_SEQUENCED) {
+                        // Not a valid wrapped command - drop a byte and look again
+                        send_error_to_cpu(CMD_SEQUENCED, ERR_INVALID_DATA);
+                        cmd_rx_read_pos++;
+                        continue;
+                    }
+                    needed = SEQ_HEADER_SIZE + inner_length;
+                }
+            } else if (cmd_id == CMD_BATCH) {
+                needed = BATCH_HEADER_SIZE;
+                if (available >= BATCH_HEADER_SIZE) {
+                    uint16_t size = (cmd_rx_peek(2) << 8) | cmd_rx_peek(3);
+                    if (BATCH_HEADER_SIZE + size > cmd_rx_size) {
+                        // Can never fit in the ring - skip the header byte
+                        send_error_to_cpu(CMD_BATCH, ERR_INVALID_PARAMETER);
+                        cmd_rx_read_pos++;
+                        continue;
+                    }
+                    needed = BATCH_HEADER_SIZE + size;
+                }
+            } else {
+                needed = cmd_rx_peek(1);
+                if (needed < 2) {
+                    // Not a valid header - drop a byte and look again
+                    cmd_rx_read_pos++;
+                    continue;
+                }
+            }
+        }
+
+        if (available < needed) {
+            // Wait for the rest, but don't hang on a transfer the CPU abandoned
+            if (cmd_rx_stall_start == 0) {
+                cmd_rx_stall_start = time_us_32() | 1;
+            } else if (time_us_32() - cmd_rx_stall_start > CMD_RX_TIMEOUT_US) {
+                cmd_rx_stats.timeouts++;
+                cmd_rx_read_pos += available;
+                cmd_rx_stall_start = 0;
+                send_error_to_cpu(cmd_id, ERR_TIMEOUT);
+            }
+            break;
+        }
+        cmd_rx_stall_start = 0;
+
+        if (cmd_id == CMD_SEQUENCED) {
+            dispatch_sequenced_command(cmd_rx_peek(1), cmd_rx_peek(SEQ_HEADER_SIZE),
+                                       needed - SEQ_HEADER_SIZE);
+        } else if (cmd_id == CMD_BATCH) {
+            trace_begin(ZONE_GPU_COMMAND, CMD_BATCH);
+            dispatch_command_batch(cmd_rx_peek(1), needed - BATCH_HEADER_SIZE);
+            trace_end(ZONE_GPU_COMMAND, CMD_BATCH);
+        } else {
+            const uint8_t* data = cmd_rx_span(2, needed - 2, cmd_buffer);
+            trace_begin(ZONE_GPU_COMMAND, cmd_id);
+            process_command(cmd_id, data, needed - 2);
+            trace_end(ZONE_GPU_COMMAND, cmd_id);
+            cmd_rx_stats.commands++;
+        }
+
+        cmd_rx_read_pos += needed;
+        dispatched++;
+    }
+
+    // One cumulative ACK for every sequenced command handled in this pass
+    if (seq_ack_pending) {
+        send_ack_to_cpu(CMD_SEQUENCED);
+    }
+
+    return dispatched;
+}
+
 // VSYNC handling variables
 volatile bool vsync_occurred = false;
 volatile bool vsync_wait_pending = false;
@@ -625,6 +1328,9 @@ typedef struct {
     // Rotation/transformation properties
     bool rotation_enabled;
     float matrix[4];  // 2x2 transformation matrix
+    int32_t affine[4];  // The same matrix in 16.16 fixed point for the renderer
+    int16_t* affine_lines;  // Optional per-line a,b,c,d in signed 8.8 (ROTATION_LINE_TABLE)
+    uint16_t affine_line_count;
     int16_t rot_center_x;
     int16_t rot_center_y;
     
@@ -637,6 +1343,14 @@ typedef struct {
     
     // Buffer for storing layer content (for blending)
     uint8_t* buffer;
+    
+    // Tiles read in place from the asset pack in flash (MAP_TILESET)
+    const uint8_t* flash_tiles;
+    uint16_t flash_tile_start;
+    uint16_t flash_tile_count;
+    uint16_t* flash_row_masks;  // Empty and opaque row masks per flash tile, or NULL
+
+    uint8_t blit_backend;  // LAYER_BLIT_AUTO or LAYER_BLIT_CPU
 } Layer;
 
 // Tile information structure
@@ -645,21 +1359,71 @@ typedef struct {
     uint8_t attributes;  // Flip, palette, priority bits
 } TileInfo;
 
+// Tile cache
+// Tiles live in fixed-size slots carved from one arena, so eviction never goes back to
+// the heap. The arena is split into TILE_SLAB_PAGE_SIZE pages and each page is handed to
+// one slot size class (32-512 bytes) while that class needs room; once all of a page's
+// slots are free again it goes back to a shared pool for any class. Lookups go
+// through an open-addressed hash index keyed on (layer_id, tile_id), and eviction uses
+// CLOCK: every hit sets a reference bit that the hand clears as it passes.
+#define TILE_SLAB_PAGE_SIZE 2048
+#define TILE_SLAB_CLASSES 5          // 32, 64, 128, 256, 512 byte slots
+#define TILE_SLAB_MIN_SHIFT 5
+#define TILE_SLAB_NO_PAGE 0xFFFF
+#define TILE_INDEX_SIZE 512          // Power of two, twice MAX_CACHED_TILES
+#define TILE_INDEX_EMPTY 0xFFFF
+#define TILE_VARIANT_FLIP_X 0x80     // Added to the layer ID for a tile's mirrored copy
+
 // Tile cache entry
 typedef struct {
     uint8_t layer_id;
     uint16_t tile_id;
     uint8_t* data;
-    uint32_t size;
-    uint32_t last_used;  // For LRU replacement
+    uint16_t size;
+    uint8_t slab_class;
+    bool in_use;
+    bool referenced;     // CLOCK reference bit
+    uint16_t empty_rows;   // Bit per row with no opaque pixel, from scan_pixel_rows()
+    uint16_t opaque_rows;  // Bit per row with no transparent pixel
 } TileCacheEntry;
 
+// One arena page. A page with free slots sits on its class's partial list; an empty
+// page sits on the shared pool, linked through next.
+typedef struct {
+    uint8_t* free_slots;  // Free slots in this page, linked through the slots
+    uint16_t next;
+    uint16_t prev;
+    uint8_t slab_class;
+    uint8_t live;         // Slots in use
+} TileSlabPage;
+
+// Tile cache statistics, reported through GPU_CMD_GET_STATUS
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t failed_inserts;  // No slot could be freed for the tile's size class
+} TileCacheStats;
+
 // Global state
 Layer layers[MAX_LAYERS];
 TileCacheEntry tile_cache[MAX_CACHED_TILES];
 uint32_t tile_cache_count = 0;
+uint32_t tile_cache_size = 0;
 uint32_t frame_counter = 0;
 
+uint16_t tile_index[TILE_INDEX_SIZE];            // Entry number, TILE_INDEX_EMPTY if unused
+uint16_t tile_free_entries[MAX_CACHED_TILES];    // Stack of unused entry numbers
+uint16_t tile_free_entry_count = 0;
+uint16_t tile_clock_hand = 0;
+uint8_t* tile_slab_memory = NULL;
+uint32_t tile_slab_pages = 0;
+uint32_t tile_slab_pages_used = 0;                // Pages carved so far
+TileSlabPage* tile_slab_page_info = NULL;
+uint16_t tile_slab_partial[TILE_SLAB_CLASSES];    // Pages of each class with a free slot
+uint16_t tile_slab_empty_pages = TILE_SLAB_NO_PAGE; // Released pages, any class may take one
+TileCacheStats tile_cache_stats;
+
 void configure_layer(uint8_t layer_id, uint8_t enable, uint8_t priority, 
                     uint8_t scroll_mode, uint8_t tile_width, uint8_t tile_height,
                     uint8_t width_tiles, uint8_t height_tiles) {
@@ -850,125 +1614,484 @@ void scroll_layer(uint8_t layer_id, uint16_t scroll_x, uint16_t scroll_y) {
         return;
     }
     
-    // Store old scroll position to calculate dirty regions
-    uint16_t old_scroll_x = layers[layer_id].scroll_x;
-    uint16_t old_scroll_y = layers[layer_id].scroll_y;
+    update_layer_scroll(layer_id, scroll_x, scroll_y);
+    
+    send_ack_to_cpu(CMD_SCROLL_LAYER);
+}
+
+// Move a layer and mark what it covers dirty. Nothing shifts the pixels
+// already in the framebuffer, so a scroll changes every pixel of the layer,
+// not just the strip it exposes, and the whole screen has to be redrawn.
+void update_layer_scroll(uint8_t layer_id, uint16_t scroll_x, uint16_t scroll_y) {
+    if (layers[layer_id].scroll_x == scroll_x && layers[layer_id].scroll_y == scroll_y) {
+        return;
+    }
     
-    // Update scroll position
     layers[layer_id].scroll_x = scroll_x;
     layers[layer_id].scroll_y = scroll_y;
     
     // Only mark dirty regions if the layer is enabled
     if (layers[layer_id].enabled) {
-        // Calculate dirty regions based on scroll change
-        uint16_t diff_x = abs((int16_t)old_scroll_x - (int16_t)scroll_x);
-        uint16_t diff_y = abs((int16_t)old_scroll_y - (int16_t)scroll_y);
-        
-        if (diff_x >= display_width || diff_y >= display_height) {
-            // If scroll change is larger than screen, mark everything dirty
-            mark_rect_dirty(0, 0, display_width, display_height);
-        } else {
-            // Mark newly exposed areas as dirty
-            if (scroll_x > old_scroll_x) {
-                // New area exposed on the right
-                mark_rect_dirty(display_width - diff_x, 0, diff_x, display_height);
-            } else if (scroll_x < old_scroll_x) {
-                // New area exposed on the left
-                mark_rect_dirty(0, 0, diff_x, display_height);
-            }
-            
-            if (scroll_y > old_scroll_y) {
-                // New area exposed on the bottom
-                mark_rect_dirty(0, display_height - diff_y, display_width, diff_y);
-            } else if (scroll_y < old_scroll_y) {
-                // New area exposed on the top
-                mark_rect_dirty(0, 0, display_width, diff_y);
-            }
-        }
+        mark_rect_dirty(0, 0, display_width, display_height);
     }
-    
-    send_ack_to_cpu(CMD_SCROLL_LAYER);
 }
 
 // Tile cache management
-void cache_tile(uint8_t layer_id, uint16_t tile_id, const uint8_t* data, uint32_t size) {
-    // Check if tile is already in cache
-    for (uint32_t i = 0; i < tile_cache_count; i++) {
-        if (tile_cache[i].layer_id == layer_id && tile_cache[i].tile_id == tile_id) {
-            // Tile found, update last used time and return
-            tile_cache[i].last_used = frame_counter;
-            return;
+// Set up the slab arena and empty index
+bool init_tile_cache(uint32_t size) {
+    uint32_t pages = size / TILE_SLAB_PAGE_SIZE;
+    if (pages > TILE_SLAB_NO_PAGE) {
+        pages = TILE_SLAB_NO_PAGE;
+    }
+
+    tile_slab_memory = safe_malloc(size);
+    if (tile_slab_memory == NULL) {
+        return false;
+    }
+
+    tile_slab_page_info = safe_malloc(pages * sizeof(TileSlabPage));
+    if (tile_slab_page_info == NULL) {
+        free(tile_slab_memory);
+        tile_slab_memory = NULL;
+        return false;
+    }
+
+    tile_cache_size = size;
+    tile_slab_pages = pages;
+    memset(&tile_cache_stats, 0, sizeof(tile_cache_stats));
+    flush_tile_cache();
+
+    return true;
+}
+
+uint16_t tile_index_hash(uint8_t layer_id, uint16_t tile_id) {
+    uint32_t key = ((uint32_t)layer_id << 16) | tile_id;
+    return (key * 2654435761u) >> 23; // Top 9 bits, TILE_INDEX_SIZE = 512
+}
+
+// Find the index slot holding a tile, or the empty slot where it would go
+uint16_t tile_index_find(uint8_t layer_id, uint16_t tile_id) {
+    uint16_t pos = tile_index_hash(layer_id, tile_id);
+
+    // The index is never more than half full, so this always reaches an empty slot
+    while (tile_index[pos] != TILE_INDEX_EMPTY) {
+        TileCacheEntry* entry = &tile_cache[tile_index[pos]];
+        if (entry->layer_id == layer_id && entry->tile_id == tile_id) {
+            break;
         }
+        pos = (pos + 1) & (TILE_INDEX_SIZE - 1);
     }
-    
-    // Tile not in cache, need to add it
-    
-    // If cache is full, use LRU replacement
-    if (tile_cache_count >= MAX_CACHED_TILES) {
-        // Find least recently used tile
-        uint32_t lru_index = 0;
-        uint32_t lru_time = 0xFFFFFFFF;
-        
-        for (uint32_t i = 0; i < MAX_CACHED_TILES; i++) {
-            if (tile_cache[i].last_used < lru_time) {
-                lru_time = tile_cache[i].last_used;
-                lru_index = i;
-            }
+
+    return pos;
+}
+
+// Remove an index slot, shifting back later entries of the same probe run
+void tile_index_remove(uint16_t pos) {
+    uint16_t next = (pos + 1) & (TILE_INDEX_SIZE - 1);
+
+    while (tile_index[next] != TILE_INDEX_EMPTY) {
+        TileCacheEntry* entry = &tile_cache[tile_index[next]];
+        uint16_t home = tile_index_hash(entry->layer_id, entry->tile_id);
+
+        // Move the entry into the hole unless its home lies between the hole and it
+        if (((next - home) & (TILE_INDEX_SIZE - 1)) >= ((next - pos) & (TILE_INDEX_SIZE - 1))) {
+            tile_index[pos] = tile_index[next];
+            pos = next;
         }
-        
-        // Free the LRU tile data
-        if (tile_cache[lru_index].data != NULL) {
-            free(tile_cache[lru_index].data);
+        next = (next + 1) & (TILE_INDEX_SIZE - 1);
+    }
+
+    tile_index[pos] = TILE_INDEX_EMPTY;
+}
+
+// Smallest slot class that fits a tile, TILE_SLAB_CLASSES if none does
+uint8_t tile_slab_class(uint32_t size) {
+    uint8_t slab_class = 0;
+
+    while (slab_class < TILE_SLAB_CLASSES && (1u << (slab_class + TILE_SLAB_MIN_SHIFT)) < size) {
+        slab_class++;
+    }
+
+    return slab_class;
+}
+
+// Unlink a page from its class's partial list
+static void tile_slab_unlink(uint16_t page_id) {
+    TileSlabPage* page = &tile_slab_page_info[page_id];
+
+    if (page->prev != TILE_SLAB_NO_PAGE) {
+        tile_slab_page_info[page->prev].next = page->next;
+    } else {
+        tile_slab_partial[page->slab_class] = page->next;
+    }
+    if (page->next != TILE_SLAB_NO_PAGE) {
+        tile_slab_page_info[page->next].prev = page->prev;
+    }
+}
+
+// Put a page at the head of its class's partial list
+static void tile_slab_link(uint16_t page_id) {
+    TileSlabPage* page = &tile_slab_page_info[page_id];
+
+    page->prev = TILE_SLAB_NO_PAGE;
+    page->next = tile_slab_partial[page->slab_class];
+    if (page->next != TILE_SLAB_NO_PAGE) {
+        tile_slab_page_info[page->next].prev = page_id;
+    }
+    tile_slab_partial[page->slab_class] = page_id;
+}
+
+// Take a free slot of a class, giving it an empty page if it has none
+uint8_t* tile_slab_alloc(uint8_t slab_class) {
+    uint16_t page_id = tile_slab_partial[slab_class];
+
+    if (page_id == TILE_SLAB_NO_PAGE) {
+        if (tile_slab_empty_pages != TILE_SLAB_NO_PAGE) {
+            page_id = tile_slab_empty_pages;
+            tile_slab_empty_pages = tile_slab_page_info[page_id].next;
+        } else if (tile_slab_pages_used < tile_slab_pages) {
+            page_id = tile_slab_pages_used++;
+        } else {
+            return NULL;
         }
-        
-        // Use this slot
-        uint32_t slot = lru_index;
-        
-        // Allocate and store the new tile
-        tile_cache[slot].layer_id = layer_id;
-        tile_cache[slot].tile_id = tile_id;
-        tile_cache[slot].size = size;
-        tile_cache[slot].last_used = frame_counter;
-        
-        //tile_cache[slot].data = malloc(size);
-        tile_cache[slot].data = safe_malloc(size);
-        if (tile_cache[slot].data != NULL) {
-            memcpy(tile_cache[slot].data, data, size);
+
+        // Split the page into slots and thread them onto its free list
+        TileSlabPage* page = &tile_slab_page_info[page_id];
+        uint32_t slot_size = 1u << (slab_class + TILE_SLAB_MIN_SHIFT);
+        uint8_t* base = tile_slab_memory + page_id * TILE_SLAB_PAGE_SIZE;
+
+        page->free_slots = NULL;
+        for (uint32_t offset = 0; offset < TILE_SLAB_PAGE_SIZE; offset += slot_size) {
+            *(uint8_t**)(base + offset) = page->free_slots;
+            page->free_slots = base + offset;
         }
-    } else {
-        // Cache isn't full, use a new slot
-        uint32_t slot = tile_cache_count++;
-        
-        // Allocate and store the new tile
-        tile_cache[slot].layer_id = layer_id;
-        tile_cache[slot].tile_id = tile_id;
-        tile_cache[slot].size = size;
-        tile_cache[slot].last_used = frame_counter;
-        
-        //tile_cache[slot].data = malloc(size);
-        tile_cache[slot].data = safe_malloc(size);
-        if (tile_cache[slot].data != NULL) {
-            memcpy(tile_cache[slot].data, data, size);
+        page->slab_class = slab_class;
+        page->live = 0;
+        tile_slab_link(page_id);
+    }
+
+    TileSlabPage* page = &tile_slab_page_info[page_id];
+    uint8_t* slot = page->free_slots;
+    page->free_slots = *(uint8_t**)slot;
+    page->live++;
+
+    if (page->free_slots == NULL) {
+        tile_slab_unlink(page_id);
+    }
+
+    return slot;
+}
+
+// Return a slot to its page, and the page to the shared pool once it is empty
+void tile_slab_release(uint8_t* slot) {
+    uint16_t page_id = (slot - tile_slab_memory) / TILE_SLAB_PAGE_SIZE;
+    TileSlabPage* page = &tile_slab_page_info[page_id];
+    bool was_full = (page->free_slots == NULL);
+
+    *(uint8_t**)slot = page->free_slots;
+    page->free_slots = slot;
+    page->live--;
+
+    if (page->live == 0) {
+        if (!was_full) {
+            tile_slab_unlink(page_id);
+        }
+        page->next = tile_slab_empty_pages;
+        tile_slab_empty_pages = page_id;
+    } else if (was_full) {
+        tile_slab_link(page_id);
+    }
+}
+
+// Drop a cached tile and return its slot and entry
+void evict_tile_entry(uint16_t entry_id) {
+    TileCacheEntry* entry = &tile_cache[entry_id];
+
+    tile_index_remove(tile_index_find(entry->layer_id, entry->tile_id));
+    tile_slab_release(entry->data);
+
+    entry->in_use = false;
+    entry->data = NULL;
+    tile_free_entries[tile_free_entry_count++] = entry_id;
+    tile_cache_count--;
+    tile_cache_stats.evictions++;
+}
+
+// CLOCK eviction: the first unreferenced entry the hand reaches goes, whatever
+// its size class, so tiles that stopped being drawn age out the same way in
+// every class and their pages empty out for the sizes still in use.
+bool evict_tile_clock() {
+    // Two sweeps: the first may only clear reference bits
+    for (uint32_t step = 0; step < 2 * MAX_CACHED_TILES; step++) {
+        uint16_t entry_id = tile_clock_hand;
+        TileCacheEntry* entry = &tile_cache[entry_id];
+        tile_clock_hand = (tile_clock_hand + 1) % MAX_CACHED_TILES;
+
+        if (!entry->in_use) {
+            continue;
+        }
+
+        if (entry->referenced) {
+            entry->referenced = false;
+            continue;
+        }
+
+        evict_tile_entry(entry_id);
+        return true;
+    }
+
+    return false;
+}
+
+// Render-ready row masks, built once when pixels are loaded: a bit per row with no
+// opaque pixel, which drawing skips, and per row with no transparent pixel, which
+// drawing copies whole. 4bpp and 8bpp only, up to 64 rows; otherwise both stay 0
+// and every row takes the per-pixel path.
+void scan_pixel_rows(const uint8_t* data, uint16_t row_pixels, uint16_t rows, uint8_t bpp,
+                     uint64_t* empty_rows, uint64_t* opaque_rows) {
+    *empty_rows = 0;
+    *opaque_rows = 0;
+    if ((bpp != 4 && bpp != 8) || rows > 64) return;
+
+    uint32_t row_bytes = row_pixels * bpp / 8;
+
+    for (uint8_t row = 0; row < rows; row++) {
+        const uint8_t* src = data + row * row_bytes;
+        bool any = false;
+        bool all = true;
+
+        for (uint32_t i = 0; i < row_bytes; i++) {
+            uint8_t v = src[i];
+            any |= (v != 0);
+            all &= (bpp == 8) ? (v != 0) : ((v & 0xF0) != 0 && (v & 0x0F) != 0);
+        }
+
+        if (!any) {
+            *empty_rows |= 1ULL << row;
+        } else if (all) {
+            *opaque_rows |= 1ULL << row;
+        }
+    }
+}
+
+// A row's bit in a row mask. Rows the mask can't hold are neither empty nor
+// opaque, so they take the per-pixel path.
+static inline bool row_mask_test(uint64_t mask, int row) {
+    return row >= 0 && row < 64 && ((mask >> row) & 1);
+}
+
+// The bits of a 16-row tile mask that cover a tile's rows, 0 if it is taller
+static inline uint16_t tile_row_mask_all(uint8_t tile_height) {
+    return (tile_height <= 16) ? (uint16_t)((1u << tile_height) - 1) : 0;
+}
+
+// Drop a tile's mirrored copy once the pixels it was built from change
+void drop_tile_variant(uint8_t layer_id, uint16_t tile_id) {
+    uint16_t entry_id = tile_index[tile_index_find(layer_id | TILE_VARIANT_FLIP_X, tile_id)];
+    if (entry_id != TILE_INDEX_EMPTY) {
+        evict_tile_entry(entry_id);
+    }
+}
+
+// Set a cache entry's row masks from its pixels and its layer's tile geometry
+void scan_tile_entry(TileCacheEntry* entry) {
+    const Layer* layer = &layers[entry->layer_id & ~TILE_VARIANT_FLIP_X];
+    uint64_t empty_rows, opaque_rows;
+
+    scan_pixel_rows(entry->data, layer->tile_width, layer->tile_height, layer->bpp,
+                    &empty_rows, &opaque_rows);
+    entry->empty_rows = (layer->tile_height <= 16) ? empty_rows : 0;
+    entry->opaque_rows = (layer->tile_height <= 16) ? opaque_rows : 0;
+}
+
+void cache_tile(uint8_t layer_id, uint16_t tile_id, const uint8_t* data, uint32_t size) {
+    if (!(layer_id & TILE_VARIANT_FLIP_X)) {
+        drop_tile_variant(layer_id, tile_id);
+    }
+
+    uint8_t slab_class = tile_slab_class(size);
+    if (slab_class >= TILE_SLAB_CLASSES || tile_slab_memory == NULL) {
+        tile_cache_stats.failed_inserts++;
+        return;
+    }
+
+    // Already cached: replace the data in place if it still fits the slot
+    uint16_t pos = tile_index_find(layer_id, tile_id);
+    if (tile_index[pos] != TILE_INDEX_EMPTY) {
+        TileCacheEntry* entry = &tile_cache[tile_index[pos]];
+
+        if (entry->slab_class == slab_class) {
+            memcpy(entry->data, data, size);
+            entry->size = size;
+            entry->referenced = true;
+            scan_tile_entry(entry);
+            return;
+        }
+
+        // Tile geometry changed, re-insert it in the right class
+        evict_tile_entry(tile_index[pos]);
+    }
+
+    // Make sure there is a free entry
+    if (tile_free_entry_count == 0 && !evict_tile_clock()) {
+        tile_cache_stats.failed_inserts++;
+        return;
+    }
+
+    // Then a free slot of this class. Evicting a tile of the same class frees one
+    // at once; tiles of other classes go until one of their pages empties and
+    // returns to the shared pool.
+    uint8_t* slot = tile_slab_alloc(slab_class);
+    while (slot == NULL) {
+        if (!evict_tile_clock()) {
+            tile_cache_stats.failed_inserts++;
+            return;
         }
+        slot = tile_slab_alloc(slab_class);
     }
+
+    uint16_t entry_id = tile_free_entries[--tile_free_entry_count];
+    TileCacheEntry* entry = &tile_cache[entry_id];
+
+    entry->layer_id = layer_id;
+    entry->tile_id = tile_id;
+    entry->data = slot;
+    entry->size = size;
+    entry->slab_class = slab_class;
+    entry->in_use = true;
+    entry->referenced = true;
+    memcpy(slot, data, size);
+    scan_tile_entry(entry);
+
+    // Evictions above may have shifted the index, look the position up again
+    tile_index[tile_index_find(layer_id, tile_id)] = entry_id;
+    tile_cache_count++;
 }
 
 uint8_t* get_cached_tile(uint8_t layer_id, uint16_t tile_id) {
-    // Search cache for the requested tile
-    for (uint32_t i = 0; i < tile_cache_count; i++) {
-        if (tile_cache[i].layer_id == layer_id && tile_cache[i].tile_id == tile_id) {
-            // Tile found, update last used time and return the data
-            tile_cache[i].last_used = frame_counter;
-            return tile_cache[i].data;
+    uint16_t entry_id = tile_index[tile_index_find(layer_id, tile_id)];
+
+    if (entry_id == TILE_INDEX_EMPTY) {
+        // Not cached: fall back to the layer's tiles in flash, if any
+        Layer* layer = &layers[layer_id];
+        uint16_t flash_index = tile_id - layer->flash_tile_start;
+        if (layer->flash_tiles != NULL && flash_index < layer->flash_tile_count) {
+            uint32_t bytes_per_tile = (layer->tile_width * layer->tile_height * layer->bpp) / 8;
+            return (uint8_t*)layer->flash_tiles + flash_index * bytes_per_tile;
         }
+        
+        // Tile not found
+        tile_cache_stats.misses++;
+        return NULL;
     }
-    
-    // Tile not found
-    return NULL;
+
+    // Tile found, mark it recently used for the CLOCK hand
+    tile_cache[entry_id].referenced = true;
+    tile_cache_stats.hits++;
+    return tile_cache[entry_id].data;
+}
+
+// A tile as render_tile() draws it
+typedef struct {
+    const uint8_t* data;
+    uint16_t empty_rows;   // Rows to skip
+    uint16_t opaque_rows;  // Rows that can be copied whole
+    bool flipped_x;        // data is the mirrored copy, draw it unflipped
+} TileView;
+
+// Whether a cache entry's row masks were built for its layer's current tile format
+bool tile_masks_valid(const TileCacheEntry* entry) {
+    const Layer* layer = &layers[entry->layer_id & ~TILE_VARIANT_FLIP_X];
+
+    return layer->tile_height > 0 && layer->tile_height <= 16 &&
+           entry->size == (uint32_t)layer->tile_width * layer->tile_height * layer->bpp / 8;
+}
+
+// Whether every row of a cached 8bpp tile is either skipped or copied
+bool tile_rows_copyable(const TileCacheEntry* entry) {
+    const Layer* layer = &layers[entry->layer_id & ~TILE_VARIANT_FLIP_X];
+
+    return layer->bpp == 8 && tile_masks_valid(entry) &&
+           (entry->empty_rows | entry->opaque_rows) == tile_row_mask_all(layer->tile_height);
+}
+
+// Look a tile up for drawing. A mirrored tile whose rows are all copies gets a
+// pre-flipped copy in the cache the first time it is drawn, so it is copied as
+// well. Tiles read from flash keep their rows in place and are drawn unflipped.
+bool get_tile_view(uint8_t layer_id, uint16_t tile_id, bool flip_x, TileView* view) {
+    view->empty_rows = 0;
+    view->opaque_rows = 0;
+    view->flipped_x = false;
+
+    uint16_t entry_id = tile_index[tile_index_find(layer_id, tile_id)];
+    if (entry_id == TILE_INDEX_EMPTY) {
+        view->data = get_cached_tile(layer_id, tile_id);
+        if (view->data == NULL) return false;
+
+        // Read in place from flash, with the masks map_tileset() built
+        const Layer* layer = &layers[layer_id];
+        if (layer->flash_row_masks != NULL) {
+            uint16_t flash_index = tile_id - layer->flash_tile_start;
+            view->empty_rows = layer->flash_row_masks[flash_index * 2];
+            view->opaque_rows = layer->flash_row_masks[flash_index * 2 + 1];
+        }
+        return true;
+    }
+
+    TileCacheEntry* entry = &tile_cache[entry_id];
+    entry->referenced = true;
+    tile_cache_stats.hits++;
+
+    if (flip_x && tile_rows_copyable(entry)) {
+        uint8_t variant = layer_id | TILE_VARIANT_FLIP_X;
+        uint16_t variant_id = tile_index[tile_index_find(variant, tile_id)];
+
+        if (variant_id == TILE_INDEX_EMPTY) {
+            // Mirror each row, then cache the copy next to the original
+            uint8_t mirrored[1 << (TILE_SLAB_MIN_SHIFT + TILE_SLAB_CLASSES - 1)];
+            uint8_t width = layers[layer_id].tile_width;
+
+            for (uint32_t row = 0; row < entry->size; row += width) {
+                for (uint8_t x = 0; x < width; x++) {
+                    mirrored[row + x] = entry->data[row + width - 1 - x];
+                }
+            }
+
+            cache_tile(variant, tile_id, mirrored, entry->size);
+            variant_id = tile_index[tile_index_find(variant, tile_id)];
+
+            // Making room may have evicted the original
+            entry_id = tile_index[tile_index_find(layer_id, tile_id)];
+            if (entry_id == TILE_INDEX_EMPTY && variant_id == TILE_INDEX_EMPTY) {
+                view->data = NULL;
+                return false;
+            }
+            entry = (entry_id != TILE_INDEX_EMPTY) ? &tile_cache[entry_id] : NULL;
+        }
+
+        if (variant_id != TILE_INDEX_EMPTY) {
+            entry = &tile_cache[variant_id];
+            entry->referenced = true;
+            view->flipped_x = true;
+        }
+    }
+
+    view->data = entry->data;
+    if (tile_masks_valid(entry)) {
+        view->empty_rows = entry->empty_rows;
+        view->opaque_rows = entry->opaque_rows;
+    }
+    return true;
 }
 
+void render_tile(int x, int y, const TileView* tile, uint8_t attributes,
+                 uint8_t tile_width, uint8_t tile_height, uint8_t bpp, uint8_t layer_id);
+
 // Sprite System
 // Sprite pattern structure
+#define SPRITE_PRIORITIES 4          // Attribute bits 4-5
+#define SPRITE_LIST_END 0xFF
+
 typedef struct {
     uint8_t width;        // In 8-pixel units
     uint8_t height;       // In 8-pixel units
@@ -976,6 +2099,9 @@ typedef struct {
     uint32_t data_offset; // Offset into sprite data memory
     uint32_t data_size;   // Size in bytes
     bool in_use;          // Whether this pattern is in use
+    const uint8_t* flash_data; // Pixels in the asset pack, or NULL if in sprite memory
+    uint64_t empty_rows;  // Bit per row with no opaque pixel, from scan_pixel_rows()
+    uint64_t opaque_rows; // Bit per row with no transparent pixel
 } SpritePattern;
 
 // Sprite attributes structure
@@ -997,6 +2123,11 @@ typedef struct {
     uint8_t frame_counter;
     uint8_t loop_mode;    // 0=once, 1=loop, 2=ping-pong
     int8_t frame_dir;     // 1=forward, -1=reverse (for ping-pong)
+    
+    // Display list links: neighbouring sprite IDs, SPRITE_LIST_END at the ends
+    uint8_t list_prev;
+    uint8_t list_next;
+    uint8_t list_priority; // List the sprite is on, SPRITE_LIST_END if none
 } Sprite;
 
 // Global state
@@ -1006,8 +2137,101 @@ uint8_t* sprite_data;         // Memory for sprite pattern data
 uint32_t sprite_data_size;    // Total size of sprite data memory
 uint32_t sprite_data_used;    // Amount of sprite memory currently in use
 
-// Sprite rendering order (sorted by Y position or priority)
-uint8_t sprite_order[MAX_SPRITES];
+// Sprite display lists
+// Visible sprites sit on one intrusive list per priority, in draw order: by Y
+// in ORDER_BY_YPOS mode, otherwise by sprite ID. A sprite is relinked only when
+// its visibility, priority or (by Y) position changes, walking from where it
+// was, so keeping the render order costs the sprites that changed rather than
+// a sort of the whole table.
+uint8_t sprite_list_head[SPRITE_PRIORITIES];
+uint8_t sprite_list_tail[SPRITE_PRIORITIES];
+
+// Bit per sprite with a running animation (MAX_SPRITES is at most 64)
+uint64_t sprite_animated_mask = 0;
+
+// Whether sprite a is drawn before sprite b on the same list
+static inline bool sprite_list_before(uint8_t a, uint8_t b) {
+    if (sprite_order_mode == ORDER_BY_YPOS && sprites[a].y != sprites[b].y) {
+        return sprites[a].y < sprites[b].y;
+    }
+    return a < b;
+}
+
+void sprite_list_unlink(uint8_t sprite_id) {
+    Sprite* sprite = &sprites[sprite_id];
+    uint8_t list = sprite->list_priority;
+    if (list == SPRITE_LIST_END) return;
+    
+    if (sprite->list_prev != SPRITE_LIST_END) {
+        sprites[sprite->list_prev].list_next = sprite->list_next;
+    } else {
+        sprite_list_head[list] = sprite->list_next;
+    }
+    
+    if (sprite->list_next != SPRITE_LIST_END) {
+        sprites[sprite->list_next].list_prev = sprite->list_prev;
+    } else {
+        sprite_list_tail[list] = sprite->list_prev;
+    }
+    
+    sprite->list_priority = SPRITE_LIST_END;
+}
+
+// Put a sprite on the list for its current state, or take it off if hidden
+void update_sprite_list(uint8_t sprite_id) {
+    Sprite* sprite = &sprites[sprite_id];
+    uint8_t list = sprite->visible ? (sprite->attributes >> 4) & 0x03 : SPRITE_LIST_END;
+    
+    if (list == SPRITE_LIST_END) {
+        sprite_list_unlink(sprite_id);
+        return;
+    }
+    
+    // Search from the old position when it stays on the same list
+    uint8_t after;
+    if (sprite->list_priority == list) {
+        uint8_t prev = sprite->list_prev;
+        uint8_t next = sprite->list_next;
+        if ((prev == SPRITE_LIST_END || sprite_list_before(prev, sprite_id)) &&
+            (next == SPRITE_LIST_END || sprite_list_before(sprite_id, next))) {
+            return; // Still in order
+        }
+        sprite_list_unlink(sprite_id);
+        after = prev;
+    } else {
+        sprite_list_unlink(sprite_id);
+        after = sprite_list_tail[list];
+    }
+    
+    // Insertion sort step: back past sprites drawn later, then forward past earlier ones
+    while (after != SPRITE_LIST_END && !sprite_list_before(after, sprite_id)) {
+        after = sprites[after].list_prev;
+    }
+    uint8_t next = (after == SPRITE_LIST_END) ? sprite_list_head[list] : sprites[after].list_next;
+    while (next != SPRITE_LIST_END && sprite_list_before(next, sprite_id)) {
+        after = next;
+        next = sprites[next].list_next;
+    }
+    
+    sprite->list_prev = after;
+    sprite->list_next = next;
+    sprite->list_priority = list;
+    
+    if (after != SPRITE_LIST_END) {
+        sprites[after].list_next = sprite_id;
+    } else {
+        sprite_list_head[list] = sprite_id;
+    }
+    if (next != SPRITE_LIST_END) {
+        sprites[next].list_prev = sprite_id;
+    } else {
+        sprite_list_tail[list] = sprite_id;
+    }
+}
+
+static inline const uint8_t* sprite_pattern_data(const SpritePattern* pattern) {
+    return (pattern->flash_data != NULL) ? pattern->flash_data : sprite_data + pattern->data_offset;
+}
 
 void load_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height, 
                         uint8_t bpp, uint8_t compression, const uint8_t* data, uint32_t data_size) {
@@ -1071,7 +2295,7 @@ void load_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height,
     }
     
     // Free existing pattern if it was in use
-    if (sprite_patterns[pattern_id].in_use) {
+    if (sprite_patterns[pattern_id].in_use && sprite_patterns[pattern_id].flash_data == NULL) {
         // Recover space in sprite data memory
         sprite_data_used -= sprite_patterns[pattern_id].data_size;
     }
@@ -1089,6 +2313,9 @@ void load_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height,
     sprite_patterns[pattern_id].data_offset = offset;
     sprite_patterns[pattern_id].data_size = pattern_size;
     sprite_patterns[pattern_id].in_use = true;
+    sprite_patterns[pattern_id].flash_data = NULL;
+    scan_pixel_rows(sprite_data + offset, width * 8, height * 8, bpp,
+                    &sprite_patterns[pattern_id].empty_rows, &sprite_patterns[pattern_id].opaque_rows);
     
     // Update used memory
     sprite_data_used += pattern_size;
@@ -1101,6 +2328,134 @@ void load_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height,
     send_ack_to_cpu(CMD_LOAD_SPRITE_PATTERN);
 }
 
+// Cartridge asset pack
+// A game's static graphics can be written to the GPU's own flash as an asset
+// pack, laid out so tiles and sprite patterns are directly addressable
+// (4-byte aligned, stored in the same format LOAD_TILESET / LOAD_SPRITE_PATTERN
+// produce). The CPU then sends a descriptor instead of the pixels and the
+// renderer reads them in place through XIP, which leaves the tile cache and
+// sprite memory for data that changes at run time.
+// Pack header: [magic:4] [version:2] [entryCount:2] [packSize:4], little-endian.
+#define ASSET_PACK_FLASH_OFFSET 0x100000   // Past the firmware image
+#define ASSET_PACK_MAGIC 0x50414254        // "TBAP"
+
+const uint8_t* asset_pack = NULL;
+uint32_t asset_pack_size = 0;
+
+void init_asset_pack() {
+    const uint8_t* pack = (const uint8_t*)(XIP_BASE + ASSET_PACK_FLASH_OFFSET);
+    uint32_t magic = pack[0] | (pack[1] << 8) | (pack[2] << 16) | ((uint32_t)pack[3] << 24);
+    
+    if (magic == ASSET_PACK_MAGIC) {
+        asset_pack = pack;
+        asset_pack_size = pack[8] | (pack[9] << 8) | (pack[10] << 16) | ((uint32_t)pack[11] << 24);
+        printf("Asset pack found: %lu bytes\n", asset_pack_size);
+    } else {
+        asset_pack = NULL;
+        asset_pack_size = 0;
+    }
+}
+
+// Pack data at offset, or NULL if the range isn't inside the pack
+static const uint8_t* asset_pack_data(uint32_t offset, uint32_t size) {
+    if (asset_pack == NULL || (offset & 3) != 0 ||
+        offset > asset_pack_size || size > asset_pack_size - offset) {
+        return NULL;
+    }
+    return asset_pack + offset;
+}
+
+// Point a layer's tiles tile_start..tile_start+tile_count-1 at the pack.
+// Tiles loaded with LOAD_TILESET still take precedence. A count of 0 unmaps.
+void map_tileset(uint8_t layer_id, uint16_t tile_start, uint16_t tile_count, uint32_t pack_offset) {
+    if (layer_id >= MAX_LAYERS) {
+        send_error_to_cpu(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    Layer* layer = &layers[layer_id];
+    uint32_t bytes_per_tile = (layer->tile_width * layer->tile_height * layer->bpp) / 8;
+    const uint8_t* tiles = NULL;
+    
+    if (tile_count > 0) {
+        tiles = asset_pack_data(pack_offset, tile_count * bytes_per_tile);
+        if (tiles == NULL) {
+            send_error_to_cpu(ERROR_INVALID_PARAMETER);
+            return;
+        }
+    }
+    
+    layer->flash_tiles = tiles;
+    layer->flash_tile_start = tile_start;
+    layer->flash_tile_count = tile_count;
+
+    // Scan the mapped tiles' rows once here rather than on every draw. Without
+    // the memory for it, flash tiles are drawn pixel by pixel.
+    free(layer->flash_row_masks);
+    layer->flash_row_masks = NULL;
+    if (tile_count > 0 && layer->tile_height <= 16) {
+        layer->flash_row_masks = malloc(tile_count * 2 * sizeof(uint16_t));
+    }
+    if (layer->flash_row_masks != NULL) {
+        for (uint16_t i = 0; i < tile_count; i++) {
+            uint64_t empty_rows, opaque_rows;
+            scan_pixel_rows(tiles + i * bytes_per_tile, layer->tile_width, layer->tile_height,
+                            layer->bpp, &empty_rows, &opaque_rows);
+            layer->flash_row_masks[i * 2] = empty_rows;
+            layer->flash_row_masks[i * 2 + 1] = opaque_rows;
+        }
+    }
+
+    // Mirrored copies may have been built from the previously mapped tiles
+    for (uint16_t i = 0; i < MAX_CACHED_TILES; i++) {
+        if (tile_cache[i].in_use && tile_cache[i].layer_id == (layer_id | TILE_VARIANT_FLIP_X)) {
+            evict_tile_entry(i);
+        }
+    }
+    
+    // Mark the entire screen as dirty since tiles have changed
+    mark_rect_dirty(0, 0, display_width, display_height);
+    
+    send_ack_to_cpu(CMD_MAP_TILESET);
+}
+
+// Define a sprite pattern whose pixels stay in the pack
+void map_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height, uint8_t bpp,
+                        uint32_t pack_offset) {
+    if (pattern_id >= MAX_PATTERNS) {
+        send_error_to_cpu(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Same size rules as LOAD_SPRITE_PATTERN
+    uint32_t bytes_per_pixel = (bpp < 8) ? 1 : bpp / 8;
+    uint32_t pattern_size = width * 8 * height * 8 * bytes_per_pixel;
+    if (bpp == 4) pattern_size /= 2;
+    
+    const uint8_t* pixels = asset_pack_data(pack_offset, pattern_size);
+    if (pixels == NULL) {
+        send_error_to_cpu(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Release sprite memory held by the previous pattern
+    if (sprite_patterns[pattern_id].in_use && sprite_patterns[pattern_id].flash_data == NULL) {
+        sprite_data_used -= sprite_patterns[pattern_id].data_size;
+    }
+    
+    sprite_patterns[pattern_id].width = width;
+    sprite_patterns[pattern_id].height = height;
+    sprite_patterns[pattern_id].bpp = bpp;
+    sprite_patterns[pattern_id].data_offset = 0;
+    sprite_patterns[pattern_id].data_size = pattern_size;
+    sprite_patterns[pattern_id].in_use = true;
+    sprite_patterns[pattern_id].flash_data = pixels;
+    scan_pixel_rows(pixels, width * 8, height * 8, bpp,
+                    &sprite_patterns[pattern_id].empty_rows, &sprite_patterns[pattern_id].opaque_rows);
+    
+    send_ack_to_cpu(CMD_MAP_SPRITE_PATTERN);
+}
+
 void define_sprite(uint8_t sprite_id, uint8_t pattern_id, int16_t x, int16_t y,
                   uint8_t attributes, uint8_t palette_offset, uint8_t scale) {
     if (sprite_id >= MAX_SPRITES) {
@@ -1134,7 +2489,7 @@ void define_sprite(uint8_t sprite_id, uint8_t pattern_id, int16_t x, int16_t y,
     mark_sprite_area_dirty(sprite_id);
     
     // Update sprite rendering order
-    update_sprite_order();
+    update_sprite_list(sprite_id);
     
     send_ack_to_cpu(CMD_DEFINE_SPRITE);
 }
@@ -1157,45 +2512,196 @@ void move_sprite(uint8_t sprite_id, int16_t x, int16_t y) {
     
     // Update sprite order if needed
     if (sprite_order_mode == ORDER_BY_YPOS) {
-        update_sprite_order();
+        update_sprite_list(sprite_id);
     }
     
     send_ack_to_cpu(CMD_MOVE_SPRITE);
 }
 
-void animate_sprite(uint8_t sprite_id, uint8_t start_frame, uint8_t end_frame,
-                   uint8_t frame_rate, uint8_t loop_mode) {
-    if (sprite_id >= MAX_SPRITES || !sprites[sprite_id].visible) {
-        send_error_to_cpu(ERROR_INVALID_PARAMETER);
-        return;
+// Sprite batch field bits, shared with the CPU's shadow OAM
+#define BATCH_X          0x01
+#define BATCH_Y          0x02
+#define BATCH_PATTERN    0x04
+#define BATCH_ATTRIBUTES 0x08
+#define BATCH_PALETTE    0x10
+#define BATCH_SCALE      0x20
+#define BATCH_VISIBLE    0x40
+
+// Bytes of field data that follow a sprite's field mask
+static inline uint8_t sprite_batch_field_bytes(uint8_t fields) {
+    return ((fields & BATCH_X) ? 2 : 0) + ((fields & BATCH_Y) ? 2 : 0) +
+           ((fields & BATCH_PATTERN) ? 1 : 0) + ((fields & BATCH_ATTRIBUTES) ? 1 : 0) +
+           ((fields & BATCH_PALETTE) ? 1 : 0) + ((fields & BATCH_SCALE) ? 1 : 0) +
+           ((fields & BATCH_VISIBLE) ? 1 : 0);
+}
+
+// Check a whole batch before any of it is applied, so a bad one changes nothing
+static bool validate_sprite_batch(const uint8_t* data, uint8_t length) {
+    if (length < 6) return false;
+
+    uint8_t first = data[0];
+    uint32_t mask = ((uint32_t)data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+    uint16_t pos = 5;
+
+    for (int bit = 0; bit < 32; bit++) {
+        if (!(mask & (1u << bit))) continue;
+
+        if (first + bit >= MAX_SPRITES || pos >= length) return false;
+        pos += 1 + sprite_batch_field_bytes(data[pos]);
+        if (pos > length) return false;
     }
-    
-    // Configure animation
-    sprites[sprite_id].animated = true;
-    sprites[sprite_id].start_frame = start_frame;
-    sprites[sprite_id].end_frame = end_frame;
-    sprites[sprite_id].current_frame = start_frame;
-    sprites[sprite_id].frame_rate = frame_rate;
-    sprites[sprite_id].frame_counter = 0;
-    sprites[sprite_id].loop_mode = loop_mode;
-    sprites[sprite_id].frame_dir = 1;  // Start animation going forward
-    
-    // Mark sprite area as dirty
-    mark_sprite_area_dirty(sprite_id);
-    send_ack_to_cpu(CMD_ANIMATE_SPRITE);
+
+    if (pos >= length) return false;
+
+    uint8_t layer_mask = data[pos++];
+    for (int l = 0; l < 4; l++) {
+        if (layer_mask & (1 << l)) pos += 2;
+        if (layer_mask & (0x10 << l)) pos += 2;
+    }
+    return pos <= length;
 }
 
-void update_sprite_animations() {
-    // Process all sprite animations
-    for (int i = 0; i < MAX_SPRITES; i++) {
-        Sprite* sprite = &sprites[i];
-        
-        if (!sprite->visible || !sprite->animated) {
-            continue;
-        }
-        
-        // Increment frame counter
-        sprite->frame_counter++;
+// Apply one frame's worth of sprite and scroll deltas:
+// [first sprite][changed mask:4] then per set mask bit [field mask][fields...],
+// then [layer mask] (bit n = layer n X, bit n+4 = layer n Y) and the 2-byte values.
+// Every sprite is updated in place and only one ack is sent for the whole batch.
+void apply_sprite_batch(const uint8_t* data, uint8_t length) {
+    if (!validate_sprite_batch(data, length)) {
+        send_error_to_cpu(CMD_BATCH_SPRITE_UPDATE, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    uint8_t first = data[0];
+    uint32_t mask = ((uint32_t)data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+    uint8_t pos = 5;
+    bool bad_pattern = false;
+
+    for (int bit = 0; bit < 32; bit++) {
+        if (!(mask & (1u << bit))) continue;
+
+        uint8_t sprite_id = first + bit;
+        uint8_t fields = data[pos++];
+        Sprite* sprite = &sprites[sprite_id];
+        bool reorder = false;
+
+        // Old area; does nothing if the sprite was hidden
+        mark_sprite_area_dirty(sprite_id);
+
+        if (fields & BATCH_X) {
+            sprite->x = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+            if (sprite_order_mode == ORDER_BY_YPOS) reorder = true;
+        }
+        if (fields & BATCH_Y) {
+            sprite->y = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+            if (sprite_order_mode == ORDER_BY_YPOS) reorder = true;
+        }
+        if (fields & BATCH_PATTERN) {
+            uint8_t pattern_id = data[pos++];
+            if (pattern_id < MAX_PATTERNS && sprite_patterns[pattern_id].in_use) {
+                sprite->pattern_id = pattern_id;
+            } else {
+                bad_pattern = true;
+            }
+        }
+        if (fields & BATCH_ATTRIBUTES) {
+            sprite->attributes = data[pos++];
+            reorder = true;
+        }
+        if (fields & BATCH_PALETTE) sprite->palette_offset = data[pos++];
+        if (fields & BATCH_SCALE) sprite->scale = data[pos++];
+        if (fields & BATCH_VISIBLE) {
+            bool visible = data[pos++] != 0;
+            if (visible && !sprite->visible) sprite->animated = false;
+            sprite->visible = visible;
+            reorder = true;
+        }
+
+        // A sprite that was never given a valid pattern stays hidden
+        if (sprite->visible && (sprite->pattern_id >= MAX_PATTERNS ||
+                                !sprite_patterns[sprite->pattern_id].in_use)) {
+            sprite->visible = false;
+            bad_pattern = true;
+            reorder = true;
+        }
+
+        if (reorder) {
+            update_sprite_list(sprite_id);
+        }
+
+        // New area
+        mark_sprite_area_dirty(sprite_id);
+    }
+
+    uint8_t layer_mask = data[pos++];
+    for (int l = 0; l < MAX_LAYERS && l < 4; l++) {
+        uint16_t scroll_x = layers[l].scroll_x;
+        uint16_t scroll_y = layers[l].scroll_y;
+
+        if (layer_mask & (1 << l)) {
+            scroll_x = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+        }
+        if (layer_mask & (0x10 << l)) {
+            scroll_y = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+        }
+
+        if (layer_mask & (0x11 << l)) {
+            update_layer_scroll(l, scroll_x, scroll_y);
+        }
+    }
+
+    if (bad_pattern) {
+        send_error_to_cpu(CMD_BATCH_SPRITE_UPDATE, ERR_INVALID_DATA);
+    } else {
+        send_ack_to_cpu(CMD_BATCH_SPRITE_UPDATE);
+    }
+}
+
+void animate_sprite(uint8_t sprite_id, uint8_t start_frame, uint8_t end_frame,
+                   uint8_t frame_rate, uint8_t loop_mode) {
+    if (sprite_id >= MAX_SPRITES || !sprites[sprite_id].visible) {
+        send_error_to_cpu(ERROR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Frames per second; the tick divides 60 by it
+    if (frame_rate == 0) {
+        send_error_to_cpu(CMD_ANIMATE_SPRITE, ERR_INVALID_PARAMETER);
+        return;
+    }
+    
+    // Configure animation
+    sprites[sprite_id].animated = true;
+    sprites[sprite_id].start_frame = start_frame;
+    sprites[sprite_id].end_frame = end_frame;
+    sprites[sprite_id].current_frame = start_frame;
+    sprites[sprite_id].frame_rate = frame_rate;
+    sprites[sprite_id].frame_counter = 0;
+    sprites[sprite_id].loop_mode = loop_mode;
+    sprites[sprite_id].frame_dir = 1;  // Start animation going forward
+    sprite_animated_mask |= 1ULL << sprite_id;
+    
+    // Mark sprite area as dirty
+    mark_sprite_area_dirty(sprite_id);
+    send_ack_to_cpu(CMD_ANIMATE_SPRITE);
+}
+
+// Advance running animations by one 60Hz tick, visiting only animated sprites
+void update_sprite_animations() {
+    for (uint64_t pending = sprite_animated_mask; pending != 0; pending &= pending - 1) {
+        int i = __builtin_ctzll(pending);
+        Sprite* sprite = &sprites[i];
+        
+        if (!sprite->visible || !sprite->animated) {
+            sprite_animated_mask &= ~(1ULL << i);
+            continue;
+        }
+        
+        // Increment frame counter
+        sprite->frame_counter++;
         
         // Check if it's time for a new frame
         if (sprite->frame_counter >= (60 / sprite->frame_rate)) {
@@ -1250,54 +2756,19 @@ void update_sprite_animations() {
     }
 }
 
+// Rebuild every display list, after a reset or a change of ordering mode
 void update_sprite_order() {
-    // Initialize the order array
+    for (int p = 0; p < SPRITE_PRIORITIES; p++) {
+        sprite_list_head[p] = SPRITE_LIST_END;
+        sprite_list_tail[p] = SPRITE_LIST_END;
+    }
+    
     for (int i = 0; i < MAX_SPRITES; i++) {
-        sprite_order[i] = i;
+        sprites[i].list_priority = SPRITE_LIST_END;
     }
     
-    // Sort sprites based on the current ordering mode
-    if (sprite_order_mode == ORDER_BY_YPOS) {
-        // Sort by Y position (bubble sort for simplicity)
-        for (int i = 0; i < MAX_SPRITES - 1; i++) {
-            for (int j = 0; j < MAX_SPRITES - i - 1; j++) {
-                if (!sprites[sprite_order[j]].visible) {
-                    // Move invisible sprites to the end
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                } else if (sprites[sprite_order[j]].visible && 
-                           sprites[sprite_order[j + 1]].visible &&
-                           sprites[sprite_order[j]].y > sprites[sprite_order[j + 1]].y) {
-                    // Swap if y position is greater
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                }
-            }
-        }
-    } else {
-        // Sort by priority (attribute bits 4-5)
-        for (int i = 0; i < MAX_SPRITES - 1; i++) {
-            for (int j = 0; j < MAX_SPRITES - i - 1; j++) {
-                uint8_t prio_j = (sprites[sprite_order[j]].attributes >> 4) & 0x03;
-                uint8_t prio_j1 = (sprites[sprite_order[j + 1]].attributes >> 4) & 0x03;
-                
-                if (!sprites[sprite_order[j]].visible) {
-                    // Move invisible sprites to the end
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                } else if (sprites[sprite_order[j]].visible && 
-                           sprites[sprite_order[j + 1]].visible &&
-                           prio_j > prio_j1) {
-                    // Swap if priority is higher (lower value = higher priority)
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                }
-            }
-        }
+    for (int i = 0; i < MAX_SPRITES; i++) {
+        update_sprite_list(i);
     }
 }
 
@@ -1359,7 +2830,9 @@ void garbage_collect_sprite_memory() {
     for (int i = 0; i < MAX_PATTERNS; i++) {
         if (sprite_patterns[i].in_use && !pattern_used[i]) {
             sprite_patterns[i].in_use = false;
-            sprite_data_used -= sprite_patterns[i].data_size;
+            if (sprite_patterns[i].flash_data == NULL) {
+                sprite_data_used -= sprite_patterns[i].data_size;
+            }
         }
     }
     
@@ -1381,7 +2854,7 @@ void compact_sprite_memory() {
     uint32_t current_offset = 0;
     
     for (int i = 0; i < MAX_PATTERNS; i++) {
-        if (sprite_patterns[i].in_use) {
+        if (sprite_patterns[i].in_use && sprite_patterns[i].flash_data == NULL) {
             // Copy pattern data to temporary buffer
             memcpy(temp_buffer + current_offset, 
                    sprite_data + sprite_patterns[i].data_offset, 
@@ -1418,8 +2891,34 @@ struct {
     uint8_t window_layer_mask[2];
     
     uint8_t color_math_mode; // 0=add, 1=subtract, 2=average
+
+    // Flash towards a color, fading back out over flash_frames
+    uint8_t flash_r;
+    uint8_t flash_g;
+    uint8_t flash_b;
+    uint8_t flash_frames;
+    uint8_t flash_remaining; // 0=off
+
+    bool color_lut_enabled;
 } effects;
 
+// Fade (8bpp), flash, the color LUT and palette cycling never touch pixels.
+// They are folded into the scan-out palette, rebuilt at most once per frame.
+#define MAX_PALETTE_CYCLES 4
+
+typedef struct {
+    uint8_t start;
+    uint8_t count;
+    uint8_t frames_per_step; // 0=off
+    uint8_t timer;
+    uint8_t phase;
+} PaletteCycle;
+
+PaletteCycle palette_cycles[MAX_PALETTE_CYCLES];
+
+// Per-channel output level for each input level (APPLY_LUT)
+uint8_t color_lut[3][256];
+
 void set_fade(uint8_t mode, uint8_t level) {
     effects.fade_mode = mode;
     effects.fade_level = level;
@@ -1431,14 +2930,78 @@ void set_fade(uint8_t mode, uint8_t level) {
 }
 
 void set_mosaic_effect(uint8_t size) {
+    if (size > 15) {
+        send_error_to_cpu(CMD_MOSAIC_EFFECT, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    // Applied as the scan-out fetches pixels, which always sends whole frames
+    // while it is on, so only turning it off needs a redraw
     effects.mosaic_size = size;
-    
-    // Mark entire screen dirty
     mark_rect_dirty(0, 0, display_width, display_height);
     
     send_ack_to_cpu(CMD_MOSAIC_EFFECT);
 }
 
+void set_flash_screen(uint8_t r, uint8_t g, uint8_t b, uint8_t frames) {
+    effects.flash_r = r;
+    effects.flash_g = g;
+    effects.flash_b = b;
+    effects.flash_frames = frames;
+    effects.flash_remaining = frames;
+    palette_lut_dirty = true;
+
+    send_ack_to_cpu(CMD_FLASH_SCREEN);
+}
+
+// Load part of one channel's color LUT; channel 0xFF turns the LUT off
+void apply_color_lut(uint8_t channel, uint8_t start, uint8_t count, const uint8_t* levels) {
+    if (channel == 0xFF) {
+        effects.color_lut_enabled = false;
+        palette_lut_dirty = true;
+        send_ack_to_cpu(CMD_APPLY_LUT);
+        return;
+    }
+
+    if (channel > 2 || start + count > 256) {
+        send_error_to_cpu(CMD_APPLY_LUT, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    // Start from identity so a partly loaded LUT leaves other levels alone
+    if (!effects.color_lut_enabled) {
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < 256; i++) {
+                color_lut[c][i] = i;
+            }
+        }
+        effects.color_lut_enabled = true;
+    }
+
+    memcpy(&color_lut[channel][start], levels, count);
+    palette_lut_dirty = true;
+
+    send_ack_to_cpu(CMD_APPLY_LUT);
+}
+
+// Rotate palette entries [start, start + count) by one every frames_per_step frames
+void set_palette_cycle(uint8_t slot, uint8_t start, uint8_t count, uint8_t frames_per_step) {
+    if (slot >= MAX_PALETTE_CYCLES || start + count > 256) {
+        send_error_to_cpu(CMD_CYCLE_PALETTE, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    PaletteCycle* cycle = &palette_cycles[slot];
+    cycle->start = start;
+    cycle->count = count;
+    cycle->frames_per_step = frames_per_step;
+    cycle->timer = 0;
+    cycle->phase = 0;
+    palette_lut_dirty = true;
+
+    send_ack_to_cpu(CMD_CYCLE_PALETTE);
+}
+
 void set_window(uint8_t window_id, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t layer_mask) {
     if (window_id >= 2) {
         send_error_to_cpu(ERROR_INVALID_PARAMETER);
@@ -1496,6 +3059,17 @@ void set_rotation_zoom(uint8_t layer_id, uint16_t angle, uint16_t scale_x, uint1
     layers[layer_id].matrix[1] = -sin_a * sx; // b
     layers[layer_id].matrix[2] = sin_a * sy;  // c
     layers[layer_id].matrix[3] = cos_a * sy;  // d
+
+    for (int i = 0; i < 4; i++) {
+        layers[layer_id].affine[i] = (int32_t)(layers[layer_id].matrix[i] * 65536.0f);
+    }
+
+    // A new transform replaces any per-line table
+    if (layers[layer_id].affine_lines != NULL) {
+        free(layers[layer_id].affine_lines);
+        layers[layer_id].affine_lines = NULL;
+        layers[layer_id].affine_line_count = 0;
+    }
     
     // Set center of rotation to center of screen
     layers[layer_id].rot_center_x = display_width / 2;
@@ -1507,44 +3081,53 @@ void set_rotation_zoom(uint8_t layer_id, uint16_t angle, uint16_t scale_x, uint1
     send_ack_to_cpu(CMD_ROTATION_ZOOM_BACKGROUND);
 }
 
-// Apply fade effect to the framebuffer
+// Load part of a layer's per-line matrix table. Each line is a, b, c, d in
+// signed 8.8; lines never loaded keep the matrix set by ROTATION_ZOOM_BACKGROUND.
+// A table changing the scale per line gives a Mode 7 style perspective floor.
+void set_rotation_line_table(uint8_t layer_id, uint16_t start_line, uint8_t count, const uint8_t* data) {
+    if (layer_id >= MAX_LAYERS || start_line + count > display_height) {
+        send_error_to_cpu(CMD_ROTATION_LINE_TABLE, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    Layer* layer = &layers[layer_id];
+
+    if (layer->affine_lines == NULL) {
+        layer->affine_lines = safe_malloc(display_height * 4 * sizeof(int16_t));
+        if (layer->affine_lines == NULL) {
+            send_error_to_cpu(CMD_ROTATION_LINE_TABLE, ERR_OUT_OF_MEMORY);
+            return;
+        }
+
+        for (uint16_t line = 0; line < display_height; line++) {
+            for (int i = 0; i < 4; i++) {
+                layer->affine_lines[line * 4 + i] = layer->affine[i] >> 8;
+            }
+        }
+        layer->affine_line_count = display_height;
+    }
+
+    for (uint16_t n = 0; n < count; n++) {
+        for (int i = 0; i < 4; i++) {
+            layer->affine_lines[(start_line + n) * 4 + i] =
+                (int16_t)((data[n * 8 + i * 2] << 8) | data[n * 8 + i * 2 + 1]);
+        }
+    }
+
+    mark_rect_dirty(0, 0, display_width, display_height);
+
+    send_ack_to_cpu(CMD_ROTATION_LINE_TABLE);
+}
+
+// Apply fade effect to a 16bpp render target.
+// 8bpp frames fade through the scan-out palette instead.
 void apply_fade_effect(uint8_t* buffer, uint32_t size) {
     uint8_t fade_level = effects.fade_level;
     if (fade_level == 0) return; // No fade
     
     bool fade_out = (effects.fade_mode == 1);
     
-    // For 8-bit paletted mode
-    if (display_bpp == 8) {
-        // Process each pixel
-        for (uint32_t i = 0; i < size; i++) {
-            uint8_t pixel = buffer[i];
-            
-            // Skip transparent pixels (usually index 0)
-            if (pixel == 0) continue;
-            
-            // Get RGB color from palette
-            uint8_t r = palette[pixel].r;
-            uint8_t g = palette[pixel].g;
-            uint8_t b = palette[pixel].b;
-            
-            // Apply fade
-            if (fade_out) {
-                // Fade to black
-                r = r * (255 - fade_level) / 255;
-                g = g * (255 - fade_level) / 255;
-                b = b * (255 - fade_level) / 255;
-            } else {
-                // Fade from black
-                r = r * fade_level / 255;
-                g = g * fade_level / 255;
-                b = b * fade_level / 255;
-            }
-            
-            // Find closest palette entry
-            buffer[i] = find_nearest_color(r, g, b);
-        }
-    } else if (display_bpp == 16) {
+    if (display_bpp == 16) {
         // For 16-bit RGB565 mode
         uint16_t* rgb_buffer = (uint16_t*)buffer;
         size /= 2; // 16-bit values
@@ -1589,71 +3172,6 @@ void apply_fade_effect(uint8_t* buffer, uint32_t size) {
     }
 }
 
-// Apply mosaic effect
-void apply_mosaic_effect(uint8_t* buffer, uint32_t width, uint32_t height) {
-    if (effects.mosaic_size <= 1) return; // No effect
-    
-    uint8_t size = effects.mosaic_size;
-    
-    // For 8-bit paletted mode
-    if (display_bpp == 8) {
-        // Create a temporary buffer for the result
-        //uint8_t* temp = malloc(width * height);
-        uint8_t* temp = safe_malloc(width * height);
-        if (temp == NULL) return; // Not enough memory
-        
-        // Copy input buffer
-        memcpy(temp, buffer, width * height);
-        
-        // Process each mosaic block
-        for (uint32_t y = 0; y < height; y += size) {
-            for (uint32_t x = 0; x < width; x += size) {
-                // Get the top-left pixel of the block
-                uint8_t pixel = buffer[y * width + x];
-                
-                // Fill the whole block with this pixel
-                for (uint32_t by = 0; by < size && y + by < height; by++) {
-                    for (uint32_t bx = 0; bx < size && x + bx < width; bx++) {
-                        temp[(y + by) * width + (x + bx)] = pixel;
-                    }
-                }
-            }
-        }
-        
-        // Copy result back to original buffer
-        memcpy(buffer, temp, width * height);
-        free(temp);
-    } else if (display_bpp == 16) {
-        // For 16-bit RGB565 mode
-        uint16_t* rgb_buffer = (uint16_t*)buffer;
-        
-        // Create a temporary buffer
-        uint16_t* temp = malloc(width * height * 2);
-        if (temp == NULL) return;
-        
-        memcpy(temp, rgb_buffer, width * height * 2);
-        
-        // Process each mosaic block
-        for (uint32_t y = 0; y < height; y += size) {
-            for (uint32_t x = 0; x < width; x += size) {
-                // Get the top-left pixel of the block
-                uint16_t pixel = rgb_buffer[y * width + x];
-                
-                // Fill the whole block with this pixel
-                for (uint32_t by = 0; by < size && y + by < height; by++) {
-                    for (uint32_t bx = 0; bx < size && x + bx < width; bx++) {
-                        temp[(y + by) * width + (x + bx)] = pixel;
-                    }
-                }
-            }
-        }
-        
-        // Copy result back
-        memcpy(rgb_buffer, temp, width * height * 2);
-        free(temp);
-    }
-}
-
 // Check if a pixel is inside a window
 bool is_in_window(uint8_t x, uint8_t y, uint8_t layer_id) {
     for (int w = 0; w < 2; w++) {
@@ -1681,117 +3199,396 @@ typedef struct {
     uint16_t height;
 } Rect;
 
+// Damage is tracked per 8x8 tile, one bitmap word per tile row. At the start
+// of a frame core 1 turns the bitmap into a few disjoint rectangles, which bound
+// both the layer redraw and the part of the framebuffer sent to the display.
+#define DAMAGE_TILE_SHIFT 3
+#define DAMAGE_ROWS (MAX_DISPLAY_HEIGHT >> DAMAGE_TILE_SHIFT)
+#define DAMAGE_FULL_FRAME_PERCENT 60   // Send the whole frame above this tile coverage
+
+uint64_t damage_rows[DAMAGE_ROWS];
+spin_lock_t* damage_lock = NULL;
+
+// This frame's damage, disjoint rectangles
 Rect dirty_regions[MAX_DIRTY_REGIONS];
 uint8_t dirty_region_count = 0;
 
-void mark_rect_dirty(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+// With several present buffers the one composed next last held the frame from
+// present_history_depth frames ago. It is redrawn wherever those frames changed,
+// while only this frame's own damage is sent to the display.
+uint64_t damage_history[PRESENT_MAX_BUFFERS - 1][DAMAGE_ROWS];
+uint8_t present_history_depth = 0;
+Rect scanout_regions[MAX_DIRTY_REGIONS];
+uint8_t scanout_region_count = 0;
+
+void mark_rect_dirty(int x, int y, int width, int height) {
     // Clip rectangle to screen bounds
-    if (x >= display_width) return;
-    if (y >= display_height) return;
-    
-    if (x + width > display_width) width = display_width - x;
-    if (y + height > display_height) height = display_height - y;
-    
-    // Check if we can merge with an existing dirty region
-    for (int i = 0; i < dirty_region_count; i++) {
-        Rect* r = &dirty_regions[i];
-        
-        // Calculate rectangle bounds
-        uint16_t r1_x1 = r->x;
-        uint16_t r1_y1 = r->y;
-        uint16_t r1_x2 = r->x + r->width;
-        uint16_t r1_y2 = r->y + r->height;
-        
-        uint16_t r2_x1 = x;
-        uint16_t r2_y1 = y;
-        uint16_t r2_x2 = x + width;
-        uint16_t r2_y2 = y + height;
-        
-        // Check if rectangles are adjacent or overlapping
-        if (!(r1_x2 < r2_x1 || r2_x2 < r1_x1 || r1_y2 < r2_y1 || r2_y2 < r1_y1)) {
-            // Merge rectangles by creating a new bounding rectangle
-            uint16_t new_x1 = min(r1_x1, r2_x1);
-            uint16_t new_y1 = min(r1_y1, r2_y1);
-            uint16_t new_x2 = max(r1_x2, r2_x2);
-            uint16_t new_y2 = max(r1_y2, r2_y2);
-            
-            r->x = new_x1;
-            r->y = new_y1;
-            r->width = new_x2 - new_x1;
-            r->height = new_y2 - new_y1;
-            
-            // If the merged region is too large, just mark the whole screen
-            if (r->width * r->height > (display_width * display_height) / 2) {
-                dirty_regions[0].x = 0;
-                dirty_regions[0].y = 0;
-                dirty_regions[0].width = display_width;
-                dirty_regions[0].height = display_height;
-                dirty_region_count = 1;
+    int x_end = min(x + width, (int)display_width);
+    int y_end = min(y + height, (int)display_height);
+    x = max(x, 0);
+    y = max(y, 0);
+    if (x >= x_end || y >= y_end) return;
+
+    int first_col = x >> DAMAGE_TILE_SHIFT;
+    int last_col = (x_end - 1) >> DAMAGE_TILE_SHIFT;
+    uint64_t cols = (~0ULL >> (63 - (last_col - first_col))) << first_col;
+
+    uint32_t irq = spin_lock_blocking(damage_lock);
+    for (int row = y >> DAMAGE_TILE_SHIFT; row <= (y_end - 1) >> DAMAGE_TILE_SHIFT; row++) {
+        damage_rows[row] |= cols;
+    }
+    spin_unlock(damage_lock, irq);
+}
+
+// Coalesce a damage bitmap into disjoint regions and return how many there are.
+// Runs of damaged tiles are merged with an identical run on the row above, so a
+// rectangle of damage becomes one region. Too many regions or high coverage
+// fall back to the full screen, where one window is cheaper than many.
+uint8_t build_dirty_regions(const uint64_t* damage, Rect* regions) {
+    int cols = (display_width + (1 << DAMAGE_TILE_SHIFT) - 1) >> DAMAGE_TILE_SHIFT;
+    int rows = (display_height + (1 << DAMAGE_TILE_SHIFT) - 1) >> DAMAGE_TILE_SHIFT;
+
+    // Regions are built in tile units and scaled to pixels at the end
+    uint32_t damaged_tiles = 0;
+    bool full_frame = false;
+    uint8_t region_count = 0;
+
+    for (int row = 0; row < rows && !full_frame; row++) {
+        uint64_t bits = damage[row];
+        damaged_tiles += __builtin_popcountll(bits);
+
+        while (bits != 0) {
+            int start = __builtin_ctzll(bits);
+            int run = __builtin_ctzll(~(bits >> start));
+            bits &= ~((~0ULL >> (64 - run)) << start);
+
+            // Extend a region that ended on the row above with the same columns
+            bool merged = false;
+            for (int i = 0; i < region_count; i++) {
+                Rect* r = &regions[i];
+                if (r->x == start && r->width == run && r->y + r->height == row) {
+                    r->height++;
+                    merged = true;
+                    break;
+                }
             }
-            
-            return;
+
+            if (merged) continue;
+
+            if (region_count == MAX_DIRTY_REGIONS) {
+                full_frame = true;
+                break;
+            }
+
+            Rect* r = &regions[region_count++];
+            r->x = start;
+            r->y = row;
+            r->width = run;
+            r->height = 1;
         }
     }
-    
-    // Add as a new dirty region if we have space
-    if (dirty_region_count < MAX_DIRTY_REGIONS) {
-        Rect* r = &dirty_regions[dirty_region_count++];
-        r->x = x;
-        r->y = y;
-        r->width = width;
-        r->height = height;
+
+    if (full_frame || damaged_tiles * 100 >= (uint32_t)(cols * rows) * DAMAGE_FULL_FRAME_PERCENT) {
+        regions[0].x = 0;
+        regions[0].y = 0;
+        regions[0].width = display_width;
+        regions[0].height = display_height;
+        return 1;
+    }
+
+    for (int i = 0; i < region_count; i++) {
+        Rect* r = &regions[i];
+        r->x <<= DAMAGE_TILE_SHIFT;
+        r->y <<= DAMAGE_TILE_SHIFT;
+        r->width = min(r->width << DAMAGE_TILE_SHIFT, display_width - r->x);
+        r->height = min(r->height << DAMAGE_TILE_SHIFT, display_height - r->y);
+    }
+
+    return region_count;
+}
+
+// Take the damage marked since the last frame: dirty_regions is what the buffer
+// about to be composed has to redraw, scanout_regions what the display has to get
+void collect_dirty_regions() {
+    int rows = (display_height + (1 << DAMAGE_TILE_SHIFT) - 1) >> DAMAGE_TILE_SHIFT;
+    uint64_t damage[DAMAGE_ROWS];
+    uint64_t redraw[DAMAGE_ROWS];
+
+    uint32_t irq = spin_lock_blocking(damage_lock);
+    for (int row = 0; row < rows; row++) {
+        damage[row] = damage_rows[row];
+        damage_rows[row] = 0;
+    }
+    spin_unlock(damage_lock, irq);
+
+    for (int row = 0; row < rows; row++) {
+        redraw[row] = damage[row];
+        for (int h = 0; h < present_history_depth; h++) {
+            redraw[row] |= damage_history[h][row];
+        }
+    }
+
+    // Age the history by one frame
+    for (int h = present_history_depth - 1; h > 0; h--) {
+        memcpy(damage_history[h], damage_history[h - 1], rows * sizeof(uint64_t));
+    }
+    if (present_history_depth > 0) {
+        memcpy(damage_history[0], damage, rows * sizeof(uint64_t));
+    }
+
+    dirty_region_count = build_dirty_regions(redraw, dirty_regions);
+    if (present_history_depth == 0) {
+        memcpy(scanout_regions, dirty_regions, dirty_region_count * sizeof(Rect));
+        scanout_region_count = dirty_region_count;
     } else {
-        // Too many regions, just mark the whole screen
-        dirty_regions[0].x = 0;
-        dirty_regions[0].y = 0;
-        dirty_regions[0].width = display_width;
-        dirty_regions[0].height = display_height;
-        dirty_region_count = 1;
+        scanout_region_count = build_dirty_regions(damage, scanout_regions);
     }
 }
 
 void clear_dirty_regions() {
+    uint32_t irq = spin_lock_blocking(damage_lock);
+    memset(damage_rows, 0, sizeof(damage_rows));
+    spin_unlock(damage_lock, irq);
+
+    memset(damage_history, 0, sizeof(damage_history));
     dirty_region_count = 0;
+    scanout_region_count = 0;
 }
 
-// Render a normal (non-rotated) layer
-void render_layer(uint8_t layer_id, bool clip_to_dirty) {
-    Layer* layer = &layers[layer_id];
-    
-    if (!layer->enabled) return;
-    
-    // Get layer properties
-    uint8_t tile_width = layer->tile_width;
-    uint8_t tile_height = layer->tile_height;
-    uint16_t scroll_x = layer->scroll_x;
-    uint16_t scroll_y = layer->scroll_y;
-    
-    // Determine regions to render
-    if (clip_to_dirty) {
-        // Only render dirty regions
-        for (int dr = 0; dr < dirty_region_count; dr++) {
-            Rect* region = &dirty_regions[dr];
-            
-            // Calculate tile range for this region
-            int start_tile_x = (region->x + scroll_x) / tile_width;
-            int start_tile_y = (region->y + scroll_y) / tile_height;
-            int end_tile_x = ((region->x + region->width + scroll_x) / tile_width) + 1;
-            int end_tile_y = ((region->y + region->height + scroll_y) / tile_height) + 1;
-            
-            // Render tiles in this region
-            render_layer_region(layer_id, start_tile_x, start_tile_y, end_tile_x, end_tile_y);
-        }
+// Render target
+// Renderers write screen lines [render_y_start, render_y_end) into render_buffer.
+// In framebuffer mode that is the whole screen; the line renderer points it at one
+// line group at a time.
+uint8_t* render_buffer = NULL;
+int16_t render_y_start = 0;
+int16_t render_y_end = 240;
+
+// Sprites binned to each line group in display list order, priority by priority;
+// group_priority_end[g][p] is where priority p's run ends
+uint8_t group_sprites[MAX_DISPLAY_HEIGHT / LINE_GROUP_HEIGHT][MAX_SPRITES_PER_GROUP];
+uint8_t group_sprite_count[MAX_DISPLAY_HEIGHT / LINE_GROUP_HEIGHT];
+uint8_t group_priority_end[MAX_DISPLAY_HEIGHT / LINE_GROUP_HEIGHT][SPRITE_PRIORITIES];
+int16_t current_line_group = -1; // -1 when rendering a whole frame
+
+void set_render_target(uint8_t* buffer, int16_t y_start, int16_t y_end) {
+    render_buffer = buffer;
+    render_y_start = y_start;
+    render_y_end = y_end;
+}
+
+// Write a palette index; 16bpp targets store its RGB565 value from the palette LUT
+void write_index_pixel(int x, int y, uint8_t index) {
+    uint32_t pos = (y - render_y_start) * display_width + x;
+
+    if (display_bpp == 16) {
+        ((uint16_t*)render_buffer)[pos] = palette_rgb565[index];
     } else {
-        // Render the entire visible layer
-        int start_tile_x = scroll_x / tile_width;
-        int start_tile_y = scroll_y / tile_height;
-        int end_tile_x = ((display_width + scroll_x) / tile_width) + 1;
-        int end_tile_y = ((display_height + scroll_y) / tile_height) + 1;
-        
-        render_layer_region(layer_id, start_tile_x, start_tile_y, end_tile_x, end_tile_y);
+        render_buffer[pos] = index;
     }
 }
 
+// Write a direct RGB565 pixel
+void write_rgb_pixel(int x, int y, uint16_t color) {
+    ((uint16_t*)render_buffer)[(y - render_y_start) * display_width + x] = color;
+}
+
+// Tile blitter
+// Opaque 8bpp tile rows are copied into the render target by DMA instead of going
+// through the per-pixel loop. A control channel feeds the data channel one block per
+// tile row (control, read address, write address, count) from a list that core 1
+// fills while the previous list is being copied, so building the next list and
+// drawing the tiles that still need the CPU (transparent or mirrored ones) overlap
+// the copy. The sub-tile part of the scroll is only the blocks' start addresses.
+// Layers the blitter can't draw stay on the CPU: 16bpp targets (colors come from the
+// LUT), 4bpp tiles, line/column scroll, window clipping, or no free DMA channels.
+#define BLIT_LIST_BLOCKS 64
+
+// Laid out like a channel's alias 1 registers; writing count starts the copy
+typedef struct {
+    uint32_t ctrl;
+    const uint8_t* read_addr;
+    uint8_t* write_addr;
+    uint32_t count;      // 0 ends the list (a null trigger)
+} BlitBlock;
+
+BlitBlock blit_lists[2][BLIT_LIST_BLOCKS + 1];
+int blit_data_channel = -1;
+int blit_ctrl_channel = -1;
+uint32_t blit_data_ctrl = 0;
+uint8_t blit_list = 0;           // List being filled
+uint16_t blit_list_count = 0;
+const BlitBlock* blit_list_end = NULL; // Past the end block of the list being copied
+bool blit_running = false;
+
+// Claim the blitter's channels. Without two free channels every layer uses the CPU.
+void init_tile_blitter() {
+    blit_data_channel = dma_claim_unused_channel(false);
+    blit_ctrl_channel = dma_claim_unused_channel(false);
+
+    if (blit_data_channel < 0 || blit_ctrl_channel < 0) {
+        if (blit_data_channel >= 0) dma_channel_unclaim(blit_data_channel);
+        if (blit_ctrl_channel >= 0) dma_channel_unclaim(blit_ctrl_channel);
+        blit_data_channel = -1;
+        blit_ctrl_channel = -1;
+        return;
+    }
+
+    // Byte copies, so rows can start at any pixel; each end hands over to the control channel
+    dma_channel_config data_config = dma_channel_get_default_config(blit_data_channel);
+    channel_config_set_transfer_data_size(&data_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&data_config, true);
+    channel_config_set_write_increment(&data_config, true);
+    channel_config_set_chain_to(&data_config, blit_ctrl_channel);
+    channel_config_set_irq_quiet(&data_config, true);
+    dma_channel_configure(blit_data_channel, &data_config, NULL, NULL, 0, false);
+    blit_data_ctrl = channel_config_get_ctrl_value(&data_config);
+
+    // The control channel writes one block into the data channel's alias 1 registers,
+    // the write address wrapping around those four words
+    dma_channel_config ctrl_config = dma_channel_get_default_config(blit_ctrl_channel);
+    channel_config_set_transfer_data_size(&ctrl_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&ctrl_config, true);
+    channel_config_set_write_increment(&ctrl_config, true);
+    channel_config_set_ring(&ctrl_config, true, 4);
+    dma_channel_configure(blit_ctrl_channel, &ctrl_config,
+                          &dma_hw->ch[blit_data_channel].al1_ctrl, NULL, 4, false);
+}
+
+// Wait until the list being copied is done
+void blit_wait() {
+    if (!blit_running) return;
+
+    while ((const BlitBlock*)dma_hw->ch[blit_ctrl_channel].read_addr != blit_list_end) {
+        tight_loop_contents();
+    }
+    while (dma_channel_is_busy(blit_data_channel)) {
+        tight_loop_contents();
+    }
+    blit_running = false;
+}
+
+// Start copying the list being filled and fill the other one from now on
+void blit_flush() {
+    if (blit_list_count == 0) return;
+
+    BlitBlock* list = blit_lists[blit_list];
+    BlitBlock* end = &list[blit_list_count];
+    end->ctrl = blit_data_ctrl;
+    end->read_addr = NULL;
+    end->write_addr = NULL;
+    end->count = 0;
+
+    // There is one chain, the other list has to be done first
+    blit_wait();
+    blit_list_end = end + 1;
+    blit_running = true;
+    dma_channel_set_read_addr(blit_ctrl_channel, list, true);
+
+    blit_list ^= 1;
+    blit_list_count = 0;
+}
+
+// Queue one row copy
+void blit_row(const uint8_t* src, uint8_t* dst, uint16_t count) {
+    if (blit_list_count == BLIT_LIST_BLOCKS) {
+        blit_flush();
+    }
+
+    BlitBlock* block = &blit_lists[blit_list][blit_list_count++];
+    block->ctrl = blit_data_ctrl;
+    block->read_addr = src;
+    block->write_addr = dst;
+    block->count = count;
+}
+
+// Backend selector: can this layer's tiles go through the blitter this frame
+bool layer_uses_blitter(const Layer* layer) {
+    return blit_data_channel >= 0 && layer->blit_backend == LAYER_BLIT_AUTO &&
+           layer->bpp == 8 && display_bpp == 8 &&
+           layer->scroll_mode != 2 && layer->scroll_mode != 3 &&
+           !effects.window_enabled[0] && !effects.window_enabled[1];
+}
+
+// Queue an 8bpp tile's rows for the blitter, clipped to the render target.
+// Returns false when the CPU has to draw it: a row mixing transparent and opaque
+// pixels keeps what is below, and mirrored rows without a pre-flipped copy run
+// backwards, neither of which a copy does. Empty rows are skipped.
+bool blit_tile(int x, int y, const TileView* tile, uint8_t attributes,
+               uint8_t tile_width, uint8_t tile_height) {
+    if (tile_height == 0 || tile_height > 16) return false;
+    if ((attributes & 0x01) && !tile->flipped_x) return false;
+    if ((tile->empty_rows | tile->opaque_rows) != tile_row_mask_all(tile_height)) return false;
+
+    bool flip_y = (attributes & 0x02) != 0;
+    int x0 = max(x, 0);
+    int x1 = min(x + tile_width, (int)display_width);
+    int y0 = max(y, (int)render_y_start);
+    int y1 = min(y + tile_height, (int)render_y_end);
+
+    for (int screen_y = y0; screen_y < y1; screen_y++) {
+        int row = flip_y ? tile_height - 1 - (screen_y - y) : screen_y - y;
+        if (row_mask_test(tile->empty_rows, row)) continue;
+
+        blit_row(tile->data + row * tile_width + (x0 - x),
+                 render_buffer + (screen_y - render_y_start) * display_width + x0,
+                 x1 - x0);
+    }
+    return true;
+}
+
+// Select a layer's tile drawing backend
+void set_layer_blit(uint8_t layer_id, uint8_t backend) {
+    if (layer_id >= MAX_LAYERS || backend > LAYER_BLIT_CPU) {
+        send_error_to_cpu(CMD_SET_LAYER_BLIT, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    layers[layer_id].blit_backend = backend;
+    send_ack_to_cpu(CMD_SET_LAYER_BLIT);
+}
+
+// Render a normal (non-rotated) layer
+void render_layer(uint8_t layer_id, bool clip_to_dirty) {
+    Layer* layer = &layers[layer_id];
+    
+    if (!layer->enabled) return;
+    
+    // Get layer properties
+    uint8_t tile_width = layer->tile_width;
+    uint8_t tile_height = layer->tile_height;
+    uint16_t scroll_x = layer->scroll_x;
+    uint16_t scroll_y = layer->scroll_y;
+    
+    // Determine regions to render
+    if (clip_to_dirty) {
+        // Only render dirty regions
+        for (int dr = 0; dr < dirty_region_count; dr++) {
+            Rect* region = &dirty_regions[dr];
+            
+            // Calculate tile range for this region
+            int start_tile_x = (region->x + scroll_x) / tile_width;
+            int start_tile_y = (region->y + scroll_y) / tile_height;
+            int end_tile_x = ((region->x + region->width + scroll_x) / tile_width) + 1;
+            int end_tile_y = ((region->y + region->height + scroll_y) / tile_height) + 1;
+            
+            // Render tiles in this region
+            render_layer_region(layer_id, start_tile_x, start_tile_y, end_tile_x, end_tile_y);
+        }
+    } else {
+        // Render the whole visible part of the layer within the render target
+        int start_tile_x = scroll_x / tile_width;
+        int start_tile_y = (render_y_start + scroll_y) / tile_height;
+        int end_tile_x = ((display_width + scroll_x) / tile_width) + 1;
+        int end_tile_y = ((render_y_end + scroll_y) / tile_height) + 1;
+        
+        render_layer_region(layer_id, start_tile_x, start_tile_y, end_tile_x, end_tile_y);
+    }
+
+    // Whatever draws next goes on top, so the blitted rows have to be in place
+    blit_flush();
+    blit_wait();
+}
+
 void render_layer_region(uint8_t layer_id, int start_tile_x, int start_tile_y, 
                         int end_tile_x, int end_tile_y) {
     Layer* layer = &layers[layer_id];
@@ -1806,6 +3603,7 @@ void render_layer_region(uint8_t layer_id, int start_tile_x, int start_tile_y,
     // Handle special scroll modes
     bool per_line_scroll = (layer->scroll_mode == 2); // Line scroll mode
     bool per_column_scroll = (layer->scroll_mode == 3); // Column scroll mode
+    bool blit = layer_uses_blitter(layer);
     
     // Render each tile in the region
     for (int ty = start_tile_y; ty < end_tile_y; ty++) {
@@ -1824,9 +3622,9 @@ void render_layer_region(uint8_t layer_id, int start_tile_x, int start_tile_y,
             // Skip empty tiles
             if (tile_info->tile_id == 0) continue;
             
-            // Get tile data from cache
-            uint8_t* tile_data = get_cached_tile(layer_id, tile_info->tile_id);
-            if (tile_data == NULL) continue;
+            // Get the tile from the cache, pre-flipped where it is copied
+            TileView tile;
+            if (!get_tile_view(layer_id, tile_info->tile_id, tile_info->attributes & 0x01, &tile)) continue;
             
             // Calculate screen position for this tile
             int screen_x = tx * tile_width - scroll_x;
@@ -1847,30 +3645,33 @@ void render_layer_region(uint8_t layer_id, int start_tile_x, int start_tile_y,
                 screen_y -= offset;
             }
             
-            // Skip tiles that are completely off-screen
+            // Skip tiles that are completely outside the render target
             if (screen_x + tile_width <= 0 || screen_x >= display_width ||
-                screen_y + tile_height <= 0 || screen_y >= display_height) {
+                screen_y + tile_height <= render_y_start || screen_y >= render_y_end) {
                 continue;
             }
             
+            // Opaque tiles are copied by DMA while the CPU draws the rest
+            if (blit && blit_tile(screen_x, screen_y, &tile, tile_info->attributes,
+                                  tile_width, tile_height)) {
+                continue;
+            }
+
             // Render the tile
-            render_tile(screen_x, screen_y, tile_data, tile_info->attributes, 
+            render_tile(screen_x, screen_y, &tile, tile_info->attributes,
                        tile_width, tile_height, layer->bpp, layer_id);
         }
     }
 }
 
-void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes, 
-                uint8_t tile_width, uint8_t tile_height, uint8_t bpp, uint8_t layer_id) {
+// Per-pixel tile drawing, for 16bpp tiles and window clipping
+void render_tile_pixels(int x, int y, const uint8_t* tile_data, uint8_t attributes,
+                        uint8_t tile_width, uint8_t tile_height, uint8_t bpp, uint8_t layer_id) {
     // Extract tile attributes
     bool flip_x = (attributes & 0x01) != 0;
     bool flip_y = (attributes & 0x02) != 0;
     uint8_t palette_offset = (attributes >> 2) & 0x0F; // 4 bits for palette
     
-    // Calculate bytes per pixel
-    uint8_t bytes_per_pixel = bpp / 8;
-    if (bpp < 8) bytes_per_pixel = 1; // For 4-bit, we store 2 pixels per byte
-    
     // For 8-bit paletted mode, apply palette offset
     uint16_t palette_shift = palette_offset * 16; // Assume 16 colors per palette entry
     
@@ -1900,9 +3701,9 @@ void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes,
                 int screen_x = x + tx;
                 int screen_y = y + ty;
                 
-                // Skip off-screen pixels
+                // Skip pixels outside the render target
                 if (screen_x < 0 || screen_x >= display_width || 
-                    screen_y < 0 || screen_y >= display_height) {
+                    screen_y < render_y_start || screen_y >= render_y_end) {
                     continue;
                 }
 
@@ -1913,8 +3714,8 @@ void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes,
                     }
                 }
                 
-                // Write pixel to framebuffer
-                framebuffer[screen_y * display_width + screen_x] = pixel;
+                // Write pixel to the render target
+                write_index_pixel(screen_x, screen_y, pixel);
               
             } else if (bpp == 8) {
                 // 8-bit (256 colors) - 1 byte per pixel
@@ -1928,9 +3729,9 @@ void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes,
                 int screen_x = x + tx;
                 int screen_y = y + ty;
                 
-                // Skip off-screen pixels
+                // Skip pixels outside the render target
                 if (screen_x < 0 || screen_x >= display_width || 
-                    screen_y < 0 || screen_y >= display_height) {
+                    screen_y < render_y_start || screen_y >= render_y_end) {
                     continue;
                 }
                 
@@ -1941,8 +3742,8 @@ void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes,
                     }
                 }
                 
-                // Write pixel to framebuffer
-                framebuffer[screen_y * display_width + screen_x] = pixel;
+                // Write pixel to the render target
+                write_index_pixel(screen_x, screen_y, pixel);
             } else if (bpp == 16) {
                 // 16-bit RGB565 - 2 bytes per pixel
                 src_pos = (src_y * tile_width + src_x) * 2;
@@ -1955,9 +3756,9 @@ void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes,
                 int screen_x = x + tx;
                 int screen_y = y + ty;
                 
-                // Skip off-screen pixels
+                // Skip pixels outside the render target
                 if (screen_x < 0 || screen_x >= display_width || 
-                    screen_y < 0 || screen_y >= display_height) {
+                    screen_y < render_y_start || screen_y >= render_y_end) {
                     continue;
                 }
                 
@@ -1968,127 +3769,156 @@ void render_tile(int x, int y, uint8_t* tile_data, uint8_t attributes,
                     }
                 }
                 
-                // Write pixel to framebuffer (16-bit mode)
-                ((uint16_t*)framebuffer)[screen_y * display_width + screen_x] = pixel;
+                // Write pixel to the render target (16-bit mode)
+                write_rgb_pixel(screen_x, screen_y, pixel);
             }
         }
     }
 }
 
+// Wrap a map coordinate; power-of-two maps use the mask
+static inline int wrap_map_coord(int v, int size, int mask) {
+    if (mask) return v & mask;
+    v %= size;
+    return (v < 0) ? v + size : v;
+}
+
 // Render a rotated/scaled layer
+// Each line's source position is set up once in 16.16 fixed point and then only
+// stepped by the matrix column per pixel. The tile under the last pixel is kept,
+// so the tilemap and tile cache are only looked up when the walk enters a new tile.
 void render_rotated_layer(uint8_t layer_id) {
     Layer* layer = &layers[layer_id];
     
-    if (!layer->enabled || !layer->rotation_enabled) return;
-    
-    // Get transformation matrix
-    float a = layer->matrix[0];
-    float b = layer->matrix[1];
-    float c = layer->matrix[2];
-    float d = layer->matrix[3];
-    
-    // Get center of rotation
+    if (!layer->enabled || !layer->rotation_enabled || layer->tilemap == NULL) return;
+    if (layer->bpp != 4 && layer->bpp != 8) return; // 16-bit tiles aren't supported here
+
+    int tile_width = layer->tile_width;
+    int tile_height = layer->tile_height;
+    int map_width = layer->width_tiles * tile_width;
+    int map_height = layer->height_tiles * tile_height;
+    if (map_width == 0 || map_height == 0) return;
+
+    // Power-of-two sizes wrap with masks and shifts
+    int mask_x = (map_width & (map_width - 1)) == 0 ? map_width - 1 : 0;
+    int mask_y = (map_height & (map_height - 1)) == 0 ? map_height - 1 : 0;
+    bool pow2_tiles = (tile_width & (tile_width - 1)) == 0 && (tile_height & (tile_height - 1)) == 0;
+    int tile_shift_x = __builtin_ctz(tile_width);
+    int tile_shift_y = __builtin_ctz(tile_height);
+
+    // Get center of rotation, with the scroll folded into the map
     int cx = layer->rot_center_x;
     int cy = layer->rot_center_y;
-    
-    // Render each pixel in the framebuffer
-    for (int y = 0; y < display_height; y++) {
-        for (int x = 0; x < display_width; x++) {
-            // Calculate source coordinates
-            float dx = x - cx;
-            float dy = y - cy;
-            
-            float src_x = (a * dx + b * dy) + cx + layer->scroll_x;
-            float src_y = (c * dx + d * dy) + cy + layer->scroll_y;
-            
-            // Convert to tile coordinates
-            int tile_x = (int)src_x / layer->tile_width;
-            int tile_y = (int)src_y / layer->tile_height;
-            
-            // Apply wrapping
-            int wrapped_tx = tile_x % layer->width_tiles;
-            int wrapped_ty = tile_y % layer->height_tiles;
-            
-            if (wrapped_tx < 0) wrapped_tx += layer->width_tiles;
-            if (wrapped_ty < 0) wrapped_ty += layer->height_tiles;
-            
-            // Get tile info
-            TileInfo* tile_info = (TileInfo*)(layer->tilemap + 
-                (wrapped_ty * layer->width_tiles + wrapped_tx) * sizeof(TileInfo));
-            
-            // Skip empty tiles
-            if (tile_info->tile_id == 0) continue;
-            
-            // Get tile data
-            uint8_t* tile_data = get_cached_tile(layer_id, tile_info->tile_id);
+    int origin_x = wrap_map_coord(cx + layer->scroll_x, map_width, mask_x);
+    int origin_y = wrap_map_coord(cy + layer->scroll_y, map_height, mask_y);
+
+    bool windowed = effects.window_enabled[0] || effects.window_enabled[1];
+    
+    for (int y = render_y_start; y < render_y_end; y++) {
+        int32_t a = layer->affine[0];
+        int32_t b = layer->affine[1];
+        int32_t c = layer->affine[2];
+        int32_t d = layer->affine[3];
+
+        if (layer->affine_lines != NULL && y < layer->affine_line_count) {
+            const int16_t* line = &layer->affine_lines[y * 4];
+            a = line[0] << 8;
+            b = line[1] << 8;
+            c = line[2] << 8;
+            d = line[3] << 8;
+        }
+
+        // Source position of the line's first pixel. Unsigned so that long steps
+        // wrap modulo 2^16 pixels, which power-of-two maps wrap at anyway.
+        int dy = y - cy;
+        uint32_t src_x = (uint32_t)-cx * a + (uint32_t)dy * b + ((uint32_t)origin_x << 16);
+        uint32_t src_y = (uint32_t)-cx * c + (uint32_t)dy * d + ((uint32_t)origin_y << 16);
+
+        int cached_tx = -1;
+        int cached_ty = -1;
+        const uint8_t* tile_data = NULL;
+        bool flip_x = false;
+        bool flip_y = false;
+        uint8_t palette_base = 0;
+
+        for (int x = 0; x < display_width; x++, src_x += a, src_y += c) {
+            int px = wrap_map_coord((int32_t)src_x >> 16, map_width, mask_x);
+            int py = wrap_map_coord((int32_t)src_y >> 16, map_height, mask_y);
+
+            int tx = pow2_tiles ? px >> tile_shift_x : px / tile_width;
+            int ty = pow2_tiles ? py >> tile_shift_y : py / tile_height;
+
+            if (tx != cached_tx || ty != cached_ty) {
+                cached_tx = tx;
+                cached_ty = ty;
+
+                TileInfo* tile_info = (TileInfo*)(layer->tilemap +
+                    (ty * layer->width_tiles + tx) * sizeof(TileInfo));
+
+                // Empty tiles and tiles that aren't loaded draw nothing
+                tile_data = (tile_info->tile_id == 0) ? NULL : get_cached_tile(layer_id, tile_info->tile_id);
+                flip_x = (tile_info->attributes & 0x01) != 0;
+                flip_y = (tile_info->attributes & 0x02) != 0;
+                palette_base = ((tile_info->attributes >> 2) & 0x0F) * 16;
+            }
+
             if (tile_data == NULL) continue;
+
+            int pixel_x = pow2_tiles ? px & (tile_width - 1) : px % tile_width;
+            int pixel_y = pow2_tiles ? py & (tile_height - 1) : py % tile_height;
             
-            // Calculate pixel coordinates within the tile
-            int pixel_x = (int)src_x % layer->tile_width;
-            int pixel_y = (int)src_y % layer->tile_height;
-            
-            if (pixel_x < 0) pixel_x += layer->tile_width;
-            if (pixel_y < 0) pixel_y += layer->tile_height;
-            
-            // Apply flipping from tile attributes
-            bool flip_x = (tile_info->attributes & 0x01) != 0;
-            bool flip_y = (tile_info->attributes & 0x02) != 0;
-            uint8_t palette_offset = (tile_info->attributes >> 2) & 0x0F;
-            
-            if (flip_x) pixel_x = layer->tile_width - 1 - pixel_x;
-            if (flip_y) pixel_y = layer->tile_height - 1 - pixel_y;
-            
-            // Get pixel color from tile data
+            if (flip_x) pixel_x = tile_width - 1 - pixel_x;
+            if (flip_y) pixel_y = tile_height - 1 - pixel_y;
+
             uint8_t pixel;
+            int pos = pixel_y * tile_width + pixel_x;
             
             if (layer->bpp == 4) {
-                // 4-bit (16 colors)
-                int byte_pos = (pixel_y * layer->tile_width + pixel_x) / 2;
-                int shift = (pixel_x & 1) ? 0 : 4;
-                
-                pixel = (tile_data[byte_pos] >> shift) & 0x0F;
-                
-                // Apply palette offset
-                if (pixel != 0) { // Skip transparent pixels
-                    pixel += palette_offset * 16;
-                }
-            } else if (layer->bpp == 8) {
-                // 8-bit (256 colors)
-                int byte_pos = pixel_y * layer->tile_width + pixel_x;
-                pixel = tile_data[byte_pos];
+                // 4-bit (16 colors), palette offset added to opaque pixels
+                pixel = (tile_data[pos >> 1] >> ((pixel_x & 1) ? 0 : 4)) & 0x0F;
+                if (pixel != 0) pixel += palette_base;
             } else {
-                // 16-bit (RGB565) - not handled here for simplicity
-                continue;
+                pixel = tile_data[pos];
             }
             
             // Skip transparent pixels
             if (pixel == 0) continue;
             
             // Check window clipping
-            if (effects.window_enabled[0] || effects.window_enabled[1]) {
-                if (!is_in_window(x, y, layer_id)) {
-                    continue;
-                }
+            if (windowed && !is_in_window(x, y, layer_id)) {
+                continue;
             }
             
-            // Write to framebuffer
-            framebuffer[y * display_width + x] = pixel;
+            // Write to the render target
+            write_index_pixel(x, y, pixel);
         }
     }
 }
 
 // Render sprites for a specific priority level
 void render_sprites_at_priority(uint8_t priority) {
-    for (int i = 0; i < MAX_SPRITES; i++) {
-        uint8_t sprite_id = sprite_order[i];
-        Sprite* sprite = &sprites[sprite_id];
-        
-        // Skip inactive sprites
-        if (!sprite->visible) continue;
+    // The line renderer only looks at this priority's run of the sprites binned
+    // to the current line group; the frame renderer walks the priority's list
+    bool grouped = (current_line_group >= 0);
+    int i = 0;
+    int end = 0;
+    uint8_t sprite_id = sprite_list_head[priority];
+
+    if (grouped) {
+        i = (priority > 0) ? group_priority_end[current_line_group][priority - 1] : 0;
+        end = group_priority_end[current_line_group][priority];
+    }
+
+    for (;;) {
+        if (grouped) {
+            if (i >= end) break;
+            sprite_id = group_sprites[current_line_group][i++];
+        } else if (i++ > 0) {
+            sprite_id = sprites[sprite_id].list_next;
+        }
+        if (sprite_id == SPRITE_LIST_END) break;
         
-        // Check priority
-        uint8_t sprite_priority = (sprite->attributes >> 4) & 0x03;
-        if (sprite_priority != priority) continue;
+        Sprite* sprite = &sprites[sprite_id];
         
         // Get pattern information
         uint8_t pattern_id = sprite->pattern_id;
@@ -2110,8 +3940,8 @@ void render_sprites_at_priority(uint8_t priority) {
         int16_t x = sprite->x >> 8;
         int16_t y = sprite->y >> 8;
         
-        // Skip completely off-screen sprites
-        if (x + width <= 0 || x >= display_width || y + height <= 0 || y >= display_height) {
+        // Skip sprites completely outside the render target
+        if (x + width <= 0 || x >= display_width || y + height <= render_y_start || y >= render_y_end) {
             continue;
         }
         
@@ -2120,6 +3950,189 @@ void render_sprites_at_priority(uint8_t priority) {
     }
 }
 
+// Sprite span blitters
+// render_sprite() clips a sprite once against the render target and then hands each
+// visible row to a span blitter picked up front for the sprite's bpp, scaling, flip_x
+// and target depth. Every blitter is the same inline body instantiated with
+// constant flags, so the per-pixel loop carries no mode tests. flip_y only changes
+// which source row is fetched, and scaled spans flip by stepping backwards.
+typedef void (*SpanBlitter)(uint8_t* dst, const uint8_t* src, uint32_t src_x, int32_t src_step,
+                            uint16_t count, uint8_t palette_base);
+
+// Store one opaque sprite pixel
+static inline __attribute__((always_inline))
+void put_span_pixel(uint8_t* dst, uint16_t i, uint16_t pixel, uint8_t palette_base,
+                    const uint8_t bpp, const bool rgb_target) {
+    if (bpp == 16) {
+        ((uint16_t*)dst)[i] = pixel;
+        return;
+    }
+
+    uint8_t index = pixel + palette_base;
+
+    if (rgb_target) {
+        ((uint16_t*)dst)[i] = palette_rgb565[index];
+    } else {
+        dst[i] = index;
+    }
+}
+
+// Fetch one source pixel
+static inline __attribute__((always_inline))
+uint16_t fetch_span_pixel(const uint8_t* src, uint32_t sx, const uint8_t bpp) {
+    if (bpp == 4) {
+        // Even pixels use the high nibble
+        return (src[sx >> 1] >> ((~sx & 1) << 2)) & 0x0F;
+    } else if (bpp == 8) {
+        return src[sx];
+    } else {
+        return src[sx * 2] | (src[sx * 2 + 1] << 8);
+    }
+}
+
+static inline __attribute__((always_inline))
+void blit_sprite_span(uint8_t* dst, const uint8_t* src, uint32_t src_x, int32_t src_step,
+                      uint16_t count, uint8_t palette_base,
+                      const uint8_t bpp, const bool scaled, const bool flip_x,
+                      const bool rgb_target) {
+    if (scaled) {
+        // src_x is a 16.16 position, src_step is negative for flipped sprites
+        uint32_t pos = src_x;
+
+        for (uint16_t i = 0; i < count; i++, pos += src_step) {
+            uint16_t pixel = fetch_span_pixel(src, pos >> 16, bpp);
+            if (pixel != 0) {
+                put_span_pixel(dst, i, pixel, palette_base, bpp, rgb_target);
+            }
+        }
+    } else if (bpp == 4 && !flip_x) {
+        // Unscaled 4bpp: take source bytes a pair of pixels at a time
+        uint16_t i = 0;
+
+        if (src_x & 1) {
+            uint16_t pixel = src[src_x >> 1] & 0x0F;
+            if (pixel != 0) {
+                put_span_pixel(dst, 0, pixel, palette_base, bpp, rgb_target);
+            }
+            i = 1;
+        }
+
+        const uint8_t* pair_src = &src[(src_x + i) >> 1];
+
+        for (; i + 2 <= count; i += 2) {
+            uint8_t pair = *pair_src++;
+            if (pair == 0) continue; // Both pixels transparent
+
+            if (pair & 0xF0) {
+                put_span_pixel(dst, i, pair >> 4, palette_base, bpp, rgb_target);
+            }
+            if (pair & 0x0F) {
+                put_span_pixel(dst, i + 1, pair & 0x0F, palette_base, bpp, rgb_target);
+            }
+        }
+
+        if (i < count && (*pair_src >> 4) != 0) {
+            put_span_pixel(dst, i, *pair_src >> 4, palette_base, bpp, rgb_target);
+        }
+    } else {
+        // Unscaled: src_x is the source column of the first pixel
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t pixel = fetch_span_pixel(src, flip_x ? src_x - i : src_x + i, bpp);
+            if (pixel != 0) {
+                put_span_pixel(dst, i, pixel, palette_base, bpp, rgb_target);
+            }
+        }
+    }
+}
+
+#define DEFINE_SPAN_BLITTER(name, bpp, scaled, flip_x, rgb_target)                                  \
+    void name(uint8_t* dst, const uint8_t* src, uint32_t src_x, int32_t src_step,                  \
+              uint16_t count, uint8_t palette_base) {                                               \
+        blit_sprite_span(dst, src, src_x, src_step, count, palette_base,                            \
+                         bpp, scaled, flip_x, rgb_target);                                          \
+    }
+
+DEFINE_SPAN_BLITTER(blit_span_4bpp, 4, false, false, false)
+DEFINE_SPAN_BLITTER(blit_span_4bpp_rgb, 4, false, false, true)
+DEFINE_SPAN_BLITTER(blit_span_4bpp_flip, 4, false, true, false)
+DEFINE_SPAN_BLITTER(blit_span_4bpp_flip_rgb, 4, false, true, true)
+DEFINE_SPAN_BLITTER(blit_span_4bpp_scaled, 4, true, false, false)
+DEFINE_SPAN_BLITTER(blit_span_4bpp_scaled_rgb, 4, true, false, true)
+DEFINE_SPAN_BLITTER(blit_span_8bpp, 8, false, false, false)
+DEFINE_SPAN_BLITTER(blit_span_8bpp_rgb, 8, false, false, true)
+DEFINE_SPAN_BLITTER(blit_span_8bpp_flip, 8, false, true, false)
+DEFINE_SPAN_BLITTER(blit_span_8bpp_flip_rgb, 8, false, true, true)
+DEFINE_SPAN_BLITTER(blit_span_8bpp_scaled, 8, true, false, false)
+DEFINE_SPAN_BLITTER(blit_span_8bpp_scaled_rgb, 8, true, false, true)
+DEFINE_SPAN_BLITTER(blit_span_16bpp, 16, false, false, false)
+DEFINE_SPAN_BLITTER(blit_span_16bpp_flip, 16, false, true, false)
+DEFINE_SPAN_BLITTER(blit_span_16bpp_scaled, 16, true, false, false)
+
+// Blitter table: [bpp 4/8/16][scaled][flip_x][16bpp target]
+// Scaled spans flip through a negative step, and 16bpp sources are always written as
+// RGB565, so those entries share one variant.
+SpanBlitter span_blitters[3][2][2][2] = {
+    { // 4bpp
+        { { blit_span_4bpp, blit_span_4bpp_rgb }, { blit_span_4bpp_flip, blit_span_4bpp_flip_rgb } },
+        { { blit_span_4bpp_scaled, blit_span_4bpp_scaled_rgb }, { blit_span_4bpp_scaled, blit_span_4bpp_scaled_rgb } }
+    },
+    { // 8bpp
+        { { blit_span_8bpp, blit_span_8bpp_rgb }, { blit_span_8bpp_flip, blit_span_8bpp_flip_rgb } },
+        { { blit_span_8bpp_scaled, blit_span_8bpp_scaled_rgb }, { blit_span_8bpp_scaled, blit_span_8bpp_scaled_rgb } }
+    },
+    { // 16bpp
+        { { blit_span_16bpp, blit_span_16bpp }, { blit_span_16bpp_flip, blit_span_16bpp_flip } },
+        { { blit_span_16bpp_scaled, blit_span_16bpp_scaled }, { blit_span_16bpp_scaled, blit_span_16bpp_scaled } }
+    }
+};
+
+// Draw a 4bpp or 8bpp tile a row at a time with the sprite span blitters. The tile
+// is clipped once, rows without opaque pixels are skipped, and opaque 8bpp rows on
+// an 8bpp target (pre-flipped for mirrored tiles) are plain copies.
+void render_tile(int x, int y, const TileView* tile, uint8_t attributes,
+                 uint8_t tile_width, uint8_t tile_height, uint8_t bpp, uint8_t layer_id) {
+    // A pre-flipped copy is drawn as it is
+    uint8_t draw_attributes = tile->flipped_x ? (attributes & ~0x01) : attributes;
+
+    if ((bpp != 4 && bpp != 8) || effects.window_enabled[0] || effects.window_enabled[1]) {
+        render_tile_pixels(x, y, tile->data, draw_attributes, tile_width, tile_height, bpp, layer_id);
+        return;
+    }
+
+    int16_t x0 = max(x, 0);
+    int16_t x1 = min(x + tile_width, (int)display_width);
+    int16_t y0 = max(y, render_y_start);
+    int16_t y1 = min(y + tile_height, render_y_end);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    bool flip_x = (draw_attributes & 0x01) != 0;
+    bool flip_y = (attributes & 0x02) != 0;
+    bool rgb_target = (display_bpp == 16);
+    bool copy_opaque = (bpp == 8 && !flip_x && !rgb_target);
+    uint8_t palette_base = (bpp == 4) ? ((attributes >> 2) & 0x0F) * 16 : 0;
+    SpanBlitter blit = span_blitters[(bpp == 4) ? 0 : 1][0][flip_x][rgb_target];
+
+    uint32_t src_row_bytes = (tile_width * bpp) / 8;
+    uint8_t dst_pixel_bytes = rgb_target ? 2 : 1;
+    uint16_t skip_x = x0 - x;
+    uint32_t src_x = flip_x ? tile_width - 1 - skip_x : skip_x;
+
+    for (int16_t screen_y = y0; screen_y < y1; screen_y++) {
+        int row = flip_y ? tile_height - 1 - (screen_y - y) : screen_y - y;
+        if (row_mask_test(tile->empty_rows, row)) continue;
+
+        const uint8_t* src = tile->data + row * src_row_bytes;
+        uint8_t* dst_row = render_buffer +
+            ((screen_y - render_y_start) * display_width + x0) * dst_pixel_bytes;
+
+        if (copy_opaque && row_mask_test(tile->opaque_rows, row)) {
+            memcpy(dst_row, src + skip_x, x1 - x0);
+        } else {
+            blit(dst_row, src, src_x, 0, x1 - x0, palette_base);
+        }
+    }
+}
+
 void render_sprite(uint8_t sprite_id, int16_t x, int16_t y, uint16_t width, uint16_t height) {
     Sprite* sprite = &sprites[sprite_id];
     SpritePattern* pattern = &sprite_patterns[sprite->pattern_id];
@@ -2130,232 +4143,1684 @@ void render_sprite(uint8_t sprite_id, int16_t x, int16_t y, uint16_t width, uint
     uint8_t palette_offset = sprite->palette_offset;
     
     // Get sprite data
-    uint8_t* sprite_data = sprite_data + pattern->data_offset;
+    const uint8_t* pattern_data = sprite_pattern_data(pattern);
     
     // Cache source dimensions
     uint16_t src_width = pattern->width * 8;
     uint16_t src_height = pattern->height * 8;
     
+    // Clip once against the render target
+    int16_t x0 = max(x, 0);
+    int16_t x1 = min(x + width, display_width);
+    int16_t y0 = max(y, render_y_start);
+    int16_t y1 = min(y + height, render_y_end);
+    
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    uint8_t bpp_index;
+    if (pattern->bpp == 4) bpp_index = 0;
+    else if (pattern->bpp == 8) bpp_index = 1;
+    else if (pattern->bpp == 16) bpp_index = 2;
+    else return;
+    
+    // Pick the span blitter for this sprite
+    bool scaled = (width != src_width || height != src_height);
+    bool rgb_target = (display_bpp == 16);
+    SpanBlitter blit = span_blitters[bpp_index][scaled][flip_x][rgb_target];
+    
+    uint32_t src_row_bytes = (src_width * pattern->bpp) / 8;
+    uint8_t dst_pixel_bytes = (rgb_target || pattern->bpp == 16) ? 2 : 1;
+    uint8_t palette_base = (pattern->bpp == 4) ? palette_offset * 16 : 0;
+    
     // Scaling factors (16.16 fixed-point)
     uint32_t x_scale = (src_width << 16) / width;
     uint32_t y_scale = (src_height << 16) / height;
     
-    // For each pixel in the destination sprite
-    for (int16_t dy = 0; dy < height; dy++) {
-        for (int16_t dx = 0; dx < width; dx++) {
-            // Calculate screen position
-            int16_t screen_x = x + dx;
-            int16_t screen_y = y + dy;
-            
-            // Skip if outside screen
-            if (screen_x < 0 || screen_x >= display_width || 
-                screen_y < 0 || screen_y >= display_height) {
-                continue;
-            }
-            
-            // Calculate source position with scaling
-            uint32_t src_x_fixed = dx * x_scale;
-            uint32_t src_y_fixed = dy * y_scale;
-            
-            uint16_t src_x = src_x_fixed >> 16;
-            uint16_t src_y = src_y_fixed >> 16;
-            
-            // Apply flipping
-            if (flip_x) src_x = src_width - 1 - src_x;
-            if (flip_y) src_y = src_height - 1 - src_y;
-            
-            // Get pixel from sprite data
-            uint8_t pixel;
-            
-            if (pattern->bpp == 4) {
-                // 4-bit (16 colors)
-                uint32_t offset = (src_y * src_width + src_x) / 2;
-                uint8_t shift = (src_x & 1) ? 0 : 4;
-                
-                pixel = (sprite_data[offset] >> shift) & 0x0F;
-                
-                // Apply palette offset
-                if (pixel != 0) { // Skip transparent pixels
-                    pixel += palette_offset * 16;
-                }
-            } else if (pattern->bpp == 8) {
-                // 8-bit (256 colors)
-                uint32_t offset = src_y * src_width + src_x;
-                pixel = sprite_data[offset];
-            } else if (pattern->bpp == 16) {
-                // 16-bit RGB565
-                uint32_t offset = (src_y * src_width + src_x) * 2;
-                uint16_t rgb_pixel = sprite_data[offset] | (sprite_data[offset + 1] << 8);
-                
-                // Skip transparent pixels (0x0000)
-                if (rgb_pixel == 0) continue;
-                
-                // Write directly to framebuffer for 16-bit mode
-                ((uint16_t*)framebuffer)[screen_y * display_width + screen_x] = rgb_pixel;
-                continue;
-            }
-            
-            // Skip transparent pixels
-            if (pixel == 0) continue;
-            
-            // Check for sprite collision if enabled
-            if (collision_detection_mode == 1 || collision_detection_mode == 3) {
-                // Check sprite-sprite collision
-                uint32_t pos = screen_y * display_width + screen_x;
-                
-                if (sprite_collision_buffer[pos / 8] & (1 << (pos % 8))) {
-                    // Collision detected
-                    sprite_collision_detected = true;
-                } else {
-                    // Mark this pixel in collision buffer
-                    sprite_collision_buffer[pos / 8] |= (1 << (pos % 8));
-                }
-            }
-            
-            // Write to framebuffer
-            framebuffer[screen_y * display_width + screen_x] = pixel;
+    // Source position of the first visible column
+    uint16_t skip_x = x0 - x;
+    uint32_t src_x;
+    int32_t src_step = 0;
+    
+    if (scaled) {
+        if (flip_x) {
+            // Step backwards from the far edge, flooring gives src_width - 1 - (dx * x_scale >> 16)
+            src_x = (((uint32_t)(src_width - 1) << 16) | 0xFFFF) - skip_x * x_scale;
+            src_step = -(int32_t)x_scale;
+        } else {
+            src_x = skip_x * x_scale;
+            src_step = x_scale;
         }
+    } else {
+        src_x = flip_x ? src_width - 1 - skip_x : skip_x;
     }
-}
-
-// Display Output and Synchronization
-// Send framebuffer to display
-void send_frame_to_display() {
-    // Set the display window to full screen
-    display_set_window(0, 0, display_width, display_height);
-    
-    // For 8-bit paletted mode, convert to RGB565 for the display
-    if (display_bpp == 8) {
-        // Configure for data transmission
-        gpio_put(DISPLAY_DC_PIN, 1); // Data mode
-        gpio_put(DISPLAY_CS_PIN, 0); // Select display
-        
-        // Send data in chunks to avoid large buffers
-        uint16_t rgb_buffer[32];
+    
+    // Rows of an unscaled, unflipped 8bpp sprite without transparent pixels are copies
+    bool copy_opaque = (pattern->bpp == 8 && !scaled && !flip_x && !rgb_target);
+    
+    // Blit each visible row
+    for (int16_t screen_y = y0; screen_y < y1; screen_y++) {
+        uint16_t dy = screen_y - y;
+        uint16_t src_y = scaled ? (dy * y_scale) >> 16 : dy;
+        if (flip_y) src_y = src_height - 1 - src_y;
         
-        for (int i = 0; i < display_width * display_height; i += 32) {
-            // Convert palette indices to RGB565
-            int chunk_size = min(32, display_width * display_height - i);
-            
-            for (int j = 0; j < chunk_size; j++) {
-                uint8_t index = framebuffer[i + j];
-                RGB color = palette[index];
-                
-                // Convert 8-bit RGB to RGB565
-                uint16_t r5 = (color.r * 31 / 255) & 0x1F;
-                uint16_t g6 = (color.g * 63 / 255) & 0x3F;
-                uint16_t b5 = (color.b * 31 / 255) & 0x1F;
-                
-                rgb_buffer[j] = (r5 << 11) | (g6 << 5) | b5;
-            }
-            
-            // Send RGB565 data to display
-            spi_write_blocking(DISPLAY_SPI_PORT, (uint8_t*)rgb_buffer, chunk_size * 2);
-        }
+        // Source rows without opaque pixels draw nothing
+        if (row_mask_test(pattern->empty_rows, src_y)) continue;
         
-        gpio_put(DISPLAY_CS_PIN, 1); // Deselect display
-    } else if (display_bpp == 16) {
-        // Send 16-bit data directly
-        gpio_put(DISPLAY_DC_PIN, 1); // Data mode
-        gpio_put(DISPLAY_CS_PIN, 0); // Select display
+        const uint8_t* src_row = pattern_data + src_y * src_row_bytes;
+        uint8_t* dst_row = render_buffer +
+            ((screen_y - render_y_start) * display_width + x0) * dst_pixel_bytes;
         
-        // Send in chunks
-        for (int i = 0; i < display_width * display_height; i += 256) {
-            int chunk_size = min(256, display_width * display_height - i);
-            spi_write_blocking(DISPLAY_SPI_PORT, &framebuffer[i * 2], chunk_size * 2);
+        if (copy_opaque && row_mask_test(pattern->opaque_rows, src_y)) {
+            memcpy(dst_row, src_row + src_x, x1 - x0);
+            continue;
         }
         
-        gpio_put(DISPLAY_CS_PIN, 1); // Deselect display
-    }
-    
-    // Signal VSYNC to CPU if enabled
-    if (vblank_callback_enabled) {
-        gpio_put(VSYNC_PIN, 0);
-        sleep_us(10);
-        gpio_put(VSYNC_PIN, 1);
+        blit(dst_row, src_row, src_x, src_step, x1 - x0, palette_base);
     }
 }
 
-// Setup DMA for faster display updates
-void setup_display_dma() {
-    // Initialize DMA channel for display
-    display_dma_channel = dma_claim_unused_channel(true);
-    
-    // Configure DMA channel
-    dma_channel_config dma_config = dma_channel_get_default_config(display_dma_channel);
-    channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_8);
-    channel_config_set_read_increment(&dma_config, true);
-    channel_config_set_write_increment(&dma_config, false);
-    
-    // Set SPI as DREQ
-    channel_config_set_dreq(&dma_config, spi_get_dreq(DISPLAY_SPI_PORT, true));
-    
-    // Configure DMA
-    dma_channel_configure(
-        display_dma_channel,
-        &dma_config,
-        &spi_get_hw(DISPLAY_SPI_PORT)->dr, // Write to SPI data register
-        NULL, // Source will be set for each transfer
-        0,    // Count will be set for each transfer
-        false // Don't start yet
-    );
-}
+// Sprite collision
+// Collisions are found once per frame from sprite bounding boxes. Sprites are kept
+// sorted by left edge (insertion sort, which is linear when little moved) and swept,
+// so only sprites already overlapping on x are compared on y, and the cost follows
+// the number of overlaps rather than screen area. With COLLISION_PIXEL_EXACT each
+// overlapping pair is also checked for a shared opaque pixel. The frame's pairs are
+// returned by GET_SPRITE_COLLISION.
+#define MAX_COLLISION_PAIRS 32
+#define COLLISION_SPRITES 0x01       // Mode bit: sprite-sprite
+#define COLLISION_PIXEL_EXACT 0x04   // Mode bit: refine overlapping boxes by pixel
 
-// Send display data using DMA
-void send_display_chunk_dma(uint8_t* data, size_t length) {
-    // Setup and start DMA transfer
-    dma_channel_set_read_addr(display_dma_channel, data, false);
-    dma_channel_set_trans_count(display_dma_channel, length, true);
-    
-    // Wait for DMA to complete
-    dma_channel_wait_for_finish_blocking(display_dma_channel);
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} SpriteBox;
+
+SpriteBox sprite_boxes[MAX_SPRITES];
+uint8_t collision_order[MAX_SPRITES];    // Sprite IDs by box left edge, invisible last
+bool collision_order_ready = false;
+
+// Results, double buffered so core 0 reads a complete frame
+typedef struct {
+    uint32_t frame;
+    uint8_t count;
+    bool overflow;
+    uint8_t pairs[MAX_COLLISION_PAIRS][2];
+} CollisionList;
+
+CollisionList collision_lists[2];
+volatile uint8_t collision_list_ready = 0;
+
+// Screen-space box of a sprite as render_sprite() draws it, false if it draws nothing
+bool get_sprite_box(uint8_t sprite_id, SpriteBox* box) {
+    Sprite* sprite = &sprites[sprite_id];
+    if (!sprite->visible || !sprite_patterns[sprite->pattern_id].in_use) return false;
+
+    SpritePattern* pattern = &sprite_patterns[sprite->pattern_id];
+    uint16_t width = pattern->width * 8;
+    uint16_t height = pattern->height * 8;
+
+    if (sprite->scale != 128) {
+        width = (width * sprite->scale) / 128;
+        height = (height * sprite->scale) / 128;
+    }
+    if (width == 0 || height == 0) return false;
+
+    box->x0 = sprite->x >> 8;
+    box->y0 = sprite->y >> 8;
+    box->x1 = box->x0 + width;
+    box->y1 = box->y0 + height;
+    return true;
 }
 
-// Core Execution Loops and Main Function
-// Core 1 rendering function
-void core1_rendering_loop() {
+// Whether a sprite covers a screen pixel with an opaque pixel
+bool sprite_opaque_at(uint8_t sprite_id, const SpriteBox* box, int16_t x, int16_t y) {
+    Sprite* sprite = &sprites[sprite_id];
+    SpritePattern* pattern = &sprite_patterns[sprite->pattern_id];
+    uint16_t src_width = pattern->width * 8;
+    uint16_t src_height = pattern->height * 8;
+
+    uint16_t sx = (uint32_t)(x - box->x0) * src_width / (box->x1 - box->x0);
+    uint16_t sy = (uint32_t)(y - box->y0) * src_height / (box->y1 - box->y0);
+    if (sprite->attributes & 0x01) sx = src_width - 1 - sx;
+    if (sprite->attributes & 0x02) sy = src_height - 1 - sy;
+
+    const uint8_t* row = sprite_pattern_data(pattern) + sy * ((src_width * pattern->bpp) / 8);
+
+    switch (pattern->bpp) {
+        case 4: return fetch_span_pixel(row, sx, 4) != 0;
+        case 8: return fetch_span_pixel(row, sx, 8) != 0;
+        default: return fetch_span_pixel(row, sx, 16) != 0;
+    }
+}
+
+// Look for a shared opaque pixel in the overlap of two boxes
+bool sprites_overlap_pixels(uint8_t a, uint8_t b) {
+    const SpriteBox* box_a = &sprite_boxes[a];
+    const SpriteBox* box_b = &sprite_boxes[b];
+    int16_t x0 = max(box_a->x0, box_b->x0);
+    int16_t x1 = min(box_a->x1, box_b->x1);
+    int16_t y0 = max(box_a->y0, box_b->y0);
+    int16_t y1 = min(box_a->y1, box_b->y1);
+
+    for (int16_t y = y0; y < y1; y++) {
+        for (int16_t x = x0; x < x1; x++) {
+            if (sprite_opaque_at(a, box_a, x, y) && sprite_opaque_at(b, box_b, x, y)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Find this frame's colliding sprite pairs
+void detect_sprite_collisions() {
+    if (!(collision_detection_mode & COLLISION_SPRITES)) return;
+
+    if (!collision_order_ready) {
+        for (int i = 0; i < MAX_SPRITES; i++) {
+            collision_order[i] = i;
+        }
+        collision_order_ready = true;
+    }
+
+    // Invisible sprites sort to the end
+    int16_t left[MAX_SPRITES];
+    for (int i = 0; i < MAX_SPRITES; i++) {
+        left[i] = get_sprite_box(i, &sprite_boxes[i]) ? sprite_boxes[i].x0 : INT16_MAX;
+    }
+
+    for (int i = 1; i < MAX_SPRITES; i++) {
+        uint8_t id = collision_order[i];
+        int j = i - 1;
+        while (j >= 0 && left[collision_order[j]] > left[id]) {
+            collision_order[j + 1] = collision_order[j];
+            j--;
+        }
+        collision_order[j + 1] = id;
+    }
+
+    CollisionList* list = &collision_lists[collision_list_ready ^ 1];
+    list->frame = frame_counter;
+    list->count = 0;
+    list->overflow = false;
+
+    for (int i = 0; i < MAX_SPRITES && left[collision_order[i]] != INT16_MAX; i++) {
+        uint8_t a = collision_order[i];
+        const SpriteBox* box_a = &sprite_boxes[a];
+
+        // Sweep: later boxes start further right, stop at the first past this one
+        for (int j = i + 1; j < MAX_SPRITES && left[collision_order[j]] < box_a->x1; j++) {
+            uint8_t b = collision_order[j];
+            const SpriteBox* box_b = &sprite_boxes[b];
+
+            if (box_b->y0 >= box_a->y1 || box_a->y0 >= box_b->y1) continue;
+
+            if ((collision_detection_mode & COLLISION_PIXEL_EXACT) && !sprites_overlap_pixels(a, b)) {
+                continue;
+            }
+
+            if (list->count == MAX_COLLISION_PAIRS) {
+                list->overflow = true;
+                break;
+            }
+
+            list->pairs[list->count][0] = min(a, b);
+            list->pairs[list->count][1] = max(a, b);
+            list->count++;
+        }
+    }
+
+    sprite_collision_detected = (list->count > 0);
+    collision_list_ready ^= 1;
+}
+
+// Report the last frame's colliding pairs
+void send_sprite_collisions() {
+    const CollisionList* list = &collision_lists[collision_list_ready];
+    uint8_t response[8 + MAX_COLLISION_PAIRS * 2];
+    uint8_t pos = 2;
+
+    response[pos++] = (list->frame >> 24) & 0xFF;
+    response[pos++] = (list->frame >> 16) & 0xFF;
+    response[pos++] = (list->frame >> 8) & 0xFF;
+    response[pos++] = list->frame & 0xFF;
+    response[pos++] = list->count;
+    response[pos++] = (list->overflow ? 0x01 : 0) | (sprite_bg_collision_detected ? 0x02 : 0);
+
+    for (uint8_t i = 0; i < list->count; i++) {
+        response[pos++] = list->pairs[i][0];
+        response[pos++] = list->pairs[i][1];
+    }
+
+    response[0] = CMD_GET_SPRITE_COLLISION;
+    response[1] = pos;
+
+    send_data_to_cpu(response, pos);
+}
+
+// Display Output and Synchronization
+// Scan-out pipeline
+// Transfers are queued to two DMA channels used in ping-pong: transfer N goes out on
+// channel N & 1. A transfer is one line, or a whole group of contiguous lines from the
+// line renderer. When a transfer is queued its channel is pointed at the RGB565 data and
+// the channel sending the previous transfer is chained to it, so consecutive transfers
+// follow each other without waiting for core 1. If the previous transfer already
+// finished before the chain was set up, the new one is started by hand and counted as late.
+// In 8bpp framebuffer mode each line is first converted through the palette LUT into
+// one of two line buffers; the line renderer queues its line group buffers directly.
+uint16_t scanout_lines[2][MAX_DISPLAY_WIDTH];
+uint8_t display_dma_channels[2];
+dma_channel_config display_dma_configs[2];
+volatile uint32_t scanout_lines_sent = 0;
+volatile uint16_t scanout_channel_lines[2] = {0, 0}; // Lines in each channel's transfer
+
+// State of the frame currently being sent
+struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t next_line;
+    uint16_t next_transfer;
+    uint16_t channel_end[2]; // Line after each channel's last queued transfer
+    bool dma_started;
+    uint32_t dma_start;
+    uint32_t convert_us;
+    uint32_t wait_us;
+    uint16_t late_lines;
+} scanout;
+
+// Scan-out timing for the last frame
+typedef struct {
+    uint32_t frames;           // Frames sent since boot
+    uint32_t dma_busy_us;      // First line trigger to last line complete
+    uint32_t convert_us;       // Core 1 time spent converting lines
+    uint32_t wait_us;          // Core 1 time spent waiting for a free line buffer
+    uint16_t late_lines;       // Lines DMA had to be restarted for
+    uint8_t dma_busy_percent;  // dma_busy_us as a share of FRAME_INTERVAL_US
+} ScanoutStats;
+
+ScanoutStats scanout_stats;
+
+// Present queue
+// In framebuffer mode core 1 composes the next frame while the previous one is
+// still going out. The framebuffer arena is split into as many whole frames as fit,
+// up to three, so 320x240 8bpp is triple buffered on RP2350. Where a second frame
+// doesn't fit (RP2040, or 16bpp on RP2350) the one frame is used as two halves that
+// race the scan-out: the top half of frame N+1 is composed while the bottom half of
+// frame N is sent. Composed parts are queued and sent in order from the DMA
+// completion interrupt, which runs on core 0, so line conversion overlaps composition.
+// Two fences keep frames whole: a buffer or half is only composed again once its
+// scan-out has finished, and a queued frame only starts going out once the frame
+// before it has ended with VSYNC, so the display never gets parts of two frames.
+typedef struct {
+    const uint8_t* pixels;   // Screen line y_start of the part
+    uint16_t y_start;        // The part holds screen lines [y_start, y_end)
+    uint16_t y_end;
+    uint8_t slot;            // Buffer or half released once the part has gone out
+    bool first;              // First part of a frame, starts its scan-out timing
+    bool last;               // Last part of a frame, ends it with VSYNC
+    uint8_t region_count;
+    Rect regions[MAX_DIRTY_REGIONS];
+} PresentJob;
+
+uint8_t present_mode = PRESENT_MODE_HALF_FRAME;
+uint8_t* present_buffers[PRESENT_MAX_BUFFERS];
+uint8_t present_slot_count = 2;     // Whole buffers, or the two halves of one
+uint8_t present_draw_slot = 0;      // Buffer composed next
+volatile uint8_t present_busy = 0;  // Bit per slot queued or going out
+PresentJob present_queue[PRESENT_QUEUE_SIZE];
+volatile uint8_t present_head = 0;  // Next free job
+volatile uint8_t present_tail = 0;  // Job going out
+volatile bool present_active = false;
+uint8_t present_region = 0;         // Region of the tail job going out
+uint32_t present_fence_waits = 0;   // Frames core 1 waited for a buffer to go out
+spin_lock_t* present_lock = NULL;
+
+// Rebuild the palette-to-RGB565 LUT, folding in the palette-domain effects
+void update_palette_lut() {
+    // Cleared first so a palette write during the rebuild is picked up next frame
+    palette_lut_dirty = false;
+
+    bool fade = (display_bpp == 8 && effects.fade_level > 0);
+    uint16_t fade_scale = (effects.fade_mode == 1) ? 255 - effects.fade_level : effects.fade_level;
+    uint16_t flash = effects.flash_frames ? effects.flash_remaining * 255 / effects.flash_frames : 0;
+
+    // Which palette entry each LUT entry shows, after cycling
+    uint8_t source[256];
+    for (int i = 0; i < 256; i++) {
+        source[i] = i;
+    }
+    for (int c = 0; c < MAX_PALETTE_CYCLES; c++) {
+        const PaletteCycle* cycle = &palette_cycles[c];
+        if (cycle->frames_per_step == 0 || cycle->count < 2) continue;
+
+        for (int i = 0; i < cycle->count; i++) {
+            source[cycle->start + (i + cycle->phase) % cycle->count] = cycle->start + i;
+        }
+    }
+
+    for (int i = 0; i < 256; i++) {
+        const RGB* color = &palette[source[i]];
+        uint16_t r = color->r;
+        uint16_t g = color->g;
+        uint16_t b = color->b;
+
+        if (effects.color_lut_enabled) {
+            r = color_lut[0][r];
+            g = color_lut[1][g];
+            b = color_lut[2][b];
+        }
+
+        if (fade) {
+            r = r * fade_scale / 255;
+            g = g * fade_scale / 255;
+            b = b * fade_scale / 255;
+        }
+
+        if (flash) {
+            r += (effects.flash_r - (int)r) * flash / 255;
+            g += (effects.flash_g - (int)g) * flash / 255;
+            b += (effects.flash_b - (int)b) * flash / 255;
+        }
+
+        palette_rgb565[i] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+}
+
+// Step flash and palette cycling, once per frame
+void advance_palette_effects() {
+    if (effects.flash_remaining > 0) {
+        effects.flash_remaining--;
+        palette_lut_dirty = true;
+    }
+
+    for (int c = 0; c < MAX_PALETTE_CYCLES; c++) {
+        PaletteCycle* cycle = &palette_cycles[c];
+        if (cycle->frames_per_step == 0 || cycle->count < 2) continue;
+
+        if (++cycle->timer >= cycle->frames_per_step) {
+            cycle->timer = 0;
+            cycle->phase = (cycle->phase + 1) % cycle->count;
+            palette_lut_dirty = true;
+        }
+    }
+}
+
+// Bring the scan-out palette up to date for this frame.
+// Returns true when it changed, so every pixel on screen may look different.
+bool begin_frame_palette() {
+    bool changed = palette_lut_dirty;
+
+    if (changed) {
+        // Queued 8bpp frames are converted through the LUT as they go out
+        if (display_bpp != 16) {
+            present_wait_idle();
+        }
+        update_palette_lut();
+    }
+
+    advance_palette_effects();
+    return changed;
+}
+
+// Convert one line of palette indices to RGB565
+void convert_scanout_line(uint16_t* dst, const uint8_t* src, uint16_t width) {
+    uint16_t x = 0;
+
+    // Unrolled by 4, the LUT lookup is the only work per pixel
+    for (; x + 4 <= width; x += 4) {
+        dst[x]     = palette_rgb565[src[x]];
+        dst[x + 1] = palette_rgb565[src[x + 1]];
+        dst[x + 2] = palette_rgb565[src[x + 2]];
+        dst[x + 3] = palette_rgb565[src[x + 3]];
+    }
+
+    for (; x < width; x++) {
+        dst[x] = palette_rgb565[src[x]];
+    }
+}
+
+// Mosaic at fetch: each pixel takes the color of its block's first column.
+// The row is a whole screen line, x0 is where the window starts in it.
+void convert_scanout_line_mosaic(uint16_t* dst, const uint8_t* row, uint16_t x0, uint16_t width, uint8_t size) {
+    uint16_t x = 0;
+
+    while (x < width) {
+        uint16_t block = (x0 + x) - (x0 + x) % size;
+        uint16_t color = palette_rgb565[row[block]];
+
+        uint16_t end = min(width, block + size - x0);
+        while (x < end) {
+            dst[x++] = color;
+        }
+    }
+}
+
+void copy_scanout_line_mosaic(uint16_t* dst, const uint16_t* row, uint16_t x0, uint16_t width, uint8_t size) {
+    uint16_t x = 0;
+
+    while (x < width) {
+        uint16_t block = (x0 + x) - (x0 + x) % size;
+        uint16_t color = row[block];
+
+        uint16_t end = min(width, block + size - x0);
+        while (x < end) {
+            dst[x++] = color;
+        }
+    }
+}
+
+// Point a channel's chain at another channel (or at itself to stop chaining)
+void set_scanout_chain(uint8_t buffer, uint8_t chain_to) {
+    channel_config_set_chain_to(&display_dma_configs[buffer], chain_to);
+    dma_channel_set_config(display_dma_channels[buffer], &display_dma_configs[buffer], false);
+}
+
+// DMA completion interrupt: count finished lines
+void scanout_dma_irq_handler() {
+    for (int b = 0; b < 2; b++) {
+        uint8_t channel = display_dma_channels[b];
+
+        if (dma_channel_get_irq0_status(channel)) {
+            dma_channel_acknowledge_irq0(channel);
+            scanout_lines_sent += scanout_channel_lines[b];
+        }
+    }
+
+    // Queued frames are fed from here while core 1 composes the next one
+    if (present_active) {
+        uint32_t irq = spin_lock_blocking(present_lock);
+        present_service();
+        spin_unlock(present_lock, irq);
+    }
+}
+
+// Wait until the given number of lines of this frame have been sent
+void scanout_wait_lines(uint32_t count) {
+    if (scanout_lines_sent >= count) return;
+
+    uint32_t wait_start = time_us_32();
+    while (scanout_lines_sent < count) {
+        tight_loop_contents();
+    }
+    scanout.wait_us += time_us_32() - wait_start;
+}
+
+// Wait until the channel that will carry the next transfer is idle.
+// Its previous transfer (two transfers back) has then completed.
+void scanout_wait_for_slot() {
+    scanout_wait_lines(scanout.channel_end[scanout.next_transfer & 1]);
+}
+
+// Start a frame's timing; its pixels go out through one or more windows
+void scanout_begin_frame() {
+    scanout.dma_started = false;
+    scanout.convert_us = 0;
+    scanout.wait_us = 0;
+    scanout.late_lines = 0;
+}
+
+// Set a display window and switch to 16-bit SPI frames for its lines
+void scanout_open_window(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    scanout.width = width;
+    scanout.height = height;
+    scanout.next_line = 0;
+    scanout.next_transfer = 0;
+    scanout.channel_end[0] = 0;
+    scanout.channel_end[1] = 0;
+    scanout_lines_sent = 0;
+
+    display_set_window(x, y, width, height);
+
+    // Pixel data goes out as 16-bit SPI frames so RGB565 is sent MSB first
+    gpio_put(DISPLAY_DC_PIN, 1); // Data mode
+    spi_set_format(DISPLAY_SPI_PORT, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+}
+
+// Start a full-screen frame
+void scanout_begin(uint16_t width, uint16_t height) {
+    scanout_begin_frame();
+    scanout_open_window(0, 0, width, height);
+}
+
+// Queue the next count lines as one transfer. The rows are contiguous and must stay
+// untouched until they have been sent.
+void scanout_queue_lines(const uint16_t* rows, uint16_t count) {
+    uint16_t transfer = scanout.next_transfer++;
+    uint8_t buffer = transfer & 1;
+    uint8_t channel = display_dma_channels[buffer];
+    uint8_t prev_channel = display_dma_channels[buffer ^ 1];
+
+    // The channel is free once its previous transfer has gone out
+    scanout_wait_lines(scanout.channel_end[buffer]);
+
+    scanout.next_line += count;
+    scanout.channel_end[buffer] = scanout.next_line;
+    scanout_channel_lines[buffer] = count;
+
+    // Arm this transfer without chaining onwards, the next queued one sets that up
+    set_scanout_chain(buffer, channel);
+    dma_channel_set_read_addr(channel, rows, false);
+    dma_channel_set_trans_count(channel, (uint32_t)scanout.width * count, false);
+
+    if (transfer == 0) {
+        if (!scanout.dma_started) {
+            scanout.dma_start = time_us_32();
+            scanout.dma_started = true;
+        }
+        dma_channel_start(channel);
+        return;
+    }
+
+    // Let the previous transfer trigger this one when it completes
+    set_scanout_chain(buffer ^ 1, channel);
+
+    // The previous transfer can only have started (the one before it is done), so if
+    // neither channel is busy it finished before the chain was set and nothing started this one
+    if (!dma_channel_is_busy(prev_channel) && !dma_channel_is_busy(channel) &&
+        scanout_lines_sent < scanout.next_line) {
+        dma_channel_start(channel);
+        scanout.late_lines += count;
+    }
+}
+
+// Queue the next line. The row must stay untouched until the line has been sent.
+void scanout_queue_line(const uint16_t* row) {
+    scanout_queue_lines(row, 1);
+}
+
+// Wait for the last line of the window and release the display
+void scanout_close_window() {
+    scanout_wait_lines(scanout.height);
+
+    // Wait until the display SPI has shifted out everything DMA gave it
+    while (spi_is_busy(DISPLAY_SPI_PORT)) {
+        tight_loop_contents();
+    }
+
+    gpio_put(DISPLAY_CS_PIN, 1); // Deselect display
+
+    // Back to 8-bit frames for display commands
+    spi_set_format(DISPLAY_SPI_PORT, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+}
+
+// Update scan-out statistics once the frame's last window is closed
+void scanout_end_frame() {
+    scanout_stats.dma_busy_us = scanout.dma_started ? time_us_32() - scanout.dma_start : 0;
+    scanout_stats.convert_us = scanout.convert_us;
+    scanout_stats.wait_us = scanout.wait_us;
+    scanout_stats.late_lines = scanout.late_lines;
+    scanout_stats.dma_busy_percent = min(100, scanout_stats.dma_busy_us * 100 / FRAME_INTERVAL_US);
+    scanout_stats.frames++;
+
+    // Signal VSYNC to CPU if enabled. Queued frames end in the DMA interrupt,
+    // so this busy-waits rather than sleeps.
+    if (vblank_callback_enabled) {
+        gpio_put(VSYNC_PIN, 0);
+        busy_wait_us_32(10);
+        gpio_put(VSYNC_PIN, 1);
+    }
+}
+
+// Finish a full-screen frame
+void scanout_end() {
+    scanout_close_window();
+    scanout_end_frame();
+}
+
+// Set at frame start when the whole frame has to go out even where nothing was redrawn
+bool scanout_full_frame = false;
+
+// Send the damaged parts of a composed frame to the display, one window per dirty region
+void send_frame_to_display(const uint8_t* pixels) {
+    uint16_t width = display_width;
+    uint8_t mosaic = (effects.mosaic_size > 1) ? effects.mosaic_size : 0;
+    Rect full_frame = {0, 0, display_width, display_height};
+    const Rect* regions = scanout_full_frame ? &full_frame : scanout_regions;
+    int region_count = scanout_full_frame ? 1 : scanout_region_count;
+
+    scanout_begin_frame();
+
+    for (int i = 0; i < region_count; i++) {
+        const Rect* region = &regions[i];
+        uint16_t y_end = region->y + region->height;
+
+        scanout_open_window(region->x, region->y, region->width, region->height);
+
+        for (uint16_t line = region->y; line < y_end; line++) {
+            // Mosaic repeats the first line of each block
+            uint16_t src_line = mosaic ? line - line % mosaic : line;
+
+            if (display_bpp == 16 && !mosaic) {
+                // The framebuffer is already RGB565, queue its rows directly
+                scanout_queue_line(&((const uint16_t*)pixels)[line * width + region->x]);
+                continue;
+            }
+
+            uint16_t* row = scanout_lines[(line - region->y) & 1];
+
+            // Convert into the line buffer as soon as its last line has gone out
+            scanout_wait_for_slot();
+
+            uint32_t convert_start = time_us_32();
+            if (display_bpp == 16) {
+                copy_scanout_line_mosaic(row, &((const uint16_t*)pixels)[src_line * width], region->x, region->width, mosaic);
+            } else {
+                copper_run_scanout(line);
+                if (mosaic) {
+                    convert_scanout_line_mosaic(row, &pixels[src_line * width], region->x, region->width, mosaic);
+                } else {
+                    convert_scanout_line(row, &pixels[line * width + region->x], region->width);
+                }
+            }
+            scanout.convert_us += time_us_32() - convert_start;
+
+            scanout_queue_line(row);
+        }
+
+        scanout_close_window();
+    }
+
+    scanout_end_frame();
+}
+
+// Setup the DMA channels for display scan-out
+void setup_display_dma() {
+    for (int b = 0; b < 2; b++) {
+        display_dma_channels[b] = dma_claim_unused_channel(true);
+    }
+    display_dma_channel = display_dma_channels[0];
+
+    for (int b = 0; b < 2; b++) {
+        // Configure DMA channel
+        dma_channel_config dma_config = dma_channel_get_default_config(display_dma_channels[b]);
+        channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_16);
+        channel_config_set_read_increment(&dma_config, true);
+        channel_config_set_write_increment(&dma_config, false);
+
+        // Set SPI as DREQ
+        channel_config_set_dreq(&dma_config, spi_get_dreq(DISPLAY_SPI_PORT, true));
+        display_dma_configs[b] = dma_config;
+
+        dma_channel_configure(
+            display_dma_channels[b],
+            &dma_config,
+            &spi_get_hw(DISPLAY_SPI_PORT)->dr, // Write to SPI data register
+            scanout_lines[b],                  // Source is set for each line
+            0,                                 // Count is set for each line
+            false                              // Don't start yet
+        );
+
+        dma_channel_set_irq0_enabled(display_dma_channels[b], true);
+    }
+
+    // The completion interrupt is serviced by the core that runs this setup
+    irq_set_exclusive_handler(DMA_IRQ_0, scanout_dma_irq_handler);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    memset(&scanout_stats, 0, sizeof(scanout_stats));
+}
+
+// Line Renderer
+// Instead of composing a full frame, layers and sprites are composed one group of
+// LINE_GROUP_HEIGHT scanlines at a time and queued for scan-out straight away. Two
+// RGB565 group buffers are used in ping-pong: DMA streams group N from one while group
+// N+1 is composed. In 16bpp mode composition writes the group buffer directly; in 8bpp
+// it writes palette indices into a small index buffer that is converted afterwards.
+// Only a few KB are needed instead of a full framebuffer.
+uint16_t* line_group_buffers[2] = {NULL, NULL};
+uint8_t* line_group_indices = NULL;
+uint16_t sprite_group_overflow = 0;
+
+// Get the on-screen rectangle of a sprite, false if it isn't drawable
+bool get_sprite_screen_rect(uint8_t sprite_id, int16_t* x, int16_t* y, uint16_t* width, uint16_t* height) {
+    Sprite* sprite = &sprites[sprite_id];
+
+    if (!sprite->visible) return false;
+
+    SpritePattern* pattern = &sprite_patterns[sprite->pattern_id];
+    if (!pattern->in_use) return false;
+
+    *width = pattern->width * 8;
+    *height = pattern->height * 8;
+
+    // Apply scaling if needed
+    if (sprite->scale != 128) { // 128 = 1.0 scale
+        *width = (*width * sprite->scale) / 128;
+        *height = (*height * sprite->scale) / 128;
+    }
+
+    // Convert from fixed-point to pixel coordinates
+    *x = sprite->x >> 8;
+    *y = sprite->y >> 8;
+
+    return true;
+}
+
+// Bin visible sprites into the line groups they cover, keeping render order
+void bin_sprites_to_groups() {
+    uint16_t group_count = (display_height + LINE_GROUP_HEIGHT - 1) / LINE_GROUP_HEIGHT;
+
+    memset(group_sprite_count, 0, sizeof(group_sprite_count));
+
+    for (int p = 0; p < SPRITE_PRIORITIES; p++) {
+        for (uint8_t sprite_id = sprite_list_head[p]; sprite_id != SPRITE_LIST_END;
+             sprite_id = sprites[sprite_id].list_next) {
+            int16_t x, y;
+            uint16_t width, height;
+
+            if (!get_sprite_screen_rect(sprite_id, &x, &y, &width, &height)) continue;
+
+            // Skip completely off-screen sprites
+            if (x + width <= 0 || x >= display_width || y + height <= 0 || y >= display_height) {
+                continue;
+            }
+
+            int first_group = max(0, y) / LINE_GROUP_HEIGHT;
+            int last_group = min(display_height - 1, y + height - 1) / LINE_GROUP_HEIGHT;
+
+            for (int g = first_group; g <= last_group && g < group_count; g++) {
+                if (group_sprite_count[g] < MAX_SPRITES_PER_GROUP) {
+                    group_sprites[g][group_sprite_count[g]++] = sprite_id;
+                } else {
+                    // Too many sprites on these lines, drop like sprite-per-line hardware would
+                    sprite_group_overflow++;
+                }
+            }
+        }
+
+        for (int g = 0; g < group_count; g++) {
+            group_priority_end[g][p] = group_sprite_count[g];
+        }
+    }
+}
+
+// Allocate line group buffers for the current display mode
+bool allocate_line_group_buffers() {
+    free_line_group_buffers();
+
+    uint32_t group_pixels = display_width * LINE_GROUP_HEIGHT;
+
+    for (int b = 0; b < 2; b++) {
+        line_group_buffers[b] = safe_malloc(group_pixels * sizeof(uint16_t));
+        if (line_group_buffers[b] == NULL) {
+            free_line_group_buffers();
+            return false;
+        }
+    }
+
+    // 8bpp composes palette indices first
+    if (display_bpp != 16) {
+        line_group_indices = safe_malloc(group_pixels);
+        if (line_group_indices == NULL) {
+            free_line_group_buffers();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void free_line_group_buffers() {
+    for (int b = 0; b < 2; b++) {
+        if (line_group_buffers[b] != NULL) {
+            free(line_group_buffers[b]);
+            line_group_buffers[b] = NULL;
+        }
+    }
+
+    if (line_group_indices != NULL) {
+        free(line_group_indices);
+        line_group_indices = NULL;
+    }
+}
+
+// Render all layers and sprites into the current render target
+void compose_render_target(bool clip_to_dirty) {
+    // Render each layer by priority
+    for (int p = 0; p < 4; p++) {
+        // First render background layers at this priority
+        for (int l = 0; l < MAX_LAYERS; l++) {
+            if (layers[l].enabled && layers[l].priority == p) {
+                trace_begin(ZONE_GPU_RENDER_LAYER, l);
+                if (layers[l].rotation_enabled) {
+                    render_rotated_layer(l);
+                } else {
+                    render_layer(l, clip_to_dirty);
+                }
+                trace_end(ZONE_GPU_RENDER_LAYER, l);
+            }
+        }
+
+        // Then render sprites at this priority
+        trace_begin(ZONE_GPU_RENDER_SPRITES, p);
+        render_sprites_at_priority(p);
+        trace_end(ZONE_GPU_RENDER_SPRITES, p);
+    }
+}
+
+// Copper
+// A copper program is a list of register writes tagged with the scanline they
+// take effect on. It is recorded once between COPPER_LIST_START and COPPER_END
+// and then replayed by core 1 on every frame, so raster splits, gradient
+// palettes and parallax bands cost no command traffic after the upload.
+// SET_PALETTE_ENTRY, SCROLL_LAYER, COPPER_WAIT_LINE and COPPER_SET_REGISTER
+// received while recording are compiled into the program instead of being
+// executed; everything else runs as usual.
+#define MAX_COPPER_OPS 128
+
+enum {
+    COPPER_OP_PALETTE = 1,   // target=index, a=RGB565
+    COPPER_OP_SCROLL = 2,    // target=layer, a=x, b=y
+    COPPER_OP_REGISTER = 3   // target=register, a=value
+};
+
+#define COPPER_KIND(type) (1 << (type))
+
+// Register numbers for COPPER_SET_REGISTER, four per layer
+#define COPPER_REG_LAYER_SCROLL_X 0
+#define COPPER_REG_LAYER_SCROLL_Y 1
+#define COPPER_REG_LAYER_ENABLE 2
+#define COPPER_REG_LAYER_PRIORITY 3
+#define COPPER_REGS_PER_LAYER 4
+
+typedef struct {
+    int16_t line;
+    uint8_t type;
+    uint8_t target;
+    uint16_t a;
+    uint16_t b;
+} CopperOp;
+
+typedef struct {
+    CopperOp ops[MAX_COPPER_OPS];
+    uint16_t count;
+    uint8_t kinds;           // COPPER_KIND bits of the ops present
+} CopperProgram;
+
+// Layer state as it was before the copper touched it this frame
+typedef struct {
+    uint16_t scroll_x;
+    uint16_t scroll_y;
+    bool enabled;
+    uint8_t priority;
+} CopperLayerState;
+
+// Core 0 records into the program core 1 is not running; copper_mutex covers
+// the hand-over at the start of a frame
+CopperProgram copper_programs[2];
+uint8_t copper_active = 0;
+bool copper_pending = false;
+bool copper_recording = false;
+int16_t copper_record_line = 0;
+mutex_t copper_mutex;
+
+// Per-frame replay state, core 1 only
+CopperLayerState copper_saved[MAX_LAYERS];
+CopperLayerState copper_written[MAX_LAYERS];
+uint8_t copper_touched[MAX_LAYERS];   // COPPER_REG bits written this frame
+uint16_t copper_compose_pc = 0;
+uint16_t copper_scanout_pc = 0;
+
+// Append an op at the current WAIT line
+bool copper_record_op(uint8_t type, uint8_t target, uint16_t a, uint16_t b) {
+    CopperProgram* program = &copper_programs[copper_active ^ 1];
+
+    if (program->count >= MAX_COPPER_OPS) {
+        return false;
+    }
+
+    CopperOp* op = &program->ops[program->count++];
+    op->line = copper_record_line;
+    op->type = type;
+    op->target = target;
+    op->a = a;
+    op->b = b;
+    program->kinds |= COPPER_KIND(type);
+    return true;
+}
+
+// Handle copper commands, and capture recordable commands while a list is open.
+// Returns true when the command was consumed.
+bool copper_record_command(uint8_t cmd_id, const uint8_t* data, uint8_t length) {
+    switch (cmd_id) {
+        case CMD_COPPER_LIST_START:
+            // The size byte is only a hint, the program ends at COPPER_END
+            mutex_enter_blocking(&copper_mutex);
+            copper_pending = false;
+            copper_recording = true;
+            copper_record_line = 0;
+            copper_programs[copper_active ^ 1].count = 0;
+            copper_programs[copper_active ^ 1].kinds = 0;
+            mutex_exit(&copper_mutex);
+            send_ack_to_cpu(CMD_COPPER_LIST_START);
+            return true;
+
+        case CMD_COPPER_END:
+            if (!copper_recording) {
+                send_error_to_cpu(CMD_COPPER_END, ERR_INVALID_PARAMETER);
+                return true;
+            }
+
+            // An empty list turns the copper off
+            mutex_enter_blocking(&copper_mutex);
+            copper_recording = false;
+            copper_pending = true;
+            mutex_exit(&copper_mutex);
+            send_ack_to_cpu(CMD_COPPER_END);
+            return true;
+
+        case CMD_COPPER_WAIT_LINE:
+            {
+                // One byte covers 240 lines, taller modes send the line as two bytes
+                int16_t line = (length >= 2) ? ((data[0] << 8) | data[1]) : data[0];
+
+                if (!copper_recording || line < copper_record_line || line >= MAX_DISPLAY_HEIGHT) {
+                    send_error_to_cpu(CMD_COPPER_WAIT_LINE, ERR_INVALID_PARAMETER);
+                    return true;
+                }
+
+                copper_record_line = line;
+                send_ack_to_cpu(CMD_COPPER_WAIT_LINE);
+            }
+            return true;
+
+        case CMD_COPPER_SET_REGISTER:
+            {
+                uint8_t reg = data[0];
+                uint16_t value = (data[1] << 8) | data[2];
+
+                if (!copper_recording || reg >= MAX_LAYERS * COPPER_REGS_PER_LAYER) {
+                    send_error_to_cpu(CMD_COPPER_SET_REGISTER, ERR_INVALID_PARAMETER);
+                    return true;
+                }
+
+                if (!copper_record_op(COPPER_OP_REGISTER, reg, value, 0)) {
+                    send_error_to_cpu(CMD_COPPER_SET_REGISTER, ERR_OUT_OF_MEMORY);
+                    return true;
+                }
+
+                send_ack_to_cpu(CMD_COPPER_SET_REGISTER);
+            }
+            return true;
+
+        case CMD_SET_PALETTE_ENTRY:
+            if (!copper_recording) {
+                return false;
+            }
+
+            {
+                uint16_t rgb565 = ((data[1] & 0xF8) << 8) | ((data[2] & 0xFC) << 3) | (data[3] >> 3);
+
+                if (!copper_record_op(COPPER_OP_PALETTE, data[0], rgb565, 0)) {
+                    send_error_to_cpu(CMD_SET_PALETTE_ENTRY, ERR_OUT_OF_MEMORY);
+                    return true;
+                }
+
+                send_ack_to_cpu(CMD_SET_PALETTE_ENTRY);
+            }
+            return true;
+
+        case CMD_SCROLL_LAYER:
+            if (!copper_recording) {
+                return false;
+            }
+
+            {
+                uint8_t layer_id = data[0];
+                uint16_t x_scroll = (data[1] << 8) | data[2];
+                uint16_t y_scroll = (data[3] << 8) | data[4];
+
+                if (layer_id >= MAX_LAYERS) {
+                    send_error_to_cpu(CMD_SCROLL_LAYER, ERR_INVALID_PARAMETER);
+                    return true;
+                }
+
+                if (!copper_record_op(COPPER_OP_SCROLL, layer_id, x_scroll, y_scroll)) {
+                    send_error_to_cpu(CMD_SCROLL_LAYER, ERR_OUT_OF_MEMORY);
+                    return true;
+                }
+
+                send_ack_to_cpu(CMD_SCROLL_LAYER);
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Close any open list and replace the running program with an empty one
+void copper_reset() {
+    mutex_enter_blocking(&copper_mutex);
+    copper_recording = false;
+    copper_programs[copper_active ^ 1].count = 0;
+    copper_programs[copper_active ^ 1].kinds = 0;
+    copper_pending = true;
+    mutex_exit(&copper_mutex);
+}
+
+// Write one layer register, remembering it so the frame can be undone
+void copper_write_layer(uint8_t layer_id, uint8_t field, uint16_t value) {
+    Layer* layer = &layers[layer_id];
+    CopperLayerState* written = &copper_written[layer_id];
+
+    switch (field) {
+        case COPPER_REG_LAYER_SCROLL_X:
+            layer->scroll_x = written->scroll_x = value;
+            break;
+        case COPPER_REG_LAYER_SCROLL_Y:
+            layer->scroll_y = written->scroll_y = value;
+            break;
+        case COPPER_REG_LAYER_ENABLE:
+            layer->enabled = written->enabled = (value != 0);
+            break;
+        case COPPER_REG_LAYER_PRIORITY:
+            layer->priority = written->priority = value & 3;
+            break;
+    }
+
+    copper_touched[layer_id] |= 1 << field;
+}
+
+// Execute the ops of the given kinds up to and including the given line
+void copper_run(uint16_t* pc, int16_t line, uint8_t kinds) {
+    const CopperProgram* program = &copper_programs[copper_active];
+
+    while (*pc < program->count && program->ops[*pc].line <= line) {
+        const CopperOp* op = &program->ops[*pc];
+        (*pc)++;
+
+        if (!(kinds & COPPER_KIND(op->type))) {
+            continue;
+        }
+
+        switch (op->type) {
+            case COPPER_OP_PALETTE:
+                palette_rgb565[op->target] = op->a;
+                break;
+            case COPPER_OP_SCROLL:
+                copper_write_layer(op->target, COPPER_REG_LAYER_SCROLL_X, op->a);
+                copper_write_layer(op->target, COPPER_REG_LAYER_SCROLL_Y, op->b);
+                break;
+            case COPPER_OP_REGISTER:
+                copper_write_layer(op->target / COPPER_REGS_PER_LAYER,
+                                   op->target % COPPER_REGS_PER_LAYER, op->a);
+                break;
+        }
+    }
+}
+
+// First line after the cursor with an op of the given kinds
+int16_t copper_next_line(uint16_t pc, uint8_t kinds) {
+    const CopperProgram* program = &copper_programs[copper_active];
+
+    for (; pc < program->count; pc++) {
+        if (kinds & COPPER_KIND(program->ops[pc].type)) {
+            return program->ops[pc].line;
+        }
+    }
+
+    return INT16_MAX;
+}
+
+// Ops applied while composing; in 8bpp palette writes wait for scan-out
+uint8_t copper_compose_kinds() {
+    uint8_t kinds = COPPER_KIND(COPPER_OP_SCROLL) | COPPER_KIND(COPPER_OP_REGISTER);
+
+    if (display_bpp == 16) {
+        kinds |= COPPER_KIND(COPPER_OP_PALETTE);
+    }
+
+    return kinds;
+}
+
+// Pick up a newly uploaded program and snapshot the state the copper may change
+void copper_begin_frame() {
+    mutex_enter_blocking(&copper_mutex);
+    bool swapped = copper_pending;
+    if (copper_pending) {
+        copper_active ^= 1;
+        copper_pending = false;
+    }
+    mutex_exit(&copper_mutex);
+
+    const CopperProgram* program = &copper_programs[copper_active];
+
+    // Raster splits change every band and palette splits every scanned-out line,
+    // so skip dirty tracking while they run, and redraw once after a program is
+    // replaced to clear the old splits
+    if (swapped || program->kinds != 0) {
+        mark_rect_dirty(0, 0, display_width, display_height);
+    }
+
+    for (int l = 0; l < MAX_LAYERS; l++) {
+        copper_saved[l].scroll_x = layers[l].scroll_x;
+        copper_saved[l].scroll_y = layers[l].scroll_y;
+        copper_saved[l].enabled = layers[l].enabled;
+        copper_saved[l].priority = layers[l].priority;
+        copper_touched[l] = 0;
+    }
+
+    copper_compose_pc = 0;
+    copper_scanout_pc = 0;
+}
+
+// Undo the copper's writes so the next frame starts from the commanded state.
+// A register core 0 changed in the meantime keeps the new value.
+void copper_end_frame() {
+    for (int l = 0; l < MAX_LAYERS; l++) {
+        uint8_t touched = copper_touched[l];
+
+        if ((touched & (1 << COPPER_REG_LAYER_SCROLL_X)) &&
+            layers[l].scroll_x == copper_written[l].scroll_x) {
+            layers[l].scroll_x = copper_saved[l].scroll_x;
+        }
+        if ((touched & (1 << COPPER_REG_LAYER_SCROLL_Y)) &&
+            layers[l].scroll_y == copper_written[l].scroll_y) {
+            layers[l].scroll_y = copper_saved[l].scroll_y;
+        }
+        if ((touched & (1 << COPPER_REG_LAYER_ENABLE)) &&
+            layers[l].enabled == copper_written[l].enabled) {
+            layers[l].enabled = copper_saved[l].enabled;
+        }
+        if ((touched & (1 << COPPER_REG_LAYER_PRIORITY)) &&
+            layers[l].priority == copper_written[l].priority) {
+            layers[l].priority = copper_saved[l].priority;
+        }
+    }
+
+    // Palette writes only went to the LUT, rebuild it from the palette
+    if (copper_programs[copper_active].kinds & COPPER_KIND(COPPER_OP_PALETTE)) {
+        palette_lut_dirty = true;
+    }
+}
+
+// Compose lines [y_start, y_end) of a render target in bands, running the
+// copper at each band's first line
+void compose_copper_bands(uint8_t* target, int16_t y_start, int16_t y_end, bool clip_to_dirty) {
+    uint8_t kinds = copper_compose_kinds();
+    uint8_t pixel_bytes = (display_bpp == 16) ? 2 : 1;
+    int16_t band_start = y_start;
+
+    while (band_start < y_end) {
+        copper_run(&copper_compose_pc, band_start, kinds);
+
+        int16_t band_end = min(y_end, copper_next_line(copper_compose_pc, kinds));
+
+        set_render_target(target + (uint32_t)(band_start - y_start) * display_width * pixel_bytes,
+                          band_start, band_end);
+        compose_render_target(clip_to_dirty);
+        band_start = band_end;
+    }
+
+    set_render_target(target, y_start, y_end);
+}
+
+// Apply palette ops due by this line before it is converted (8bpp scan-out)
+void copper_run_scanout(int16_t line) {
+    copper_run(&copper_scanout_pc, line, COPPER_KIND(COPPER_OP_PALETTE));
+}
+
+// Render and scan out a frame one line group at a time
+void render_frame_by_lines() {
+    uint16_t width = display_width;
+    uint16_t height = display_height;
+    uint16_t group_count = (height + LINE_GROUP_HEIGHT - 1) / LINE_GROUP_HEIGHT;
+    bool direct_rgb = (display_bpp == 16);
+
+    bin_sprites_to_groups();
+    scanout_begin(width, height);
+
+    for (uint16_t g = 0; g < group_count; g++) {
+        uint16_t* group_rgb = line_group_buffers[g & 1];
+        int16_t y_start = g * LINE_GROUP_HEIGHT;
+        int16_t y_end = min(height, y_start + LINE_GROUP_HEIGHT);
+        uint16_t lines = y_end - y_start;
+
+        // This buffer is free once the group sent from it two groups ago has gone out.
+        // Groups alternate channels like buffers, so that is the channel's last transfer.
+        scanout_wait_for_slot();
+
+        // Compose the group
+        uint8_t* target = direct_rgb ? (uint8_t*)group_rgb : line_group_indices;
+        memset(target, 0, width * lines * (direct_rgb ? 2 : 1));
+
+        current_line_group = g;
+        compose_copper_bands(target, y_start, y_end, false);
+
+        if (effects.fade_level > 0 && direct_rgb) {
+            apply_fade_effect(target, width * lines * 2);
+        }
+
+        // Convert palette indices for 8bpp
+        if (!direct_rgb) {
+            uint32_t convert_start = time_us_32();
+            for (uint16_t l = 0; l < lines; l++) {
+                copper_run_scanout(y_start + l);
+                convert_scanout_line(&group_rgb[l * width], &line_group_indices[l * width], width);
+            }
+            scanout.convert_us += time_us_32() - convert_start;
+        }
+
+        // Queue the whole group as one transfer, DMA reads it straight from the group buffer
+        scanout_queue_lines(group_rgb, lines);
+    }
+
+    current_line_group = -1;
+    scanout_end();
+}
+
+// Wait until core 1 has finished any frame it was asked for and queued frames
+// have gone out. Only core 0's main loop raises render_requested, and command
+// handlers run in that loop, so core 1 then stays idle until the handler returns
+// and render targets can be freed or swapped.
+void render_wait_idle() {
+    // Core 1 clears render_requested before rendering_in_progress
+    while (render_requested || rendering_in_progress) {
+        sleep_us(10);
+    }
+    present_wait_idle();
+}
+
+// Switch between full framebuffer and line renderer
+void set_render_mode(uint8_t mode) {
+    if (mode != RENDER_MODE_FRAMEBUFFER && mode != RENDER_MODE_LINE) {
+        send_error_to_cpu(CMD_SET_RENDER_TARGET, ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    render_wait_idle();
+
+    if (mode == RENDER_MODE_LINE) {
+        if (!allocate_line_group_buffers()) {
+            send_error_to_cpu(CMD_SET_RENDER_TARGET, ERR_OUT_OF_MEMORY);
+            return;
+        }
+
+        // The full framebuffer is no longer needed, give its memory back
+        if (framebuffer != NULL) {
+            free(framebuffer);
+            framebuffer = NULL;
+            framebuffer_size = 0;
+        }
+    } else {
+        free_line_group_buffers();
+
+        uint32_t required_size = display_width * display_height * (display_bpp == 16 ? 2 : 1);
+        framebuffer = safe_malloc(required_size);
+        if (framebuffer == NULL) {
+            // Stay in line mode
+            allocate_line_group_buffers();
+            send_error_to_cpu(CMD_SET_RENDER_TARGET, ERR_OUT_OF_MEMORY);
+            return;
+        }
+
+        framebuffer_size = required_size;
+        memset(framebuffer, 0, framebuffer_size);
+    }
+
+    render_mode = mode;
+    configure_present_buffers();
+
+    send_ack_to_cpu(CMD_SET_RENDER_TARGET);
+}
+
+// GPU status reporting
+// Status packet layout (big-endian):
+//   [0] 0x05, [1] length, [2] status flags (bit3 = line renderer, bit4 = frame
+//   pacing by FRAME_COMMIT), [3] current error, [4-7] frame counter,
+//   [8] scan-out DMA busy %, [9-10] late lines, [11-12] conversion time (us),
+//   [13-16] tile cache hits, [17-20] misses, [21-24] evictions, [25-26] tiles cached,
+//   [27-28] late commits, [29] present mode, [30-31] present fence waits
+void send_gpu_status() {
+    uint8_t status[64];
+    uint8_t pos = 2;
+
+    // Status flags
+    uint8_t flags = 0;
+    if (rendering_in_progress) flags |= 0x01;
+    if (double_buffering_enabled) flags |= 0x02;
+    if (in_error_recovery) flags |= 0x04;
+    if (render_mode == RENDER_MODE_LINE) flags |= 0x08;
+    if (frame_pacing_fenced) flags |= 0x10;
+    status[pos++] = flags;
+    status[pos++] = current_error;
+
+    status[pos++] = (frame_counter >> 24) & 0xFF;
+    status[pos++] = (frame_counter >> 16) & 0xFF;
+    status[pos++] = (frame_counter >> 8) & 0xFF;
+    status[pos++] = frame_counter & 0xFF;
+
+    // Scan-out pipeline
+    uint16_t convert_us = min(0xFFFF, scanout_stats.convert_us);
+    status[pos++] = scanout_stats.dma_busy_percent;
+    status[pos++] = scanout_stats.late_lines >> 8;
+    status[pos++] = scanout_stats.late_lines & 0xFF;
+    status[pos++] = convert_us >> 8;
+    status[pos++] = convert_us & 0xFF;
+
+    // Tile cache
+    uint32_t counters[3] = {
+        tile_cache_stats.hits,
+        tile_cache_stats.misses,
+        tile_cache_stats.evictions
+    };
+    for (int i = 0; i < 3; i++) {
+        status[pos++] = (counters[i] >> 24) & 0xFF;
+        status[pos++] = (counters[i] >> 16) & 0xFF;
+        status[pos++] = (counters[i] >> 8) & 0xFF;
+        status[pos++] = counters[i] & 0xFF;
+    }
+    status[pos++] = tile_cache_count >> 8;
+    status[pos++] = tile_cache_count & 0xFF;
+
+    // Frame pacing
+    uint16_t late = min(0xFFFF, late_commits);
+    status[pos++] = late >> 8;
+    status[pos++] = late & 0xFF;
+
+    // Present queue
+    uint16_t fence_waits = min(0xFFFF, present_fence_waits);
+    status[pos++] = present_mode;
+    status[pos++] = fence_waits >> 8;
+    status[pos++] = fence_waits & 0xFF;
+
+    status[0] = CMD_GET_STATUS;
+    status[1] = pos;
+
+    send_data_to_cpu(status, pos);
+}
+
+// Split the framebuffer arena into present buffers for the current display and render mode
+void configure_present_buffers() {
+    present_wait_idle();
+
+    uint32_t frame_size = (uint32_t)display_width * display_height * (display_bpp == 16 ? 2 : 1);
+    uint32_t count = 0;
+    if (render_mode == RENDER_MODE_FRAMEBUFFER && framebuffer != NULL) {
+        count = min(PRESENT_MAX_BUFFERS, framebuffer_size / frame_size);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        present_buffers[i] = framebuffer + i * frame_size;
+    }
+
+    if (render_mode == RENDER_MODE_LINE) {
+        present_mode = PRESENT_MODE_LINES;
+        present_slot_count = 0;
+    } else if (count >= 2) {
+        present_mode = (count == 3) ? PRESENT_MODE_TRIPLE : PRESENT_MODE_DOUBLE;
+        present_slot_count = count;
+    } else {
+        present_mode = PRESENT_MODE_HALF_FRAME;
+        present_buffers[0] = framebuffer;
+        present_slot_count = 2;
+    }
+
+    present_history_depth = (count >= 2) ? count - 1 : 0;
+    memset(damage_history, 0, sizeof(damage_history));
+    present_draw_slot = 0;
+    double_buffering_enabled = (count >= 2);
+
+    // The other buffers hold nothing yet, redraw them in full
+    mark_rect_dirty(0, 0, display_width, display_height);
+}
+
+// Open the display window for the tail job's current region
+void present_open_window(const PresentJob* job) {
+    const Rect* region = &job->regions[present_region];
+    scanout_open_window(region->x, region->y, region->width, region->height);
+}
+
+// Start sending the tail job
+void present_start_job() {
+    const PresentJob* job = &present_queue[present_tail];
+
+    if (job->first) {
+        scanout_begin_frame();
+    }
+
+    present_region = 0;
+    if (job->region_count > 0) {
+        present_open_window(job);
+    }
+}
+
+// Convert and queue lines of the open window as far as the two line buffers allow
+void present_queue_lines(const PresentJob* job) {
+    const Rect* region = &job->regions[present_region];
+    uint8_t pixel_bytes = (display_bpp == 16) ? 2 : 1;
+
+    // A line buffer is free once the line two back has gone out
+    while (scanout.next_line < scanout.height && scanout.next_line <= scanout_lines_sent + 1) {
+        uint16_t line = region->y + scanout.next_line;
+        const uint8_t* src = job->pixels +
+            ((uint32_t)(line - job->y_start) * display_width + region->x) * pixel_bytes;
+
+        if (display_bpp == 16) {
+            // Already RGB565, queue the row directly
+            scanout_queue_line((const uint16_t*)src);
+            continue;
+        }
+
+        uint16_t* row = scanout_lines[scanout.next_line & 1];
+        uint32_t convert_start = time_us_32();
+        convert_scanout_line(row, src, region->width);
+        scanout.convert_us += time_us_32() - convert_start;
+
+        scanout_queue_line(row);
+    }
+}
+
+// Advance the queue: feed the open window, move on to the next region and job.
+// Called with present_lock held, from the DMA interrupt or when a job is submitted.
+void present_service() {
+    while (present_active) {
+        const PresentJob* job = &present_queue[present_tail];
+
+        if (present_region < job->region_count) {
+            present_queue_lines(job);
+            if (scanout_lines_sent < scanout.height) return;
+
+            scanout_close_window();
+            if (++present_region < job->region_count) {
+                present_open_window(job);
+                continue;
+            }
+        }
+
+        // The part is out, its pixels can be composed again
+        if (job->last) {
+            scanout_end_frame();
+        }
+        present_busy &= ~(1 << job->slot);
+
+        present_tail = (present_tail + 1) % PRESENT_QUEUE_SIZE;
+        if (present_tail == present_head) {
+            present_active = false;
+            return;
+        }
+        present_start_job();
+    }
+}
+
+// Queue a composed part holding screen lines [y_start, y_end) for scan-out
+void present_submit(const uint8_t* pixels, uint16_t y_start, uint16_t y_end, uint8_t slot, bool first, bool last) {
+    // Every queued job holds a distinct busy slot, so the head job is always free
+    PresentJob* job = &present_queue[present_head];
+    Rect full_frame = {0, 0, display_width, display_height};
+    const Rect* regions = scanout_full_frame ? &full_frame : scanout_regions;
+    int region_count = scanout_full_frame ? 1 : scanout_region_count;
+
+    job->pixels = pixels;
+    job->y_start = y_start;
+    job->y_end = y_end;
+    job->slot = slot;
+    job->first = first;
+    job->last = last;
+    job->region_count = 0;
+
+    // Keep the part of each region that lies in this part of the frame
+    for (int i = 0; i < region_count; i++) {
+        uint16_t top = max(regions[i].y, y_start);
+        uint16_t bottom = min(regions[i].y + regions[i].height, y_end);
+        if (top >= bottom) continue;
+
+        Rect* r = &job->regions[job->region_count++];
+        r->x = regions[i].x;
+        r->y = top;
+        r->width = regions[i].width;
+        r->height = bottom - top;
+    }
+
+    uint32_t irq = spin_lock_blocking(present_lock);
+    present_busy |= 1 << slot;
+    present_head = (present_head + 1) % PRESENT_QUEUE_SIZE;
+    if (!present_active) {
+        present_active = true;
+        present_start_job();
+        present_service();
+    }
+    spin_unlock(present_lock, irq);
+}
+
+// Wait until a slot's last part has gone out before composing into it again
+void present_wait_slot(uint8_t slot) {
+    if (!(present_busy & (1 << slot))) return;
+
+    trace_begin(ZONE_GPU_PRESENT_WAIT, slot);
+    present_fence_waits++;
+    while (present_busy & (1 << slot)) {
+        tight_loop_contents();
+    }
+    trace_end(ZONE_GPU_PRESENT_WAIT, slot);
+}
+
+// Wait until everything queued has gone out
+void present_wait_idle() {
+    while (present_active) {
+        tight_loop_contents();
+    }
+}
+
+// Queued parts are converted without the copper, and mosaic reads lines of the
+// other half, so frames with either are composed and sent in one go instead
+bool present_queue_usable() {
+    return effects.mosaic_size <= 1 &&
+           !(copper_programs[copper_active].kinds & COPPER_KIND(COPPER_OP_PALETTE));
+}
+
+// Compose screen lines [y_start, y_end) into a present buffer
+void compose_present_part(uint8_t* target, int16_t y_start, int16_t y_end) {
+    compose_copper_bands(target, y_start, y_end, true);
+
+    // Apply global effects
+    if (effects.fade_level > 0 && display_bpp == 16) {
+        apply_fade_effect(target, (uint32_t)(y_end - y_start) * display_width * 2);
+    }
+}
+
+// Compose this frame into free present buffers and queue it for scan-out.
+// Frames the queue can't send are composed and sent synchronously.
+void present_frame() {
+    uint32_t line_bytes = display_width * (display_bpp == 16 ? 2 : 1);
+    bool queued = present_queue_usable();
+
+    if (present_mode == PRESENT_MODE_HALF_FRAME) {
+        uint16_t split = display_height / 2;
+        uint8_t* bottom = framebuffer + split * line_bytes;
+
+        if (!queued) {
+            present_wait_idle();
+            compose_present_part(framebuffer, 0, display_height);
+            trace_begin(ZONE_GPU_SCANOUT, 0);
+            send_frame_to_display(framebuffer);
+            trace_end(ZONE_GPU_SCANOUT, 0);
+            return;
+        }
+
+        // Each half still holds the previous frame, so only this frame's damage is redrawn
+        present_wait_slot(0);
+        compose_present_part(framebuffer, 0, split);
+        present_submit(framebuffer, 0, split, 0, true, false);
+
+        present_wait_slot(1);
+        compose_present_part(bottom, split, display_height);
+        present_submit(bottom, split, display_height, 1, false, true);
+        return;
+    }
+
+    uint8_t slot = present_draw_slot;
+    uint8_t* target = present_buffers[slot];
+    present_draw_slot = (slot + 1) % present_slot_count;
+
+    if (!queued) {
+        present_wait_idle();
+        compose_present_part(target, 0, display_height);
+        trace_begin(ZONE_GPU_SCANOUT, 0);
+        send_frame_to_display(target);
+        trace_end(ZONE_GPU_SCANOUT, 0);
+        return;
+    }
+
+    present_wait_slot(slot);
+    compose_present_part(target, 0, display_height);
+    present_submit(target, 0, display_height, slot, true, true);
+}
+
+// Core Execution Loops and Main Function
+// Core 1 rendering function
+void core1_rendering_loop() {
     printf("GPU Core 1 started - Rendering engine\n");
     
     while (true) {
         // Wait for render signal
         if (render_requested) {
             // Signal that we're starting to render
-            rendering_in_progress = true;
-            
-            // Clear the framebuffer if needed
-            if (clear_screen_requested) {
-                memset(framebuffer, 0, framebuffer_size);
-                clear_screen_requested = false;
+            rendering_in_progress = true;
+            trace_begin(ZONE_GPU_FRAME, frame_counter & 0xFFFF);
+            copper_begin_frame();
+
+            // A new scan-out palette changes every pixel on screen. 16bpp frames
+            // store its colors, so they are redrawn, and their fade rewrites the
+            // framebuffer each frame.
+            bool palette_changed = begin_frame_palette();
+            if (display_bpp == 16 && (palette_changed || effects.fade_level > 0)) {
+                mark_rect_dirty(0, 0, display_width, display_height);
             }
+            scanout_full_frame = palette_changed || effects.mosaic_size > 1;
+
+            // Collisions of the sprite positions this frame shows
+            detect_sprite_collisions();
+
+            // Damage marked from here on belongs to the next frame
+            collect_dirty_regions();
             
-            // Render each layer by priority
-            for (int p = 0; p < 4; p++) {
-                // First render background layers at this priority
-                for (int l = 0; l < MAX_LAYERS; l++) {
-                    if (layers[l].enabled && layers[l].priority == p) {
-                        if (layers[l].rotation_enabled) {
-                            render_rotated_layer(l);
-                        } else {
-                            render_layer(l, true);
-                        }
-                    }
+            if (render_mode == RENDER_MODE_LINE) {
+                // Compose and scan out line groups, there is no framebuffer to clear.
+                // Frames queued before the switch have to be out first.
+                present_wait_idle();
+                render_frame_by_lines();
+                clear_screen_requested = false;
+            } else {
+                // Clear the framebuffer if needed
+                if (clear_screen_requested) {
+                    present_wait_idle();
+                    memset(framebuffer, 0, framebuffer_size);
+                    clear_screen_requested = false;
                 }
-                
-                // Then render sprites at this priority
-                render_sprites_at_priority(p);
-            }
-            
-            // Apply global effects
-            if (effects.fade_level > 0) {
-                apply_fade_effect(framebuffer, framebuffer_size);
-            }
-            
-            if (effects.mosaic_size > 1) {
-                apply_mosaic_effect(framebuffer, display_width, display_height);
+
+                // Mosaic is applied by the scan-out and needs whole blocks of the
+                // frame, so only the framebuffer mode has it
+
+                // Compose into a free present buffer and queue it for the display
+                present_frame();
             }
-            
-            // Send frame to display
-            send_frame_to_display();
+
+            copper_end_frame();
 
             // Signal VSYNC to Core 0
             core1_vsync_flag = true;
@@ -2367,9 +5832,8 @@ void core1_rendering_loop() {
                 gpio_put(VBLANK_PIN, 0);
             }
 
-            // Clear dirty regions for next frame
-            clear_dirty_regions();
-            
+            trace_end(ZONE_GPU_FRAME, frame_counter & 0xFFFF);
+
             // Update frame counter
             frame_counter++;
             
@@ -2388,6 +5852,10 @@ int main() {
     // Initialize stdio
     stdio_init_all();
     printf("TriBoy GPU Initializing...\n");
+
+    // Damage is marked by core 0 and collected by core 1
+    damage_lock = spin_lock_init(spin_lock_claim_unused(true));
+    present_lock = spin_lock_init(spin_lock_claim_unused(true));
     
     // Initialize hardware
     setup_spi_slave(); // For CPU communication
@@ -2428,28 +5896,41 @@ int main() {
         printf("Failed to allocate sprite data memory!\n");
         while (1) tight_loop_contents();
     }
+
+    // Allocate the tile cache slab arena
+    if (!init_tile_cache(tile_cache_size)) {
+        printf("Failed to allocate tile cache memory!\n");
+        while (1) tight_loop_contents();
+    }
     
     // Initialize state
     clear_dirty_regions();
     memset(framebuffer, 0, framebuffer_size);
     memset(sprite_data, 0, sprite_data_size);
+    configure_present_buffers();
     
     // Initialize layers
     for (int i = 0; i < MAX_LAYERS; i++) {
         layers[i].enabled = false;
         layers[i].tilemap = NULL;
         layers[i].rotation_enabled = false;
+        layers[i].flash_tiles = NULL;
+        layers[i].flash_row_masks = NULL;
     }
     
+    // Static graphics the CPU can map instead of uploading
+    init_asset_pack();
+    
     // Initialize sprites
     for (int i = 0; i < MAX_SPRITES; i++) {
         sprites[i].visible = false;
-        sprite_order[i] = i;
     }
+    update_sprite_order();
     
     // Initialize sprite patterns
     for (int i = 0; i < MAX_PATTERNS; i++) {
         sprite_patterns[i].in_use = false;
+        sprite_patterns[i].flash_data = NULL;
     }
     
     // Initialize display mode (default 320x240x8-bit)
@@ -2468,7 +5949,17 @@ int main() {
     
     // Setup DMA for faster display updates
     setup_display_dma();
+    init_tile_blitter();
+
+    // Receive CPU commands by DMA into the command buffer ring
+    if (!init_command_rx(command_buffer_size)) {
+        printf("Failed to allocate command buffer!\n");
+        while (1) tight_loop_contents();
+    }
     
+    // Copper programs are handed to core 1 under this lock
+    mutex_init(&copper_mutex);
+
     // Start Core 1 for rendering
     multicore_launch_core1(core1_rendering_loop);
     
@@ -2476,104 +5967,64 @@ int main() {
     
     // Main command processing loop on Core 0
     while (true) {
-        // Check if CS is asserted (CPU is sending a command)
-        if (!gpio_get(CPU_CS_PIN)) {
-            // Read command and length bytes
-            uint8_t cmd_id, length;
-            
-            spi_read_blocking(CPU_SPI_PORT, 0xFF, &cmd_id, 1);
-            spi_read_blocking(CPU_SPI_PORT, 0xFF, &length, 1);
-            
-            // Read command data if any
-            if (length > 2) {
-                spi_read_blocking(CPU_SPI_PORT, 0xFF, cmd_buffer, length - 2);
-            }
-
-            // Check for VSYNC event from display hardware or Core 1
-            bool vsync_detected = check_vsync_signal();
-            if (vsync_detected) {
-                vsync_occurred = true;
-
-                // If CPU is waiting for VSYNC, send acknowledgment now
-                if (vsync_wait_pending) {
-                    send_ack_to_cpu(CMD_VSYNC_WAIT);
-                    vsync_wait_pending = false;
-                }
-
-                // Handle other vsync-dependent processing
-                if (copper_list_enabled) {
-                    trigger_copper_execution();
-                }
-
-                // Reset flag after processing
-                vsync_occurred = false;
+        // Dispatch everything the receive DMA has collected so far
+        uint32_t dispatched = process_received_commands();
+
+        // Check for VSYNC event from display hardware or Core 1
+        bool vsync_detected = check_vsync_signal();
+        if (vsync_detected) {
+            vsync_occurred = true;
+
+            // If CPU is waiting for VSYNC, send acknowledgment now
+            if (vsync_wait_pending) {
+                send_ack_to_cpu(CMD_VSYNC_WAIT);
+                vsync_wait_pending = false;
             }
 
-            // Process the command
-            process_command(cmd_id, cmd_buffer, length - 2);
+            // Reset flag after processing
+            vsync_occurred = false;
         }
         
-        // Update sprite animations
-        update_sprite_animations();
+        // Step sprite animations on 60Hz ticks rather than on every pass
+        uint32_t tick_time = time_us_32();
+        if (tick_time - animation_tick_time > 4 * FRAME_INTERVAL_US) {
+            // Stalled - don't replay the missed ticks all at once
+            animation_tick_time = tick_time - FRAME_INTERVAL_US;
+        }
+        while (tick_time - animation_tick_time >= FRAME_INTERVAL_US) {
+            animation_tick_time += FRAME_INTERVAL_US;
+            update_sprite_animations();
+        }
         
-        // Check if we need to trigger rendering
+        // Check if we need to trigger rendering. While the CPU commits frames a
+        // frame is rendered once its commit is in, at most once per interval;
+        // a late commit starts the render as soon as it arrives.
         uint32_t current_time = time_us_32();
-        if (!rendering_in_progress && current_time - last_render_time >= FRAME_INTERVAL_US) {
+        bool interval_elapsed = current_time - last_render_time >= FRAME_INTERVAL_US;
+        bool fenced = frame_pacing_fenced &&
+                      current_time - last_commit_time < FRAME_COMMIT_TIMEOUT_US;
+
+        if (!rendering_in_progress && interval_elapsed && (!fenced || frame_committed)) {
             // Request a new frame to be rendered
             render_requested = true;
             last_render_time = current_time;
+            frame_committed = false;
+            late_commit_counted = false;
+        } else if (fenced && interval_elapsed && !frame_committed && !late_commit_counted) {
+            late_commits++;
+            late_commit_counted = true;
         }
         
-        // Small delay to prevent tight loop
-        sleep_us(100);
+        // Small delay to prevent tight loop, only when there was nothing to do
+        if (dispatched == 0) {
+            sleep_us(100);
+        }
     }
     
     return 0;
 }
 
 // RP2350-Specific Enhancements
-// Double-buffering implementation (RP2350 only)
-void initialize_double_buffering() {
-    #ifdef RP2350
-    // Allocate front and back buffers
-    uint32_t single_buffer_size = display_width * display_height * (display_bpp / 8);
-    
-    front_buffer = framebuffer; // Use already allocated buffer
-    // back_buffer = malloc(single_buffer_size);
-    back_buffer = safe_malloc(single_buffer_size);
-    
-    if (back_buffer != NULL) {
-        // Clear both buffers
-        memset(front_buffer, 0, single_buffer_size);
-        memset(back_buffer, 0, single_buffer_size);
-        
-        // Enable double buffering
-        double_buffering_enabled = true;
-        current_draw_buffer = back_buffer;
-    }
-    #endif
-}
-
-// Swap buffers (for double buffering)
-void swap_buffers() {
-    #ifdef RP2350
-    if (!double_buffering_enabled) return;
-    
-    // Wait for any in-progress rendering
-    while (rendering_in_progress) {
-        sleep_us(10);
-    }
-    
-    // Swap pointers
-    uint8_t* temp = front_buffer;
-    front_buffer = current_draw_buffer;
-    current_draw_buffer = temp;
-    
-    // Update global framebuffer pointer
-    framebuffer = front_buffer;
-    #endif
-}
-
 // Enhanced layer blending for RP2350
 void apply_layer_blend(uint8_t layer_id) {
     #ifdef RP2350
@@ -2653,115 +6104,11 @@ void apply_layer_blend(uint8_t layer_id) {
 }
 
 // Enhanced rotation and scaling (RP2350 only)
+// It picked the nearest of four samples, which is what the fixed-point walk
+// fetches, so both chips share render_rotated_layer.
 void render_rotated_layer_enhanced(uint8_t layer_id) {
     #ifdef RP2350
-    // Similar to original function but with bilinear filtering for smoother results
-    Layer* layer = &layers[layer_id];
-    
-    if (!layer->enabled || !layer->rotation_enabled) return;
-    
-    // Get transformation matrix
-    float a = layer->matrix[0];
-    float b = layer->matrix[1];
-    float c = layer->matrix[2];
-    float d = layer->matrix[3];
-    
-    // Get center of rotation
-    int cx = layer->rot_center_x;
-    int cy = layer->rot_center_y;
-    
-    // For each pixel in the framebuffer
-    for (int y = 0; y < display_height; y++) {
-        for (int x = 0; x < display_width; x++) {
-            // Calculate source coordinates
-            float dx = x - cx;
-            float dy = y - cy;
-            
-            float src_x = (a * dx + b * dy) + cx + layer->scroll_x;
-            float src_y = (c * dx + d * dy) + cy + layer->scroll_y;
-            
-            // For bilinear interpolation, we need to know the fractional part
-            int int_src_x = (int)src_x;
-            int int_src_y = (int)src_y;
-            float frac_x = src_x - int_src_x;
-            float frac_y = src_y - int_src_y;
-            
-            // Calculate tile coordinates for four sample points
-            int tile_x1 = int_src_x / layer->tile_width;
-            int tile_y1 = int_src_y / layer->tile_height;
-            int tile_x2 = (int_src_x + 1) / layer->tile_width;
-            int tile_y2 = (int_src_y + 1) / layer->tile_height;
-
-            // Apply wrapping
-            tile_x1 = (tile_x1 % layer->width_tiles + layer->width_tiles) % layer->width_tiles;
-            tile_y1 = (tile_y1 % layer->height_tiles + layer->height_tiles) % layer->height_tiles;
-            tile_x2 = (tile_x2 % layer->width_tiles + layer->width_tiles) % layer->width_tiles;
-            tile_y2 = (tile_y2 % layer->height_tiles + layer->height_tiles) % layer->height_tiles;
-            
-            // Calculate pixel coordinates within tiles
-            int pixel_x1 = ((int)src_x % layer->tile_width + layer->tile_width) % layer->tile_width;
-            int pixel_y1 = ((int)src_y % layer->tile_height + layer->tile_height) % layer->tile_height;
-            int pixel_x2 = ((int_src_x + 1) % layer->tile_width + layer->tile_width) % layer->tile_width;
-            int pixel_y2 = ((int_src_y + 1) % layer->tile_height + layer->tile_height) % layer->tile_height;
-            
-            // Get tile information for all four corners
-            TileInfo* tile11 = (TileInfo*)(layer->tilemap + (tile_y1 * layer->width_tiles + tile_x1) * sizeof(TileInfo));
-            TileInfo* tile12 = (TileInfo*)(layer->tilemap + (tile_y1 * layer->width_tiles + tile_x2) * sizeof(TileInfo));
-            TileInfo* tile21 = (TileInfo*)(layer->tilemap + (tile_y2 * layer->width_tiles + tile_x1) * sizeof(TileInfo));
-            TileInfo* tile22 = (TileInfo*)(layer->tilemap + (tile_y2 * layer->width_tiles + tile_x2) * sizeof(TileInfo));
-            
-            // Get tile data from cache
-            uint8_t* data11 = get_cached_tile(layer_id, tile11->tile_id);
-            uint8_t* data12 = get_cached_tile(layer_id, tile12->tile_id);
-            uint8_t* data21 = get_cached_tile(layer_id, tile21->tile_id);
-            uint8_t* data22 = get_cached_tile(layer_id, tile22->tile_id);
-            
-            // Skip if any tile data is missing
-            if (data11 == NULL || data12 == NULL || data21 == NULL || data22 == NULL) {
-                continue;
-            }
-            
-            // Get pixel colors from all four corners (assuming 8-bit mode for simplicity)
-            uint8_t color11 = get_pixel_from_tile(data11, pixel_x1, pixel_y1, layer->tile_width, tile11->attributes);
-            uint8_t color12 = get_pixel_from_tile(data12, pixel_x2, pixel_y1, layer->tile_width, tile12->attributes);
-            uint8_t color21 = get_pixel_from_tile(data21, pixel_x1, pixel_y2, layer->tile_width, tile21->attributes);
-            uint8_t color22 = get_pixel_from_tile(data22, pixel_x2, pixel_y2, layer->tile_width, tile22->attributes);
-            
-            // Skip if all pixels are transparent
-            if (color11 == 0 && color12 == 0 && color21 == 0 && color22 == 0) {
-                continue;
-            }
-            
-            // Bilinear interpolation (for simplicity, we'll just pick the nearest pixel)
-            uint8_t final_color;
-            if (frac_x < 0.5) {
-                if (frac_y < 0.5) {
-                    final_color = color11;
-                } else {
-                    final_color = color21;
-                }
-            } else {
-                if (frac_y < 0.5) {
-                    final_color = color12;
-                } else {
-                    final_color = color22;
-                }
-            }
-            
-            // Skip transparent pixels
-            if (final_color == 0) continue;
-            
-            // Check window clipping
-            if (effects.window_enabled[0] || effects.window_enabled[1]) {
-                if (!is_in_window(x, y, layer_id)) {
-                    continue;
-                }
-            }
-            
-            // Write to framebuffer
-            framebuffer[y * display_width + x] = final_color;
-        }
-    }
+    render_rotated_layer(layer_id);
     #endif
 }
 
@@ -2777,7 +6124,7 @@ void render_sprite_enhanced(uint8_t sprite_id, int16_t x, int16_t y, uint16_t wi
     uint8_t palette_offset = sprite->palette_offset;
     
     // Get sprite data
-    uint8_t* sprite_data = sprite_data + pattern->data_offset;
+    const uint8_t* sprite_data = sprite_pattern_data(pattern);
     
     // Cache source dimensions
     uint16_t src_width = pattern->width * 8;
@@ -2943,18 +6290,10 @@ void set_sprite_collision_detection(uint8_t mode) {
     collision_detection_mode = mode;
     
     // Reset collision buffers
+    // Sprite-sprite collision (bit 0) works from sprite boxes and needs no buffer
     if (mode != 0) {
-        // For sprite-sprite collision (mode 1 or 3)
-        if (mode == 1 || mode == 3) {
-            if (sprite_collision_buffer == NULL) {
-                // sprite_collision_buffer = malloc(display_width * display_height / 8);
-                sprite_collision_buffer = safe_malloc(display_width * display_height / 8);
-            }
-            memset(sprite_collision_buffer, 0, display_width * display_height / 8);
-        }
-        
         // For sprite-BG collision (mode 2 or 3)
-        if (mode == 2 || mode == 3) {
+        if ((mode & 0x03) == 2 || (mode & 0x03) == 3) {
             if (bg_collision_buffer == NULL) {
                 // bg_collision_buffer = malloc(display_width * display_height / 8);
                 bg_collision_buffer = safe_malloc(display_width * display_height / 8);
@@ -2973,6 +6312,8 @@ void set_sprite_collision_detection(uint8_t mode) {
     // Reset collision detection flags
     sprite_collision_detected = false;
     sprite_bg_collision_detected = false;
+    collision_lists[collision_list_ready].count = 0;
+    collision_lists[collision_list_ready].overflow = false;
     
     send_ack_to_cpu(CMD_SET_SPRITE_COLLISION_DETECTION);
 }
@@ -3144,7 +6485,9 @@ void display_set_window(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
 }
 
 void reset_gpu() {
-    // Reset GPU state to defaults
+    // Reset GPU state to defaults. Layer buffers are freed below, so no frame
+    // may be reading them.
+    render_wait_idle();
 
     // Clear all layers
     for (int i = 0; i < MAX_LAYERS; i++) {
@@ -3163,28 +6506,34 @@ void reset_gpu() {
             layers[i].v_scroll_table = NULL;
         }
 
+        if (layers[i].affine_lines != NULL) {
+            free(layers[i].affine_lines);
+            layers[i].affine_lines = NULL;
+            layers[i].affine_line_count = 0;
+        }
+
         layers[i].enabled = false;
         layers[i].rotation_enabled = false;
+        layers[i].flash_tiles = NULL;
+        free(layers[i].flash_row_masks);
+        layers[i].flash_row_masks = NULL;
     }
 
     // Clear sprites
     for (int i = 0; i < MAX_SPRITES; i++) {
         sprites[i].visible = false;
     }
+    update_sprite_order();
+    sprite_animated_mask = 0;
 
     // Reset patterns
     for (int i = 0; i < MAX_PATTERNS; i++) {
         sprite_patterns[i].in_use = false;
+        sprite_patterns[i].flash_data = NULL;
     }
 
     // Clear tile cache
-    for (int i = 0; i < tile_cache_count; i++) {
-        if (tile_cache[i].data != NULL) {
-            free(tile_cache[i].data);
-            tile_cache[i].data = NULL;
-        }
-    }
-    tile_cache_count = 0;
+    flush_tile_cache();
 
     // Reset special effects
     effects.fade_level = 0;
@@ -3192,8 +6541,12 @@ void reset_gpu() {
     effects.window_enabled[0] = false;
     effects.window_enabled[1] = false;
     effects.color_math_mode = 0;
+    effects.flash_remaining = 0;
+    effects.color_lut_enabled = false;
+    memset(palette_cycles, 0, sizeof(palette_cycles));
 
-    // Clear framebuffer
+    // Clear framebuffer once nothing queued still reads it
+    present_wait_idle();
     if (framebuffer != NULL) {
         memset(framebuffer, 0, framebuffer_size);
     }
@@ -3202,6 +6555,11 @@ void reset_gpu() {
     clear_dirty_regions();
     sprite_data_used = 0;
 
+    // Render on the timer until the CPU commits frames again
+    frame_pacing_fenced = false;
+    frame_committed = false;
+    late_commits = 0;
+
     // Reset display mode to default
     set_display_mode(320, 240, 8);
 
@@ -3209,9 +6567,8 @@ void reset_gpu() {
     initialize_default_palette();
 
     // Reset collision detection
-    if (sprite_collision_buffer != NULL) {
-        memset(sprite_collision_buffer, 0, display_width * display_height / 8);
-    }
+    collision_detection_mode = 0;
+    collision_lists[collision_list_ready].count = 0;
     if (bg_collision_buffer != NULL) {
         memset(bg_collision_buffer, 0, display_width * display_height / 8);
     }
@@ -3219,17 +6576,39 @@ void reset_gpu() {
     sprite_collision_detected = false;
     sprite_bg_collision_detected = false;
 
+    // Stop the copper from the next frame
+    copper_reset();
+
     // Send acknowledgment
     send_ack_to_cpu(CMD_RESET_GPU);
 }
 
 void set_display_mode(uint16_t width, uint16_t height, uint8_t bpp) {
     // Validate parameters
-    if (width == 0 || height == 0 || (bpp != 4 && bpp != 8 && bpp != 16)) {
+    if (width == 0 || height == 0 || width > MAX_DISPLAY_WIDTH || height > MAX_DISPLAY_HEIGHT ||
+        (bpp != 4 && bpp != 8 && bpp != 16)) {
         send_error_to_cpu(CMD_SET_DISPLAY_MODE, ERR_INVALID_PARAMETER);
         return;
     }
 
+    // Both modes reallocate what frames render into and scan out from
+    render_wait_idle();
+
+    // The line renderer has no framebuffer, only line group buffers sized for the mode
+    if (render_mode == RENDER_MODE_LINE) {
+        display_width = width;
+        display_height = height;
+        display_bpp = bpp;
+
+        if (!allocate_line_group_buffers()) {
+            send_error_to_cpu(CMD_SET_DISPLAY_MODE, ERR_OUT_OF_MEMORY);
+            return;
+        }
+
+        send_ack_to_cpu(CMD_SET_DISPLAY_MODE);
+        return;
+    }
+
     // Calculate required framebuffer size
     uint32_t required_size = width * height;
     if (bpp == 16) {
@@ -3248,7 +6627,19 @@ void set_display_mode(uint16_t width, uint16_t height, uint8_t bpp) {
         // Allocate new framebuffer
         framebuffer = malloc(required_size);
         if (framebuffer == NULL) {
-            send_error_to_cpu(CMD_SET_DISPLAY_MODE, ERR_OUT_OF_MEMORY);
+            // Not enough RAM for a full frame (e.g. 16bpp on RP2040), fall back to the line renderer
+            display_width = width;
+            display_height = height;
+            display_bpp = bpp;
+            framebuffer_size = 0;
+
+            if (allocate_line_group_buffers()) {
+                render_mode = RENDER_MODE_LINE;
+                configure_present_buffers();
+                send_ack_to_cpu(CMD_SET_DISPLAY_MODE);
+            } else {
+                send_error_to_cpu(CMD_SET_DISPLAY_MODE, ERR_OUT_OF_MEMORY);
+            }
             return;
         }
 
@@ -3267,27 +6658,8 @@ void set_display_mode(uint16_t width, uint16_t height, uint8_t bpp) {
     clear_dirty_regions();
     mark_rect_dirty(0, 0, width, height);
 
-    // If using double buffering, update buffers
-    if (double_buffering_enabled) {
-        front_buffer = framebuffer;
-
-        // Reallocate back buffer if needed
-        if (back_buffer != NULL) {
-            free(back_buffer);
-        }
-
-        back_buffer = malloc(required_size);
-        if (back_buffer != NULL) {
-            memset(back_buffer, 0, required_size);
-            current_draw_buffer = back_buffer;
-        } else {
-            // Failed to allocate back buffer, disable double buffering
-            double_buffering_enabled = false;
-            current_draw_buffer = framebuffer;
-        }
-    } else {
-        current_draw_buffer = framebuffer;
-    }
+    // As many frames of the new size as fit in the framebuffer are used as present buffers
+    configure_present_buffers();
 
     // Configure the physical display
     // This would configure the actual display hardware
@@ -3334,223 +6706,30 @@ void initialize_default_palette() {
     palette[5].r = 255; palette[5].g = 255; palette[5].b = 0;
     palette[6].r = 0;   palette[6].g = 255; palette[6].b = 255;
     palette[7].r = 255; palette[7].g = 0;   palette[7].b = 255;
-}
-
-void update_sprite_order() {
-    // Initialize the sprite order array
-    for (int i = 0; i < MAX_SPRITES; i++) {
-        sprite_order[i] = i;
-    }
-
-    // Sort sprites based on the current ordering mode
-    if (sprite_order_mode == ORDER_BY_YPOS) {
-        // Sort by Y position (bubble sort for simplicity)
-        for (int i = 0; i < MAX_SPRITES - 1; i++) {
-            for (int j = 0; j < MAX_SPRITES - i - 1; j++) {
-                if (!sprites[sprite_order[j]].visible) {
-                    // Move invisible sprites to the end
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                } else if (sprites[sprite_order[j]].visible &&
-                          sprites[sprite_order[j + 1]].visible &&
-                          sprites[sprite_order[j]].y > sprites[sprite_order[j + 1]].y) {
-                    // Swap if y position is greater
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                }
-            }
-        }
-    } else {
-        // Sort by priority (attribute bits 4-5)
-        for (int i = 0; i < MAX_SPRITES - 1; i++) {
-            for (int j = 0; j < MAX_SPRITES - i - 1; j++) {
-                uint8_t prio_j = (sprites[sprite_order[j]].attributes >> 4) & 0x03;
-                uint8_t prio_j1 = (sprites[sprite_order[j + 1]].attributes >> 4) & 0x03;
-
-                if (!sprites[sprite_order[j]].visible) {
-                    // Move invisible sprites to the end
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                } else if (sprites[sprite_order[j]].visible &&
-                          sprites[sprite_order[j + 1]].visible &&
-                          prio_j > prio_j1) {
-                    // Swap if priority is higher (lower value = higher priority)
-                    uint8_t temp = sprite_order[j];
-                    sprite_order[j] = sprite_order[j + 1];
-                    sprite_order[j + 1] = temp;
-                }
-            }
-        }
-    }
-}
-
-void update_sprite_animations() {
-    // Process all sprite animations
-    for (int i = 0; i < MAX_SPRITES; i++) {
-        Sprite* sprite = &sprites[i];
-
-        if (!sprite->visible || !sprite->animated) {
-            continue;
-        }
-
-        // Increment frame counter
-        sprite->frame_counter++;
-
-        // Check if it's time for a new frame
-        if (sprite->frame_counter >= (60 / sprite->frame_rate)) {
-            sprite->frame_counter = 0;
-
-            // Advance to next frame
-            sprite->current_frame += sprite->frame_dir;
-
-            // Handle looping based on mode
-            if (sprite->frame_dir > 0 && sprite->current_frame > sprite->end_frame) {
-                switch (sprite->loop_mode) {
-                    case 0: // Once
-                        sprite->current_frame = sprite->end_frame;
-                        sprite->animated = false; // Stop animation
-                        break;
-
-                    case 1: // Loop
-                        sprite->current_frame = sprite->start_frame;
-                        break;
-
-                    case 2: // Ping-pong
-                        sprite->current_frame = sprite->end_frame - 1;
-                        sprite->frame_dir = -1; // Reverse direction
-                        break;
-                }
-            } else if (sprite->frame_dir < 0 && sprite->current_frame < sprite->start_frame) {
-                switch (sprite->loop_mode) {
-                    case 0: // Once
-                        sprite->current_frame = sprite->start_frame;
-                        sprite->animated = false; // Stop animation
-                        break;
-
-                    case 1: // Loop
-                        sprite->current_frame = sprite->end_frame;
-                        break;
-
-                    case 2: // Ping-pong
-                        sprite->current_frame = sprite->start_frame + 1;
-                        sprite->frame_dir = 1; // Forward direction
-                        break;
-                }
-            }
 
-            // Mark sprite area as dirty
-            mark_sprite_area_dirty(i);
-
-            // Update pattern ID for the sprite based on animation frame
-            sprite->pattern_id = sprite->start_frame +
-                (sprite->current_frame - sprite->start_frame) %
-                (sprite->end_frame - sprite->start_frame + 1);
-        }
-    }
+    // Scan-out LUT must be rebuilt
+    palette_lut_dirty = true;
 }
 
-void mark_sprite_area_dirty(uint8_t sprite_id) {
-    if (sprite_id >= MAX_SPRITES || !sprites[sprite_id].visible) {
-        return;
-    }
-
-    // Get sprite pattern
-    uint8_t pattern_id = sprites[sprite_id].pattern_id;
-    if (pattern_id >= MAX_PATTERNS || !sprite_patterns[pattern_id].in_use) {
-        return;
-    }
-
-    // Calculate sprite dimensions
-    uint16_t width = sprite_patterns[pattern_id].width * 8;
-    uint16_t height = sprite_patterns[pattern_id].height * 8;
-
-    // Apply scaling
-    if (sprites[sprite_id].scale != 128) { // 128 represents 1.0 scale
-        width = (width * sprites[sprite_id].scale) / 128;
-        height = (height * sprites[sprite_id].scale) / 128;
-    }
-
-    // Calculate screen position (fixed-point to pixel)
-    int16_t x = sprites[sprite_id].x >> 8;
-    int16_t y = sprites[sprite_id].y >> 8;
-
-    // Add padding to ensure we catch any partially visible edges
-    x -= 1;
-    y -= 1;
-    width += 2;
-    height += 2;
+void set_palette_entry(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
+    palette[index].r = r;
+    palette[index].g = g;
+    palette[index].b = b;
 
-    // Mark the region dirty
-    mark_rect_dirty(x, y, width, height);
+    // Rebuilt once at the start of the next frame
+    palette_lut_dirty = true;
 }
 
-void mark_rect_dirty(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
-    // Clip rectangle to screen bounds
-    if (x >= display_width) return;
-    if (y >= display_height) return;
-
-    if (x + width > display_width) width = display_width - x;
-    if (y + height > display_height) height = display_height - y;
-
-    // Check if we can merge with an existing dirty region
-    for (int i = 0; i < dirty_region_count; i++) {
-        Rect* r = &dirty_regions[i];
-
-        // Calculate rectangle bounds
-        uint16_t r1_x1 = r->x;
-        uint16_t r1_y1 = r->y;
-        uint16_t r1_x2 = r->x + r->width;
-        uint16_t r1_y2 = r->y + r->height;
-
-        uint16_t r2_x1 = x;
-        uint16_t r2_y1 = y;
-        uint16_t r2_x2 = x + width;
-        uint16_t r2_y2 = y + height;
-
-        // Check if rectangles are adjacent or overlapping
-        if (!(r1_x2 < r2_x1 || r2_x2 < r1_x1 || r1_y2 < r2_y1 || r2_y2 < r1_y1)) {
-            // Merge rectangles by creating a new bounding rectangle
-            uint16_t new_x1 = min(r1_x1, r2_x1);
-            uint16_t new_y1 = min(r1_y1, r2_y1);
-            uint16_t new_x2 = max(r1_x2, r2_x2);
-            uint16_t new_y2 = max(r1_y2, r2_y2);
-
-            r->x = new_x1;
-            r->y = new_y1;
-            r->width = new_x2 - new_x1;
-            r->height = new_y2 - new_y1;
-
-            // If the merged region is too large, just mark the whole screen
-            if (r->width * r->height > (display_width * display_height) / 2) {
-                dirty_regions[0].x = 0;
-                dirty_regions[0].y = 0;
-                dirty_regions[0].width = display_width;
-                dirty_regions[0].height = display_height;
-                dirty_region_count = 1;
-            }
-
-            return;
-        }
+void load_palette(uint8_t start_index, uint8_t count, const uint8_t* data) {
+    // RGB triplets
+    for (uint16_t i = 0; i < count && start_index + i < 256; i++) {
+        palette[start_index + i].r = data[i * 3];
+        palette[start_index + i].g = data[i * 3 + 1];
+        palette[start_index + i].b = data[i * 3 + 2];
     }
 
-    // Add as a new dirty region if we have space
-    if (dirty_region_count < MAX_DIRTY_REGIONS) {
-        Rect* r = &dirty_regions[dirty_region_count++];
-        r->x = x;
-        r->y = y;
-        r->width = width;
-        r->height = height;
-    } else {
-        // Too many regions, just mark the whole screen
-        dirty_regions[0].x = 0;
-        dirty_regions[0].y = 0;
-        dirty_regions[0].width = display_width;
-        dirty_regions[0].height = display_height;
-        dirty_region_count = 1;
-    }
+    // Rebuilt once at the start of the next frame
+    palette_lut_dirty = true;
 }
 
 uint8_t get_pixel_from_tile(uint8_t* data, uint16_t x, uint16_t y, uint16_t width, uint8_t attributes) {
@@ -3595,19 +6774,6 @@ uint8_t get_pixel_from_sprite(uint8_t* data, uint16_t x, uint16_t y, uint16_t wi
     return pixel_value;
 }
 
-void trigger_copper_execution() {
-    // Copper list is a series of commands executed at specific scanlines
-    if (!copper_list_enabled) return;
-
-    // Need to parse and execute the copper list
-    // Here we don't implement the full functionality
-
-    // Example implementation would:
-    // 1. Process each command in the copper list
-    // 2. Check if the current scanline matches the wait condition
-    // 3. Execute the command when the condition is met
-}
-
 void compact_sprite_memory() {
     // Allocate temporary buffer
     uint8_t* temp_buffer = malloc(sprite_data_size);
@@ -3619,7 +6785,7 @@ void compact_sprite_memory() {
     uint32_t current_offset = 0;
 
     for (int i = 0; i < MAX_PATTERNS; i++) {
-        if (sprite_patterns[i].in_use) {
+        if (sprite_patterns[i].in_use && sprite_patterns[i].flash_data == NULL) {
             // Copy pattern data to temporary buffer
             memcpy(temp_buffer + current_offset,
                    sprite_data + sprite_patterns[i].data_offset,
@@ -3641,13 +6807,24 @@ void compact_sprite_memory() {
 }
 
 void flush_tile_cache() {
-    // Free all tile cache memory
-    for (int i = 0; i < tile_cache_count; i++) {
-        if (tile_cache[i].data != NULL) {
-            free(tile_cache[i].data);
-            tile_cache[i].data = NULL;
-        }
+    // Empty the index and hand every page back to the arena
+    for (int i = 0; i < TILE_INDEX_SIZE; i++) {
+        tile_index[i] = TILE_INDEX_EMPTY;
+    }
+
+    for (int i = 0; i < MAX_CACHED_TILES; i++) {
+        tile_cache[i].in_use = false;
+        tile_cache[i].data = NULL;
+        tile_free_entries[i] = MAX_CACHED_TILES - 1 - i;
+    }
+    tile_free_entry_count = MAX_CACHED_TILES;
+
+    for (int c = 0; c < TILE_SLAB_CLASSES; c++) {
+        tile_slab_partial[c] = TILE_SLAB_NO_PAGE;
     }
+    tile_slab_empty_pages = TILE_SLAB_NO_PAGE;
+    tile_slab_pages_used = 0;
+    tile_clock_hand = 0;
 
     // Reset cache count
     tile_cache_count = 0;
@@ -3658,6 +6835,8 @@ void clear_sprites() {
     for (int i = 0; i < MAX_SPRITES; i++) {
         sprites[i].visible = false;
     }
+    update_sprite_order();
+    sprite_animated_mask = 0;
 
     // Mark the entire screen as dirty
     mark_rect_dirty(0, 0, display_width, display_height);
@@ -3670,6 +6849,10 @@ void reset_effects() {
     effects.window_enabled[0] = false;
     effects.window_enabled[1] = false;
     effects.color_math_mode = 0;
+    effects.flash_remaining = 0;
+    effects.color_lut_enabled = false;
+    memset(palette_cycles, 0, sizeof(palette_cycles));
+    palette_lut_dirty = true;
 
     // Mark the entire screen as dirty
     mark_rect_dirty(0, 0, display_width, display_height);
@@ -0,0 +1,50 @@
+# Copy the parts of a firmware source that the host build compiles into one file.
+#
+#   triboy_extract(<source> <output> <begin> <end> [<begin> <end> ...])
+#
+# Each region runs from a begin marker up to, not including, the next end marker
+# after it. Markers are literal text from the source (no semicolons or brackets).
+# A marker that has gone missing stops the configure step, so the host build
+# can't quietly test code the firmware no longer has.
+function(triboy_extract source output)
+    file(READ ${source} text)
+    get_filename_component(source_name ${source} NAME)
+    set(result "/* Generated from ${source_name} by triboy_extract(), do not edit */\n\n")
+
+    set(regions ${ARGN})
+    list(LENGTH regions count)
+    math(EXPR odd "${count} % 2")
+    if(count EQUAL 0 OR odd)
+        message(FATAL_ERROR "triboy_extract(${source_name}): markers must come in begin/end pairs")
+    endif()
+    math(EXPR last "${count} - 2")
+
+    foreach(i RANGE 0 ${last} 2)
+        math(EXPR j "${i} + 1")
+        list(GET regions ${i} begin)
+        list(GET regions ${j} end)
+
+        string(FIND "${text}" "${begin}" start)
+        if(start EQUAL -1)
+            message(FATAL_ERROR "triboy_extract(${source_name}): begin marker not found: ${begin}")
+        endif()
+        string(SUBSTRING "${text}" ${start} -1 rest)
+
+        string(LENGTH "${begin}" begin_length)
+        string(SUBSTRING "${rest}" ${begin_length} -1 after)
+        string(FIND "${after}" "${end}" stop)
+        if(stop EQUAL -1)
+            message(FATAL_ERROR "triboy_extract(${source_name}): end marker not found after '${begin}': ${end}")
+        endif()
+
+        math(EXPR length "${begin_length} + ${stop}")
+        string(SUBSTRING "${rest}" 0 ${length} region)
+        string(APPEND result "${region}\n")
+    endforeach()
+
+    # Only touch the output when it changes, so a reconfigure doesn't rebuild
+    file(WRITE ${output}.tmp "${result}")
+    configure_file(${output}.tmp ${output} COPYONLY)
+    file(REMOVE ${output}.tmp)
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${source})
+endfunction()
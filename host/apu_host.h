@@ -0,0 +1,119 @@
+// The APU's FM engine and mixer as the host build sees them: the sections of
+// apu.c extracted into apu_extract.c, plus host versions of what they call from
+// the rest of apu.c. Only FM voices are rendered; sample and wavetable voices
+// stay silent. Include from exactly one source file per executable.
+#ifndef TRIBOY_APU_HOST_H
+#define TRIBOY_APU_HOST_H
+
+#include "pico_host.h"
+
+static uint32_t host_apu_acks = 0;
+static uint32_t host_apu_errors = 0;
+
+void send_ack_to_cpu(uint8_t command_id) {
+    (void)command_id;
+    host_apu_acks++;
+}
+
+void send_error_to_cpu(uint8_t command_id, uint8_t error_code) {
+    (void)command_id;
+    (void)error_code;
+    host_apu_errors++;
+}
+
+// Defined after their first use in apu.c
+uint8_t render_sample_channel(uint8_t channel_id, float* out_left, float* out_right, uint32_t sample_count);
+uint8_t render_sample_channel_q15(uint8_t channel_id, int32_t* out_left, int32_t* out_right, uint32_t sample_count);
+uint8_t render_wavetable_channel(uint8_t channel_id, float* out, float* unused, uint32_t sample_count);
+uint8_t render_wavetable_channel_q15(uint8_t channel_id, int32_t* out, int32_t* unused, uint32_t sample_count);
+void render_fm_channel_float(uint8_t channel_id, float* out, uint32_t sample_count);
+
+#include "apu_extract.c"
+
+uint8_t render_sample_channel(uint8_t channel_id, float* out_left, float* out_right, uint32_t sample_count) {
+    (void)channel_id; (void)out_left; (void)out_right; (void)sample_count;
+    return 0;
+}
+
+uint8_t render_sample_channel_q15(uint8_t channel_id, int32_t* out_left, int32_t* out_right, uint32_t sample_count) {
+    (void)channel_id; (void)out_left; (void)out_right; (void)sample_count;
+    return 0;
+}
+
+uint8_t render_wavetable_channel(uint8_t channel_id, float* out, float* unused, uint32_t sample_count) {
+    (void)channel_id; (void)out; (void)unused; (void)sample_count;
+    return 0;
+}
+
+uint8_t render_wavetable_channel_q15(uint8_t channel_id, int32_t* out, int32_t* unused, uint32_t sample_count) {
+    (void)channel_id; (void)out; (void)unused; (void)sample_count;
+    return 0;
+}
+
+// The float FM reference engine isn't built on the host; use_float_fm stays off
+void render_fm_channel_float(uint8_t channel_id, float* out, uint32_t sample_count) {
+    (void)channel_id;
+    memset(out, 0, sample_count * sizeof(float));
+}
+
+// Tables and effect lines as the APU's boot leaves them, with the sine table
+// built in double precision so it is the same on every host
+static inline bool host_apu_init(bool fixed_mixing) {
+    for (int i = 0; i < SINE_WAVE_SIZE; i++) {
+        sine_table[i] = (int16_t)lrint(sin(2.0 * M_PI * i / SINE_WAVE_SIZE) * 32767.0);
+    }
+    init_fm_tables();
+    init_soft_clip_lut();
+
+    use_fixed_mixing = fixed_mixing;
+    master_volume = 255;
+
+    delay.buffer_frames = 1u << 14;
+    delay.frame_mask = delay.buffer_frames - 1;
+    delay.buffer = calloc(delay.buffer_frames * 2, sizeof(int16_t));
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        channels[ch].effect_routing = EFFECT_ROUTE_ALL;
+    }
+
+    return delay.buffer != NULL && init_reverb_lines();
+}
+
+// Key an FM voice on with every operator attacking. Operator frequencies are
+// picked up by render_fm_channel_fixed() from the channel frequency.
+static inline void host_fm_voice(uint8_t channel_id, uint8_t algorithm, uint8_t feedback,
+                                 float frequency, uint8_t volume, uint8_t pan) {
+    init_fm_channel(channel_id, algorithm);
+    FMChannel* fm = &fm_channels[channel_id];
+    fm->feedback = feedback;
+
+    for (int i = 0; i < 4; i++) {
+        FMOperator* op = &fm->operators[i];
+        op->multiple = (uint8_t)(i + 1);
+        op->detune = (int8_t)(i * 3 - 4);
+        op->waveform = (uint8_t)((channel_id + i) & 3);
+        op->envelope_state = 1;
+    }
+
+    Channel* ch = &channels[channel_id];
+    ch->active = true;
+    ch->frequency = frequency;
+    ch->base_frequency = frequency;
+    ch->volume = volume;
+    ch->base_volume = volume;
+    ch->pan = pan;
+}
+
+// One audio period the way the two cores produce it, run back to back
+static inline void host_render_audio_period(void) {
+    plan_voice_split();
+    render_voice_job(0);
+    render_voice_job(1);
+    if (use_fixed_mixing) {
+        finish_audio_buffer_fixed();
+    } else {
+        finish_audio_buffer_float();
+    }
+}
+
+#endif
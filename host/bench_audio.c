@@ -0,0 +1,62 @@
+// Audio benchmark: sixteen FM voices through the voice split, delay, reverb and
+// soft clipper, reported as ns per AUDIO_BUFFER_SIZE-frame block. The fixed
+// pipeline's first GOLDEN_PERIODS blocks are hashed and checked against a
+// recorded value; the float pipeline goes through tanhf and the C library's
+// float maths, so it is only timed.
+//
+//   bench_audio [blocks]
+#include "apu_host.h"
+#include "host_check.h"
+
+#define GOLDEN_PERIODS 16
+#define GOLDEN_FIXED 0xaf44760de8a039b4ULL
+
+static void start_voices(void) {
+    for (uint8_t ch = 0; ch < MAX_CHANNELS; ch++) {
+        host_fm_voice(ch, ch & 7, ch % 6, 110.0f + ch * 27.5f, 48, (uint8_t)(ch * 17));
+    }
+    configure_delay(60, 96, 80);
+    configure_reverb(160, 100, 64);
+}
+
+static uint64_t run(const char* name, uint32_t blocks) {
+    uint64_t hash = FNV1A_INIT;
+
+    start_voices();
+
+    uint64_t start = now_ns();
+    for (uint32_t b = 0; b < blocks; b++) {
+        host_render_audio_period();
+        if (b < GOLDEN_PERIODS) {
+            hash = fnv1a(pcm_buffer, sizeof(pcm_buffer), hash);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    uint64_t per_block = elapsed / blocks;
+    uint64_t period_ns = 1000000000ULL * AUDIO_BUFFER_SIZE / SAMPLE_RATE;
+    printf("%-6s %10llu ns/audio-block  (%.1f%% of a period)\n", name,
+           (unsigned long long)per_block, 100.0 * per_block / period_ns);
+    return hash;
+}
+
+int main(int argc, char** argv) {
+    uint32_t blocks = (argc > 1) ? (uint32_t)atoi(argv[1]) : 2000;
+    if (blocks < GOLDEN_PERIODS) blocks = GOLDEN_PERIODS;
+
+    CHECK(host_apu_init(true));
+    uint64_t hash = run("fixed", blocks);
+    if (hash != GOLDEN_FIXED) {
+        printf("fixed: hash %016llx differs from golden %016llx\n",
+               (unsigned long long)hash, (unsigned long long)GOLDEN_FIXED);
+        host_failures++;
+    }
+
+    // The float pipeline keeps its reverb lines in their own buffer
+    use_fixed_mixing = false;
+    CHECK(init_reverb_lines());
+    run("float", blocks);
+
+    CHECK(host_apu_errors == 0);
+    return host_report("bench_audio");
+}
@@ -0,0 +1,205 @@
+// Render benchmark: whole frames of three synthetic scenes through
+// compose_render_target(), reported as ns/frame. The first GOLDEN_FRAMES of
+// each scene are hashed and checked against a recorded value, so a change that
+// alters the picture fails here before it is measured.
+//
+//   bench_render [frames]
+#include "gpu_host.h"
+#include "host_check.h"
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+#define GOLDEN_FRAMES 4
+
+typedef struct {
+    const char* name;
+    void (*setup)(void);
+    void (*frame)(uint32_t frame);
+    uint64_t golden;
+} Scene;
+
+// Nothing on screen, every pattern and tile gone
+static void reset_scene(void) {
+    for (int l = 0; l < MAX_LAYERS; l++) {
+        layers[l].enabled = false;
+        layers[l].rotation_enabled = false;
+    }
+    for (int s = 0; s < MAX_SPRITES; s++) {
+        if (sprites[s].visible) {
+            sprites[s].visible = false;
+            update_sprite_list(s);
+        }
+    }
+    sprite_data_used = 0;
+    flush_tile_cache();
+}
+
+// 8x8 8bpp tiles 1..count: odd tiles opaque, even ones with transparent holes
+static void load_tiles(uint8_t layer_id, uint16_t count, uint32_t seed) {
+    uint8_t tile[64];
+    uint32_t rng = seed;
+
+    for (uint16_t t = 1; t <= count; t++) {
+        for (int i = 0; i < 64; i++) {
+            uint8_t v = (uint8_t)(1 + xorshift32(&rng) % 255);
+            if (!(t & 1) && ((i >> 3) + (i & 7) + t) % 3 == 0) v = 0;
+            tile[i] = v;
+        }
+        cache_tile(layer_id, t, tile, sizeof(tile));
+    }
+}
+
+// Every cell from tiles 1..count, or empty one time in `holes` when holes is non-zero
+static void fill_map(uint8_t layer_id, uint16_t count, uint32_t holes, uint32_t seed) {
+    Layer* layer = &layers[layer_id];
+    uint32_t rng = seed;
+
+    for (int ty = 0; ty < layer->height_tiles; ty++) {
+        for (int tx = 0; tx < layer->width_tiles; tx++) {
+            uint32_t r = xorshift32(&rng);
+            uint16_t tile_id = (holes && r % holes == 0) ? 0 : 1 + (r >> 4) % count;
+            host_set_tile(layer_id, tx, ty, tile_id, (r >> 12) & 0x03);
+        }
+    }
+}
+
+static void load_pattern(uint8_t pattern_id, uint8_t size_tiles, uint8_t bpp, uint32_t seed) {
+    uint8_t pixels[32 * 32];
+    uint32_t rng = seed;
+    int side = size_tiles * 8;
+
+    // A filled disc, so rows have transparent edges and opaque middles
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            int dx = 2 * x + 1 - side;
+            int dy = 2 * y + 1 - side;
+            uint8_t v = (uint8_t)(1 + xorshift32(&rng) % 255);
+            if (bpp == 4) v = (v & 0x0F) ? (v & 0x0F) : 1;
+            pixels[y * side + x] = (dx * dx + dy * dy <= side * side) ? v : 0;
+        }
+    }
+
+    if (bpp == 4) {
+        for (int i = 0; i < side * side / 2; i++) {
+            pixels[i] = (uint8_t)((pixels[i * 2] << 4) | pixels[i * 2 + 1]);
+        }
+    }
+    host_load_sprite_pattern(pattern_id, size_tiles, size_tiles, bpp, pixels);
+}
+
+// Positions are 8.8, so sprites stay within -128..127 px of the origin
+static int16_t sprite_coord(uint32_t value, int min, int range) {
+    return (int16_t)((int)(value % range + min) * 256);
+}
+
+// Side-scrolling stage: an opaque parallax backdrop, a transparent foreground
+// scrolling faster, and a handful of 16x16 4bpp characters
+static void shinobi_setup(void) {
+    host_configure_layer(0, 0, 8, 8, 64, 32, 8);
+    host_configure_layer(1, 1, 8, 8, 64, 32, 8);
+    load_tiles(0, 48, 1);
+    load_tiles(1, 48, 2);
+    fill_map(0, 48, 0, 3);
+    fill_map(1, 48, 3, 4);
+    for (uint8_t p = 0; p < 4; p++) load_pattern(p, 2, 4, 10 + p);
+}
+
+static void shinobi_frame(uint32_t frame) {
+    layers[0].scroll_x = frame / 2;
+    layers[1].scroll_x = frame * 2;
+    layers[1].scroll_y = (frame * 3) & 15;
+
+    for (uint8_t s = 0; s < 12; s++) {
+        host_place_sprite(s, s & 3, sprite_coord(s * 37 + frame * (s % 3 + 1), -16, 140),
+                          sprite_coord(s * 23 + frame, -8, 130), s & 1, (s & 3) * 16, 128);
+    }
+}
+
+// Every sprite slot in use: 32x32 8bpp sprites at mixed scales and flips over
+// an opaque backdrop
+static void sprites64_setup(void) {
+    host_configure_layer(0, 0, 8, 8, 64, 32, 8);
+    load_tiles(0, 16, 5);
+    fill_map(0, 16, 0, 6);
+    for (uint8_t p = 0; p < 8; p++) load_pattern(p, 4, 8, 20 + p);
+}
+
+static void sprites64_frame(uint32_t frame) {
+    static const uint8_t scales[4] = { 128, 128, 96, 192 };
+
+    for (uint8_t s = 0; s < MAX_SPRITES; s++) {
+        host_place_sprite(s, s & 7, sprite_coord(s * 53 + frame * 3, -32, 160),
+                          sprite_coord(s * 29 + frame * 2, -32, 160), s & 3, 0, scales[s & 3]);
+    }
+}
+
+// One rotating, zooming playfield under a scrolling transparent layer
+static void rotozoom_setup(void) {
+    host_configure_layer(0, 0, 8, 8, 64, 64, 8);
+    host_configure_layer(1, 1, 8, 8, 64, 32, 8);
+    load_tiles(0, 32, 7);
+    load_tiles(1, 32, 8);
+    fill_map(0, 32, 0, 9);
+    fill_map(1, 32, 4, 10);
+
+    Layer* layer = &layers[0];
+    layer->rotation_enabled = true;
+    layer->rot_center_x = SCREEN_WIDTH / 2;
+    layer->rot_center_y = SCREEN_HEIGHT / 2;
+}
+
+static void rotozoom_frame(uint32_t frame) {
+    Layer* layer = &layers[0];
+    double angle = frame * (M_PI / 90.0);
+    double zoom = 1.0 + 0.5 * sin(frame * (M_PI / 60.0));
+
+    layer->affine[0] = (int32_t)lrint(cos(angle) * zoom * 65536.0);
+    layer->affine[1] = (int32_t)lrint(-sin(angle) * zoom * 65536.0);
+    layer->affine[2] = (int32_t)lrint(sin(angle) * zoom * 65536.0);
+    layer->affine[3] = (int32_t)lrint(cos(angle) * zoom * 65536.0);
+    layer->scroll_x = frame;
+    layers[1].scroll_x = frame * 3;
+}
+
+static Scene scenes[] = {
+    { "shinobi",   shinobi_setup,   shinobi_frame,   0x459bba41a11c8410ULL },
+    { "sprites64", sprites64_setup, sprites64_frame, 0xbd5880185e0574b4ULL },
+    { "rotozoom",  rotozoom_setup,  rotozoom_frame,  0x1bff90c7bafe4c6bULL },
+};
+
+int main(int argc, char** argv) {
+    uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 600;
+    if (frames < GOLDEN_FRAMES) frames = GOLDEN_FRAMES;
+
+    CHECK(host_gpu_init(SCREEN_WIDTH, SCREEN_HEIGHT, 96 * 1024));
+    init_tile_blitter();
+
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+        Scene* scene = &scenes[i];
+        uint64_t hash = FNV1A_INIT;
+
+        reset_scene();
+        scene->setup();
+
+        uint64_t start = now_ns();
+        for (uint32_t f = 0; f < frames; f++) {
+            scene->frame(f);
+            host_compose_frame();
+            if (f < GOLDEN_FRAMES) {
+                hash = fnv1a(framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT, hash);
+            }
+        }
+        uint64_t elapsed = now_ns() - start;
+
+        printf("%-10s %10llu ns/frame  hash %016llx\n", scene->name,
+               (unsigned long long)(elapsed / frames), (unsigned long long)hash);
+        if (hash != scene->golden) {
+            printf("%s: hash differs from golden %016llx\n", scene->name,
+                   (unsigned long long)scene->golden);
+            host_failures++;
+        }
+    }
+
+    CHECK(tile_cache_stats.failed_inserts == 0);
+    return host_report("bench_render");
+}
@@ -0,0 +1,34 @@
+// The CPU's command rings as the host build sees them: the producer side of
+// cpu.c extracted into cpu_extract.c. The consumer is the test itself, which
+// drains the ring the way the TX DMA would. Include from exactly one source
+// file per executable.
+#ifndef TRIBOY_CPU_HOST_H
+#define TRIBOY_CPU_HOST_H
+
+#include "pico_host.h"
+
+#include "cpu_extract.c"
+
+// Commands issued on core 1 go straight to the bus instead of the ring
+static uint32_t host_direct_commands = 0;
+
+bool send_command_now(CommandQueue* queue, uint8_t cmd_id, uint8_t length, const uint8_t* data) {
+    (void)queue; (void)cmd_id; (void)length; (void)data;
+    host_direct_commands++;
+    return true;
+}
+
+// Copy out everything published between tail and head and retire it
+static inline uint32_t host_drain_ring(CommandQueue* queue, uint8_t* out, uint32_t capacity) {
+    uint32_t count = queue->head - queue->tail;
+    if (count > capacity) count = capacity;
+
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = queue->buffer[(queue->tail + i) & queue->mask];
+    }
+    __dmb();
+    queue->tail += count;
+    return count;
+}
+
+#endif
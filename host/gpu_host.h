@@ -0,0 +1,142 @@
+// The GPU's tile cache and renderer as the host build sees them: the sections
+// of gpu.c extracted into gpu_extract.c, plus host versions of what they call
+// from the rest of gpu.c. Include from exactly one source file per executable.
+#ifndef TRIBOY_GPU_HOST_H
+#define TRIBOY_GPU_HOST_H
+
+#include "pico_host.h"
+
+// Defined after their first use in gpu.c
+void render_layer_region(uint8_t layer_id, int start_tile_x, int start_tile_y,
+                         int end_tile_x, int end_tile_y);
+void render_tile_pixels(int x, int y, const uint8_t* tile_data, uint8_t attributes,
+                        uint8_t tile_width, uint8_t tile_height, uint8_t bpp, uint8_t layer_id);
+void render_sprite(uint8_t sprite_id, int16_t x, int16_t y, uint16_t width, uint16_t height);
+
+// Responses the extracted code sends, counted instead of going to the CPU
+static uint32_t host_gpu_acks = 0;
+static uint32_t host_gpu_errors = 0;
+
+void send_ack_to_cpu(uint8_t command_id) {
+    (void)command_id;
+    host_gpu_acks++;
+}
+
+static inline void* safe_malloc(size_t size) {
+    return malloc(size);
+}
+
+// Trace timestamps; there is no master clock to follow on the host
+uint64_t get_master_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+#include "gpu_extract.c"
+
+void send_error_to_cpu(uint8_t command_id, uint8_t error_code) {
+    (void)command_id;
+    (void)error_code;
+    host_gpu_errors++;
+}
+
+// An 8bpp framebuffer-mode target of the given size, with the tile cache and
+// sprite memory set up the way reset_gpu() leaves them
+static inline bool host_gpu_init(uint16_t width, uint16_t height, uint32_t tile_cache_bytes) {
+    display_width = width;
+    display_height = height;
+    display_bpp = 8;
+    framebuffer = calloc((size_t)width * height, 1);
+    set_render_target(framebuffer, 0, height);
+
+    sprite_data_size = 48 * 1024;
+    sprite_data = calloc(sprite_data_size, 1);
+    sprite_data_used = 0;
+    for (int p = 0; p < SPRITE_PRIORITIES; p++) {
+        sprite_list_head[p] = SPRITE_LIST_END;
+        sprite_list_tail[p] = SPRITE_LIST_END;
+    }
+    for (int s = 0; s < MAX_SPRITES; s++) {
+        sprites[s].list_priority = SPRITE_LIST_END;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        palette_rgb565[i] = (uint16_t)(i * 0x0101);
+    }
+
+    return framebuffer != NULL && sprite_data != NULL && init_tile_cache(tile_cache_bytes);
+}
+
+// A layer as configure_layer() leaves it, with the given tile depth
+static inline bool host_configure_layer(uint8_t layer_id, uint8_t priority, uint8_t tile_width,
+                                        uint8_t tile_height, uint8_t width_tiles, uint8_t height_tiles,
+                                        uint8_t bpp) {
+    Layer* layer = &layers[layer_id];
+    free(layer->tilemap);
+    memset(layer, 0, sizeof(*layer));
+
+    layer->enabled = true;
+    layer->priority = priority;
+    layer->tile_width = tile_width;
+    layer->tile_height = tile_height;
+    layer->width_tiles = width_tiles;
+    layer->height_tiles = height_tiles;
+    layer->bpp = bpp;
+    layer->tilemap = calloc((size_t)width_tiles * height_tiles, sizeof(TileInfo));
+    return layer->tilemap != NULL;
+}
+
+static inline void host_set_tile(uint8_t layer_id, int tx, int ty, uint16_t tile_id, uint8_t attributes) {
+    Layer* layer = &layers[layer_id];
+    TileInfo* info = (TileInfo*)(layer->tilemap + (ty * layer->width_tiles + tx) * sizeof(TileInfo));
+    info->tile_id = tile_id;
+    info->attributes = attributes;
+}
+
+// A sprite pattern as load_sprite_pattern() stores an uncompressed one
+static inline bool host_load_sprite_pattern(uint8_t pattern_id, uint8_t width, uint8_t height,
+                                            uint8_t bpp, const uint8_t* data) {
+    uint32_t size = (uint32_t)width * 8 * height * 8 * bpp / 8;
+    if (size > sprite_data_size - sprite_data_used) return false;
+
+    uint32_t offset = sprite_data_size - sprite_data_used - size;
+    memcpy(sprite_data + offset, data, size);
+
+    SpritePattern* pattern = &sprite_patterns[pattern_id];
+    pattern->width = width;
+    pattern->height = height;
+    pattern->bpp = bpp;
+    pattern->data_offset = offset;
+    pattern->data_size = size;
+    pattern->in_use = true;
+    pattern->flash_data = NULL;
+    scan_pixel_rows(sprite_data + offset, width * 8, height * 8, bpp,
+                    &pattern->empty_rows, &pattern->opaque_rows);
+    sprite_data_used += size;
+    return true;
+}
+
+// Show or move a sprite the way define_sprite() and the batch update do, with
+// the position in 8.8 fixed point as DEFINE_SPRITE carries it
+static inline void host_place_sprite(uint8_t sprite_id, uint8_t pattern_id, int16_t x, int16_t y,
+                                     uint8_t attributes, uint8_t palette_offset, uint8_t scale) {
+    Sprite* sprite = &sprites[sprite_id];
+    sprite->pattern_id = pattern_id;
+    sprite->x = x;
+    sprite->y = y;
+    sprite->attributes = attributes;
+    sprite->palette_offset = palette_offset;
+    sprite->scale = scale;
+    sprite->visible = true;
+    update_sprite_list(sprite_id);
+}
+
+// Clear the target and compose every layer and sprite, as a whole-frame render does
+static inline void host_compose_frame(void) {
+    memset(framebuffer, 0, (size_t)display_width * display_height * (display_bpp == 16 ? 2 : 1));
+    set_render_target(framebuffer, 0, display_height);
+    compose_render_target(false);
+}
+
+#endif
@@ -0,0 +1,56 @@
+// Shared helpers for the host tests and benchmarks
+#ifndef TRIBOY_HOST_CHECK_H
+#define TRIBOY_HOST_CHECK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int host_failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+            host_failures++;                                                     \
+        }                                                                        \
+    } while (0)
+
+// 64-bit FNV-1a, for golden framebuffer and PCM hashes
+static inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#define FNV1A_INIT 0xcbf29ce484222325ULL
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Deterministic pseudo-random bytes for test content
+static inline uint32_t xorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static inline int host_report(const char* name) {
+    if (host_failures) {
+        printf("%s: %d check(s) failed\n", name, host_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,237 @@
+// Thin host stand-in for the parts of the pico SDK the extracted firmware
+// sections use. Single-threaded: locks are no-ops, get_core_num() is whatever
+// host_core is set to, and DMA transfers run to completion when triggered.
+#ifndef TRIBOY_PICO_HOST_H
+#define TRIBOY_PICO_HOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+typedef unsigned int uint;
+
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
+
+// gpu.c uses lower-case min/max on ints
+static inline int min(int a, int b) { return a < b ? a : b; }
+static inline int max(int a, int b) { return a > b ? a : b; }
+
+// Cores and barriers
+static uint host_core = 0;
+
+static inline uint get_core_num(void) { return host_core; }
+static inline void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void tight_loop_contents(void) {}
+
+static inline uint32_t time_us_32(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000u + ts.tv_nsec / 1000);
+}
+
+// Locks
+typedef struct { int owner; } mutex_t;
+typedef struct { int locked; } spin_lock_t;
+
+static inline void mutex_init(mutex_t* mutex) { mutex->owner = -1; }
+static inline void mutex_enter_blocking(mutex_t* mutex) { mutex->owner = (int)host_core; }
+static inline void mutex_exit(mutex_t* mutex) { mutex->owner = -1; }
+
+static inline uint32_t spin_lock_blocking(spin_lock_t* lock) {
+    if (lock) lock->locked = 1;
+    return 0;
+}
+static inline void spin_unlock(spin_lock_t* lock, uint32_t irq) {
+    (void)irq;
+    if (lock) lock->locked = 0;
+}
+
+// Inter-core FIFO. Nothing runs on the other side, so pops time out.
+static inline bool multicore_fifo_pop_timeout_us(uint64_t timeout_us, uint32_t* out) {
+    (void)timeout_us;
+    (void)out;
+    return false;
+}
+static inline void multicore_fifo_push_blocking(uint32_t data) { (void)data; }
+static inline uint32_t multicore_fifo_pop_blocking(void) {
+    fprintf(stderr, "multicore_fifo_pop_blocking: no second core on the host\n");
+    abort();
+}
+
+// SPI. Only the instance pointers are used.
+typedef struct { int id; } spi_inst_t;
+static spi_inst_t host_spi[2];
+#define spi0 (&host_spi[0])
+#define spi1 (&host_spi[1])
+
+static inline uint spi_get_dreq(spi_inst_t* spi, bool is_tx) {
+    return (uint)(spi - host_spi) * 2 + (is_tx ? 0 : 1);
+}
+static inline bool spi_is_busy(spi_inst_t* spi) {
+    (void)spi;
+    return false;
+}
+
+// DMA. A channel's alias 1 registers in the order the hardware has them, with
+// host-sized addresses. Triggering a channel runs it and everything chained from
+// it before returning, which is one valid ordering of the real transfers.
+#define HOST_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+    const void* read_addr;
+    void* write_addr;
+    uint32_t transfer_count;   // Writing this triggers the channel
+} host_dma_alias1_t;
+
+typedef struct {
+    host_dma_alias1_t al1;
+    uintptr_t read_addr;       // Where the channel reads next
+    uintptr_t write_addr;
+    uint32_t transfer_count;
+} host_dma_channel_t;
+
+typedef struct {
+    struct {
+        uint32_t al1_ctrl;     // Only its address is used, as a write target
+        uintptr_t read_addr;
+    } ch[HOST_DMA_CHANNELS];
+} host_dma_hw_t;
+
+typedef struct {
+    uint32_t ctrl;
+    uint8_t size;              // enum dma_channel_transfer_size
+    bool read_increment;
+    bool write_increment;
+    int chain_to;              // Itself when not chained, like the hardware
+    uint8_t ring_bits;
+    bool ring_write;
+} dma_channel_config;
+
+static host_dma_hw_t host_dma_regs;
+static host_dma_hw_t* const dma_hw = &host_dma_regs;
+static host_dma_channel_t host_dma[HOST_DMA_CHANNELS];
+static dma_channel_config host_dma_config[HOST_DMA_CHANNELS];
+static uint32_t host_dma_claimed = 0;
+static uint32_t host_dma_bytes = 0;     // Bytes moved by data channels, for tests
+
+static inline int dma_claim_unused_channel(bool required) {
+    for (int ch = 0; ch < HOST_DMA_CHANNELS; ch++) {
+        if (!(host_dma_claimed & (1u << ch))) {
+            host_dma_claimed |= 1u << ch;
+            return ch;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "dma_claim_unused_channel: no free channel\n");
+        abort();
+    }
+    return -1;
+}
+static inline void dma_channel_unclaim(uint ch) { host_dma_claimed &= ~(1u << ch); }
+
+static inline dma_channel_config dma_channel_get_default_config(uint ch) {
+    dma_channel_config config = { 0, DMA_SIZE_32, true, false, (int)ch, 0, false };
+    config.ctrl = ch;
+    return config;
+}
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) { c->size = (uint8_t)size; }
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr) { c->read_increment = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr) { c->write_increment = incr; }
+static inline void channel_config_set_chain_to(dma_channel_config* c, uint chain_to) { c->chain_to = (int)chain_to; }
+static inline void channel_config_set_irq_quiet(dma_channel_config* c, bool quiet) { (void)c; (void)quiet; }
+static inline void channel_config_set_dreq(dma_channel_config* c, uint dreq) { (void)c; (void)dreq; }
+static inline void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits) {
+    c->ring_write = write;
+    c->ring_bits = (uint8_t)size_bits;
+}
+// The control word a control block carries names the channel it was taken from
+static inline uint32_t channel_config_get_ctrl_value(const dma_channel_config* c) { return c->ctrl; }
+
+static void host_dma_run(uint ch);
+
+static inline void dma_channel_configure(uint ch, const dma_channel_config* config, volatile void* write_addr,
+                                         const volatile void* read_addr, uint32_t count, bool trigger) {
+    host_dma_config[ch] = *config;
+    host_dma[ch].write_addr = (uintptr_t)write_addr;
+    host_dma[ch].read_addr = (uintptr_t)read_addr;
+    host_dma[ch].transfer_count = count;
+    dma_hw->ch[ch].read_addr = (uintptr_t)read_addr;
+    if (trigger) host_dma_run(ch);
+}
+
+static inline void dma_channel_set_read_addr(uint ch, const volatile void* read_addr, bool trigger) {
+    host_dma[ch].read_addr = (uintptr_t)read_addr;
+    dma_hw->ch[ch].read_addr = (uintptr_t)read_addr;
+    if (trigger) host_dma_run(ch);
+}
+
+static inline bool dma_channel_is_busy(uint ch) {
+    (void)ch;
+    return false;
+}
+
+// The channel whose alias 1 registers a channel writes, or -1 for a plain copy
+static int host_dma_control_target(const host_dma_channel_t* channel) {
+    for (int target = 0; target < HOST_DMA_CHANNELS; target++) {
+        if (channel->write_addr == (uintptr_t)&dma_hw->ch[target].al1_ctrl) return target;
+    }
+    return -1;
+}
+
+// Run a channel and its chain. Two shapes are modelled: a plain copy, and a
+// control channel writing blocks into another channel's alias 1 registers.
+static void host_dma_run(uint ch) {
+    for (;;) {
+        host_dma_channel_t* channel = &host_dma[ch];
+        int target = host_dma_control_target(channel);
+
+        if (target >= 0) {
+            // Control channel: one block per trigger, a null trigger ends the chain
+            const host_dma_alias1_t* block = (const host_dma_alias1_t*)channel->read_addr;
+            channel->read_addr = (uintptr_t)(block + 1);
+            dma_hw->ch[ch].read_addr = channel->read_addr;
+
+            host_dma_channel_t* data = &host_dma[target];
+            data->al1 = *block;
+            if (block->transfer_count == 0) return;
+
+            data->read_addr = (uintptr_t)block->read_addr;
+            data->write_addr = (uintptr_t)block->write_addr;
+            data->transfer_count = block->transfer_count;
+            ch = (uint)target;
+            continue;
+        }
+
+        dma_channel_config* config = &host_dma_config[ch];
+        uint32_t unit = 1u << config->size;
+        const uint8_t* src = (const uint8_t*)channel->read_addr;
+        uint8_t* dst = (uint8_t*)channel->write_addr;
+
+        for (uint32_t i = 0; i < channel->transfer_count; i++) {
+            memcpy(dst, src, unit);
+            if (config->read_increment) src += unit;
+            if (config->write_increment) dst += unit;
+        }
+        host_dma_bytes += channel->transfer_count * unit;
+        channel->transfer_count = 0;
+        dma_hw->ch[ch].read_addr = (uintptr_t)src;
+
+        if (config->chain_to == (int)ch) return;
+        ch = (uint)config->chain_to;
+    }
+}
+
+#endif
@@ -0,0 +1,115 @@
+// Command rings: encoding, wrap, batching and the full-ring path from cpu.c
+#include "cpu_host.h"
+#include "host_check.h"
+
+#define RING_SIZE 64
+
+static CommandQueue queue;
+
+static void fill_payload(uint8_t* data, uint8_t count, uint8_t seed) {
+    for (uint8_t i = 0; i < count; i++) {
+        data[i] = (uint8_t)(seed * 13 + i);
+    }
+}
+
+// Commands come out of the ring byte for byte as [cmd][len][data], including
+// those that straddle the end of the buffer
+static void test_encode_and_wrap(void) {
+    uint8_t data[32];
+    uint8_t out[RING_SIZE];
+
+    for (uint8_t round = 0; round < 40; round++) {
+        uint8_t length = 2 + round % 23;
+        fill_payload(data, length - 2, round);
+        CHECK(queue_command(&queue, 0x40 + round, length, data));
+        CHECK(queue.head == queue.write_pos);
+
+        uint32_t count = host_drain_ring(&queue, out, sizeof(out));
+        CHECK(count == length);
+        CHECK(out[0] == 0x40 + round);
+        CHECK(out[1] == length);
+        CHECK(memcmp(&out[2], data, length - 2) == 0);
+    }
+
+    // A command without a payload is sent with zeros
+    memset(queue.buffer, 0xAA, RING_SIZE);
+    CHECK(queue_command(&queue, 0x21, 10, NULL));
+    CHECK(host_drain_ring(&queue, out, sizeof(out)) == 10);
+    for (int i = 2; i < 10; i++) CHECK(out[i] == 0);
+
+    CHECK(!queue_command(&queue, 0x21, 1, data));
+    CHECK(queue.head == queue.tail);
+}
+
+// A batch is published as one [CMD_BATCH][count][size] container, and only
+// once it is closed
+static void test_batch(void) {
+    uint8_t data[8];
+    uint8_t out[RING_SIZE];
+
+    CHECK(begin_command_batch(&queue));
+    for (uint8_t i = 0; i < 3; i++) {
+        fill_payload(data, 4, i);
+        CHECK(queue_command(&queue, 0x30 + i, 6, data));
+    }
+    CHECK(queue.head == queue.tail);
+    end_command_batch(&queue);
+
+    uint32_t count = host_drain_ring(&queue, out, sizeof(out));
+    CHECK(count == BATCH_HEADER_SIZE + 3 * 6);
+    CHECK(out[0] == CMD_BATCH);
+    CHECK(out[1] == 3);
+    CHECK(((out[2] << 8) | out[3]) == 3 * 6);
+    for (uint8_t i = 0; i < 3; i++) {
+        fill_payload(data, 4, i);
+        CHECK(out[BATCH_HEADER_SIZE + i * 6] == 0x30 + i);
+        CHECK(memcmp(&out[BATCH_HEADER_SIZE + i * 6 + 2], data, 4) == 0);
+    }
+
+    // An empty batch gives its reserved header back
+    uint32_t write_pos = queue.write_pos;
+    CHECK(begin_command_batch(&queue));
+    end_command_batch(&queue);
+    CHECK(queue.write_pos == write_pos);
+    CHECK(queue.head == queue.tail);
+}
+
+// A command that doesn't fit is refused and counted, and leaves what is
+// already queued intact
+static void test_full_ring(void) {
+    uint8_t data[32] = {0};
+    uint8_t out[RING_SIZE];
+
+    CHECK(queue_command(&queue, 0x50, 30, data));
+    CHECK(queue_command(&queue, 0x51, 30, data));
+    CHECK(!queue_command(&queue, 0x52, 8, data));
+    CHECK(queue.dropped == 1);
+    CHECK(queue.head - queue.tail == 60);
+
+    CHECK(host_drain_ring(&queue, out, sizeof(out)) == 60);
+    CHECK(out[0] == 0x50 && out[30] == 0x51);
+    CHECK(queue_command(&queue, 0x52, 8, data));
+    CHECK(host_drain_ring(&queue, out, sizeof(out)) == 8);
+}
+
+// Core 1 never produces into the ring
+static void test_core1_direct(void) {
+    uint8_t data[4] = {0};
+
+    host_core = 1;
+    CHECK(queue_command(&queue, 0x60, 6, data));
+    host_core = 0;
+
+    CHECK(host_direct_commands == 1);
+    CHECK(queue.head == queue.tail);
+    CHECK(queue.write_pos == queue.head);
+}
+
+int main(void) {
+    CHECK(init_command_ring(&queue, spi0, 17, RING_SIZE));
+    test_encode_and_wrap();
+    test_batch();
+    test_full_ring();
+    test_core1_direct();
+    return host_report("command_ring");
+}
@@ -0,0 +1,138 @@
+// Mixer: the voice split, Q15 voice strip, delay and soft clipper from apu.c
+#include "apu_host.h"
+#include "host_check.h"
+
+#define TEST_PERIODS 8
+
+static void start_voices(void) {
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        channels[ch].active = false;
+    }
+    host_fm_voice(0, 0, 3, 220.0f, 100, 0);
+    host_fm_voice(1, 4, 0, 330.0f, 100, 255);
+    host_fm_voice(2, 7, 5, 440.0f, 60, 128);
+    host_fm_voice(5, 2, 1, 110.0f, 80, 64);
+}
+
+static uint64_t render_periods(bool split, int16_t* first_period) {
+    uint64_t hash = FNV1A_INIT;
+
+    start_voices();
+    for (int p = 0; p < TEST_PERIODS; p++) {
+        if (split) {
+            host_render_audio_period();
+        } else {
+            // Every voice on one core
+            plan_voice_split();
+            for (int i = 0; i < voice_jobs[1].count; i++) {
+                voice_jobs[0].channels[voice_jobs[0].count++] = voice_jobs[1].channels[i];
+            }
+            voice_jobs[1].count = 0;
+            render_voice_job(0);
+            render_voice_job(1);
+            if (use_fixed_mixing) finish_audio_buffer_fixed();
+            else finish_audio_buffer_float();
+        }
+        if (p == 0 && first_period) memcpy(first_period, pcm_buffer, sizeof(pcm_buffer));
+        hash = fnv1a(pcm_buffer, sizeof(pcm_buffer), hash);
+    }
+    return hash;
+}
+
+// The fixed bus gives the same samples however the voices are split between
+// the cores, and they are not silence
+static void test_split_invariant(void) {
+    static int16_t period[AUDIO_BUFFER_SIZE * 2];
+
+    uint64_t split = render_periods(true, period);
+    uint64_t single = render_periods(false, NULL);
+    CHECK(split == single);
+    CHECK(voice_jobs[0].count > 0 || voice_jobs[1].count > 0);
+
+    int32_t peak_left = 0;
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+        peak_left = MAX(peak_left, abs(period[i * 2]));
+    }
+    CHECK(peak_left > 256);
+}
+
+// Both pipelines share the master gain and the clipper's curve, so at any
+// master volume they agree to within the fixed bus's truncation, a couple of
+// LSBs per voice
+static void test_float_matches_fixed(uint8_t volume) {
+    static int16_t fixed[AUDIO_BUFFER_SIZE * 2];
+    static int16_t floating[AUDIO_BUFFER_SIZE * 2];
+
+    master_volume = volume;
+    use_fixed_mixing = true;
+    render_periods(true, fixed);
+    use_fixed_mixing = false;
+    render_periods(true, floating);
+    use_fixed_mixing = true;
+
+    int32_t worst = 0;
+    for (int i = 0; i < AUDIO_BUFFER_SIZE * 2; i++) {
+        worst = MAX(worst, abs(fixed[i] - floating[i]));
+    }
+    printf("float/fixed worst difference at volume %u: %d\n", volume, worst);
+    CHECK(worst <= 8);
+    master_volume = 255;
+}
+
+// Unity below the knee, odd, monotonic, never past full scale, and within a
+// few LSBs of the float curve
+static void test_soft_clip(void) {
+    int16_t previous = soft_clip_q15(-MIX_BUS_LIMIT * 4);
+
+    for (int32_t x = -MIX_BUS_LIMIT * 4; x <= MIX_BUS_LIMIT * 4; x += 7) {
+        int16_t y = soft_clip_q15(x);
+        CHECK(y >= previous);
+        CHECK(y == -soft_clip_q15(-x));
+        if (abs(x) < (int32_t)(SOFT_CLIP_KNEE * 32768)) CHECK(abs(y - x) <= 1);
+        if (abs(x) < MIX_BUS_LIMIT) {
+            CHECK(fabsf(y - soft_clip_curve(x / 32768.0f) * 32767.0f) <= 3.0f);
+        }
+        previous = y;
+    }
+    CHECK(soft_clip_q15(MIX_BUS_LIMIT) <= 32767);
+    CHECK(soft_clip_q15(MIX_BUS_LIMIT) > 30000);
+}
+
+// A send comes back delay.samples later, scaled by the wet level, and the
+// feedback repeats it
+static void test_delay(void) {
+    static int32_t bus[AUDIO_BUFFER_SIZE * 2];
+    static int32_t send[AUDIO_BUFFER_SIZE * 2];
+
+    delay.enabled = true;
+    delay.samples = 100;
+    delay.write_pos = 0;
+    delay.wet_q15 = 16384;
+    delay.feedback_q15 = 16384;
+    memset(delay.buffer, 0, delay.buffer_frames * 2 * sizeof(int16_t));
+
+    memset(bus, 0, sizeof(bus));
+    memset(send, 0, sizeof(send));
+    send[0] = 20000;
+    send[1] = -20000;
+    apply_delay_q15(bus, send, AUDIO_BUFFER_SIZE);
+
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+        int32_t expected = (i == 100) ? 10000 : (i == 200) ? 5000 : 0;
+        CHECK(bus[i * 2] == expected);
+        CHECK(bus[i * 2 + 1] == -expected);
+    }
+
+    delay.enabled = false;
+}
+
+int main(void) {
+    CHECK(host_apu_init(true));
+    test_split_invariant();
+    test_float_matches_fixed(255);
+    test_float_matches_fixed(160);
+    test_soft_clip();
+    test_delay();
+    CHECK(host_apu_errors == 0);
+    return host_report("mixer");
+}
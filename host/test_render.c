@@ -0,0 +1,238 @@
+// Renderer: sprite span blitters, the DMA tile blitter, sprite clipping and the
+// rotate/zoom layer, from gpu.c
+#include "gpu_host.h"
+#include "host_check.h"
+
+#define SPAN_SOURCE 128
+
+static uint16_t reference_fetch(const uint8_t* src, uint32_t sx, uint8_t bpp) {
+    if (bpp == 4) return (sx & 1) ? src[sx / 2] & 0x0F : src[sx / 2] >> 4;
+    if (bpp == 8) return src[sx];
+    return src[sx * 2] | (src[sx * 2 + 1] << 8);
+}
+
+// What a span blitter should write, one pixel at a time
+static void reference_span(uint8_t* dst, const uint8_t* src, uint32_t src_x, int32_t src_step,
+                           uint16_t count, uint8_t palette_base, uint8_t bpp, bool scaled,
+                           bool flip_x, bool rgb_target) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t sx;
+        if (scaled) sx = (src_x + (uint32_t)(i * src_step)) >> 16;
+        else sx = flip_x ? src_x - i : src_x + i;
+
+        uint16_t pixel = reference_fetch(src, sx, bpp);
+        if (pixel == 0) continue;
+
+        if (bpp == 16) {
+            ((uint16_t*)dst)[i] = pixel;
+        } else if (rgb_target) {
+            ((uint16_t*)dst)[i] = palette_rgb565[(uint8_t)(pixel + palette_base)];
+        } else {
+            dst[i] = (uint8_t)(pixel + palette_base);
+        }
+    }
+}
+
+static void test_span_blitters(void) {
+    static const uint8_t depths[3] = { 4, 8, 16 };
+    uint8_t src[SPAN_SOURCE * 2];
+    uint8_t dst[SPAN_SOURCE * 2];
+    uint8_t expected[SPAN_SOURCE * 2];
+    uint32_t rng = 99;
+
+    for (int i = 0; i < 256; i++) palette_rgb565[i] = (uint16_t)(i * 2654435761u >> 16);
+
+    for (int round = 0; round < 200; round++) {
+        for (uint32_t i = 0; i < sizeof(src); i++) {
+            uint32_t r = xorshift32(&rng);
+            src[i] = (r & 3) == 0 ? 0 : (uint8_t)(r >> 8);
+        }
+
+        for (int d = 0; d < 3; d++) {
+            for (int scaled = 0; scaled < 2; scaled++) {
+                for (int flip_x = 0; flip_x < 2; flip_x++) {
+                    for (int rgb = 0; rgb < 2; rgb++) {
+                        uint8_t bpp = depths[d];
+                        uint16_t count = 1 + xorshift32(&rng) % 40;
+                        uint8_t palette_base = (bpp == 4) ? (xorshift32(&rng) % 16) * 16 : 0;
+                        uint32_t src_x;
+                        int32_t step = 0;
+
+                        if (scaled) {
+                            // 0.5x to 2x, staying inside the source row
+                            uint32_t scale = 0x8000 + xorshift32(&rng) % 0x18000;
+                            uint32_t span = (count - 1) * scale + 0xFFFF;
+                            uint32_t start = xorshift32(&rng) % ((SPAN_SOURCE << 16) - span);
+                            src_x = flip_x ? start + span : start;
+                            step = flip_x ? -(int32_t)scale : (int32_t)scale;
+                        } else {
+                            uint32_t start = xorshift32(&rng) % (SPAN_SOURCE - count + 1);
+                            src_x = flip_x ? start + count - 1 : start;
+                        }
+
+                        memset(dst, 0xEE, sizeof(dst));
+                        memset(expected, 0xEE, sizeof(expected));
+                        span_blitters[d][scaled][flip_x][rgb](dst, src, src_x, step, count, palette_base);
+                        reference_span(expected, src, src_x, step, count, palette_base,
+                                       bpp, scaled, flip_x, rgb);
+                        CHECK(memcmp(dst, expected, sizeof(dst)) == 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Tiles with every row kind: opaque, empty, mixed, and mixed tiles mirrored
+static void load_test_tiles(uint8_t layer_id, uint16_t count, uint32_t seed) {
+    uint8_t tile[64];
+    uint32_t rng = seed;
+
+    for (uint16_t t = 1; t <= count; t++) {
+        for (int y = 0; y < 8; y++) {
+            uint32_t kind = (t + y) % 4;
+            for (int x = 0; x < 8; x++) {
+                uint8_t v = (uint8_t)(1 + xorshift32(&rng) % 255);
+                if (kind == 1 || (kind == 2 && (x + y) % 3 == 0)) v = 0;
+                tile[y * 8 + x] = v;
+            }
+        }
+        // Half the tiles fully opaque, so the blitter has whole tiles to copy
+        if (t & 1) {
+            for (int i = 0; i < 64; i++) tile[i] |= 1;
+        }
+        cache_tile(layer_id, t, tile, sizeof(tile));
+    }
+}
+
+static void fill_test_map(uint8_t layer_id, uint16_t tiles, uint32_t seed) {
+    Layer* layer = &layers[layer_id];
+    uint32_t rng = seed;
+
+    for (int ty = 0; ty < layer->height_tiles; ty++) {
+        for (int tx = 0; tx < layer->width_tiles; tx++) {
+            uint32_t r = xorshift32(&rng);
+            host_set_tile(layer_id, tx, ty, (r % 8 == 0) ? 0 : 1 + r % tiles, (r >> 8) & 0x03);
+        }
+    }
+}
+
+// The DMA blitter draws the same frame as the per-pixel CPU path
+static void test_tile_blitter(void) {
+    init_tile_blitter();
+    CHECK(blit_data_channel >= 0 && blit_ctrl_channel >= 0);
+
+    CHECK(host_configure_layer(0, 0, 8, 8, 64, 32, 8));
+    CHECK(host_configure_layer(1, 1, 8, 8, 64, 32, 8));
+    load_test_tiles(0, 40, 7);
+    load_test_tiles(1, 40, 11);
+    fill_test_map(0, 40, 3);
+    fill_test_map(1, 40, 5);
+    layers[0].scroll_x = 13;
+    layers[0].scroll_y = 7;
+    layers[1].scroll_x = 301;
+    layers[1].scroll_y = 250;
+
+    uint32_t frame_size = display_width * display_height;
+    uint8_t* cpu_frame = malloc(frame_size);
+
+    layers[0].blit_backend = LAYER_BLIT_CPU;
+    layers[1].blit_backend = LAYER_BLIT_CPU;
+    host_compose_frame();
+    memcpy(cpu_frame, framebuffer, frame_size);
+
+    layers[0].blit_backend = LAYER_BLIT_AUTO;
+    layers[1].blit_backend = LAYER_BLIT_AUTO;
+    host_dma_bytes = 0;
+    host_compose_frame();
+
+    CHECK(host_dma_bytes > 0);
+    CHECK(!blit_running);
+    CHECK(memcmp(cpu_frame, framebuffer, frame_size) == 0);
+
+    free(cpu_frame);
+    layers[0].enabled = false;
+    layers[1].enabled = false;
+}
+
+// A sprite clipped at the screen edge draws the same pixels as the part of it
+// that is on screen when it isn't clipped
+static void test_sprite_clipping(void) {
+    static const uint8_t scales[3] = { 128, 200, 77 };
+    static const uint8_t depths[2] = { 4, 8 };
+    uint8_t pixels[16 * 16];
+    uint32_t rng = 5;
+
+    for (int d = 0; d < 2; d++) {
+        uint8_t bpp = depths[d];
+        for (int i = 0; i < (int)sizeof(pixels); i++) {
+            uint32_t r = xorshift32(&rng);
+            pixels[i] = (r % 5 == 0) ? 0 : (uint8_t)(r >> 8);
+        }
+        CHECK(host_load_sprite_pattern(d, 2, 2, bpp, pixels));
+    }
+
+    uint32_t frame_size = display_width * display_height;
+    uint8_t* unclipped = malloc(frame_size);
+
+    for (int d = 0; d < 2; d++) {
+        for (int s = 0; s < 3; s++) {
+            for (uint8_t flip = 0; flip < 4; flip++) {
+                host_place_sprite(0, d, 40 * 256, 40 * 256, flip, 3, scales[s]);
+                host_compose_frame();
+                memcpy(unclipped, framebuffer, frame_size);
+
+                host_place_sprite(0, d, -7 * 256, -5 * 256, flip, 3, scales[s]);
+                host_compose_frame();
+
+                for (int y = 0; y < 40; y++) {
+                    CHECK(memcmp(&framebuffer[y * display_width],
+                                 &unclipped[(y + 45) * display_width + 47], 40) == 0);
+                }
+            }
+        }
+    }
+
+    sprites[0].visible = false;
+    update_sprite_list(0);
+    free(unclipped);
+}
+
+// With an identity matrix the rotate/zoom renderer draws what the tile renderer does
+static void test_rotation_identity(void) {
+    CHECK(host_configure_layer(2, 0, 8, 8, 64, 32, 8));
+    load_test_tiles(2, 40, 23);
+    fill_test_map(2, 40, 29);
+    layers[2].scroll_x = 100;
+    layers[2].scroll_y = 37;
+    layers[2].blit_backend = LAYER_BLIT_CPU;
+
+    uint32_t frame_size = display_width * display_height;
+    uint8_t* tiled = malloc(frame_size);
+    host_compose_frame();
+    memcpy(tiled, framebuffer, frame_size);
+
+    Layer* layer = &layers[2];
+    layer->rotation_enabled = true;
+    layer->affine[0] = 1 << 16;
+    layer->affine[1] = 0;
+    layer->affine[2] = 0;
+    layer->affine[3] = 1 << 16;
+    layer->rot_center_x = 160;
+    layer->rot_center_y = 120;
+    host_compose_frame();
+
+    CHECK(memcmp(tiled, framebuffer, frame_size) == 0);
+
+    free(tiled);
+    layer->enabled = false;
+}
+
+int main(void) {
+    CHECK(host_gpu_init(320, 240, 64 * 1024));
+    test_span_blitters();
+    test_tile_blitter();
+    test_sprite_clipping();
+    test_rotation_identity();
+    return host_report("render");
+}
@@ -0,0 +1,149 @@
+// Tile cache: slab pages, hash index and CLOCK eviction from gpu.c
+#include "gpu_host.h"
+#include "host_check.h"
+
+static uint8_t tile_bytes[512];
+
+static void fill_tile(uint8_t layer_id, uint16_t tile_id, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        tile_bytes[i] = (uint8_t)(layer_id * 31 + tile_id * 7 + i);
+    }
+}
+
+static bool tile_matches(const uint8_t* data, uint8_t layer_id, uint16_t tile_id, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        if (data[i] != (uint8_t)(layer_id * 31 + tile_id * 7 + i)) return false;
+    }
+    return true;
+}
+
+// Every entry in use is reachable through the index and holds its own pixels,
+// and the pages' live counts add up to the entries in use
+static void check_cache_consistent(void) {
+    uint32_t in_use = 0;
+    uint32_t live = 0;
+
+    for (int i = 0; i < MAX_CACHED_TILES; i++) {
+        TileCacheEntry* entry = &tile_cache[i];
+        if (!entry->in_use) continue;
+        in_use++;
+
+        CHECK(tile_index[tile_index_find(entry->layer_id, entry->tile_id)] == i);
+        if (!(entry->layer_id & TILE_VARIANT_FLIP_X)) {
+            CHECK(tile_matches(entry->data, entry->layer_id, entry->tile_id, entry->size));
+        }
+    }
+    for (uint32_t p = 0; p < tile_slab_pages_used; p++) {
+        live += tile_slab_page_info[p].live;
+    }
+
+    CHECK(in_use == tile_cache_count);
+    CHECK(live == tile_cache_count);
+    CHECK(tile_free_entry_count + tile_cache_count == MAX_CACHED_TILES);
+}
+
+// Pages handed to one size class come back for another once they empty, so a
+// change of tile size doesn't leave the arena carved for the old one
+static void test_class_change(void) {
+    CHECK(init_tile_cache(8 * TILE_SLAB_PAGE_SIZE));
+
+    // Fill every entry with 64-byte tiles, which carves the whole arena for them
+    for (uint16_t t = 0; t < MAX_CACHED_TILES; t++) {
+        fill_tile(0, t, 64);
+        cache_tile(0, t, tile_bytes, 64);
+    }
+    CHECK(tile_cache_stats.failed_inserts == 0);
+    CHECK(tile_slab_pages_used == tile_slab_pages);
+
+    for (uint16_t t = 0; t < 24; t++) {
+        fill_tile(1, t, 512);
+        cache_tile(1, t, tile_bytes, 512);
+    }
+    CHECK(tile_cache_stats.failed_inserts == 0);
+    check_cache_consistent();
+
+    // The new size got pages: the tile just loaded and a good share of the others
+    uint32_t large = 0;
+    for (uint16_t t = 0; t < 24; t++) {
+        uint8_t* data = get_cached_tile(1, t);
+        if (data != NULL) {
+            CHECK(tile_matches(data, 1, t, 512));
+            large++;
+        }
+    }
+    CHECK(get_cached_tile(1, 23) != NULL);
+    printf("512-byte tiles resident: %u of 24\n", large);
+    CHECK(large >= 8);
+
+    free(tile_slab_memory);
+    free(tile_slab_page_info);
+}
+
+// Mixed sizes, replacements and lookups keep the index and slabs consistent
+static void test_churn(void) {
+    CHECK(init_tile_cache(16 * TILE_SLAB_PAGE_SIZE));
+    uint32_t rng = 12345;
+
+    for (int i = 0; i < 20000; i++) {
+        uint8_t layer_id = xorshift32(&rng) % MAX_LAYERS;
+        uint16_t tile_id = 1 + xorshift32(&rng) % 400;
+        uint32_t size = 32u << (xorshift32(&rng) % 5);
+
+        if (xorshift32(&rng) & 1) {
+            fill_tile(layer_id, tile_id, size);
+            cache_tile(layer_id, tile_id, tile_bytes, size);
+        } else {
+            get_cached_tile(layer_id, tile_id);
+        }
+    }
+
+    CHECK(tile_cache_stats.failed_inserts == 0);
+    CHECK(tile_cache_stats.hits + tile_cache_stats.misses > 0);
+    check_cache_consistent();
+
+    flush_tile_cache();
+    CHECK(tile_cache_count == 0);
+    CHECK(get_cached_tile(0, 1) == NULL);
+
+    free(tile_slab_memory);
+    free(tile_slab_page_info);
+}
+
+// A mirrored tile whose rows are all copies gets a pre-flipped copy
+static void test_flip_variant(void) {
+    CHECK(init_tile_cache(8 * TILE_SLAB_PAGE_SIZE));
+    Layer* layer = &layers[2];
+    layer->tile_width = 8;
+    layer->tile_height = 8;
+    layer->bpp = 8;
+
+    uint8_t tile[64];
+    for (int i = 0; i < 64; i++) tile[i] = (uint8_t)(1 + i);
+    cache_tile(2, 5, tile, sizeof(tile));
+
+    TileView view;
+    CHECK(get_tile_view(2, 5, true, &view));
+    CHECK(view.flipped_x);
+    CHECK(view.opaque_rows == 0xFF);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            CHECK(view.data[y * 8 + x] == tile[y * 8 + 7 - x]);
+        }
+    }
+
+    // New pixels drop the stale mirrored copy
+    tile[0] = 200;
+    cache_tile(2, 5, tile, sizeof(tile));
+    CHECK(tile_index[tile_index_find(2 | TILE_VARIANT_FLIP_X, 5)] == TILE_INDEX_EMPTY);
+
+    memset(layer, 0, sizeof(*layer));
+    free(tile_slab_memory);
+    free(tile_slab_page_info);
+}
+
+int main(void) {
+    test_class_change();
+    test_churn();
+    test_flip_variant();
+    return host_report("tile_cache");
+}
@@ -20,6 +20,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define GPU_CMD_SET_DEBUG_MODE           0x07 /* Toggle debug visualization modes - Not in original spec */
 #define GPU_CMD_SET_FRAMERATE            0x08 /* Set target framerate - Not in original spec */
 #define GPU_CMD_CLEAR_SCREEN             0x09 /* Clear screen to a specified color - Not in original spec */
+#define GPU_CMD_FRAME_COMMIT             0x0A /* End of a frame's commands; the GPU renders once it arrives - Not in original spec */
 
 /* GPU Palette Commands (0x10-0x1F) */
 #define GPU_CMD_SET_PALETTE_ENTRY        0x10 /* Set single palette entry */
@@ -43,6 +44,8 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define GPU_CMD_UPDATE_TILE              0x29 /* Update a single tile in a tileset - Not in original spec */
 #define GPU_CMD_COPY_LAYER_REGION        0x2A /* Copy a region from one layer to another - Not in original spec */
 #define GPU_CMD_FILL_LAYER_REGION        0x2B /* Fill a region with a specified tile - Not in original spec */
+#define GPU_CMD_MAP_TILESET              0x2C /* Use tiles from the GPU's flash asset pack in place - Not in original spec */
+#define GPU_CMD_SET_LAYER_BLIT           0x2D /* Select DMA tile blitter or CPU drawing for a layer - Not in original spec */
 
 /* GPU Sprite Commands (0x40-0x5F) */
 #define GPU_CMD_LOAD_SPRITE_PATTERN      0x40 /* Load sprite pattern/graphic data */
@@ -58,6 +61,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define GPU_CMD_GET_SPRITE_COLLISION     0x4A /* Check if sprite collided with another sprite - Not in original spec */
 #define GPU_CMD_BATCH_SPRITE_UPDATE      0x4B /* Update multiple sprites in a single command - Not in original spec */
 #define GPU_CMD_SET_SPRITE_Z_DEPTH       0x4C /* Set sprite depth for 3D-like layering - Not in original spec */
+#define GPU_CMD_MAP_SPRITE_PATTERN       0x4D /* Define a sprite pattern stored in the GPU's flash asset pack - Not in original spec */
 
 /* GPU Special Effects Commands (0x60-0x7F) */
 #define GPU_CMD_SET_FADE                 0x60 /* Set screen fade level */
@@ -71,6 +75,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define GPU_CMD_SHAKE_SCREEN             0x68 /* Screen shake effect - Not in original spec */
 #define GPU_CMD_FLASH_SCREEN             0x69 /* Screen flash effect - Not in original spec */
 #define GPU_CMD_APPLY_LUT                0x6A /* Apply color lookup table - Not in original spec */
+#define GPU_CMD_ROTATION_LINE_TABLE      0x6B /* Per-scanline rotation matrix table - Not in original spec */
 
 /* GPU Direct Drawing Commands (0x80-0x9F) */
 #define GPU_CMD_DRAW_PIXEL               0x80 /* Draw single pixel */
@@ -94,6 +99,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define GPU_CMD_COPPER_LIST_START        0xA3 /* Begin "copper list" of timed commands */
 #define GPU_CMD_COPPER_WAIT_LINE         0xA4 /* Wait until scanline before next command */
 #define GPU_CMD_COPPER_END               0xA5 /* End copper list */
+#define GPU_CMD_COPPER_SET_REGISTER      0xA6 /* Copper list layer register write - Not in original spec */
 #define GPU_CMD_SET_LAYER_BLEND          0xB0 /* Set layer transparency and blend mode */
 #define GPU_CMD_SET_RENDER_TARGET        0xB1 /* Set custom render target buffer - Not in original spec */
 #define GPU_CMD_APPLY_SHADER             0xB2 /* Apply simple shader effect - Not in original spec */
@@ -144,6 +150,8 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define APU_CMD_TRACKER_SET_ROW_CALLBACK 0x1D /* Set callback for specific row - Not in original spec */
 #define APU_CMD_TRACKER_EXPORT           0x1E /* Export current song data - Not in original spec */
 #define APU_CMD_TRACKER_IMPORT           0x1F /* Import song data from different format - Not in original spec */
+/* 0x10-0x1F is fully assigned; tracker additions continue at 0x20 (0x20-0x2F has no other users) */
+#define APU_CMD_TRACKER_LOAD_DATA        0x20 /* Append the next chunk of a song being loaded - Not in original spec */
 
 /* APU Channel Control Commands (0x30-0x4F) */
 #define APU_CMD_CHANNEL_SET_VOLUME       0x30 /* Set volume for specific channel */
@@ -185,6 +193,10 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define APU_CMD_SAMPLE_SET_ENDIANNESS    0x79 /* Set sample data endianness - Not in original spec */
 #define APU_CMD_SAMPLE_NORMALIZE         0x7A /* Normalize sample amplitude - Not in original spec */
 #define APU_CMD_SAMPLE_TRIM              0x7B /* Trim silence from sample - Not in original spec */
+#define APU_CMD_SAMPLE_STREAM_DEFINE     0x7C /* Define a sample streamed from flash or the CPU - Not in original spec */
+#define APU_CMD_SAMPLE_STREAM_DATA       0x7D /* Deliver streamed sample data for a channel - Not in original spec */
+#define APU_CMD_SAMPLE_LOAD_DATA         0x7E /* Append the next chunk of a sample being loaded - Not in original spec */
+#define APU_CMD_SAMPLE_MAP               0x7F /* Define a sample played in place from the APU's flash asset pack - Not in original spec */
 
 /* APU Wavetable Synthesis Commands (0x90-0xAF) */
 #define APU_CMD_WAVE_DEFINE_TABLE        0x90 /* Define custom wavetable */
@@ -197,6 +209,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define APU_CMD_WAVE_SET_FORMANT         0x97 /* Apply formant filter to wavetable - Not in original spec */
 #define APU_CMD_WAVE_GENERATE            0x98 /* Generate wavetable algorithmically - Not in original spec */
 #define APU_CMD_WAVE_ANALYZE             0x99 /* Analyze sample to create wavetable - Not in original spec */
+#define APU_CMD_WAVE_MAP_TABLE           0x9A /* Use a wavetable from the APU's flash asset pack - Not in original spec */
 
 /* APU Effects Processing Commands (0xB0-0xCF) */
 #define APU_CMD_EFFECT_SET_REVERB        0xB0 /* Configure global reverb effect */
@@ -223,6 +236,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define APU_CMD_MEM_COMPRESS             0xD7 /* Apply runtime compression to memory - Not in original spec */
 #define APU_CMD_MEM_BACKUP               0xD8 /* Backup critical audio data - Not in original spec */
 #define APU_CMD_MEM_RESTORE              0xD9 /* Restore audio data from backup - Not in original spec */
+#define APU_CMD_AUDIO_STATUS             0xDA /* Report output ring underruns and latency - Not in original spec */
 
 /*====================================================================================================================*/
 
@@ -235,6 +249,8 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define CPU_CMD_SET_RP2350_MODE          0xE5 /* Enable RP2350-specific features */
 #define CPU_CMD_PROFILE_START            0xE6 /* Start performance profiling - Not in original spec */
 #define CPU_CMD_PROFILE_STOP             0xE7 /* Stop performance profiling - Not in original spec */
+#define CPU_CMD_PROFILE_READ             0xE8 /* Read recorded profiler events of one core - Not in original spec */
+#define CPU_CMD_SEQUENCED                0xE9 /* [0xE9][seq] + one command, run in order and acknowledged cumulatively - Not in original spec */
 
 /* Batch Command Set (0xF0-0xF7) */
 #define CMD_BATCH_SPRITES                0xF0 /* Batch multiple sprite commands */
@@ -243,7 +259,7 @@ This file defines all command IDs used for inter-microcontroller communication b
 #define CMD_BATCH_DRAW                   0xF3 /* Batch multiple drawing commands */
 #define CMD_BATCH_AUDIO                  0xF4 /* Batch multiple audio commands */
 #define CMD_BATCH_CHANNELS               0xF5 /* Batch multiple channel commands */
-#define CMD_BATCH_CUSTOM                 0xF6 /* User-defined batch command - Not in original spec */
+#define CMD_BATCH_CUSTOM                 0xF6 /* Generic batch container: [0xF6][count][size:2] + sub-commands, one ACK - Not in original spec */
 #define CMD_BATCH_END                    0xF7 /* End of batch sequence - Not in original spec */
 
 /* Communication Protocol Commands (0xF8-0xFF) */